@@ -37,6 +37,8 @@
 
 #include "AlignedAllocator.h"
 #include "QueueManager.h"
+#include "AcceleratorBufferPerformanceCounters.h"
+#include "HostMemoryPolicy.h"
 
 #ifdef _WIN32
 #undef MemoryBarrier
@@ -62,107 +64,8 @@ extern std::mutex g_vkTransferMutex;
 
 extern bool g_hasDebugUtils;
 extern bool g_vulkanDeviceHasUnifiedMemory;
-
-/**
-	@brief Performance counters shared by all AcceleratorBuffer instances
- */
-class AcceleratorBufferPerformanceCounters
-{
-public:
-	static void Reset()
-	{
-		m_hostDeviceCopiesBlocking.store(0);
-		m_hostDeviceCopiesNonBlocking.store(0);
-		m_hostDeviceCopiesSkipped.store(0);
-
-		m_deviceHostCopiesBlocking.store(0);
-		m_deviceHostCopiesNonBlocking.store(0);
-		m_deviceHostCopiesSkipped.store(0);
-
-		m_deviceDeviceCopiesBlocking.store(0);
-		m_deviceDeviceCopiesNonBlocking.store(0);
-		m_deviceDeviceCopiesSkipped.store(0);
-	}
-
-	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	// Helpers for logging specific interactions
-
-	static void LogHostDeviceCopyBlocking()
-	{ m_hostDeviceCopiesBlocking ++; }
-
-	static void LogHostDeviceCopyNonBlocking()
-	{ m_hostDeviceCopiesNonBlocking ++; }
-
-	static void LogHostDeviceCopySkipped()
-	{ m_hostDeviceCopiesSkipped ++; }
-
-	//---
-
-	static void LogDeviceHostCopyBlocking()
-	{ m_deviceHostCopiesBlocking ++; }
-
-	static void LogDeviceHostCopyNonBlocking()
-	{ m_deviceHostCopiesNonBlocking ++; }
-
-	static void LogDeviceHostCopySkipped()
-	{ m_deviceHostCopiesSkipped ++; }
-
-	//---
-
-	static void LogDeviceDeviceCopyBlocking()
-	{ m_deviceDeviceCopiesBlocking ++; }
-
-	static void LogDeviceDeviceCopyNonBlocking()
-	{ m_deviceDeviceCopiesNonBlocking ++; }
-
-	static void LogDeviceDeviceCopySkipped()
-	{ m_deviceDeviceCopiesSkipped ++; }
-
-
-	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	// Actual counters
-
-	///@brief Number of blocking copies from the CPU to GPU made with the global transfer queue
-	static std::atomic<int64_t> m_hostDeviceCopiesBlocking;
-
-	///@brief Number of nonblocking copies from the CPU to GPU made as part of a larger command buffer
-	static std::atomic<int64_t> m_hostDeviceCopiesNonBlocking;
-
-	///@brief Number of copies from the CPU to GPU avoided because the data was already resident
-	static std::atomic<int64_t> m_hostDeviceCopiesSkipped;
-
-	//---
-
-	///@brief Number of blocking copies from the GPU to CPU made with the global transfer queue
-	static std::atomic<int64_t> m_deviceHostCopiesBlocking;
-
-	///@brief Number of nonblocking copies from the GPU to CPU made as part of a larger command buffer
-	static std::atomic<int64_t> m_deviceHostCopiesNonBlocking;
-
-	///@brief Number of copies from the CPU to GPU avoided because the data was already resident
-	static std::atomic<int64_t> m_deviceHostCopiesSkipped;
-
-	//---
-
-	///@brief Number of blocking copies from the GPU to GPU made with the global transfer queue
-	static std::atomic<int64_t> m_deviceDeviceCopiesBlocking;
-
-	///@brief Number of nonblocking copies from the GPU to GPU made as part of a larger command buffer
-	static std::atomic<int64_t> m_deviceDeviceCopiesNonBlocking;
-
-	///@brief Number of copies from the GPU to GPU avoided because the data was already resident
-	static std::atomic<int64_t> m_deviceDeviceCopiesSkipped;
-
-	//---
-
-	/*
-	///@brief Number of buffer resize operations requested
-	static std::atomic<int64_t> m_resizeRequests;
-
-	///@brief Number of GPU allocate operations requested
-	static std::atomic<int64_t> m_gpuAllocations;
-	*/
-};
+extern bool g_hasExternalMemoryHost;
+extern size_t g_vkMinImportedHostPointerAlignment;
 
 template<class T>
 class AcceleratorBuffer;
@@ -413,7 +316,10 @@ public:
 
 		//Speed
 		MEM_ATTRIB_CPU_FAST			= 0x10,
-		MEM_ATTRIB_GPU_FAST			= 0x20
+		MEM_ATTRIB_GPU_FAST			= 0x20,
+
+		//Allocation method
+		MEM_ATTRIB_CPU_MAPPED		= 0x40
 	};
 
 	/**
@@ -432,12 +338,22 @@ public:
 		MEM_TYPE_CPU_ONLY =
 			MEM_ATTRIB_CPU_SIDE | MEM_ATTRIB_CPU_REACHABLE | MEM_ATTRIB_CPU_FAST,
 
+		//Same as MEM_TYPE_CPU_ONLY, but a large anonymous mapping placed according to HostMemoryPolicy
+		MEM_TYPE_CPU_LARGE =
+			MEM_ATTRIB_CPU_SIDE | MEM_ATTRIB_CPU_REACHABLE | MEM_ATTRIB_CPU_FAST | MEM_ATTRIB_CPU_MAPPED,
+
 		//Memory is located on the CPU, but can be accessed by the GPU.
 		//Fast to access from the CPU, but accesses from the GPU require PCIe DMA and is slow
 		//(unless platform uses unified memory, in which case g_vulkanDeviceHasUnifiedMemory will be true)
 		MEM_TYPE_CPU_DMA_CAPABLE =
 			MEM_ATTRIB_CPU_SIDE | MEM_ATTRIB_CPU_REACHABLE | MEM_ATTRIB_CPU_FAST | MEM_ATTRIB_GPU_REACHABLE,
 
+		//Same as MEM_TYPE_CPU_DMA_CAPABLE, but a large anonymous mapping placed according to HostMemoryPolicy
+		//and imported into Vulkan with VK_EXT_external_memory_host
+		MEM_TYPE_CPU_DMA_CAPABLE_LARGE =
+			MEM_ATTRIB_CPU_SIDE | MEM_ATTRIB_CPU_REACHABLE | MEM_ATTRIB_CPU_FAST | MEM_ATTRIB_GPU_REACHABLE |
+			MEM_ATTRIB_CPU_MAPPED,
+
 		//Memory is located on the GPU and cannot be directly accessed by the CPU
 		MEM_TYPE_GPU_ONLY =
 			MEM_ATTRIB_GPU_SIDE | MEM_ATTRIB_GPU_REACHABLE | MEM_ATTRIB_GPU_FAST,
@@ -475,6 +391,12 @@ protected:
 	bool IsFastFromGpu(MemoryType mt)
 	{ return (mt & MEM_ATTRIB_GPU_FAST) != 0; }
 
+	/**
+		@brief Returns true if the given buffer type is pinned CPU memory the GPU can access directly
+	 */
+	bool IsPinned(MemoryType mt)
+	{ return (mt == MEM_TYPE_CPU_DMA_CAPABLE) || (mt == MEM_TYPE_CPU_DMA_CAPABLE_LARGE); }
+
 	///@brief Type of the CPU-side buffer
 	MemoryType m_cpuMemoryType;
 
@@ -508,6 +430,9 @@ protected:
 	///@brief True if m_gpuPhysMem contains stale data (m_cpuPtr has been modified and they point to different memory)
 	bool m_gpuPhysMemIsStale;
 
+	///@brief Completion token of asynchronously submitted GPU work which may still be writing this buffer
+	QueueTimelinePoint m_gpuCompletion;
+
 	///@brief File handle used for MEM_TYPE_CPU_PAGED
 #ifndef _WIN32
 	int m_tempFileHandle;
@@ -741,8 +666,6 @@ public:
 
 	/**
 		@brief Copies our content from another AcceleratorBuffer
-
-		TODO perf counters
 	 */
 	 __attribute__((noinline))
 	void CopyFrom(const AcceleratorBuffer<T>& rhs, bool reallocateToMatch = true)
@@ -772,12 +695,13 @@ public:
 		}
 		m_cpuPhysMemIsStale = rhs.m_cpuPhysMemIsStale;
 
-		//Valid data GPU side? Copy it to here
+		//Valid data GPU side? Copy it to here (once it's finished being written)
 		if(rhs.HasGpuBuffer() && !rhs.m_gpuPhysMemIsStale)
 		{
-			std::lock_guard<std::mutex> lock(g_vkTransferMutex);
+			rhs.m_gpuCompletion.Wait();
 
-			AcceleratorBufferPerformanceCounters::LogDeviceDeviceCopyBlocking();
+			double start = GetTime();
+			std::lock_guard<std::mutex> lock(g_vkTransferMutex);
 
 			//Make the transfer request
 			g_vkTransferCommandBuffer->begin({});
@@ -787,6 +711,9 @@ public:
 
 			//Submit the request and block until it completes
 			g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
+
+			AcceleratorBufferPerformanceCounters::LogDeviceDeviceCopyBlocking(
+				m_name, m_size * sizeof(T), GetTime() - start);
 		}
 		else if(rhs.HasGpuBuffer())
 			AcceleratorBufferPerformanceCounters::LogDeviceDeviceCopySkipped();
@@ -795,8 +722,6 @@ public:
 
 	/**
 		@brief Copies our content from another AcceleratorBuffer
-
-		TODO perf counters
 	 */
 	 __attribute__((noinline))
 	void CopyFromNonblocking(
@@ -832,7 +757,7 @@ public:
 		//Valid data GPU side? Copy it to here
 		if(rhs.HasGpuBuffer() && !rhs.m_gpuPhysMemIsStale)
 		{
-			AcceleratorBufferPerformanceCounters::LogDeviceDeviceCopyNonBlocking();
+			AcceleratorBufferPerformanceCounters::LogDeviceDeviceCopyNonBlocking(m_name, m_size * sizeof(T));
 
 			//Add a barrier
 			cmdBuf.pipelineBarrier(
@@ -868,6 +793,8 @@ protected:
 		if(size == 0)
 			return;
 
+		AcceleratorBufferPerformanceCounters::LogReallocate(m_name, size * sizeof(T));
+
 		//We can't have a transfer in progress when we reallocate
 		ClearTransferFlags();
 
@@ -960,7 +887,7 @@ protected:
 			//If GPU access is unlikely, we probably want to just use pinned memory.
 			//If available, mark buffers as the same, and free any existing GPU buffer we might have
 			//Always use pinned memory if the platform has unified memory
-			if( ((m_gpuAccessHint == HINT_UNLIKELY) && (m_cpuMemoryType == MEM_TYPE_CPU_DMA_CAPABLE)) || g_vulkanDeviceHasUnifiedMemory )
+			if( ((m_gpuAccessHint == HINT_UNLIKELY) && IsPinned(m_cpuMemoryType)) || g_vulkanDeviceHasUnifiedMemory )
 				FreeGpuBuffer();
 
 			//Nope, we need to allocate dedicated GPU memory
@@ -976,12 +903,10 @@ protected:
 					//Allocation successful!
 					if(AllocateGpuBuffer(size))
 					{
+						double start = GetTime();
 						std::lock_guard<std::mutex> lock(g_vkTransferMutex);
 
-						AcceleratorBufferPerformanceCounters::LogDeviceDeviceCopyBlocking();
-
 						//Make the transfer request
-						//TODO perf counters
 						g_vkTransferCommandBuffer->begin({});
 						vk::BufferCopy region(0, 0, m_size * sizeof(T));
 						g_vkTransferCommandBuffer->copyBuffer(**bOld, **m_gpuBuffer, {region});
@@ -990,6 +915,9 @@ protected:
 						//Submit the request and block until it completes
 						g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
 
+						AcceleratorBufferPerformanceCounters::LogDeviceDeviceCopyBlocking(
+							m_name, m_size * sizeof(T), GetTime() - start);
+
 						//make sure buffer is freed before underlying physical memory (pOld) goes out of scope
 						bOld = nullptr;
 					}
@@ -1002,7 +930,7 @@ protected:
 						m_gpuBuffer = std::move(bOld);
 
 						//Make sure we have a CPU side buffer that's DMA capable
-						if(m_cpuMemoryType != MEM_TYPE_CPU_DMA_CAPABLE)
+						if(!IsPinned(m_cpuMemoryType))
 						{
 							SetCpuAccessHint(HINT_LIKELY);
 							SetGpuAccessHint(HINT_LIKELY);
@@ -1054,7 +982,7 @@ protected:
 
 		//If we have a pinned buffer and nothing on the other side, there's a single shared physical memory region
 		m_buffersAreSame =
-			( (m_cpuMemoryType == MEM_TYPE_CPU_DMA_CAPABLE) && (m_gpuMemoryType == MEM_TYPE_NULL) ) ||
+			( IsPinned(m_cpuMemoryType) && (m_gpuMemoryType == MEM_TYPE_NULL) ) ||
 			( (m_cpuMemoryType == MEM_TYPE_NULL) && (m_gpuMemoryType == MEM_TYPE_GPU_DMA_CAPABLE) );
 	}
 
@@ -1224,6 +1152,25 @@ public:
 			Reallocate(m_size);
 	}
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Asynchronous GPU work
+
+	/**
+		@brief Records that this buffer is being written by GPU work which may still be executing
+
+		Set when the command buffer writing this buffer was submitted with QueueHandle::SubmitAsync(). CPU access via
+		PrepareForCpuAccess() blocks until the work has completed. GPU consumers on other queues wait for it on the
+		device side with QueueHandle::AddWait().
+
+		@param point	Completion token of the submission writing this buffer
+	 */
+	void SetGpuCompletion(const QueueTimelinePoint& point)
+	{ m_gpuCompletion = point; }
+
+	///@brief Returns the completion token of the GPU work writing this buffer (invalid if none)
+	const QueueTimelinePoint& GetGpuCompletion() const
+	{ return m_gpuCompletion; }
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Cache invalidation
 
@@ -1273,6 +1220,9 @@ public:
 		if(m_size == 0)
 			return;
 
+		//Let any asynchronous GPU work writing the buffer finish first
+		m_gpuCompletion.Wait();
+
 		//If there's no buffer at all on the CPU, allocate one
 		if(!HasCpuBuffer() && (m_gpuMemoryType != MEM_TYPE_GPU_DMA_CAPABLE))
 			AllocateCpuBuffer(m_capacity);
@@ -1295,6 +1245,8 @@ public:
 		if(m_size == 0)
 			return;
 
+		m_gpuCompletion.Wait();
+
 		//If there's no buffer at all on the CPU, allocate one
 		if(!HasCpuBuffer() && (m_gpuMemoryType != MEM_TYPE_GPU_DMA_CAPABLE))
 			AllocateCpuBuffer(m_capacity);
@@ -1328,6 +1280,9 @@ public:
 		if(m_size == 0)
 			return;
 
+		//We don't need the GPU's data, but mustn't write while it's still writing
+		m_gpuCompletion.Wait();
+
 		//If there's no buffer at all on the CPU, allocate one
 		if(!HasCpuBuffer() && (m_gpuMemoryType != MEM_TYPE_GPU_DMA_CAPABLE))
 			AllocateCpuBuffer(m_capacity);
@@ -1378,7 +1333,7 @@ public:
 			SetGpuAccessHint(HINT_UNLIKELY, true);
 
 		//If we don't have a buffer, allocate one unless our CPU buffer is pinned and GPU-readable
-		if(!HasGpuBuffer() && (m_cpuMemoryType != MEM_TYPE_CPU_DMA_CAPABLE) )
+		if(!HasGpuBuffer() && !IsPinned(m_cpuMemoryType) )
 		{
 			if(!AllocateGpuBuffer(m_capacity))
 				return;
@@ -1410,7 +1365,7 @@ public:
 			SetGpuAccessHint(HINT_UNLIKELY, true);
 
 		//If we don't have a buffer, allocate one unless our CPU buffer is pinned and GPU-readable
-		if(!HasGpuBuffer() && (m_cpuMemoryType != MEM_TYPE_CPU_DMA_CAPABLE) )
+		if(!HasGpuBuffer() && !IsPinned(m_cpuMemoryType) )
 		{
 			if(!AllocateGpuBuffer(m_capacity))
 				return;
@@ -1435,8 +1390,10 @@ protected:
 	{
 		assert(std::is_trivially_copyable<T>::value);
 
-		AcceleratorBufferPerformanceCounters::LogDeviceHostCopyBlocking();
+		//The transfer queue doesn't know about the timeline, so wait for the data to be written on the CPU
+		m_gpuCompletion.Wait();
 
+		double start = GetTime();
 		std::lock_guard<std::mutex> lock(g_vkTransferMutex);
 
 		//Make the transfer request
@@ -1463,6 +1420,8 @@ protected:
 		g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
 
 		m_cpuPhysMemIsStale = false;
+
+		AcceleratorBufferPerformanceCounters::LogDeviceHostCopyBlocking(m_name, m_size * sizeof(T), GetTime() - start);
 	}
 
 	/**
@@ -1472,8 +1431,9 @@ protected:
 	{
 		assert(std::is_trivially_copyable<T>::value);
 
-		AcceleratorBufferPerformanceCounters::LogDeviceHostCopyBlocking();
+		m_gpuCompletion.Wait();
 
+		double start = GetTime();
 		std::lock_guard<std::mutex> lock(g_vkTransferMutex);
 
 		//Make the transfer request
@@ -1501,6 +1461,8 @@ protected:
 		g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
 
 		//do NOT modify m_cpuPhysMemIsStale, since the rest of the buffer is still stale
+
+		AcceleratorBufferPerformanceCounters::LogDeviceHostCopyBlocking(m_name, 2 * sizeof(T), GetTime() - start);
 	}
 
 	/**
@@ -1510,7 +1472,7 @@ protected:
 	{
 		assert(std::is_trivially_copyable<T>::value);
 
-		AcceleratorBufferPerformanceCounters::LogDeviceHostCopyNonBlocking();
+		AcceleratorBufferPerformanceCounters::LogDeviceHostCopyNonBlocking(m_name, m_size * sizeof(T));
 
 		//Add a barrier just in case a shader is still writing to it
 		if(!skipBarrier)
@@ -1545,8 +1507,7 @@ protected:
 	{
 		assert(std::is_trivially_copyable<T>::value);
 
-		AcceleratorBufferPerformanceCounters::LogHostDeviceCopyBlocking();
-
+		double start = GetTime();
 		std::lock_guard<std::mutex> lock(g_vkTransferMutex);
 
 		//Make the transfer request
@@ -1564,6 +1525,8 @@ protected:
 		g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
 
 		m_gpuPhysMemIsStale = false;
+
+		AcceleratorBufferPerformanceCounters::LogHostDeviceCopyBlocking(m_name, m_size * sizeof(T), GetTime() - start);
 	}
 
 
@@ -1576,7 +1539,7 @@ protected:
 	{
 		assert(std::is_trivially_copyable<T>::value);
 
-		AcceleratorBufferPerformanceCounters::LogHostDeviceCopyNonBlocking();
+		AcceleratorBufferPerformanceCounters::LogHostDeviceCopyNonBlocking(m_name, m_size * sizeof(T));
 
 		//Make the transfer request
 		vk::BufferCopy region(0, 0, m_size * sizeof(T));
@@ -1704,40 +1667,55 @@ protected:
 		//If any GPU access is expected, use pinned memory so we don't have to move things around
 		if(m_gpuAccessHint != HINT_NEVER)
 		{
-			//Make a Vulkan buffer first
-			vk::BufferCreateInfo bufinfo(
-				{},
-				size * sizeof(T),
-				vk::BufferUsageFlagBits::eTransferSrc |
-					vk::BufferUsageFlagBits::eTransferDst |
-					vk::BufferUsageFlagBits::eStorageBuffer);
-			m_cpuBuffer = std::make_unique<vk::raii::Buffer>(*g_vkComputeDevice, bufinfo);
-
-			//Figure out actual memory requirements of the buffer
-			//(may be rounded up from what we asked for)
-			auto req = m_cpuBuffer->getMemoryRequirements();
-
-			//Allocate the physical memory to back the buffer
-			vk::MemoryAllocateInfo info(req.size, g_vkPinnedMemoryType);
-			m_cpuPhysMem = std::make_unique<vk::raii::DeviceMemory>(*g_vkComputeDevice, info);
-
-			//Map it and bind to the buffer
-			m_cpuPtr = reinterpret_cast<T*>(m_cpuPhysMem->mapMemory(0, req.size));
-			m_cpuBuffer->bindMemory(**m_cpuPhysMem, 0);
-
-			//We now have pinned memory
-			m_cpuMemoryType = MEM_TYPE_CPU_DMA_CAPABLE;
-
-			if(g_hasDebugUtils)
-				UpdateCpuNames();
+			//Very large buffers get hugepage backing and NUMA placement if we can import our own allocation,
+			//otherwise the driver allocates it
+			if(!AllocateImportedPinnedBuffer(size))
+			{
+				//Make a Vulkan buffer first
+				vk::BufferCreateInfo bufinfo(
+					{},
+					size * sizeof(T),
+					vk::BufferUsageFlagBits::eTransferSrc |
+						vk::BufferUsageFlagBits::eTransferDst |
+						vk::BufferUsageFlagBits::eStorageBuffer);
+				m_cpuBuffer = std::make_unique<vk::raii::Buffer>(*g_vkComputeDevice, bufinfo);
+
+				//Figure out actual memory requirements of the buffer
+				//(may be rounded up from what we asked for)
+				auto req = m_cpuBuffer->getMemoryRequirements();
+
+				//Allocate the physical memory to back the buffer
+				vk::MemoryAllocateInfo info(req.size, g_vkPinnedMemoryType);
+				m_cpuPhysMem = std::make_unique<vk::raii::DeviceMemory>(*g_vkComputeDevice, info);
+
+				//Map it and bind to the buffer
+				m_cpuPtr = reinterpret_cast<T*>(m_cpuPhysMem->mapMemory(0, req.size));
+				m_cpuBuffer->bindMemory(**m_cpuPhysMem, 0);
+
+				//We now have pinned memory
+				m_cpuMemoryType = MEM_TYPE_CPU_DMA_CAPABLE;
+
+				if(g_hasDebugUtils)
+					UpdateCpuNames();
+			}
 		}
 
 		//If frequent CPU access is expected, use normal host memory
 		else if(m_cpuAccessHint == HINT_LIKELY)
 		{
 			m_cpuBuffer = nullptr;
-			m_cpuMemoryType = MEM_TYPE_CPU_ONLY;
-			m_cpuPtr = m_cpuAllocator.allocate(size);
+
+			//Very large buffers get hugepage backing and NUMA placement
+			if(HostMemoryPolicy::IsLargeAllocation(size * sizeof(T)))
+			{
+				m_cpuMemoryType = MEM_TYPE_CPU_LARGE;
+				m_cpuPtr = reinterpret_cast<T*>(HostMemoryPolicy::AllocateLarge(size * sizeof(T)));
+			}
+			else
+			{
+				m_cpuMemoryType = MEM_TYPE_CPU_ONLY;
+				m_cpuPtr = m_cpuAllocator.allocate(size);
+			}
 		}
 
 		//If infrequent CPU access is expected, use a memory mapped temporary file so it can be paged out to disk
@@ -1788,6 +1766,8 @@ protected:
 					abort();
 				}
 				m_cpuMemoryType = MEM_TYPE_CPU_PAGED;
+				HostMemoryPolicy::ApplyToFileMapping(m_cpuPtr, bytesize);
+				AcceleratorBufferPerformanceCounters::LogPagedAllocation(m_name, bytesize);
 
 				//Delete it (file will be removed by the OS after our active handle is closed)
 				if(0 != unlink(fname))
@@ -1829,6 +1809,7 @@ protected:
 				break;
 
 			case MEM_TYPE_CPU_DMA_CAPABLE:
+			case MEM_TYPE_CPU_DMA_CAPABLE_LARGE:
 				LogFatal("FreeCpuPointer for MEM_TYPE_CPU_DMA_CAPABLE requires the vk::raii::DeviceMemory\n");
 				break;
 
@@ -1837,6 +1818,7 @@ protected:
 					munmap(ptr, size * sizeof(T));
 					close(m_tempFileHandle);
 					m_tempFileHandle = -1;
+					AcceleratorBufferPerformanceCounters::LogPagedFree(size * sizeof(T));
 				#endif
 				break;
 
@@ -1844,11 +1826,88 @@ protected:
 				m_cpuAllocator.deallocate(ptr, size);
 				break;
 
+			case MEM_TYPE_CPU_LARGE:
+				HostMemoryPolicy::FreeLarge(ptr, size * sizeof(T));
+				break;
+
 			default:
 				LogFatal("FreeCpuPointer: invalid type %x\n", type);
 		}
 	}
 
+	/**
+		@brief Allocates a large pinned buffer with HostMemoryPolicy and imports it into Vulkan
+
+		@return False if the buffer is too small for the policy to apply or the import isn't possible, in which case
+		the caller should fall back to a normal pinned allocation
+	 */
+	bool AllocateImportedPinnedBuffer(size_t size)
+	{
+		size_t bytesize = size * sizeof(T);
+		if(!g_hasExternalMemoryHost || !HostMemoryPolicy::IsLargeAllocation(bytesize))
+			return false;
+
+		//Mappings are rounded up to a multiple of 2 MB so this is only an issue for weird alignment requirements
+		size_t mapsize = HostMemoryPolicy::GetMappingSize(bytesize);
+		if( (mapsize % g_vkMinImportedHostPointerAlignment) != 0)
+			return false;
+
+		void* ptr = HostMemoryPolicy::AllocateLarge(bytesize);
+		if( (reinterpret_cast<uintptr_t>(ptr) % g_vkMinImportedHostPointerAlignment) != 0)
+		{
+			HostMemoryPolicy::FreeLarge(ptr, bytesize);
+			return false;
+		}
+
+		try
+		{
+			//Make sure the driver can import it as our pinned memory type
+			auto handleType = vk::ExternalMemoryHandleTypeFlagBits::eHostAllocationEXT;
+			auto props = g_vkComputeDevice->getMemoryHostPointerPropertiesEXT(handleType, ptr);
+			if( (props.memoryTypeBits & (1 << g_vkPinnedMemoryType)) == 0)
+			{
+				HostMemoryPolicy::FreeLarge(ptr, bytesize);
+				return false;
+			}
+
+			vk::ExternalMemoryBufferCreateInfo extinfo(handleType);
+			vk::BufferCreateInfo bufinfo(
+				{},
+				bytesize,
+				vk::BufferUsageFlagBits::eTransferSrc |
+					vk::BufferUsageFlagBits::eTransferDst |
+					vk::BufferUsageFlagBits::eStorageBuffer);
+			bufinfo.setPNext(&extinfo);
+			auto buf = std::make_unique<vk::raii::Buffer>(*g_vkComputeDevice, bufinfo);
+			if(buf->getMemoryRequirements().size > mapsize)
+			{
+				buf = nullptr;
+				HostMemoryPolicy::FreeLarge(ptr, bytesize);
+				return false;
+			}
+
+			vk::ImportMemoryHostPointerInfoEXT importInfo(handleType, ptr);
+			vk::MemoryAllocateInfo info(mapsize, g_vkPinnedMemoryType, &importInfo);
+			m_cpuPhysMem = std::make_unique<vk::raii::DeviceMemory>(*g_vkComputeDevice, info);
+			buf->bindMemory(**m_cpuPhysMem, 0);
+			m_cpuBuffer = std::move(buf);
+		}
+		catch(const vk::SystemError& e)
+		{
+			LogDebug("Importing a %zu byte pinned buffer failed (%s), using driver allocation\n", mapsize, e.what());
+			m_cpuPhysMem = nullptr;
+			HostMemoryPolicy::FreeLarge(ptr, bytesize);
+			return false;
+		}
+
+		m_cpuPtr = reinterpret_cast<T*>(ptr);
+		m_cpuMemoryType = MEM_TYPE_CPU_DMA_CAPABLE_LARGE;
+
+		if(g_hasDebugUtils)
+			UpdateCpuNames();
+		return true;
+	}
+
 	/**
 		@brief Frees a CPU-side physical memory block
 
@@ -1865,6 +1924,12 @@ protected:
 				buf->unmapMemory();
 				break;
 
+			//Release the imported memory before unmapping the host allocation backing it
+			case MEM_TYPE_CPU_DMA_CAPABLE_LARGE:
+				buf = nullptr;
+				HostMemoryPolicy::FreeLarge(ptr, size * sizeof(T));
+				break;
+
 			default:
 				FreeCpuPointer(ptr, type, size);
 		}
@@ -0,0 +1,531 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of AcceleratorBufferPerformanceCounters
+	@ingroup core
+ */
+
+#include "scopehal.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static variables
+
+atomic<int64_t> AcceleratorBufferPerformanceCounters::m_hostDeviceCopiesBlocking;
+atomic<int64_t> AcceleratorBufferPerformanceCounters::m_hostDeviceCopiesNonBlocking;
+atomic<int64_t> AcceleratorBufferPerformanceCounters::m_hostDeviceCopiesSkipped;
+
+atomic<int64_t> AcceleratorBufferPerformanceCounters::m_deviceHostCopiesBlocking;
+atomic<int64_t> AcceleratorBufferPerformanceCounters::m_deviceHostCopiesNonBlocking;
+atomic<int64_t> AcceleratorBufferPerformanceCounters::m_deviceHostCopiesSkipped;
+
+atomic<int64_t> AcceleratorBufferPerformanceCounters::m_deviceDeviceCopiesBlocking;
+atomic<int64_t> AcceleratorBufferPerformanceCounters::m_deviceDeviceCopiesNonBlocking;
+atomic<int64_t> AcceleratorBufferPerformanceCounters::m_deviceDeviceCopiesSkipped;
+
+atomic<int64_t> AcceleratorBufferPerformanceCounters::m_pagedBytesLive;
+atomic<int64_t> AcceleratorBufferPerformanceCounters::m_pagedBuffersLive;
+atomic<int64_t> AcceleratorBufferPerformanceCounters::m_pagedFrees;
+
+atomic<bool> AcceleratorBufferPerformanceCounters::m_perBufferStatsEnabled(false);
+mutex AcceleratorBufferPerformanceCounters::m_statsMutex;
+AcceleratorBufferAtomicStats AcceleratorBufferPerformanceCounters::m_totals;
+map<string, AcceleratorBufferStats> AcceleratorBufferPerformanceCounters::m_buffers;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AcceleratorBufferTransferStats
+
+AcceleratorBufferTransferStats& AcceleratorBufferTransferStats::operator-=(const AcceleratorBufferTransferStats& rhs)
+{
+	m_blockingCount -= rhs.m_blockingCount;
+	m_nonblockingCount -= rhs.m_nonblockingCount;
+	m_bytes -= rhs.m_bytes;
+	m_blockingTime -= rhs.m_blockingTime;
+	m_sizeHistogram -= rhs.m_sizeHistogram;
+	m_latencyHistogram -= rhs.m_latencyHistogram;
+	return *this;
+}
+
+AcceleratorBufferTransferStats& AcceleratorBufferTransferStats::operator+=(const AcceleratorBufferTransferStats& rhs)
+{
+	m_blockingCount += rhs.m_blockingCount;
+	m_nonblockingCount += rhs.m_nonblockingCount;
+	m_bytes += rhs.m_bytes;
+	m_blockingTime += rhs.m_blockingTime;
+	m_sizeHistogram += rhs.m_sizeHistogram;
+	m_latencyHistogram += rhs.m_latencyHistogram;
+	return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AcceleratorBufferStats
+
+AcceleratorBufferStats& AcceleratorBufferStats::operator-=(const AcceleratorBufferStats& rhs)
+{
+	m_hostDevice -= rhs.m_hostDevice;
+	m_deviceHost -= rhs.m_deviceHost;
+	m_deviceDevice -= rhs.m_deviceDevice;
+	m_reallocations -= rhs.m_reallocations;
+	m_reallocatedBytes -= rhs.m_reallocatedBytes;
+	m_pagedAllocations -= rhs.m_pagedAllocations;
+	m_pagedBytes -= rhs.m_pagedBytes;
+	return *this;
+}
+
+AcceleratorBufferStats& AcceleratorBufferStats::operator+=(const AcceleratorBufferStats& rhs)
+{
+	m_hostDevice += rhs.m_hostDevice;
+	m_deviceHost += rhs.m_deviceHost;
+	m_deviceDevice += rhs.m_deviceDevice;
+	m_reallocations += rhs.m_reallocations;
+	m_reallocatedBytes += rhs.m_reallocatedBytes;
+	m_pagedAllocations += rhs.m_pagedAllocations;
+	m_pagedBytes += rhs.m_pagedBytes;
+	return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AcceleratorBufferAtomicTransferStats
+
+void AcceleratorBufferAtomicTransferStats::Add(size_t bytes, bool blocking, double latency)
+{
+	if(blocking)
+	{
+		m_blockingCount.fetch_add(1, memory_order_relaxed);
+		m_blockingTimeNs.fetch_add(static_cast<uint64_t>(latency * 1e9), memory_order_relaxed);
+		m_latencyBins[AcceleratorBufferLog2Histogram::GetBin(latency * 1e6)].fetch_add(1, memory_order_relaxed);
+	}
+	else
+		m_nonblockingCount.fetch_add(1, memory_order_relaxed);
+
+	m_bytes.fetch_add(bytes, memory_order_relaxed);
+	m_sizeBins[AcceleratorBufferLog2Histogram::GetBin(bytes)].fetch_add(1, memory_order_relaxed);
+}
+
+void AcceleratorBufferAtomicTransferStats::Reset()
+{
+	m_blockingCount = 0;
+	m_nonblockingCount = 0;
+	m_bytes = 0;
+	m_blockingTimeNs = 0;
+	for(size_t i=0; i<AcceleratorBufferLog2Histogram::NUM_BINS; i++)
+	{
+		m_sizeBins[i] = 0;
+		m_latencyBins[i] = 0;
+	}
+}
+
+/**
+	@brief Copies the current totals
+
+	Fields are read one at a time, so a transfer logged concurrently may be only partially included.
+ */
+AcceleratorBufferTransferStats AcceleratorBufferAtomicTransferStats::Load() const
+{
+	AcceleratorBufferTransferStats ret;
+	ret.m_blockingCount = m_blockingCount.load(memory_order_relaxed);
+	ret.m_nonblockingCount = m_nonblockingCount.load(memory_order_relaxed);
+	ret.m_bytes = m_bytes.load(memory_order_relaxed);
+	ret.m_blockingTime = m_blockingTimeNs.load(memory_order_relaxed) * 1e-9;
+	for(size_t i=0; i<AcceleratorBufferLog2Histogram::NUM_BINS; i++)
+	{
+		ret.m_sizeHistogram.m_bins[i] = m_sizeBins[i].load(memory_order_relaxed);
+		ret.m_latencyHistogram.m_bins[i] = m_latencyBins[i].load(memory_order_relaxed);
+	}
+	return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AcceleratorBufferAtomicStats
+
+void AcceleratorBufferAtomicStats::Reset()
+{
+	m_hostDevice.Reset();
+	m_deviceHost.Reset();
+	m_deviceDevice.Reset();
+	m_reallocations = 0;
+	m_reallocatedBytes = 0;
+	m_pagedAllocations = 0;
+	m_pagedBytes = 0;
+}
+
+AcceleratorBufferStats AcceleratorBufferAtomicStats::Load() const
+{
+	AcceleratorBufferStats ret;
+	ret.m_hostDevice = m_hostDevice.Load();
+	ret.m_deviceHost = m_deviceHost.Load();
+	ret.m_deviceDevice = m_deviceDevice.Load();
+	ret.m_reallocations = m_reallocations.load(memory_order_relaxed);
+	ret.m_reallocatedBytes = m_reallocatedBytes.load(memory_order_relaxed);
+	ret.m_pagedAllocations = m_pagedAllocations.load(memory_order_relaxed);
+	ret.m_pagedBytes = m_pagedBytes.load(memory_order_relaxed);
+	return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AcceleratorBufferPerformanceSnapshot
+
+/**
+	@brief Calculates what happened between two snapshots
+
+	Buffers present in this snapshot but not in rhs are reported in full. Buffers with no activity in the interval
+	are dropped from the result.
+
+	@param rhs	The earlier snapshot
+ */
+AcceleratorBufferPerformanceSnapshot AcceleratorBufferPerformanceSnapshot::operator-(
+	const AcceleratorBufferPerformanceSnapshot& rhs) const
+{
+	AcceleratorBufferPerformanceSnapshot ret;
+	ret.m_timestamp = m_timestamp - rhs.m_timestamp;
+
+	ret.m_totals = m_totals;
+	ret.m_totals -= rhs.m_totals;
+
+	for(auto& it : m_buffers)
+	{
+		auto stats = it.second;
+		auto jt = rhs.m_buffers.find(it.first);
+		if(jt != rhs.m_buffers.end())
+			stats -= jt->second;
+
+		if( (stats.m_hostDevice.GetCount() == 0) &&
+			(stats.m_deviceHost.GetCount() == 0) &&
+			(stats.m_deviceDevice.GetCount() == 0) &&
+			(stats.m_reallocations == 0) &&
+			(stats.m_pagedAllocations == 0) )
+		{
+			continue;
+		}
+
+		ret.m_buffers[it.first] = stats;
+	}
+
+	//Live paging usage is a level, not a counter, so report the current value
+	ret.m_pagedBytesLive = m_pagedBytesLive;
+	ret.m_pagedBuffersLive = m_pagedBuffersLive;
+	ret.m_pagedFrees = m_pagedFrees - rhs.m_pagedFrees;
+
+	ret.m_skippedHostDevice = m_skippedHostDevice - rhs.m_skippedHostDevice;
+	ret.m_skippedDeviceHost = m_skippedDeviceHost - rhs.m_skippedDeviceHost;
+	ret.m_skippedDeviceDevice = m_skippedDeviceDevice - rhs.m_skippedDeviceDevice;
+
+	return ret;
+}
+
+/**
+	@brief Gets the names of all buffers which were copied in both directions between CPU and GPU, most traffic first
+ */
+vector<string> AcceleratorBufferPerformanceSnapshot::GetPingPongBuffers() const
+{
+	vector< pair<uint64_t, string> > hits;
+	for(auto& it : m_buffers)
+	{
+		if(it.second.IsPingPong())
+			hits.push_back(pair<uint64_t, string>(it.second.GetHostDeviceTrafficBytes(), it.first));
+	}
+	sort(hits.rbegin(), hits.rend());
+
+	vector<string> ret;
+	for(auto& h : hits)
+		ret.push_back(h.second);
+	return ret;
+}
+
+/**
+	@brief Prints the snapshot to the debug log
+ */
+void AcceleratorBufferPerformanceSnapshot::Dump() const
+{
+	Unit bytes(Unit::UNIT_BYTES);
+	Unit fs(Unit::UNIT_FS);
+
+	LogDebug("AcceleratorBuffer performance counters\n");
+	LogIndenter li;
+
+	auto dumpDirection = [&](const char* label, const AcceleratorBufferTransferStats& s)
+	{
+		if(s.GetCount() == 0)
+			return;
+
+		LogDebug("%-14s %8" PRIu64 " blocking, %8" PRIu64 " nonblocking, %10s, %10s blocked\n",
+			label,
+			s.m_blockingCount,
+			s.m_nonblockingCount,
+			bytes.PrettyPrint(s.m_bytes).c_str(),
+			fs.PrettyPrint(s.m_blockingTime * FS_PER_SECOND).c_str());
+	};
+
+	auto dumpStats = [&](const AcceleratorBufferStats& s)
+	{
+		LogIndenter li2;
+		dumpDirection("Host->device", s.m_hostDevice);
+		dumpDirection("Device->host", s.m_deviceHost);
+		dumpDirection("Device->device", s.m_deviceDevice);
+		if(s.m_reallocations)
+		{
+			LogDebug("Reallocations  %8" PRIu64 " (%s)\n",
+				s.m_reallocations, bytes.PrettyPrint(s.m_reallocatedBytes).c_str());
+		}
+		if(s.m_pagedAllocations)
+		{
+			LogDebug("Paged allocs   %8" PRIu64 " (%s)\n",
+				s.m_pagedAllocations, bytes.PrettyPrint(s.m_pagedBytes).c_str());
+		}
+	};
+
+	LogDebug("Totals\n");
+	dumpStats(m_totals);
+	{
+		LogIndenter li2;
+		LogDebug("Skipped copies: %" PRIu64 " host->device, %" PRIu64 " device->host, %" PRIu64 " device->device\n",
+			m_skippedHostDevice,
+			m_skippedDeviceHost,
+			m_skippedDeviceDevice);
+		LogDebug("Paged memory:   %" PRIi64 " buffers live (%s), %" PRIu64 " freed\n",
+			m_pagedBuffersLive,
+			bytes.PrettyPrint(m_pagedBytesLive).c_str(),
+			m_pagedFrees);
+	}
+
+	//Print per-buffer stats, worst offenders first
+	vector< pair<uint64_t, string> > order;
+	for(auto& it : m_buffers)
+		order.push_back(pair<uint64_t, string>(it.second.GetHostDeviceTrafficBytes(), it.first));
+	sort(order.rbegin(), order.rend());
+
+	for(auto& o : order)
+	{
+		auto& s = m_buffers.at(o.second);
+		LogDebug("%s%s\n", o.second.c_str(), s.IsPingPong() ? " (ping-pong)" : "");
+		dumpStats(s);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AcceleratorBufferPerformanceCounters
+
+/**
+	@brief Clears all counters
+ */
+void AcceleratorBufferPerformanceCounters::Reset()
+{
+	m_hostDeviceCopiesBlocking.store(0);
+	m_hostDeviceCopiesNonBlocking.store(0);
+	m_hostDeviceCopiesSkipped.store(0);
+
+	m_deviceHostCopiesBlocking.store(0);
+	m_deviceHostCopiesNonBlocking.store(0);
+	m_deviceHostCopiesSkipped.store(0);
+
+	m_deviceDeviceCopiesBlocking.store(0);
+	m_deviceDeviceCopiesNonBlocking.store(0);
+	m_deviceDeviceCopiesSkipped.store(0);
+
+	//don't reset live paging usage, that's a level not a counter
+	m_pagedFrees.store(0);
+
+	m_totals.Reset();
+
+	lock_guard<mutex> lock(m_statsMutex);
+	m_buffers.clear();
+}
+
+/**
+	@brief Turns on or off breaking statistics out by buffer name
+
+	This costs a map lookup per transfer so is off by default. Global totals are always collected.
+ */
+void AcceleratorBufferPerformanceCounters::EnablePerBufferStats(bool enable)
+{
+	m_perBufferStatsEnabled = enable;
+}
+
+/**
+	@brief Gets a copy of the current state of all counters
+ */
+AcceleratorBufferPerformanceSnapshot AcceleratorBufferPerformanceCounters::GetSnapshot()
+{
+	AcceleratorBufferPerformanceSnapshot ret;
+	ret.m_timestamp = GetTime();
+	ret.m_pagedBytesLive = m_pagedBytesLive;
+	ret.m_pagedBuffersLive = m_pagedBuffersLive;
+	ret.m_pagedFrees = m_pagedFrees;
+	ret.m_skippedHostDevice = m_hostDeviceCopiesSkipped;
+	ret.m_skippedDeviceHost = m_deviceHostCopiesSkipped;
+	ret.m_skippedDeviceDevice = m_deviceDeviceCopiesSkipped;
+
+	ret.m_totals = m_totals.Load();
+
+	lock_guard<mutex> lock(m_statsMutex);
+	ret.m_buffers = m_buffers;
+	return ret;
+}
+
+/**
+	@brief Gets the per-buffer statistics for a given buffer. Caller must hold m_statsMutex.
+ */
+AcceleratorBufferStats& AcceleratorBufferPerformanceCounters::GetStatsForName(const string& name)
+{
+	if(name.empty())
+		return m_buffers["(unnamed)"];
+	return m_buffers[name];
+}
+
+void AcceleratorBufferPerformanceCounters::LogHostDeviceCopyBlocking(const string& name, size_t bytes, double latency)
+{
+	m_hostDeviceCopiesBlocking ++;
+	m_totals.m_hostDevice.Add(bytes, true, latency);
+
+	if(IsPerBufferStatsEnabled())
+	{
+		lock_guard<mutex> lock(m_statsMutex);
+		GetStatsForName(name).m_hostDevice.Add(bytes, true, latency);
+	}
+}
+
+void AcceleratorBufferPerformanceCounters::LogHostDeviceCopyNonBlocking(const string& name, size_t bytes)
+{
+	m_hostDeviceCopiesNonBlocking ++;
+	m_totals.m_hostDevice.Add(bytes, false, 0);
+
+	if(IsPerBufferStatsEnabled())
+	{
+		lock_guard<mutex> lock(m_statsMutex);
+		GetStatsForName(name).m_hostDevice.Add(bytes, false, 0);
+	}
+}
+
+void AcceleratorBufferPerformanceCounters::LogDeviceHostCopyBlocking(const string& name, size_t bytes, double latency)
+{
+	m_deviceHostCopiesBlocking ++;
+	m_totals.m_deviceHost.Add(bytes, true, latency);
+
+	if(IsPerBufferStatsEnabled())
+	{
+		lock_guard<mutex> lock(m_statsMutex);
+		GetStatsForName(name).m_deviceHost.Add(bytes, true, latency);
+	}
+}
+
+void AcceleratorBufferPerformanceCounters::LogDeviceHostCopyNonBlocking(const string& name, size_t bytes)
+{
+	m_deviceHostCopiesNonBlocking ++;
+	m_totals.m_deviceHost.Add(bytes, false, 0);
+
+	if(IsPerBufferStatsEnabled())
+	{
+		lock_guard<mutex> lock(m_statsMutex);
+		GetStatsForName(name).m_deviceHost.Add(bytes, false, 0);
+	}
+}
+
+void AcceleratorBufferPerformanceCounters::LogDeviceDeviceCopyBlocking(const string& name, size_t bytes, double latency)
+{
+	m_deviceDeviceCopiesBlocking ++;
+	m_totals.m_deviceDevice.Add(bytes, true, latency);
+
+	if(IsPerBufferStatsEnabled())
+	{
+		lock_guard<mutex> lock(m_statsMutex);
+		GetStatsForName(name).m_deviceDevice.Add(bytes, true, latency);
+	}
+}
+
+void AcceleratorBufferPerformanceCounters::LogDeviceDeviceCopyNonBlocking(const string& name, size_t bytes)
+{
+	m_deviceDeviceCopiesNonBlocking ++;
+	m_totals.m_deviceDevice.Add(bytes, false, 0);
+
+	if(IsPerBufferStatsEnabled())
+	{
+		lock_guard<mutex> lock(m_statsMutex);
+		GetStatsForName(name).m_deviceDevice.Add(bytes, false, 0);
+	}
+}
+
+/**
+	@brief Records a call to AcceleratorBuffer::Reallocate()
+
+	@param name		Name of the buffer
+	@param bytes	New capacity of the buffer, in bytes
+ */
+void AcceleratorBufferPerformanceCounters::LogReallocate(const string& name, size_t bytes)
+{
+	m_totals.m_reallocations.fetch_add(1, memory_order_relaxed);
+	m_totals.m_reallocatedBytes.fetch_add(bytes, memory_order_relaxed);
+
+	if(IsPerBufferStatsEnabled())
+	{
+		lock_guard<mutex> lock(m_statsMutex);
+		auto& stats = GetStatsForName(name);
+		stats.m_reallocations ++;
+		stats.m_reallocatedBytes += bytes;
+	}
+}
+
+/**
+	@brief Records creation of a CPU-side buffer backed by a memory mapped temporary file
+
+	@param name		Name of the buffer
+	@param bytes	Size of the mapping, in bytes
+ */
+void AcceleratorBufferPerformanceCounters::LogPagedAllocation(const string& name, size_t bytes)
+{
+	m_pagedBuffersLive ++;
+	m_pagedBytesLive += bytes;
+
+	m_totals.m_pagedAllocations.fetch_add(1, memory_order_relaxed);
+	m_totals.m_pagedBytes.fetch_add(bytes, memory_order_relaxed);
+
+	if(IsPerBufferStatsEnabled())
+	{
+		lock_guard<mutex> lock(m_statsMutex);
+		auto& stats = GetStatsForName(name);
+		stats.m_pagedAllocations ++;
+		stats.m_pagedBytes += bytes;
+	}
+}
+
+/**
+	@brief Records unmapping of a temporary file backed buffer
+
+	@param bytes	Size of the mapping, in bytes
+ */
+void AcceleratorBufferPerformanceCounters::LogPagedFree(size_t bytes)
+{
+	m_pagedBuffersLive --;
+	m_pagedBytesLive -= bytes;
+	m_pagedFrees ++;
+}
@@ -0,0 +1,461 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of AcceleratorBufferPerformanceCounters
+	@ingroup core
+ */
+#ifndef AcceleratorBufferPerformanceCounters_h
+#define AcceleratorBufferPerformanceCounters_h
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+	@brief Histogram with power-of-two bin widths
+
+	Bin 0 holds values 0 and 1, bin N holds values in [2^N, 2^(N+1) ), the last bin holds everything larger.
+
+	@ingroup core
+ */
+class AcceleratorBufferLog2Histogram
+{
+public:
+	AcceleratorBufferLog2Histogram()
+	: m_bins{}
+	{}
+
+	///@brief Number of bins in the histogram
+	static const size_t NUM_BINS = 48;
+
+	///@brief Adds a value to the histogram
+	void Add(uint64_t value)
+	{ m_bins[GetBin(value)] ++; }
+
+	///@brief Gets the bin a value belongs in
+	static size_t GetBin(uint64_t value)
+	{
+		if(value <= 1)
+			return 0;
+		size_t bin = 63 - __builtin_clzll(value);
+		if(bin >= NUM_BINS)
+			bin = NUM_BINS - 1;
+		return bin;
+	}
+
+	///@brief Gets the smallest value counted in a bin
+	static uint64_t GetBinLowerBound(size_t bin)
+	{ return (bin == 0) ? 0 : (1ULL << bin); }
+
+	AcceleratorBufferLog2Histogram& operator-=(const AcceleratorBufferLog2Histogram& rhs)
+	{
+		for(size_t i=0; i<NUM_BINS; i++)
+			m_bins[i] -= rhs.m_bins[i];
+		return *this;
+	}
+
+	AcceleratorBufferLog2Histogram& operator+=(const AcceleratorBufferLog2Histogram& rhs)
+	{
+		for(size_t i=0; i<NUM_BINS; i++)
+			m_bins[i] += rhs.m_bins[i];
+		return *this;
+	}
+
+	///@brief Number of values in each bin
+	uint64_t m_bins[NUM_BINS];
+};
+
+/**
+	@brief Statistics for one direction of transfers
+	@ingroup core
+ */
+class AcceleratorBufferTransferStats
+{
+public:
+	AcceleratorBufferTransferStats()
+	: m_blockingCount(0)
+	, m_nonblockingCount(0)
+	, m_bytes(0)
+	, m_blockingTime(0)
+	{}
+
+	void Add(size_t bytes, bool blocking, double latency)
+	{
+		if(blocking)
+		{
+			m_blockingCount ++;
+			m_blockingTime += latency;
+			m_latencyHistogram.Add(latency * 1e6);
+		}
+		else
+			m_nonblockingCount ++;
+
+		m_bytes += bytes;
+		m_sizeHistogram.Add(bytes);
+	}
+
+	///@brief Total number of transfers in this direction
+	uint64_t GetCount() const
+	{ return m_blockingCount + m_nonblockingCount; }
+
+	AcceleratorBufferTransferStats& operator-=(const AcceleratorBufferTransferStats& rhs);
+	AcceleratorBufferTransferStats& operator+=(const AcceleratorBufferTransferStats& rhs);
+
+	///@brief Number of blocking transfers
+	uint64_t m_blockingCount;
+
+	///@brief Number of transfers recorded into a command buffer without blocking
+	uint64_t m_nonblockingCount;
+
+	///@brief Total number of bytes moved
+	uint64_t m_bytes;
+
+	///@brief Total wall clock time spent in blocking transfers, in seconds
+	double m_blockingTime;
+
+	///@brief Histogram of transfer sizes, in bytes
+	AcceleratorBufferLog2Histogram m_sizeHistogram;
+
+	/**
+		@brief Histogram of blocking transfer latency, in microseconds
+
+		Nonblocking transfers complete asynchronously as part of a larger command buffer so aren't timed.
+	 */
+	AcceleratorBufferLog2Histogram m_latencyHistogram;
+};
+
+/**
+	@brief Statistics for a single named buffer (or the sum of all buffers)
+	@ingroup core
+ */
+class AcceleratorBufferStats
+{
+public:
+	AcceleratorBufferStats()
+	: m_reallocations(0)
+	, m_reallocatedBytes(0)
+	, m_pagedAllocations(0)
+	, m_pagedBytes(0)
+	{}
+
+	/**
+		@brief Returns true if data moved in both directions between CPU and GPU
+
+		This usually means the buffer is being processed alternately by CPU and GPU filters, and is a good candidate
+		for moving the CPU side processing to a shader (or vice versa).
+	 */
+	bool IsPingPong() const
+	{ return (m_hostDevice.GetCount() > 0) && (m_deviceHost.GetCount() > 0); }
+
+	///@brief Total bytes moved between CPU and GPU in either direction
+	uint64_t GetHostDeviceTrafficBytes() const
+	{ return m_hostDevice.m_bytes + m_deviceHost.m_bytes; }
+
+	AcceleratorBufferStats& operator-=(const AcceleratorBufferStats& rhs);
+	AcceleratorBufferStats& operator+=(const AcceleratorBufferStats& rhs);
+
+	///@brief Copies from CPU to GPU
+	AcceleratorBufferTransferStats m_hostDevice;
+
+	///@brief Copies from GPU to CPU
+	AcceleratorBufferTransferStats m_deviceHost;
+
+	///@brief Copies from GPU to GPU (buffer-to-buffer copies and reallocations)
+	AcceleratorBufferTransferStats m_deviceDevice;
+
+	///@brief Number of calls to Reallocate()
+	uint64_t m_reallocations;
+
+	///@brief Total bytes requested by calls to Reallocate()
+	uint64_t m_reallocatedBytes;
+
+	///@brief Number of CPU-side buffers backed by a memory mapped temporary file (MEM_TYPE_CPU_PAGED)
+	uint64_t m_pagedAllocations;
+
+	///@brief Total size of all paged allocations, in bytes
+	uint64_t m_pagedBytes;
+};
+
+/**
+	@brief Lock-free running totals for one direction of transfers
+
+	Same contents as AcceleratorBufferTransferStats, but every field is atomic so transfers on different threads can
+	update it without serializing on a mutex.
+
+	@ingroup core
+ */
+class AcceleratorBufferAtomicTransferStats
+{
+public:
+	AcceleratorBufferAtomicTransferStats()
+	{ Reset(); }
+
+	void Add(size_t bytes, bool blocking, double latency);
+	void Reset();
+	AcceleratorBufferTransferStats Load() const;
+
+protected:
+
+	///@brief Number of blocking transfers
+	std::atomic<uint64_t> m_blockingCount;
+
+	///@brief Number of transfers recorded into a command buffer without blocking
+	std::atomic<uint64_t> m_nonblockingCount;
+
+	///@brief Total number of bytes moved
+	std::atomic<uint64_t> m_bytes;
+
+	///@brief Total wall clock time spent in blocking transfers, in nanoseconds
+	std::atomic<uint64_t> m_blockingTimeNs;
+
+	///@brief Histogram of transfer sizes, in bytes
+	std::atomic<uint64_t> m_sizeBins[AcceleratorBufferLog2Histogram::NUM_BINS];
+
+	///@brief Histogram of blocking transfer latency, in microseconds
+	std::atomic<uint64_t> m_latencyBins[AcceleratorBufferLog2Histogram::NUM_BINS];
+};
+
+/**
+	@brief Lock-free running totals for all buffers
+	@ingroup core
+ */
+class AcceleratorBufferAtomicStats
+{
+public:
+	AcceleratorBufferAtomicStats()
+	{ Reset(); }
+
+	void Reset();
+	AcceleratorBufferStats Load() const;
+
+	///@brief Copies from CPU to GPU
+	AcceleratorBufferAtomicTransferStats m_hostDevice;
+
+	///@brief Copies from GPU to CPU
+	AcceleratorBufferAtomicTransferStats m_deviceHost;
+
+	///@brief Copies from GPU to GPU
+	AcceleratorBufferAtomicTransferStats m_deviceDevice;
+
+	///@brief Number of calls to Reallocate()
+	std::atomic<uint64_t> m_reallocations;
+
+	///@brief Total bytes requested by calls to Reallocate()
+	std::atomic<uint64_t> m_reallocatedBytes;
+
+	///@brief Number of CPU-side buffers backed by a memory mapped temporary file
+	std::atomic<uint64_t> m_pagedAllocations;
+
+	///@brief Total size of all paged allocations, in bytes
+	std::atomic<uint64_t> m_pagedBytes;
+};
+
+/**
+	@brief Point-in-time copy of all AcceleratorBuffer performance counters
+
+	Take one snapshot before and one after the operation of interest and subtract them to see what it did.
+
+	@ingroup core
+ */
+class AcceleratorBufferPerformanceSnapshot
+{
+public:
+	AcceleratorBufferPerformanceSnapshot()
+	: m_timestamp(0)
+	, m_pagedBytesLive(0)
+	, m_pagedBuffersLive(0)
+	, m_pagedFrees(0)
+	, m_skippedHostDevice(0)
+	, m_skippedDeviceHost(0)
+	, m_skippedDeviceDevice(0)
+	{}
+
+	AcceleratorBufferPerformanceSnapshot operator-(const AcceleratorBufferPerformanceSnapshot& rhs) const;
+
+	std::vector<std::string> GetPingPongBuffers() const;
+
+	void Dump() const;
+
+	///@brief Time the snapshot was taken (from GetTime()), or elapsed time for a diff
+	double m_timestamp;
+
+	///@brief Sum of all buffers, named or not
+	AcceleratorBufferStats m_totals;
+
+	///@brief Per-buffer statistics, indexed by buffer name (only if per-buffer tracking was enabled)
+	std::map<std::string, AcceleratorBufferStats> m_buffers;
+
+	///@brief Bytes of temporary file mappings currently live (absolute value, not diffed)
+	int64_t m_pagedBytesLive;
+
+	///@brief Number of temporary file mappings currently live (absolute value, not diffed)
+	int64_t m_pagedBuffersLive;
+
+	///@brief Number of temporary file mappings freed
+	uint64_t m_pagedFrees;
+
+	///@brief Copies from the CPU to GPU avoided because the data was already resident
+	uint64_t m_skippedHostDevice;
+
+	///@brief Copies from the GPU to CPU avoided because the data was already resident
+	uint64_t m_skippedDeviceHost;
+
+	///@brief Copies from the GPU to GPU avoided because the data was stale
+	uint64_t m_skippedDeviceDevice;
+};
+
+/**
+	@brief Performance counters shared by all AcceleratorBuffer instances
+
+	The simple copy counters are always updated. Byte counts, latency histograms, reallocation and paging statistics
+	are accumulated into global totals as well, and additionally broken out by buffer name (see
+	AcceleratorBuffer::SetName()) if EnablePerBufferStats() has been called.
+
+	Global totals are lock-free. Only the per-buffer breakdown takes a mutex, so transfers on different threads don't
+	serialize unless it's enabled.
+
+	@ingroup core
+ */
+class AcceleratorBufferPerformanceCounters
+{
+public:
+	static void Reset();
+
+	static void EnablePerBufferStats(bool enable);
+
+	///@brief Returns true if statistics are being broken out by buffer name
+	static bool IsPerBufferStatsEnabled()
+	{ return m_perBufferStatsEnabled.load(std::memory_order_relaxed); }
+
+	static AcceleratorBufferPerformanceSnapshot GetSnapshot();
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Helpers for logging specific interactions
+
+	static void LogHostDeviceCopyBlocking(const std::string& name, size_t bytes, double latency);
+	static void LogHostDeviceCopyNonBlocking(const std::string& name, size_t bytes);
+
+	static void LogHostDeviceCopySkipped()
+	{ m_hostDeviceCopiesSkipped ++; }
+
+	//---
+
+	static void LogDeviceHostCopyBlocking(const std::string& name, size_t bytes, double latency);
+	static void LogDeviceHostCopyNonBlocking(const std::string& name, size_t bytes);
+
+	static void LogDeviceHostCopySkipped()
+	{ m_deviceHostCopiesSkipped ++; }
+
+	//---
+
+	static void LogDeviceDeviceCopyBlocking(const std::string& name, size_t bytes, double latency);
+	static void LogDeviceDeviceCopyNonBlocking(const std::string& name, size_t bytes);
+
+	static void LogDeviceDeviceCopySkipped()
+	{ m_deviceDeviceCopiesSkipped ++; }
+
+	//---
+
+	static void LogReallocate(const std::string& name, size_t bytes);
+	static void LogPagedAllocation(const std::string& name, size_t bytes);
+	static void LogPagedFree(size_t bytes);
+
+protected:
+	static AcceleratorBufferStats& GetStatsForName(const std::string& name);
+
+public:
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Actual counters
+
+	///@brief Number of blocking copies from the CPU to GPU made with the global transfer queue
+	static std::atomic<int64_t> m_hostDeviceCopiesBlocking;
+
+	///@brief Number of nonblocking copies from the CPU to GPU made as part of a larger command buffer
+	static std::atomic<int64_t> m_hostDeviceCopiesNonBlocking;
+
+	///@brief Number of copies from the CPU to GPU avoided because the data was already resident
+	static std::atomic<int64_t> m_hostDeviceCopiesSkipped;
+
+	//---
+
+	///@brief Number of blocking copies from the GPU to CPU made with the global transfer queue
+	static std::atomic<int64_t> m_deviceHostCopiesBlocking;
+
+	///@brief Number of nonblocking copies from the GPU to CPU made as part of a larger command buffer
+	static std::atomic<int64_t> m_deviceHostCopiesNonBlocking;
+
+	///@brief Number of copies from the CPU to GPU avoided because the data was already resident
+	static std::atomic<int64_t> m_deviceHostCopiesSkipped;
+
+	//---
+
+	///@brief Number of blocking copies from the GPU to GPU made with the global transfer queue
+	static std::atomic<int64_t> m_deviceDeviceCopiesBlocking;
+
+	///@brief Number of nonblocking copies from the GPU to GPU made as part of a larger command buffer
+	static std::atomic<int64_t> m_deviceDeviceCopiesNonBlocking;
+
+	///@brief Number of copies from the GPU to GPU avoided because the data was already resident
+	static std::atomic<int64_t> m_deviceDeviceCopiesSkipped;
+
+	//---
+
+	///@brief Bytes of temporary file mappings currently live
+	static std::atomic<int64_t> m_pagedBytesLive;
+
+	///@brief Number of temporary file mappings currently live
+	static std::atomic<int64_t> m_pagedBuffersLive;
+
+	///@brief Number of temporary file mappings freed
+	static std::atomic<int64_t> m_pagedFrees;
+
+protected:
+
+	///@brief True if statistics should be broken out by buffer name
+	static std::atomic<bool> m_perBufferStatsEnabled;
+
+	///@brief Mutex protecting m_buffers
+	static std::mutex m_statsMutex;
+
+	///@brief Sum of all buffers
+	static AcceleratorBufferAtomicStats m_totals;
+
+	///@brief Per-buffer statistics, indexed by buffer name
+	static std::map<std::string, AcceleratorBufferStats> m_buffers;
+};
+
+#endif
@@ -0,0 +1,294 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of ByteArenaRef and ByteArenaWaveform
+	@ingroup datamodel
+ */
+#ifndef ByteArenaWaveform_h
+#define ByteArenaWaveform_h
+
+#include "Waveform.h"
+
+/**
+	@brief Reference to a run of bytes in the payload arena of a ByteArenaWaveform
+
+	This is POD so protocol symbols which carry a variable length payload can stay trivially copyable.
+
+	@ingroup datamodel
+ */
+class ByteArenaRef
+{
+public:
+
+	///@brief Offset of the first byte within the arena
+	uint32_t m_offset;
+
+	///@brief Number of bytes
+	uint32_t m_length;
+
+	///@brief Gets the end of the referenced run of bytes
+	size_t end() const
+	{ return m_offset + m_length; }
+
+	///@brief Checks if the reference is empty
+	bool empty() const
+	{ return m_length == 0; }
+
+	///@brief Compares two references (not the bytes they point to)
+	bool operator==(const ByteArenaRef& rhs) const
+	{ return (m_offset == rhs.m_offset) && (m_length == rhs.m_length); }
+};
+
+/**
+	@brief A sparse waveform whose samples reference variable length payloads stored in a shared byte arena
+
+	Protocol decoders whose symbols have variable length data (e.g. multi-byte header fields) store a ByteArenaRef in
+	each symbol and append the bytes to m_arena, rather than keeping a std::vector in every symbol. This keeps S
+	trivially copyable, so m_samples does not need per-element construction and destruction, and decoding does not
+	make one heap allocation per symbol.
+
+	Since symbols only make sense together with the arena, use CopyFrom(), Serialize() and Deserialize() rather than
+	copying m_samples on its own.
+
+	@ingroup datamodel
+ */
+template<class S>
+class ByteArenaWaveform : public SparseWaveform<S>
+{
+public:
+
+	ByteArenaWaveform(const std::string& name = "")
+		: SparseWaveform<S>(name)
+	{
+		static_assert(std::is_trivially_copyable<S>::value, "ByteArenaWaveform symbols must be trivially copyable");
+
+		//Payload bytes are only ever used by CPU-side decoders
+		m_arena.SetCpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_LIKELY);
+		m_arena.SetGpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_NEVER);
+		RenameArena(name);
+	}
+
+	virtual ~ByteArenaWaveform()
+	{}
+
+	virtual void Rename(const std::string& name = "") override
+	{
+		SparseWaveform<S>::Rename(name);
+		RenameArena(name);
+	}
+
+	///@brief Payload bytes referenced by the samples
+	AcceleratorBuffer<uint8_t> m_arena;
+
+	/**
+		@brief Appends a run of bytes to the arena
+
+		@param data		Bytes to add
+		@param len		Number of bytes
+
+		@return Reference to the new bytes
+	 */
+	ByteArenaRef AddBytes(const uint8_t* data, size_t len)
+	{
+		ByteArenaRef ref;
+		ref.m_offset = m_arena.size();
+		ref.m_length = len;
+
+		m_arena.resize(ref.m_offset + len);
+		memcpy(m_arena.GetCpuPointer() + ref.m_offset, data, len);
+		return ref;
+	}
+
+	///@brief Appends a single byte to the arena
+	ByteArenaRef AddByte(uint8_t b)
+	{ return AddBytes(&b, 1); }
+
+	/**
+		@brief Appends one more byte to an existing run of bytes
+
+		This is cheap if the run is at the end of the arena (i.e. it belongs to the symbol currently being decoded).
+		Otherwise the run is moved to the end of the arena first, leaving the old bytes unreferenced.
+
+		@param ref		Reference to update
+		@param b		Byte to append
+	 */
+	void AppendByte(ByteArenaRef& ref, uint8_t b)
+	{
+		if(ref.end() != m_arena.size())
+		{
+			size_t offset = m_arena.size();
+			m_arena.resize(offset + ref.m_length + 1);
+			memmove(m_arena.GetCpuPointer() + offset, m_arena.GetCpuPointer() + ref.m_offset, ref.m_length);
+			ref.m_offset = offset;
+		}
+		else
+			m_arena.resize(ref.end() + 1);
+
+		m_arena[ref.end()] = b;
+		ref.m_length ++;
+	}
+
+	///@brief Gets a pointer to the bytes of a run. Only valid until the arena is next resized.
+	const uint8_t* GetBytes(const ByteArenaRef& ref)
+	{ return m_arena.GetCpuPointer() + ref.m_offset; }
+
+	/**
+		@brief Gets one byte of a run
+
+		@param ref	Run of bytes
+		@param i	Index within the run
+
+		@return The byte, or 0 if i is out of range
+	 */
+	uint8_t GetByte(const ByteArenaRef& ref, size_t i)
+	{
+		if(i >= ref.m_length)
+			return 0;
+		return m_arena[ref.m_offset + i];
+	}
+
+	///@brief Gets the big endian value of a run of up to 8 bytes
+	uint64_t GetBigEndian(const ByteArenaRef& ref)
+	{
+		uint64_t ret = 0;
+		auto p = GetBytes(ref);
+		for(size_t i=0; i<ref.m_length && i<8; i++)
+			ret = (ret << 8) | p[i];
+		return ret;
+	}
+
+	///@brief Compares the contents of two runs of bytes, which may be in different waveforms
+	bool BytesEqual(const ByteArenaRef& ref, ByteArenaWaveform<S>& rhs, const ByteArenaRef& rhsref)
+	{
+		if(ref.m_length != rhsref.m_length)
+			return false;
+		return 0 == memcmp(GetBytes(ref), rhs.GetBytes(rhsref), ref.m_length);
+	}
+
+	/**
+		@brief Copies samples, timestamps, and payload bytes from another waveform
+
+		Sample references stay valid because the arena is copied verbatim.
+	 */
+	void CopyFrom(ByteArenaWaveform<S>& rhs)
+	{
+		rhs.PrepareForCpuAccess();
+		this->CopyTimestamps(&rhs);
+		this->m_samples.CopyFrom(rhs.m_samples);
+		m_arena.CopyFrom(rhs.m_arena);
+	}
+
+	/**
+		@brief Writes samples, timestamps, and payload bytes to a file
+
+		Format is the sample count and arena size (both uint64_t), followed by the raw offsets, durations, samples,
+		and arena contents. Not portable between hosts of different endianness.
+
+		@return True on success
+	 */
+	bool Serialize(FILE* fp)
+	{
+		this->PrepareForCpuAccess();
+
+		uint64_t hdr[2] = { this->m_samples.size(), m_arena.size() };
+		size_t len = hdr[0];
+		if(1 != fwrite(hdr, sizeof(hdr), 1, fp))
+			return false;
+		if(len != fwrite(this->m_offsets.GetCpuPointer(), sizeof(int64_t), len, fp))
+			return false;
+		if(len != fwrite(this->m_durations.GetCpuPointer(), sizeof(int64_t), len, fp))
+			return false;
+		if(len != fwrite(this->m_samples.GetCpuPointer(), sizeof(S), len, fp))
+			return false;
+		if(hdr[1] != fwrite(m_arena.GetCpuPointer(), 1, hdr[1], fp))
+			return false;
+		return true;
+	}
+
+	/**
+		@brief Reads samples, timestamps, and payload bytes written by Serialize()
+
+		@return True on success. On failure the waveform is left empty.
+	 */
+	bool Deserialize(FILE* fp)
+	{
+		this->clear();
+
+		uint64_t hdr[2];
+		if(1 != fread(hdr, sizeof(hdr), 1, fp))
+			return false;
+
+		size_t len = hdr[0];
+		this->Resize(len);
+		m_arena.resize(hdr[1]);
+		this->PrepareForCpuAccess();
+
+		if( (len != fread(this->m_offsets.GetCpuPointer(), sizeof(int64_t), len, fp)) ||
+			(len != fread(this->m_durations.GetCpuPointer(), sizeof(int64_t), len, fp)) ||
+			(len != fread(this->m_samples.GetCpuPointer(), sizeof(S), len, fp)) ||
+			(hdr[1] != fread(m_arena.GetCpuPointer(), 1, hdr[1], fp)) )
+		{
+			this->clear();
+			return false;
+		}
+
+		this->MarkModifiedFromCpu();
+		return true;
+	}
+
+	virtual void clear() override
+	{
+		SparseWaveform<S>::clear();
+		m_arena.clear();
+	}
+
+	virtual size_t GetMemoryBytes() const override
+	{ return SparseWaveform<S>::GetMemoryBytes() + m_arena.GetMemoryBytes(); }
+
+	virtual void PrepareForCpuAccess() override
+	{
+		SparseWaveform<S>::PrepareForCpuAccess();
+		m_arena.PrepareForCpuAccess();
+	}
+
+protected:
+	void RenameArena(const std::string& name)
+	{
+		if(name.empty())
+			m_arena.SetName(std::string("ByteArenaWaveform<") + typeid(S).name() + ">.m_arena");
+		else
+			m_arena.SetName(name + ".m_arena");
+	}
+};
+
+#endif
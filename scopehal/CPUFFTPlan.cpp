@@ -0,0 +1,975 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of CPUFFTPlan
+
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "CPUFFTPlan.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+mutex CPUFFTPlan::m_cacheMutex;
+map<CPUFFTPlan::PlanKey, weak_ptr<CPUFFTPlan> > CPUFFTPlan::m_cache;
+
+///@brief Don't bother spinning up worker threads for a single transform smaller than this
+#define FFT_PARALLEL_THRESHOLD 65536
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Complex arithmetic helpers
+
+static inline FFTComplex operator+(FFTComplex a, FFTComplex b)
+{ return { a.re + b.re, a.im + b.im }; }
+
+static inline FFTComplex operator-(FFTComplex a, FFTComplex b)
+{ return { a.re - b.re, a.im - b.im }; }
+
+static inline FFTComplex operator*(FFTComplex a, FFTComplex b)
+{ return { a.re*b.re - a.im*b.im, a.re*b.im + a.im*b.re }; }
+
+static inline FFTComplex operator*(FFTComplex a, float b)
+{ return { a.re*b, a.im*b }; }
+
+static inline FFTComplex conj(FFTComplex a)
+{ return { a.re, -a.im }; }
+
+///@brief Multiplies by -i
+static inline FFTComplex mul_negj(FFTComplex a)
+{ return { a.im, -a.re }; }
+
+///@brief Multiplies by +i
+static inline FFTComplex mul_j(FFTComplex a)
+{ return { -a.im, a.re }; }
+
+///@brief Multiplies by exp(-i*pi/4)
+static inline FFTComplex mul_w8(FFTComplex a)
+{ return FFTComplex{ (a.re + a.im) * (float)M_SQRT1_2, (a.im - a.re) * (float)M_SQRT1_2 }; }
+
+///@brief Calculates exp(-2*pi*i*num/den) in double precision
+static FFTComplex Twiddle(uint64_t num, uint64_t den)
+{
+	double theta = -2 * M_PI * num / den;
+	return { (float)cos(theta), (float)sin(theta) };
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CPUFFTKernel
+
+/**
+	@brief Creates a new complex FFT kernel
+
+	@param n	Number of points
+ */
+CPUFFTKernel::CPUFFTKernel(size_t n)
+	: m_size(n)
+	, m_pow2( (n & (n-1)) == 0 )
+{
+	if(m_pow2)
+	{
+		m_twiddles.resize(n);
+		for(size_t k=0; k<n; k++)
+			m_twiddles[k] = Twiddle(k, n);
+	}
+
+	//Bluestein: rewrite the DFT as a convolution with a chirp, which we can do with a power-of-two FFT
+	else
+	{
+		size_t m = next_pow2(2*n - 1);
+		m_convKernel = make_unique<CPUFFTKernel>(m);
+
+		//Keep k^2 modulo 2n to avoid losing precision in the phase for large k
+		m_chirp.resize(n);
+		for(size_t k=0; k<n; k++)
+			m_chirp[k] = Twiddle( (k*k) % (2*n), 2*n);
+
+		//Convolution kernel is the conjugate chirp, wrapped around for negative indexes
+		FFTComplexVector b(m, FFTComplex{0, 0});
+		b[0] = conj(m_chirp[0]);
+		for(size_t k=1; k<n; k++)
+		{
+			b[k] = conj(m_chirp[k]);
+			b[m-k] = b[k];
+		}
+
+		m_chirpFFT.resize(m);
+		FFTComplexVector scratch(m_convKernel->GetScratchSize());
+		m_convKernel->Forward(b.data(), m_chirpFFT.data(), scratch.data(), false);
+		float scale = 1.0f / m;
+		for(auto& c : m_chirpFFT)
+			c = c * scale;
+	}
+}
+
+/**
+	@brief Does a forward transform
+
+	@param in		Input data (may be the same as out)
+	@param out		Output data
+	@param scratch	Scratch buffer of GetScratchSize() values
+	@param parallel	True to allow using OpenMP worker threads for this transform
+ */
+void CPUFFTKernel::Forward(const FFTComplex* in, FFTComplex* out, FFTComplex* scratch, bool parallel) const
+{
+	parallel = parallel && (m_size >= FFT_PARALLEL_THRESHOLD);
+
+	if(!m_pow2)
+	{
+		ForwardBluestein(in, out, scratch, parallel);
+		return;
+	}
+
+	if(in != out)
+		memcpy(out, in, m_size * sizeof(FFTComplex));
+
+	ForwardPow2(out, scratch, parallel);
+}
+
+/**
+	@brief Does an inverse (unnormalized) transform
+
+	@param in		Input data (may be the same as out)
+	@param out		Output data
+	@param scratch	Scratch buffer of GetScratchSize() values
+	@param parallel	True to allow using OpenMP worker threads for this transform
+ */
+void CPUFFTKernel::Reverse(const FFTComplex* in, FFTComplex* out, FFTComplex* scratch, bool parallel) const
+{
+	//ifft(x) = conj(fft(conj(x)))
+	for(size_t i=0; i<m_size; i++)
+		out[i] = conj(in[i]);
+	Forward(out, out, scratch, parallel);
+	for(size_t i=0; i<m_size; i++)
+		out[i].im = -out[i].im;
+}
+
+/**
+	@brief Power-of-two Stockham FFT
+
+	@param x	Input data, overwritten with the output
+	@param y	Scratch buffer of the same size
+ */
+void CPUFFTKernel::ForwardPow2(FFTComplex* x, FFTComplex* y, bool parallel) const
+{
+	size_t n = m_size;
+	size_t s = 1;
+	FFTComplex* src = x;
+	FFTComplex* dst = y;
+
+	//Radix-8 passes for as long as we can
+	while(n >= 8)
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2 && (s >= 4) )
+			Radix8PassAVX2(src, dst, n, s, parallel);
+		else
+		#endif
+			Radix8Pass(src, dst, n, s, parallel);
+
+		swap(src, dst);
+		n /= 8;
+		s *= 8;
+	}
+
+	//Finish with a radix-4 or radix-2 pass if the length isn't a power of 8
+	if(n == 4)
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2 && (s >= 4) )
+			Radix4PassAVX2(src, dst, n, s, parallel);
+		else
+		#endif
+			Radix4Pass(src, dst, n, s, parallel);
+
+		swap(src, dst);
+	}
+	else if(n == 2)
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2 && (s >= 4) )
+			Radix2PassAVX2(src, dst, s);
+		else
+		#endif
+			Radix2Pass(src, dst, s);
+
+		swap(src, dst);
+	}
+
+	//Result has to end up in x
+	if(src != x)
+		memcpy(x, src, m_size * sizeof(FFTComplex));
+}
+
+/**
+	@brief Arbitrary length FFT via Bluestein's algorithm
+
+	The first m values of scratch hold the convolution, the rest is scratch space for the convolution kernel.
+ */
+void CPUFFTKernel::ForwardBluestein(const FFTComplex* in, FFTComplex* out, FFTComplex* scratch, bool parallel) const
+{
+	size_t m = m_convKernel->size();
+	FFTComplex* a = scratch;
+	FFTComplex* convScratch = scratch + m;
+
+	//Premultiply by the chirp and zero pad
+	for(size_t k=0; k<m_size; k++)
+		a[k] = in[k] * m_chirp[k];
+	for(size_t k=m_size; k<m; k++)
+		a[k] = FFTComplex{0, 0};
+
+	//Convolve with the conjugate chirp
+	m_convKernel->Forward(a, a, convScratch, parallel);
+	for(size_t k=0; k<m; k++)
+		a[k] = a[k] * m_chirpFFT[k];
+	m_convKernel->Reverse(a, a, convScratch, parallel);
+
+	//Postmultiply by the chirp
+	for(size_t k=0; k<m_size; k++)
+		out[k] = a[k] * m_chirp[k];
+}
+
+/**
+	@brief Four point DFT of a, b, c, d, written to out
+ */
+static inline void Butterfly4(FFTComplex a, FFTComplex b, FFTComplex c, FFTComplex d, FFTComplex* out)
+{
+	FFTComplex apc = a + c;
+	FFTComplex amc = a - c;
+	FFTComplex bpd = b + d;
+	FFTComplex jbmd = mul_negj(b - d);
+
+	out[0] = apc + bpd;
+	out[1] = amc + jbmd;
+	out[2] = apc - bpd;
+	out[3] = amc - jbmd;
+}
+
+/**
+	@brief One radix-8 Stockham pass
+
+	Each eight point DFT is split into four point DFTs of the even and odd inputs, which are then combined with the
+	eighth roots of unity.
+
+	@param x	Input
+	@param y	Output
+	@param n	Sub-transform length for this pass
+	@param s	Stride for this pass
+ */
+void CPUFFTKernel::Radix8Pass(const FFTComplex* x, FFTComplex* y, size_t n, size_t s, bool parallel) const
+{
+	size_t m = n/8;
+	size_t tstride = m_size / n;
+
+	#pragma omp parallel for if(parallel)
+	for(size_t p=0; p<m; p++)
+	{
+		FFTComplex w[8];
+		for(size_t j=1; j<8; j++)
+			w[j] = m_twiddles[j*p*tstride];
+
+		for(size_t q=0; q<s; q++)
+		{
+			FFTComplex e[4];
+			FFTComplex o[4];
+			Butterfly4(x[q + s*p], x[q + s*(p + 2*m)], x[q + s*(p + 4*m)], x[q + s*(p + 6*m)], e);
+			Butterfly4(x[q + s*(p + m)], x[q + s*(p + 3*m)], x[q + s*(p + 5*m)], x[q + s*(p + 7*m)], o);
+
+			o[1] = mul_w8(o[1]);
+			o[2] = mul_negj(o[2]);
+			o[3] = mul_negj(mul_w8(o[3]));
+
+			FFTComplex* py = y + q + s*8*p;
+			py[0] = e[0] + o[0];
+			py[s*4] = w[4] * (e[0] - o[0]);
+			for(size_t j=1; j<4; j++)
+			{
+				py[s*j] = w[j] * (e[j] + o[j]);
+				py[s*(j+4)] = w[j+4] * (e[j] - o[j]);
+			}
+		}
+	}
+}
+
+/**
+	@brief One radix-4 Stockham pass
+
+	@param x	Input
+	@param y	Output
+	@param n	Sub-transform length for this pass
+	@param s	Stride for this pass
+ */
+void CPUFFTKernel::Radix4Pass(const FFTComplex* x, FFTComplex* y, size_t n, size_t s, bool parallel) const
+{
+	size_t m = n/4;
+	size_t tstride = m_size / n;
+
+	#pragma omp parallel for if(parallel)
+	for(size_t p=0; p<m; p++)
+	{
+		FFTComplex w1 = m_twiddles[p*tstride];
+		FFTComplex w2 = m_twiddles[2*p*tstride];
+		FFTComplex w3 = m_twiddles[3*p*tstride];
+
+		for(size_t q=0; q<s; q++)
+		{
+			FFTComplex a = x[q + s*p];
+			FFTComplex b = x[q + s*(p + m)];
+			FFTComplex c = x[q + s*(p + 2*m)];
+			FFTComplex d = x[q + s*(p + 3*m)];
+
+			FFTComplex apc = a + c;
+			FFTComplex amc = a - c;
+			FFTComplex bpd = b + d;
+			FFTComplex jbmd = mul_negj(b - d);
+
+			y[q + s*(4*p + 0)] = apc + bpd;
+			y[q + s*(4*p + 1)] = w1 * (amc + jbmd);
+			y[q + s*(4*p + 2)] = w2 * (apc - bpd);
+			y[q + s*(4*p + 3)] = w3 * (amc - jbmd);
+		}
+	}
+}
+
+/**
+	@brief Final radix-2 Stockham pass (sub-transform length 2, so all twiddles are 1)
+ */
+void CPUFFTKernel::Radix2Pass(const FFTComplex* x, FFTComplex* y, size_t s) const
+{
+	for(size_t q=0; q<s; q++)
+	{
+		FFTComplex a = x[q];
+		FFTComplex b = x[q + s];
+		y[q] = a + b;
+		y[q + s] = a - b;
+	}
+}
+
+#ifdef __x86_64__
+
+/**
+	@brief Multiplies four interleaved complex values by one complex scalar
+ */
+__attribute__((target("avx2")))
+static inline __m256 ComplexMultiplyAVX2(__m256 v, __m256 wr, __m256 wi)
+{
+	__m256 vswap = _mm256_permute_ps(v, 0xb1);
+	return _mm256_addsub_ps(_mm256_mul_ps(v, wr), _mm256_mul_ps(vswap, wi));
+}
+
+/**
+	@brief Multiplies four interleaved complex values by -i
+ */
+__attribute__((target("avx2")))
+static inline __m256 MultiplyNegJAVX2(__m256 v)
+{
+	//Negate the real half of each pair after swapping
+	const __m256 negodd = _mm256_set_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f);
+	return _mm256_xor_ps(_mm256_permute_ps(v, 0xb1), negodd);
+}
+
+/**
+	@brief Multiplies four interleaved complex values by exp(-i*pi/4)
+ */
+__attribute__((target("avx2")))
+static inline __m256 MultiplyW8AVX2(__m256 v)
+{
+	//(re + im, im - re) / sqrt(2)
+	__m256 t = _mm256_addsub_ps(_mm256_permute_ps(v, 0xb1), v);
+	return _mm256_mul_ps(_mm256_permute_ps(t, 0xb1), _mm256_set1_ps(M_SQRT1_2));
+}
+
+/**
+	@brief Four point DFTs of four interleaved complex values at a time
+ */
+__attribute__((target("avx2")))
+static inline void Butterfly4AVX2(__m256 a, __m256 b, __m256 c, __m256 d, __m256* out)
+{
+	__m256 apc = _mm256_add_ps(a, c);
+	__m256 amc = _mm256_sub_ps(a, c);
+	__m256 bpd = _mm256_add_ps(b, d);
+	__m256 jbmd = MultiplyNegJAVX2(_mm256_sub_ps(b, d));
+
+	out[0] = _mm256_add_ps(apc, bpd);
+	out[1] = _mm256_add_ps(amc, jbmd);
+	out[2] = _mm256_sub_ps(apc, bpd);
+	out[3] = _mm256_sub_ps(amc, jbmd);
+}
+
+/**
+	@brief AVX2 radix-8 Stockham pass, four complex values (one vector) per iteration. Requires s >= 4.
+ */
+__attribute__((target("avx2")))
+void CPUFFTKernel::Radix8PassAVX2(const FFTComplex* x, FFTComplex* y, size_t n, size_t s, bool parallel) const
+{
+	size_t m = n/8;
+	size_t tstride = m_size / n;
+
+	//Late passes have few twiddles but long strides, so split across q instead of p there
+	size_t qblock = s;
+	if(parallel && (m < 64) )
+		qblock = max((size_t)64, s / 64);
+	size_t nqblocks = s / qblock;
+
+	#pragma omp parallel for collapse(2) if(parallel)
+	for(size_t p=0; p<m; p++)
+	{
+		for(size_t iq=0; iq<nqblocks; iq++)
+		{
+			__m256 wr[8];
+			__m256 wi[8];
+			for(size_t j=1; j<8; j++)
+			{
+				auto w = m_twiddles[j*p*tstride];
+				wr[j] = _mm256_set1_ps(w.re);
+				wi[j] = _mm256_set1_ps(w.im);
+			}
+
+			const float* px[8];
+			float* py[8];
+			for(size_t k=0; k<8; k++)
+			{
+				px[k] = reinterpret_cast<const float*>(x + s*(p + k*m));
+				py[k] = reinterpret_cast<float*>(y + s*(8*p + k));
+			}
+
+			size_t qend = (iq+1)*qblock*2;
+			for(size_t q=iq*qblock*2; q<qend; q += 8)
+			{
+				__m256 e[4];
+				__m256 o[4];
+				Butterfly4AVX2(
+					_mm256_loadu_ps(px[0] + q),
+					_mm256_loadu_ps(px[2] + q),
+					_mm256_loadu_ps(px[4] + q),
+					_mm256_loadu_ps(px[6] + q),
+					e);
+				Butterfly4AVX2(
+					_mm256_loadu_ps(px[1] + q),
+					_mm256_loadu_ps(px[3] + q),
+					_mm256_loadu_ps(px[5] + q),
+					_mm256_loadu_ps(px[7] + q),
+					o);
+
+				o[1] = MultiplyW8AVX2(o[1]);
+				o[2] = MultiplyNegJAVX2(o[2]);
+				o[3] = MultiplyNegJAVX2(MultiplyW8AVX2(o[3]));
+
+				_mm256_storeu_ps(py[0] + q, _mm256_add_ps(e[0], o[0]));
+				_mm256_storeu_ps(py[4] + q, ComplexMultiplyAVX2(_mm256_sub_ps(e[0], o[0]), wr[4], wi[4]));
+				for(size_t j=1; j<4; j++)
+				{
+					_mm256_storeu_ps(py[j] + q, ComplexMultiplyAVX2(_mm256_add_ps(e[j], o[j]), wr[j], wi[j]));
+					_mm256_storeu_ps(py[j+4] + q,
+						ComplexMultiplyAVX2(_mm256_sub_ps(e[j], o[j]), wr[j+4], wi[j+4]));
+				}
+			}
+		}
+	}
+}
+
+/**
+	@brief AVX2 radix-4 Stockham pass, four complex values (one vector) per iteration. Requires s >= 4.
+ */
+__attribute__((target("avx2")))
+void CPUFFTKernel::Radix4PassAVX2(const FFTComplex* x, FFTComplex* y, size_t n, size_t s, bool parallel) const
+{
+	size_t m = n/4;
+	size_t tstride = m_size / n;
+
+	//Late passes have few twiddles but long strides, so split across q instead of p there
+	size_t qblock = s;
+	if(parallel && (m < 64) )
+		qblock = max((size_t)64, s / 64);
+	size_t nqblocks = s / qblock;
+
+	#pragma omp parallel for collapse(2) if(parallel)
+	for(size_t p=0; p<m; p++)
+	{
+		for(size_t iq=0; iq<nqblocks; iq++)
+		{
+			//Negate the real half of each pair after swapping to multiply by -i
+			const __m256 negodd = _mm256_set_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f);
+
+			auto w1 = m_twiddles[p*tstride];
+			auto w2 = m_twiddles[2*p*tstride];
+			auto w3 = m_twiddles[3*p*tstride];
+			__m256 w1r = _mm256_set1_ps(w1.re);
+			__m256 w1i = _mm256_set1_ps(w1.im);
+			__m256 w2r = _mm256_set1_ps(w2.re);
+			__m256 w2i = _mm256_set1_ps(w2.im);
+			__m256 w3r = _mm256_set1_ps(w3.re);
+			__m256 w3i = _mm256_set1_ps(w3.im);
+
+			auto pa = reinterpret_cast<const float*>(x + s*p);
+			auto pb = reinterpret_cast<const float*>(x + s*(p + m));
+			auto pc = reinterpret_cast<const float*>(x + s*(p + 2*m));
+			auto pd = reinterpret_cast<const float*>(x + s*(p + 3*m));
+			auto py0 = reinterpret_cast<float*>(y + s*(4*p + 0));
+			auto py1 = reinterpret_cast<float*>(y + s*(4*p + 1));
+			auto py2 = reinterpret_cast<float*>(y + s*(4*p + 2));
+			auto py3 = reinterpret_cast<float*>(y + s*(4*p + 3));
+
+			size_t qend = (iq+1)*qblock*2;
+			for(size_t q=iq*qblock*2; q<qend; q += 8)
+			{
+				__m256 a = _mm256_loadu_ps(pa + q);
+				__m256 b = _mm256_loadu_ps(pb + q);
+				__m256 c = _mm256_loadu_ps(pc + q);
+				__m256 d = _mm256_loadu_ps(pd + q);
+
+				__m256 apc = _mm256_add_ps(a, c);
+				__m256 amc = _mm256_sub_ps(a, c);
+				__m256 bpd = _mm256_add_ps(b, d);
+				__m256 bmd = _mm256_sub_ps(b, d);
+				__m256 jbmd = _mm256_xor_ps(_mm256_permute_ps(bmd, 0xb1), negodd);
+
+				_mm256_storeu_ps(py0 + q, _mm256_add_ps(apc, bpd));
+				_mm256_storeu_ps(py1 + q, ComplexMultiplyAVX2(_mm256_add_ps(amc, jbmd), w1r, w1i));
+				_mm256_storeu_ps(py2 + q, ComplexMultiplyAVX2(_mm256_sub_ps(apc, bpd), w2r, w2i));
+				_mm256_storeu_ps(py3 + q, ComplexMultiplyAVX2(_mm256_sub_ps(amc, jbmd), w3r, w3i));
+			}
+		}
+	}
+}
+
+/**
+	@brief AVX2 final radix-2 pass. Requires s >= 4.
+ */
+__attribute__((target("avx2")))
+void CPUFFTKernel::Radix2PassAVX2(const FFTComplex* x, FFTComplex* y, size_t s) const
+{
+	auto pa = reinterpret_cast<const float*>(x);
+	auto pb = reinterpret_cast<const float*>(x + s);
+	auto py0 = reinterpret_cast<float*>(y);
+	auto py1 = reinterpret_cast<float*>(y + s);
+
+	size_t end = s*2;
+	for(size_t q=0; q<end; q += 8)
+	{
+		__m256 a = _mm256_loadu_ps(pa + q);
+		__m256 b = _mm256_loadu_ps(pb + q);
+		_mm256_storeu_ps(py0 + q, _mm256_add_ps(a, b));
+		_mm256_storeu_ps(py1 + q, _mm256_sub_ps(a, b));
+	}
+}
+
+#endif /* __x86_64__ */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CPUFFTPlan construction / destruction
+
+/**
+	@brief Creates a new FFT plan
+
+	Most callers should use Get() instead, to share plans with other filters.
+
+	@param npoints			Number of points in the FFT
+	@param dir				Direction (forward or reverse)
+	@param numBatches		Number of batched FFTs to perform (for spectrograms etc)
+	@param timeDomainType	Data type of the time-domain signal (real or complex)
+ */
+CPUFFTPlan::CPUFFTPlan(
+	size_t npoints,
+	CPUFFTPlanDirection dir,
+	size_t numBatches,
+	CPUFFTDataType timeDomainType)
+	: m_size(npoints)
+	, m_numBatches(numBatches)
+	, m_direction(dir)
+	, m_type(timeDomainType)
+	, m_halfLength(false)
+{
+	if(timeDomainType == TYPE_COMPLEX)
+	{
+		m_nouts = npoints;
+		m_kernel = make_unique<CPUFFTKernel>(npoints);
+	}
+
+	else
+	{
+		m_nouts = npoints/2 + 1;
+
+		//Even length real transform: pack into a half length complex transform
+		if( (npoints % 2) == 0)
+		{
+			m_halfLength = true;
+			m_kernel = make_unique<CPUFFTKernel>(npoints / 2);
+
+			m_realTwiddles.resize(m_nouts);
+			for(size_t k=0; k<m_nouts; k++)
+				m_realTwiddles[k] = Twiddle(k, npoints);
+		}
+
+		//Odd length: promote to complex
+		else
+			m_kernel = make_unique<CPUFFTKernel>(npoints);
+	}
+}
+
+/**
+	@brief Gets a plan from the global cache, creating it if needed
+
+	Plans are shared by every filter using the same configuration and freed once nobody is using them any more.
+ */
+shared_ptr<CPUFFTPlan> CPUFFTPlan::Get(
+	size_t npoints,
+	CPUFFTPlanDirection dir,
+	size_t numBatches,
+	CPUFFTDataType timeDomainType)
+{
+	PlanKey key(npoints, dir, numBatches, timeDomainType);
+
+	lock_guard<mutex> lock(m_cacheMutex);
+	auto it = m_cache.find(key);
+	if(it != m_cache.end())
+	{
+		auto plan = it->second.lock();
+		if(plan)
+			return plan;
+	}
+
+	//Not found, clean out any dead entries and make a new plan
+	for(auto jt = m_cache.begin(); jt != m_cache.end(); )
+	{
+		if(jt->second.expired())
+			jt = m_cache.erase(jt);
+		else
+			jt ++;
+	}
+
+	auto plan = make_shared<CPUFFTPlan>(npoints, dir, numBatches, timeDomainType);
+	m_cache[key] = plan;
+	return plan;
+}
+
+/**
+	@brief Drops all plans from the cache (plans still in use stay alive until released)
+ */
+void CPUFFTPlan::ClearCache()
+{
+	lock_guard<mutex> lock(m_cacheMutex);
+	m_cache.clear();
+}
+
+/**
+	@brief Returns true if filters should run their FFTs with CPUFFTPlan rather than VulkanFFTPlan
+
+	This is the only place the choice of FFT backend is made. Currently that's whenever the Vulkan device is a software
+	implementation, since VkFFT on lavapipe etc is much slower than a native CPU transform.
+ */
+bool CPUFFTPlan::IsPreferred()
+{
+	return g_vulkanDeviceIsSoftware;
+}
+
+/**
+	@brief Gets a scratch buffer for one transform, reusing a previously released one if possible
+ */
+FFTComplexVector* CPUFFTPlan::AcquireScratch() const
+{
+	{
+		lock_guard<mutex> lock(m_scratchMutex);
+		if(!m_scratchPool.empty())
+		{
+			auto ret = m_scratchPool.back().release();
+			m_scratchPool.pop_back();
+			return ret;
+		}
+	}
+
+	return new FFTComplexVector(m_kernel->size() + m_kernel->GetScratchSize());
+}
+
+/**
+	@brief Returns a scratch buffer from AcquireScratch() to the pool
+ */
+void CPUFFTPlan::ReleaseScratch(FFTComplexVector* scratch) const
+{
+	lock_guard<mutex> lock(m_scratchMutex);
+	m_scratchPool.push_back(unique_ptr<FFTComplexVector>(scratch));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Window functions (CPU equivalents of the window shaders, same arguments)
+
+/**
+	@brief Copies samples into a FFT input buffer, zero padding past the end of the input
+ */
+void CPUFFTPlan::ApplyRectangularWindow(const float* in, float* out, const WindowFunctionArgs& args)
+{
+	in += args.offsetIn;
+	out += args.offsetOut;
+
+	size_t nactual = min(args.numActualSamples, args.npoints);
+	memcpy(out, in, nactual * sizeof(float));
+	for(size_t i=nactual; i<args.npoints; i++)
+		out[i] = 0;
+}
+
+/**
+	@brief Applies a two-term cosine-sum window (Hann, Hamming) and zero pads past the end of the input
+ */
+void CPUFFTPlan::ApplyCosineSumWindow(const float* in, float* out, const WindowFunctionArgs& args)
+{
+	in += args.offsetIn;
+	out += args.offsetOut;
+
+	size_t nactual = min(args.numActualSamples, args.npoints);
+	for(size_t i=0; i<nactual; i++)
+		out[i] = (args.alpha0 - args.alpha1*cosf(i*args.scale)) * in[i];
+	for(size_t i=nactual; i<args.npoints; i++)
+		out[i] = 0;
+}
+
+/**
+	@brief Applies a Blackman-Harris window and zero pads past the end of the input
+ */
+void CPUFFTPlan::ApplyBlackmanHarrisWindow(const float* in, float* out, const WindowFunctionArgs& args)
+{
+	const float alpha0 = 0.35875;
+	const float alpha1 = 0.48829;
+	const float alpha2 = 0.14128;
+	const float alpha3 = 0.01168;
+
+	in += args.offsetIn;
+	out += args.offsetOut;
+
+	size_t nactual = min(args.numActualSamples, args.npoints);
+	for(size_t i=0; i<nactual; i++)
+	{
+		float num = i * args.scale;
+		float w =
+			alpha0 -
+			alpha1 * cosf(num) +
+			alpha2 * cosf(2*num) -
+			alpha3 * cosf(3*num);
+		out[i] = w * in[i];
+	}
+	for(size_t i=nactual; i<args.npoints; i++)
+		out[i] = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Execution
+
+/**
+	@brief Does a forward FFT of all batches
+
+	@param dataIn	Time domain input
+	@param dataOut	Frequency domain output (must be preallocated)
+ */
+void CPUFFTPlan::Forward(const float* dataIn, float* dataOut) const
+{
+	size_t instride = (m_type == TYPE_REAL) ? m_size : 2*m_size;
+	size_t outstride = 2*m_nouts;
+
+	//Parallelize across batches if we have more than one, otherwise within the transform
+	bool batchParallel = (m_numBatches > 1);
+	size_t worksize = m_kernel->size();
+
+	#pragma omp parallel if(batchParallel)
+	{
+		//One scratch buffer per thread, reused for all of its batches
+		auto scratch = AcquireScratch();
+		auto work = scratch->data();
+
+		#pragma omp for
+		for(size_t i=0; i<m_numBatches; i++)
+		{
+			auto in = dataIn + i*instride;
+			auto out = reinterpret_cast<FFTComplex*>(dataOut + i*outstride);
+
+			if(m_type == TYPE_COMPLEX)
+				m_kernel->Forward(reinterpret_cast<const FFTComplex*>(in), out, work + worksize, !batchParallel);
+			else
+				ForwardReal(in, out, work, work + worksize, !batchParallel);
+		}
+
+		ReleaseScratch(scratch);
+	}
+}
+
+/**
+	@brief Does an inverse (unnormalized) FFT of all batches
+
+	@param dataIn	Frequency domain input
+	@param dataOut	Time domain output (must be preallocated)
+ */
+void CPUFFTPlan::Reverse(const float* dataIn, float* dataOut) const
+{
+	size_t instride = 2*m_nouts;
+	size_t outstride = (m_type == TYPE_REAL) ? m_size : 2*m_size;
+
+	bool batchParallel = (m_numBatches > 1);
+	size_t worksize = m_kernel->size();
+
+	#pragma omp parallel if(batchParallel)
+	{
+		auto scratch = AcquireScratch();
+		auto work = scratch->data();
+
+		#pragma omp for
+		for(size_t i=0; i<m_numBatches; i++)
+		{
+			auto in = reinterpret_cast<const FFTComplex*>(dataIn + i*instride);
+			auto out = dataOut + i*outstride;
+
+			if(m_type == TYPE_COMPLEX)
+				m_kernel->Reverse(in, reinterpret_cast<FFTComplex*>(out), work + worksize, !batchParallel);
+			else
+				ReverseReal(in, out, work, work + worksize, !batchParallel);
+		}
+
+		ReleaseScratch(scratch);
+	}
+}
+
+/**
+	@brief Does a forward FFT of all batches, with data in AcceleratorBuffers
+
+	@param dataIn	Time domain input
+	@param dataOut	Frequency domain output (must be preallocated)
+ */
+void CPUFFTPlan::Forward(AcceleratorBuffer<float>& dataIn, AcceleratorBuffer<float>& dataOut) const
+{
+	dataIn.PrepareForCpuAccess();
+	dataOut.PrepareForCpuAccess();
+	Forward(dataIn.GetCpuPointer(), dataOut.GetCpuPointer());
+	dataOut.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Does an inverse FFT of all batches, with data in AcceleratorBuffers
+
+	@param dataIn	Frequency domain input
+	@param dataOut	Time domain output (must be preallocated)
+ */
+void CPUFFTPlan::Reverse(AcceleratorBuffer<float>& dataIn, AcceleratorBuffer<float>& dataOut) const
+{
+	dataIn.PrepareForCpuAccess();
+	dataOut.PrepareForCpuAccess();
+	Reverse(dataIn.GetCpuPointer(), dataOut.GetCpuPointer());
+	dataOut.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Forward transform of a single batch of real data
+
+	@param in		Input (m_size real values)
+	@param out		Output (m_nouts complex values)
+	@param work		Work buffer (kernel size complex values)
+	@param scratch	Scratch buffer for the kernel
+	@param parallel	True to allow using OpenMP worker threads
+ */
+void CPUFFTPlan::ForwardReal(
+	const float* in,
+	FFTComplex* out,
+	FFTComplex* work,
+	FFTComplex* scratch,
+	bool parallel) const
+{
+	//Odd length: promote to complex and do the full transform
+	if(!m_halfLength)
+	{
+		for(size_t i=0; i<m_size; i++)
+			work[i] = { in[i], 0 };
+		m_kernel->Forward(work, work, scratch, parallel);
+		memcpy(out, work, m_nouts * sizeof(FFTComplex));
+		return;
+	}
+
+	//Treat even samples as real and odd as imaginary, do a half length complex FFT
+	size_t h = m_size / 2;
+	m_kernel->Forward(reinterpret_cast<const FFTComplex*>(in), work, scratch, parallel);
+
+	//Then separate the even and odd spectra and combine them into the full spectrum
+	for(size_t k=0; k<m_nouts; k++)
+	{
+		FFTComplex zk = work[k % h];
+		FFTComplex zn = conj(work[(h - k) % h]);
+
+		FFTComplex even = (zk + zn) * 0.5f;
+		FFTComplex odd = mul_negj(zk - zn) * 0.5f;
+		out[k] = even + m_realTwiddles[k] * odd;
+	}
+}
+
+/**
+	@brief Inverse transform of a single batch to real data
+
+	@param in		Input (m_nouts complex values)
+	@param out		Output (m_size real values)
+	@param work		Work buffer (kernel size complex values)
+	@param scratch	Scratch buffer for the kernel
+	@param parallel	True to allow using OpenMP worker threads
+ */
+void CPUFFTPlan::ReverseReal(
+	const FFTComplex* in,
+	float* out,
+	FFTComplex* work,
+	FFTComplex* scratch,
+	bool parallel) const
+{
+	//Odd length: rebuild the full Hermitian spectrum and do a complex transform
+	if(!m_halfLength)
+	{
+		work[0] = in[0];
+		for(size_t k=1; k<m_nouts; k++)
+		{
+			work[k] = in[k];
+			work[m_size - k] = conj(in[k]);
+		}
+		m_kernel->Reverse(work, work, scratch, parallel);
+		for(size_t i=0; i<m_size; i++)
+			out[i] = work[i].re;
+		return;
+	}
+
+	//Recombine the even and odd spectra into a half length complex spectrum.
+	//The factors of 2 cancel out so the output is unnormalized, same as a full length transform
+	size_t h = m_size / 2;
+	for(size_t k=0; k<h; k++)
+	{
+		FFTComplex xk = in[k];
+		FFTComplex xn = conj(in[h - k]);
+
+		FFTComplex even = xk + xn;
+		FFTComplex odd = (xk - xn) * conj(m_realTwiddles[k]);
+		work[k] = even + mul_j(odd);
+	}
+
+	m_kernel->Reverse(work, reinterpret_cast<FFTComplex*>(out), scratch, parallel);
+}
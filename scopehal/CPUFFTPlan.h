@@ -0,0 +1,248 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of CPUFFTPlan
+	@ingroup core
+ */
+#ifndef CPUFFTPlan_h
+#define CPUFFTPlan_h
+
+#include <mutex>
+#include <tuple>
+
+#include "AlignedAllocator.h"
+#include "AcceleratorBuffer.h"
+#include "VulkanFFTPlan.h"
+
+/**
+	@brief A single complex float32 value, laid out the same as the interleaved buffers used by VkFFT
+	@ingroup core
+ */
+struct FFTComplex
+{
+	float re;
+	float im;
+};
+
+///@brief Vector of complex values aligned for AVX access
+typedef std::vector<FFTComplex, AlignedAllocator<FFTComplex, 64> > FFTComplexVector;
+
+/**
+	@brief A complex-to-complex FFT of one fixed length, executed on the CPU
+
+	Power-of-two lengths use a Stockham autosort radix-8 kernel (with one radix-4 or radix-2 pass to finish off lengths
+	which aren't a power of eight), so no bit reversal pass is needed. Any other length is computed with Bluestein's
+	algorithm on top of a power-of-two kernel.
+
+	All transforms are unnormalized, matching VkFFT.
+ */
+class CPUFFTKernel
+{
+public:
+	CPUFFTKernel(size_t n);
+
+	void Forward(const FFTComplex* in, FFTComplex* out, FFTComplex* scratch, bool parallel) const;
+	void Reverse(const FFTComplex* in, FFTComplex* out, FFTComplex* scratch, bool parallel) const;
+
+	///@brief Return the transform length
+	size_t size() const
+	{ return m_size; }
+
+	///@brief Return the number of complex values of scratch space needed by Forward() and Reverse()
+	size_t GetScratchSize() const
+	{ return m_pow2 ? m_size : (m_convKernel->size() + m_convKernel->GetScratchSize()); }
+
+protected:
+	void ForwardPow2(FFTComplex* x, FFTComplex* y, bool parallel) const;
+	void ForwardBluestein(const FFTComplex* in, FFTComplex* out, FFTComplex* scratch, bool parallel) const;
+
+	void Radix8Pass(const FFTComplex* x, FFTComplex* y, size_t n, size_t s, bool parallel) const;
+	void Radix4Pass(const FFTComplex* x, FFTComplex* y, size_t n, size_t s, bool parallel) const;
+	void Radix2Pass(const FFTComplex* x, FFTComplex* y, size_t s) const;
+
+#ifdef __x86_64__
+	void Radix8PassAVX2(const FFTComplex* x, FFTComplex* y, size_t n, size_t s, bool parallel) const;
+	void Radix4PassAVX2(const FFTComplex* x, FFTComplex* y, size_t n, size_t s, bool parallel) const;
+	void Radix2PassAVX2(const FFTComplex* x, FFTComplex* y, size_t s) const;
+#endif
+
+	///@brief Transform length
+	size_t m_size;
+
+	///@brief True if m_size is a power of two
+	bool m_pow2;
+
+	///@brief Twiddle factors exp(-2*pi*i*k/n) for the power-of-two kernel
+	FFTComplexVector m_twiddles;
+
+	///@brief Bluestein chirp exp(-pi*i*k^2/n)
+	FFTComplexVector m_chirp;
+
+	///@brief Forward FFT of the Bluestein convolution kernel, pre-scaled by 1/M
+	FFTComplexVector m_chirpFFT;
+
+	///@brief Power-of-two kernel used for the Bluestein convolution
+	std::unique_ptr<CPUFFTKernel> m_convKernel;
+};
+
+/**
+	@brief A (possibly batched) FFT plan executed on the CPU
+
+	Drop-in replacement for VulkanFFTPlan on hosts without a hardware GPU, where running VkFFT through a software
+	Vulkan implementation is far slower than a native CPU transform.
+
+	Buffer layout is the same as VulkanFFTPlan:
+	* Real time domain data is npoints float32 values per batch
+	* Complex time domain data is npoints interleaved complex values per batch
+	* Frequency domain data is interleaved complex, npoints/2 + 1 values per batch for real transforms or npoints for
+	  complex
+
+	Real transforms of even length are computed as a half length complex FFT plus a post-processing pass.
+	Batches are processed in parallel with OpenMP, a single large transform is parallelized across each pass instead.
+
+	Filters with a FFT stage check IsPreferred() to decide between this and VulkanFFTPlan.
+ */
+class CPUFFTPlan
+{
+public:
+
+	///@brief Direction of a FFT
+	enum CPUFFTPlanDirection
+	{
+		///@brief Normal FFT
+		DIRECTION_FORWARD,
+
+		///@brief Inverse FFT
+		DIRECTION_REVERSE
+	};
+
+	///@brief Data type of a FFT input or output
+	enum CPUFFTDataType
+	{
+		///@brief Real float32 values
+		TYPE_REAL,
+
+		///@brief Complex float32 values
+		TYPE_COMPLEX
+	};
+
+	CPUFFTPlan(
+		size_t npoints,
+		CPUFFTPlanDirection dir,
+		size_t numBatches = 1,
+		CPUFFTDataType timeDomainType = CPUFFTPlan::TYPE_REAL);
+
+	static std::shared_ptr<CPUFFTPlan> Get(
+		size_t npoints,
+		CPUFFTPlanDirection dir,
+		size_t numBatches = 1,
+		CPUFFTDataType timeDomainType = CPUFFTPlan::TYPE_REAL);
+
+	static void ClearCache();
+
+	static bool IsPreferred();
+
+	static void ApplyRectangularWindow(const float* in, float* out, const WindowFunctionArgs& args);
+	static void ApplyCosineSumWindow(const float* in, float* out, const WindowFunctionArgs& args);
+	static void ApplyBlackmanHarrisWindow(const float* in, float* out, const WindowFunctionArgs& args);
+
+	void Forward(const float* dataIn, float* dataOut) const;
+	void Reverse(const float* dataIn, float* dataOut) const;
+
+	void Forward(AcceleratorBuffer<float>& dataIn, AcceleratorBuffer<float>& dataOut) const;
+	void Reverse(AcceleratorBuffer<float>& dataIn, AcceleratorBuffer<float>& dataOut) const;
+
+	///@brief Return the number of points in the FFT
+	size_t size() const
+	{ return m_size; }
+
+	///@brief Return the number of complex frequency domain points per batch
+	size_t GetNumOutputs() const
+	{ return m_nouts; }
+
+	///@brief Return the number of batches
+	size_t GetNumBatches() const
+	{ return m_numBatches; }
+
+protected:
+	void ForwardReal(const float* in, FFTComplex* out, FFTComplex* work, FFTComplex* scratch, bool parallel) const;
+	void ReverseReal(const FFTComplex* in, float* out, FFTComplex* work, FFTComplex* scratch, bool parallel) const;
+
+	FFTComplexVector* AcquireScratch() const;
+	void ReleaseScratch(FFTComplexVector* scratch) const;
+
+	///@brief Number of points in the FFT
+	size_t m_size;
+
+	///@brief Number of complex frequency domain points per batch
+	size_t m_nouts;
+
+	///@brief Number of batches
+	size_t m_numBatches;
+
+	///@brief Direction of the transform
+	CPUFFTPlanDirection m_direction;
+
+	///@brief Type of the time domain data
+	CPUFFTDataType m_type;
+
+	///@brief True if this is a real transform computed via a half length complex FFT
+	bool m_halfLength;
+
+	///@brief Complex kernel (half length for even real transforms, full length otherwise)
+	std::unique_ptr<CPUFFTKernel> m_kernel;
+
+	///@brief Twiddle factors exp(-2*pi*i*k/npoints) for real post-processing
+	FFTComplexVector m_realTwiddles;
+
+	///@brief Mutex protecting m_scratchPool
+	mutable std::mutex m_scratchMutex;
+
+	/**
+		@brief Scratch buffers not currently in use by any thread
+
+		Each holds a kernel sized work area followed by the kernel's own scratch space. They're kept for the lifetime of
+		the plan so repeated transforms don't have to allocate.
+	 */
+	mutable std::vector<std::unique_ptr<FFTComplexVector> > m_scratchPool;
+
+	///@brief Key for the plan cache: (npoints, direction, batches, type)
+	typedef std::tuple<size_t, CPUFFTPlanDirection, size_t, CPUFFTDataType> PlanKey;
+
+	///@brief Mutex protecting the plan cache
+	static std::mutex m_cacheMutex;
+
+	///@brief Plans shared by all filters, freed once nobody holds a reference
+	static std::map<PlanKey, std::weak_ptr<CPUFFTPlan> > m_cache;
+};
+
+#endif
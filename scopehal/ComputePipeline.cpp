@@ -71,6 +71,32 @@ ComputePipeline::ComputePipeline(
 	m_sampledImageInfo.resize(numSampledImages);
 }
 
+/**
+	@brief Construct a new compute pipeline from a SPIR-V binary in memory, rather than a file
+
+	Initialization is deferred until the first time the shader is bound, as with the file based constructor.
+
+	@param spirv				SPIR-V binary of the shader
+	@param cacheKey				Unique name for the shader, used as the pipeline cache key
+	@param numSSBOs				Number of SSBO bindings
+	@param pushConstantSize		Size in bytes of our push constants
+ */
+ComputePipeline::ComputePipeline(
+	shared_ptr<vector<uint32_t> > spirv,
+	const string& cacheKey,
+	size_t numSSBOs,
+	size_t pushConstantSize)
+	: m_shaderPath(cacheKey)
+	, m_spirv(spirv)
+	, m_numSSBOs(numSSBOs)
+	, m_numStorageImages(0)
+	, m_numSampledImages(0)
+	, m_pushConstantSize(pushConstantSize)
+{
+	m_writeDescriptors.resize(numSSBOs);
+	m_bufferInfo.resize(numSSBOs);
+}
+
 /**
 	@brief Wipes the state of this object and recreates it with a new shader binary and configuration
 
@@ -92,6 +118,7 @@ void ComputePipeline::Reinitialize(
 {
 	//Copy paths
 	m_shaderPath = shaderPath;
+	m_spirv = nullptr;
 	m_numSSBOs = numSSBOs;
 	m_numStorageImages = numStorageImages;
 	m_numSampledImages = numSampledImages;
@@ -128,14 +155,20 @@ ComputePipeline::~ComputePipeline()
 void ComputePipeline::DeferredInit()
 {
 	//Look up the pipeline cache to see if we have a binary etc to use
+	//(generated shaders have a unique key per binary, so no timestamp needed)
 	time_t tstamp = 0;
 	int64_t fs = 0;
-	GetTimestampOfFile(FindDataFile(m_shaderPath), tstamp, fs);
+	if(!m_spirv)
+		GetTimestampOfFile(FindDataFile(m_shaderPath), tstamp, fs);
 	auto shaderBase = BaseName(m_shaderPath);
 	auto cache = g_pipelineCacheMgr->Lookup(shaderBase, tstamp);
 
 	//Load the shader module
-	auto srcvec = ReadDataFileUint32(m_shaderPath);
+	vector<uint32_t> srcvec;
+	if(m_spirv)
+		srcvec = *m_spirv;
+	else
+		srcvec = ReadDataFileUint32(m_shaderPath);
 	vk::ShaderModuleCreateInfo info({}, srcvec);
 	m_shaderModule = make_unique<vk::raii::ShaderModule>(*g_vkComputeDevice, info);
 
@@ -60,6 +60,11 @@ public:
 		size_t pushConstantSize,
 		size_t numStorageImages = 0,
 		size_t numSampledImages = 0);
+	ComputePipeline(
+		std::shared_ptr<std::vector<uint32_t> > spirv,
+		const std::string& cacheKey,
+		size_t numSSBOs,
+		size_t pushConstantSize);
 	virtual ~ComputePipeline();
 
 	void Reinitialize(
@@ -274,6 +279,54 @@ public:
 		cmdBuf.dispatch(x, y, z);
 	}
 
+	/**
+		@brief Adds a vkCmdDispatch operation to a command buffer, with push constants whose layout is only known at
+		run time (for shaders generated on the fly)
+
+		@param cmdBuf			Command buffer to append the dispatch operation to
+		@param pushConstants	Constants to pass to the shader, as 32-bit words
+		@param x				X size of the dispatch, in thread blocks
+		@param y				Y size of the dispatch, in thread blocks
+		@param z				Z size of the dispatch, in thread blocks
+	 */
+	void Dispatch(
+		vk::raii::CommandBuffer& cmdBuf,
+		const std::vector<uint32_t>& pushConstants,
+		uint32_t x,
+		uint32_t y=1,
+		uint32_t z=1)
+	{
+		if(!g_hasPushDescriptor)
+			g_vkComputeDevice->updateDescriptorSets(m_writeDescriptors, nullptr);
+
+		Bind(cmdBuf);
+		cmdBuf.pushConstants<uint32_t>(
+			**m_pipelineLayout,
+			vk::ShaderStageFlagBits::eCompute,
+			0,
+			pushConstants);
+
+		if(g_hasPushDescriptor)
+		{
+			cmdBuf.pushDescriptorSetKHR(
+				vk::PipelineBindPoint::eCompute,
+				**m_pipelineLayout,
+				0,
+			m_writeDescriptors
+			);
+		}
+		else
+		{
+			cmdBuf.bindDescriptorSets(
+				vk::PipelineBindPoint::eCompute,
+				**m_pipelineLayout,
+				0,
+				**m_descriptorSet,
+				{});
+		}
+		cmdBuf.dispatch(x, y, z);
+	}
+
 	/**
 		@brief Similar to Dispatch() but does not bind descriptor sets.
 
@@ -313,9 +366,12 @@ public:
 protected:
 	void DeferredInit();
 
-	///@brief Filesystem path to the compiled SPIR-V shader binary
+	///@brief Filesystem path to the compiled SPIR-V shader binary (or cache key, if m_spirv is used)
 	std::string m_shaderPath;
 
+	///@brief SPIR-V binary generated at run time, used instead of loading m_shaderPath if present
+	std::shared_ptr<std::vector<uint32_t> > m_spirv;
+
 	///@brief Number of SSBO bindings in the shader
 	size_t m_numSSBOs;
 
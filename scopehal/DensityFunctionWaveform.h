@@ -94,6 +94,12 @@ public:
 	virtual void PrepareForCpuAccess() override
 	{ m_outdata.PrepareForCpuAccess(); }
 
+	virtual void SetGpuCompletion(const QueueTimelinePoint& point) override
+	{ m_outdata.SetGpuCompletion(point); }
+
+	virtual const QueueTimelinePoint& GetGpuCompletion() const override
+	{ return m_outdata.GetGpuCompletion(); }
+
 	virtual void PrepareForGpuAccess() override
 	{ m_outdata.PrepareForGpuAccess();}
 
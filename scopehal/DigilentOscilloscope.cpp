@@ -429,15 +429,17 @@ bool DigilentOscilloscope::AcquireData()
 	}
 
 	//Process analog captures in parallel
-	#pragma omp parallel for
+	int nthreads = ParallelTuning::GetThreadCount(ParallelTuning::KERNEL_COPY, awfms.size(), memdepth);
+	#pragma omp parallel for if(nthreads > 1) num_threads(nthreads)
 	for(size_t i=0; i<awfms.size(); i++)
 	{
 		auto cap = awfms[i];
 
 		double* buf = abufs[i];
 		cap->PrepareForCpuAccess();
+		float* pout = cap->m_samples.GetCpuPointer();
 		for(size_t j=0; j<memdepth; j++)
-			cap->m_samples[j] = buf[j];
+			pout[j] = buf[j];
 		cap->MarkSamplesModifiedFromCpu();
 
 		delete[] abufs[i];
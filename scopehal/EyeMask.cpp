@@ -48,6 +48,9 @@
 
 using namespace std;
 
+mutex EyeMask::m_rasterCacheMutex;
+map<EyeMask::RasterKey, weak_ptr<EyeMaskRaster> > EyeMask::m_rasterCache;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -57,7 +60,6 @@ EyeMask::EyeMask()
 	, m_timebaseIsRelative(false)
 	, m_width(0)
 	, m_height(0)
-	, m_bitmapDirty(false)
 {
 }
 
@@ -82,14 +84,28 @@ bool EyeMask::Load(string path)
 	m_hitrate = 0;
 	m_timebaseIsRelative = false;
 	m_maskname = "";
-	m_bitmapDirty = true;
+	m_raster = nullptr;
+
+	//The file may have changed on disk since anyone else loaded it, so drop any cached rasters of it
+	{
+		lock_guard<mutex> lock(m_rasterCacheMutex);
+		for(auto it = m_rasterCache.begin(); it != m_rasterCache.end(); )
+		{
+			if(get<0>(it->first) == path)
+				it = m_rasterCache.erase(it);
+			else
+				it ++;
+		}
+	}
 
 	try
 	{
-		m_fname = path;
 		auto docs = YAML::LoadAllFromFile(path);
 		if(!Load(docs[0]))
 			return false;
+
+		//Only now that the polygons match the file can rasters be shared under its name
+		m_fname = path;
 	}
 	catch(const YAML::BadFile& ex)
 	{
@@ -108,11 +124,13 @@ bool EyeMask::Load(string path)
  */
 bool EyeMask::Load(const YAML::Node& node)
 {
-	//Clear out any previous state
+	//Clear out any previous state, including the file name since the polygons no longer come from it
+	m_fname = "";
 	m_polygons.clear();
 	m_hitrate = 0;
 	m_timebaseIsRelative = false;
 	m_maskname = "";
+	m_raster = nullptr;
 
 	//Load protocol section
 	auto proto = node["protocol"];
@@ -185,23 +203,33 @@ bool EyeMask::Load(const YAML::Node& node)
 }
 
 /**
-	@brief Renders the mask to an offscreen buffer we can use for hit testing
+	@brief Renders the mask and converts it to spans of covered pixels
+
+	@param width	Width of the raster, in pixels
+	@param height	Height of the raster, in pixels
+	@param uiWidth	Width of one UI, in X axis units (only used if the mask is in relative units)
+	@param xscale	Horizontal scale, in pixels per X axis unit
+	@param xoff		Horizontal offset, in X axis units
+	@param yscale	Vertical scale, in pixels per volt
+	@param yoff		Vertical offset, in volts
  */
-void EyeMask::RenderForAnalysis(
-		EyeWaveform* waveform,
+shared_ptr<EyeMaskRaster> EyeMask::RenderForAnalysis(
+		size_t width,
+		size_t height,
+		float uiWidth,
 		float xscale,
 		float xoff,
 		float yscale,
-		float yoff,
-		float height) const
+		float yoff) const
 {
 	LogTrace("Rendering mask for testing\n");
 
 	//clear background to blank
-	m_canvas->clear_rectangle(0, 0, m_width, m_height);
+	canvas_ity::canvas canvas(width, height);
+	canvas.clear_rectangle(0, 0, width, height);
 
 	//Draw each polygon
-	m_canvas->set_color( canvas_ity::fill_style, 1.0f, 1.0f, 1.0f, 1.0f );
+	canvas.set_color( canvas_ity::fill_style, 1.0f, 1.0f, 1.0f, 1.0f );
 	float ypixoff = height / 2;
 	for(auto& poly : m_polygons)
 	{
@@ -212,24 +240,66 @@ void EyeMask::RenderForAnalysis(
 			//Convert from ps to UI if needed
 			float time = point.m_time;
 			if(m_timebaseIsRelative)
-				time *= waveform->GetUIWidth();
+				time *= uiWidth;
 
 			float x = (time - xoff) * xscale;
 			float y = ( (point.m_voltage + yoff) * -yscale ) + ypixoff;
 
 			if(i == 0) // TODO: Probably not necessary and can always run line_to(x, y)
-				m_canvas->move_to(x, y); // Set to starting point for line if first run
+				canvas.move_to(x, y); // Set to starting point for line if first run
 			else
-				m_canvas->line_to(x, y); // Draw line to next coord
+				canvas.line_to(x, y); // Draw line to next coord
+		}
+		canvas.fill(); // fill the resultant line defined polygon with the current color (white)
+	}
+
+	//Pull the image back out of the canvas
+	vector<uint8_t> image_data(width*height*4);
+	canvas.get_image_data(image_data.data(), width, height, width*4, 0,0);
+
+	//Run-length encode it. Any pixel that isn't black (even partially covered) counts as part of the mask
+	auto raster = make_shared<EyeMaskRaster>(width, height);
+	raster->m_rowStart.resize(height + 1);
+	for(size_t y=0; y<height; y++)
+	{
+		raster->m_rowStart[y] = raster->m_spans.size();
+
+		auto row = image_data.data() + y*width*4;
+		size_t x = 0;
+		while(x < width)
+		{
+			//Skip uncovered pixels
+			while( (x < width) && (row[x*4] == 0) )
+				x++;
+			if(x >= width)
+				break;
+
+			//Find the end of the covered run
+			size_t start = x;
+			while( (x < width) && (row[x*4] != 0) )
+				x++;
+			raster->m_spans.push_back(EyeMaskSpan(start, x));
 		}
-		m_canvas->fill(); // fill the resultant line defined polygon with the current color (white)
 	}
+	raster->m_rowStart[height] = raster->m_spans.size();
+
+	return raster;
 }
 
 /**
-	@brief Checks a raw eye pattern dataset against the mask
+	@brief Gets the rasterized mask for hit testing, re-rendering it if needed
+
+	Rasters of masks loaded from a file are shared between all EyeMask objects using the same file at the same scale,
+	so many eye patterns checked against one mask only render it once.
+
+	@param cap				Eye pattern being tested (used for UI width if the mask is in relative units)
+	@param width			Width of the eye pattern, in pixels
+	@param height			Height of the eye pattern, in pixels
+	@param fullscalerange	Full scale vertical range of the eye pattern
+	@param xscale			Horizontal scale of the eye pattern, in pixels per X axis unit
+	@param xoff				Horizontal offset of the eye pattern, in X axis units
  */
-float EyeMask::CalculateHitRate(
+shared_ptr<const EyeMaskRaster> EyeMask::GetRaster(
 	EyeWaveform* cap,
 	size_t width,
 	size_t height,
@@ -238,51 +308,118 @@ float EyeMask::CalculateHitRate(
 	float xoff
 	)
 {
-	//TODO: GPU this?
-	//For now, we're running on the CPU though. Make sure the data is here when we need it
-	if(!m_canvas || (m_width != width) || (m_height != height) || m_bitmapDirty)
+	float yscale = height / fullscalerange;
+	float uiWidth = m_timebaseIsRelative ? cap->GetUIWidth() : 0;
+	RasterKey key(m_fname, width, height, uiWidth, xscale, xoff, yscale, 0);
+
+	//Still valid? Nothing to do
+	if(m_raster && (key == m_rasterKey))
+		return m_raster;
+
+	m_width = width;
+	m_height = height;
+	m_rasterKey = key;
+
+	//Masks that didn't come from a file can't be shared, render privately
+	if(m_fname.empty())
 	{
-		m_width = width;
-		m_height = height;
-		m_canvas = std::make_unique< canvas_ity::canvas >( width, height );
-
-		//Software rendering
-		float yscale = height / fullscalerange;
-		RenderForAnalysis(
-			cap,
-			xscale,
-			xoff,
-			yscale,
-			0,
-			height);
-
-		m_bitmapDirty = false;
+		m_raster = RenderForAnalysis(width, height, uiWidth, xscale, xoff, yscale, 0);
+		return m_raster;
 	}
 
-	//Test each pixel of the eye pattern against the mask
+	//Check the shared cache, and render if nobody else has this one yet
+	lock_guard<mutex> lock(m_rasterCacheMutex);
+	auto it = m_rasterCache.find(key);
+	if(it != m_rasterCache.end())
+		m_raster = it->second.lock();
+	else
+		m_raster = nullptr;
 
-	vector<uint8_t> image_data(width*height*4);
-	m_canvas->get_image_data(image_data.data(), width, height, m_width*4, 0,0);
+	if(!m_raster)
+	{
+		m_raster = RenderForAnalysis(width, height, uiWidth, xscale, xoff, yscale, 0);
+
+		//Clean out anything nobody is using any more before adding the new entry
+		for(auto jt = m_rasterCache.begin(); jt != m_rasterCache.end(); )
+		{
+			if(jt->second.expired())
+				jt = m_rasterCache.erase(jt);
+			else
+				jt ++;
+		}
+		m_rasterCache[key] = m_raster;
+	}
 
+	return m_raster;
+}
+
+/**
+	@brief Drops all shared rasters from the cache
+
+	Masks which currently hold a raster keep using it until they need to re-render.
+ */
+void EyeMask::ClearRasterCache()
+{
+	lock_guard<mutex> lock(m_rasterCacheMutex);
+	m_rasterCache.clear();
+}
+
+/**
+	@brief Get the most recently rendered mask as RGBA32 image data (helper for unit testing)
+
+	Covered pixels are opaque white, everything else is transparent black.
+
+	@param pixels	Empty std::vector to be filled with image data
+ */
+void EyeMask::GetPixels(vector<uint8_t>& pixels)
+{
+	pixels.clear();
+	pixels.resize(m_width * m_height * 4);
+	if(!m_raster)
+		return;
+
+	auto data = reinterpret_cast<uint32_t*>(pixels.data());
+	for(size_t y=0; y<m_height; y++)
+	{
+		auto row = data + y*m_width;
+		for(auto span = m_raster->GetRowBegin(y); span != m_raster->GetRowEnd(y); span++)
+		{
+			for(size_t x=span->m_start; x<span->m_end; x++)
+				row[x] = 0xffffffff;
+		}
+	}
+}
+
+/**
+	@brief Checks a raw eye pattern dataset against the mask
+ */
+float EyeMask::CalculateHitRate(
+	EyeWaveform* cap,
+	size_t width,
+	size_t height,
+	float fullscalerange,
+	float xscale,
+	float xoff
+	)
+{
+	//TODO: GPU this?
+	//For now, we're running on the CPU though. Make sure the data is here when we need it
+	auto raster = GetRaster(cap, width, height, fullscalerange, xscale, xoff);
+
+	//Test each covered span of the mask against the eye pattern
 	if(cap->GetType() == EyeWaveform::EYE_NORMAL)
 	{
 		cap->GetAccumBuffer().PrepareForCpuAccess();
 		auto accum = cap->GetAccumData();
 		size_t nhits = 0;
 
-		uint32_t* data = reinterpret_cast<uint32_t*>(&image_data[0]);
 		for(size_t y=0; y<height; y++)
 		{
-			auto row = data + (y*width);
 			auto eyerow = accum + (y*width);
-
-			for(size_t x=0; x<width; x++)
+			for(auto span = raster->GetRowBegin(y); span != raster->GetRowEnd(y); span++)
 			{
-				//If mask pixel isn't black, count violations
-				uint32_t pix = row[x];
-				auto hits = eyerow[x];
-				if(pix & 0xff)
-					nhits += hits;
+				for(size_t x=span->m_start; x<span->m_end; x++)
+					nhits += eyerow[x];
 			}
 		}
 
@@ -295,22 +432,14 @@ float EyeMask::CalculateHitRate(
 		auto accum = cap->GetData();
 		float nmax = 0;
 
-		uint32_t* data = reinterpret_cast<uint32_t*>(&image_data[0]);
 		for(size_t y=0; y<height; y++)
 		{
-			auto row = data + (y*width);
 			auto eyerow = accum + (y*width);
-			for(size_t x=0; x<width; x++)
+			for(auto span = raster->GetRowBegin(y); span != raster->GetRowEnd(y); span++)
 			{
-				//If mask pixel isn't black, count violations
-				uint32_t pix = row[x];
-				if( (pix & 0xff) != 0)
-				{
-					//BER eyes don't need any preprocessing since the pixel values are already raw BER
-					float rate = eyerow[x];
-					if(rate > nmax)
-						nmax = rate;
-				}
+				//BER eyes don't need any preprocessing since the pixel values are already raw BER
+				for(size_t x=span->m_start; x<span->m_end; x++)
+					nmax = max(nmax, eyerow[x]);
 			}
 		}
 
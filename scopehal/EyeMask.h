@@ -90,6 +90,81 @@ public:
 	std::vector<EyeMaskPoint> m_points;
 };
 
+/**
+	@brief A horizontal run of covered pixels within one row of an EyeMaskRaster
+	@ingroup datamodel
+ */
+class EyeMaskSpan
+{
+public:
+
+	/**
+		@brief Initialize a span
+
+		@param start	X coordinate of the first covered pixel
+		@param end		X coordinate one past the last covered pixel
+	 */
+	EyeMaskSpan(uint32_t start, uint32_t end)
+	: m_start(start)
+	, m_end(end)
+	{}
+
+	///@brief X coordinate of the first covered pixel
+	uint32_t m_start;
+
+	///@brief X coordinate one past the last covered pixel
+	uint32_t m_end;
+};
+
+/**
+	@brief An EyeMask rasterized at one specific size and scale, stored as per-row spans of covered pixels
+	@ingroup datamodel
+
+	Hit testing only needs to visit pixels inside the mask, which are typically a small fraction of the eye, so the
+	raster is kept run-length encoded rather than as a full bitmap.
+
+	Rasters are immutable once created and shared between every EyeMask using the same file at the same scale.
+ */
+class EyeMaskRaster
+{
+public:
+
+	/**
+		@brief Creates an empty raster
+
+		@param width	Width of the raster, in pixels
+		@param height	Height of the raster, in pixels
+	 */
+	EyeMaskRaster(size_t width, size_t height)
+	: m_width(width)
+	, m_height(height)
+	{}
+
+	///@brief Width of the raster, in pixels
+	size_t m_width;
+
+	///@brief Height of the raster, in pixels
+	size_t m_height;
+
+	/**
+		@brief Index of the first span in each row
+
+		Has m_height+1 entries, so row y covers spans m_rowStart[y] through m_rowStart[y+1]-1
+	 */
+	std::vector<uint32_t> m_rowStart;
+
+	///@brief Covered spans, sorted by row then X coordinate
+	std::vector<EyeMaskSpan> m_spans;
+
+	///@brief Get a pointer to the first span of a row
+	const EyeMaskSpan* GetRowBegin(size_t y) const
+	{ return m_spans.data() + m_rowStart[y]; }
+
+	///@brief Get a pointer one past the last span of a row
+	const EyeMaskSpan* GetRowEnd(size_t y) const
+	{ return m_spans.data() + m_rowStart[y+1]; }
+};
+
 /**
 	@brief A mask used for checking eye patterns
 	@ingroup datamodel
@@ -120,15 +195,15 @@ public:
 	float GetAllowedHitRate() const
 	{ return m_hitrate; }
 
-	void RenderForAnalysis(
-		EyeWaveform* waveform,
+	float CalculateHitRate(
+		EyeWaveform* cap,
+		size_t width,
+		size_t height,
+		float fullscalerange,
 		float xscale,
-		float xoff,
-		float yscale,
-		float yoff,
-		float height) const;
+		float xoff);
 
-	float CalculateHitRate(
+	std::shared_ptr<const EyeMaskRaster> GetRaster(
 		EyeWaveform* cap,
 		size_t width,
 		size_t height,
@@ -136,6 +211,8 @@ public:
 		float xscale,
 		float xoff);
 
+	static void ClearRasterCache();
+
 	///@brief Return true if there are no polygons in the mask
 	bool empty() const
 	{ return m_polygons.empty(); }
@@ -159,18 +236,25 @@ public:
 	//Helpers for unit testing
 public:
 
+	void GetPixels(std::vector<uint8_t>& pixels);
+
+protected:
+
+	std::shared_ptr<EyeMaskRaster> RenderForAnalysis(
+		size_t width,
+		size_t height,
+		float uiWidth,
+		float xscale,
+		float xoff,
+		float yscale,
+		float yoff) const;
+
 	/**
-		@brief Get the raw image data as RGBA32
+		@brief Key for looking up a cached raster
 
-		@param pixels	Empty std::vector to be filled with image data
+		(file name, width, height, UI width, xscale, xoff, yscale, yoff)
 	 */
-	void GetPixels(std::vector<uint8_t>& pixels)
-	{
-		pixels.resize(m_width * m_height * 4);
-		m_canvas->get_image_data(pixels.data(), m_width, m_height, m_width*4, 0,0);
-	}
-
-protected:
+	typedef std::tuple<std::string, size_t, size_t, float, float, float, float, float> RasterKey;
 
 	///@brief Filename of the mask
 	std::string m_fname;
@@ -187,17 +271,27 @@ protected:
 	///@brief Human readable name of the mask (e.g. "XFI")
 	std::string m_maskname;
 
-	///@brief Canvas for rasterizing the mask
-    std::unique_ptr< canvas_ity::canvas > m_canvas;
-
 	///@brief Current width
     size_t m_width;
 
     ///@brief Current height
     size_t m_height;
 
-    ///@brief True if we need to re-render
-    bool m_bitmapDirty;
+	///@brief The raster we're currently using for hit testing (null if we need to re-render)
+	std::shared_ptr<EyeMaskRaster> m_raster;
+
+	///@brief Cache key of m_raster
+	RasterKey m_rasterKey;
+
+	///@brief Mutex protecting the raster cache
+	static std::mutex m_rasterCacheMutex;
+
+	/**
+		@brief Rasters shared by all masks loaded from the same file at the same scale
+
+		Entries are weak so a raster is freed once no mask is using it any more.
+	 */
+	static std::map<RasterKey, std::weak_ptr<EyeMaskRaster> > m_rasterCache;
 };
 
 #endif
@@ -191,6 +191,12 @@ public:
 		m_accumdata.PrepareForCpuAccess();
 	}
 
+	virtual void SetGpuCompletion(const QueueTimelinePoint& point) override
+	{
+		m_outdata.SetGpuCompletion(point);
+		m_accumdata.SetGpuCompletion(point);
+	}
+
 	virtual void PrepareForGpuAccess() override
 	{
 		m_outdata.PrepareForGpuAccess();
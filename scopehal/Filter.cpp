@@ -320,6 +320,106 @@ void Filter::FillDurationsAVX2(SparseWaveformBase& wfm)
 }
 #endif /* __x86_64__ */
 
+/**
+	@brief Samples several digital signals on the rising edges of a common clock
+
+	Equivalent to calling SampleOnRisingEdgesBase() once per input, but the clock is only scanned once and all inputs
+	share a single set of timestamps. Bit i of each output sample is the value of data[i] at that clock edge.
+
+	If any input is empty or not a digital waveform, the output is empty (matching the length of the shortest
+	per-signal result).
+
+	@param data		The data signals to sample (at most 32). Can be sparse or uniform digital.
+	@param clock	The clock signal to use. Must be sparse or uniform digital.
+	@param samples	Output waveform, with timestamps in femtoseconds
+ */
+void Filter::SampleBusOnRisingEdges(
+	const vector<WaveformBase*>& data,
+	WaveformBase* clock,
+	SparseDigitalBusWaveform32& samples)
+{
+	samples.clear();
+	samples.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_NEVER);
+	samples.PrepareForCpuAccess();
+
+	clock->PrepareForCpuAccess();
+	auto uclock = dynamic_cast<UniformDigitalWaveform*>(clock);
+	auto sclock = dynamic_cast<SparseDigitalWaveform*>(clock);
+	if(!uclock && !sclock)
+		return;
+
+	//Per-input read cursors
+	struct BusInput
+	{
+		SparseDigitalWaveform* m_sparse;
+		UniformDigitalWaveform* m_uniform;
+		const bool* m_samples;
+		size_t m_len;
+		size_t m_index;
+	};
+	size_t ninputs = min(data.size(), (size_t)32);
+	vector<BusInput> inputs(ninputs);
+	for(size_t j=0; j<ninputs; j++)
+	{
+		auto& in = inputs[j];
+		data[j]->PrepareForCpuAccess();
+		in.m_sparse = dynamic_cast<SparseDigitalWaveform*>(data[j]);
+		in.m_uniform = dynamic_cast<UniformDigitalWaveform*>(data[j]);
+		if(in.m_sparse)
+			in.m_samples = in.m_sparse->m_samples.GetCpuPointer();
+		else if(in.m_uniform)
+			in.m_samples = in.m_uniform->m_samples.GetCpuPointer();
+		else
+			return;
+		in.m_len = data[j]->size();
+		in.m_index = 0;
+		if(!in.m_len)
+			return;
+	}
+
+	//Find the clock edges once, and use their timestamps for every input
+	size_t len = clock->size();
+	const bool* clk = sclock ? sclock->m_samples.GetCpuPointer() : uclock->m_samples.GetCpuPointer();
+	for(size_t i=1; i<len; i++)
+	{
+		if(clk[i] && !clk[i-1])
+			samples.m_offsets.push_back(GetOffsetScaled(sclock, uclock, i));
+	}
+
+	//Sample every input at each edge, advancing each cursor the same way SampleOnRisingEdges() does
+	size_t nedges = samples.m_offsets.size();
+	samples.m_samples.resize(nedges);
+	int64_t* offsets = samples.m_offsets.GetCpuPointer();
+	uint32_t* words = samples.m_samples.GetCpuPointer();
+	for(size_t i=0; i<nedges; i++)
+	{
+		int64_t clkstart = offsets[i];
+		uint32_t word = 0;
+		for(size_t j=0; j<ninputs; j++)
+		{
+			auto& in = inputs[j];
+			while( (in.m_index+1 < in.m_len) &&
+				(GetOffsetScaled(in.m_sparse, in.m_uniform, in.m_index+1) < clkstart) )
+			{
+				in.m_index ++;
+			}
+			if(in.m_samples[in.m_index])
+				word |= (1U << j);
+		}
+		words[i] = word;
+	}
+
+	//Compute sample durations
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		FillDurationsAVX2(samples);
+	else
+	#endif
+		FillDurationsGeneric(samples);
+
+	samples.MarkModifiedFromCpu();
+}
+
 /**
 	@brief Find rising edges in a waveform, interpolating to sub-sample resolution as necessary
  */
@@ -1272,6 +1372,65 @@ SparseDigitalWaveform* Filter::SetupSparseDigitalOutputWaveform(SparseWaveformBa
 	return cap;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shader fusion
+
+/**
+	@brief Gets an elementwise kernel equivalent to this filter, which may be fused with its neighbors
+
+	The filter graph executor uses this to merge linear chains of elementwise filters into a single shader, so
+	intermediate waveforms never have to be written to and read back from GPU memory.
+
+	The default implementation returns nullptr (not fusible). Filters which override this should only return a kernel
+	if, in the current configuration, their Refresh() would do nothing but apply the kernel to every sample of
+	uniformly sampled analog inputs of equal timebase and produce a single output stream.
+
+	@param inputs	Filter input index supplying each of the kernel's inputs, in order
+
+	@return The kernel, or nullptr if the filter cannot be fused in the current configuration
+ */
+shared_ptr<FusibleShader> Filter::GetFusibleShader(vector<size_t>& /*inputs*/)
+{
+	return nullptr;
+}
+
+/**
+	@brief Does the CPU-side work of Refresh() when this filter is executed as part of a fused shader
+
+	Derived classes which return a kernel from GetFusibleShader() should update output units etc. here as Refresh()
+	would, then append the values of the kernel's push constants in declaration order.
+
+	@param pushConstants	Push constant words to append to
+ */
+void Filter::PrepareFusedRefresh(vector<uint32_t>& /*pushConstants*/)
+{
+}
+
+/**
+	@brief Sets up the output waveform of a filter being executed as part of a fused shader
+
+	@param din		Input waveform to copy timebase metadata from
+	@param len		Length of the output waveform
+	@param digital	True for a uniform digital output, false for uniform analog
+
+	@return	The ready-to-use output waveform
+ */
+WaveformBase* Filter::SetupFusedOutputWaveform(WaveformBase* din, size_t len, bool digital)
+{
+	if(digital)
+	{
+		auto cap = SetupEmptyUniformDigitalOutputWaveform(din, 0);
+		cap->Resize(len);
+		return cap;
+	}
+	else
+	{
+		auto cap = SetupEmptyUniformAnalogOutputWaveform(din, 0);
+		cap->Resize(len);
+		return cap;
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Event driven filter processing
 
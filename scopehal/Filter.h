@@ -240,6 +240,14 @@ public:
 	virtual float GetOffset(size_t stream) override;
 	virtual void SetOffset(float offset, size_t stream) override;
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Shader fusion
+
+	virtual std::shared_ptr<FusibleShader> GetFusibleShader(std::vector<size_t>& inputs);
+	virtual void PrepareFusedRefresh(std::vector<uint32_t>& pushConstants);
+
+	WaveformBase* SetupFusedOutputWaveform(WaveformBase* din, size_t len, bool digital);
+
 protected:
 
 	///@brief Y axis range of each output stream
@@ -1205,6 +1213,11 @@ public:
 			SampleOnRisingEdges(sdata, uclock, samples);
 	}
 
+	static void SampleBusOnRisingEdges(
+		const std::vector<WaveformBase*>& data,
+		WaveformBase* clock,
+		SparseDigitalBusWaveform32& samples);
+
 	/**
 		@brief Samples a waveform on the falling edges of a clock
 
@@ -36,11 +36,57 @@
 
 #include "scopehal.h"
 #include <shared_mutex>
-#include "FusibleShader.h"
-#include "ShaderBaker.h"
 
 using namespace std;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ConcurrentDispatchBatch
+
+/**
+	@brief Creates a batch
+
+	@param needBegin	True if the command buffer has to be opened before running the first node
+	@param needEnd		True if the command buffer has to be closed and submitted after running the last node
+	@param nodes		The nodes to run
+	@param fusedChains	All fused chains in the graph (the ones ending at a node in this batch are run instead of it)
+ */
+ConcurrentDispatchBatch::ConcurrentDispatchBatch(
+	bool needBegin,
+	bool needEnd,
+	const set<FlowGraphNode*>& nodes,
+	const FusedChainMap& fusedChains)
+	: m_needBegin(needBegin)
+	, m_needEnd(needEnd)
+	, m_nodes(nodes)
+{
+	for(auto p : m_nodes)
+	{
+		auto it = fusedChains.find(p);
+		if(it != fusedChains.end())
+			m_fusedChains[p] = it->second;
+	}
+}
+
+/**
+	@brief Enqueue all of the filters in this batch to the command buffer, and possibly submit it
+ */
+void ConcurrentDispatchBatch::Run(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	for(auto p : m_nodes)
+	{
+		//Nodes that end their refresh with SubmitAsync() leave their outputs pending on the GPU
+		auto before = queue->GetLastSubmission().m_value;
+		auto it = m_fusedChains.find(p);
+		if(it != m_fusedChains.end())
+			it->second->Refresh(cmdBuf, queue);
+		else
+			p->Refresh(cmdBuf, queue);
+		auto after = queue->GetLastSubmission();
+		if(after.m_value != before)
+			SubmitBatch::SetGpuCompletion(p, after);
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // SubmitBatch
 
@@ -52,6 +98,19 @@ void SubmitBatch::Run(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> q
 	LogTrace("Running batch\n");
 	LogIndenter li;
 
+	//Inputs may still be being written by asynchronous submits from other nodes.
+	//Make the GPU wait for them before running anything we submit; CPU consumers block in PrepareForCpuAccess().
+	auto nodes = GetNodes();
+	for(auto f : nodes)
+	{
+		for(size_t i=0; i<f->GetInputCount(); i++)
+		{
+			auto data = f->GetInput(i).GetData();
+			if(data)
+				queue->AddWait(data->GetGpuCompletion());
+		}
+	}
+
 	//Open command buffer if needed for first node
 	if(m_batches[0].GetNeedBegin())
 		cmdBuf.begin({});
@@ -68,11 +127,33 @@ void SubmitBatch::Run(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> q
 			ComputePipeline::AddComputeMemoryBarrier(cmdBuf);
 	}
 
-	//Submit if needed
+	//Submit if needed, but don't wait for completion: downstream nodes wait on the timeline
 	if(m_batches[m_batches.size() - 1].GetNeedEnd())
 	{
 		cmdBuf.end();
-		queue->SubmitAndBlock(cmdBuf);
+		auto point = queue->SubmitAsync(cmdBuf);
+		if(point.IsValid())
+		{
+			for(auto f : nodes)
+				SetGpuCompletion(f, point);
+		}
+	}
+}
+
+/**
+	@brief Tags every output stream of a node with the completion token of the submission that writes it
+ */
+void SubmitBatch::SetGpuCompletion(FlowGraphNode* node, const QueueTimelinePoint& point)
+{
+	auto chan = dynamic_cast<InstrumentChannel*>(node);
+	if(!chan)
+		return;
+
+	for(size_t i=0; i<chan->GetStreamCount(); i++)
+	{
+		auto data = chan->GetData(i);
+		if(data)
+			data->SetGpuCompletion(point);
 	}
 }
 
@@ -96,6 +177,7 @@ set<FlowGraphNode*> SubmitBatch::GetNodes()
 FilterGraphExecutor::FilterGraphExecutor(size_t numThreads)
 	: m_allWorkersComplete(true)
 	, m_terminating(false)
+	, m_fusionBytesSaved(0)
 {
 	//Create our thread pool
 	for(size_t i=0; i<numThreads; i++)
@@ -123,26 +205,6 @@ void FilterGraphExecutor::RunBlocking(const set<FlowGraphNode*>& nodes)
 	if(nodes.empty())
 		return;
 
-	////////////////////////////////////////////////
-
-	/*
-	//TEST: try to dynamically generate the shader
-	auto es = make_shared<FusibleShader>("EmphasisFilter.glsl", "EmphasisFilter");
-	auto us = make_shared<FusibleShader>("UpsampleFilter.glsl", "EmphasisFilter");
-
-	auto stage1 = make_shared<BakedShaderStage>(es);
-	auto stage2 = make_shared<BakedShaderStage>(us);
-
-	ShaderBaker baker;
-	baker.AddStage(stage1);
-	baker.AddStage(stage2);
-
-	auto str = baker.Bake();
-	LogDebug("BAKED SHADER\n%s\n", str.c_str());
-	*/
-
-	//////////////////////////////////////////
-
 	LogTrace("Start graph refresh\n");
 	LogIndenter li;
 
@@ -160,6 +222,18 @@ void FilterGraphExecutor::RunBlocking(const set<FlowGraphNode*>& nodes)
 		m_incompleteNodes = nodes;
 		m_incompleteNodes.erase(nullptr);	//don't crash if a null filter somehow ended up in the list
 
+		//Merge chains of elementwise filters into a single shader.
+		//Only the last filter of each chain is scheduled, the chain runs in its place.
+		FindFusedChains(m_incompleteNodes);
+		for(auto& it : m_fusedChains)
+		{
+			for(auto f : it.second->GetStages())
+			{
+				if(f != it.first)
+					m_incompleteNodes.erase(f);
+			}
+		}
+
 		m_runnableNodes.clear();
 		m_allWorkersComplete = false;
 
@@ -180,6 +254,20 @@ void FilterGraphExecutor::RunBlocking(const set<FlowGraphNode*>& nodes)
 			break;
 	}
 
+	//Batches are submitted without blocking, so wait for the GPU to catch up before handing results back.
+	//Consumers outside the graph (rendering etc) may use output buffers from any queue.
+	{
+		lock_guard<mutex> lock(m_mutex);
+		for(auto& q : m_queues)
+			q->WaitIdle();
+
+		m_fusionBytesSaved = 0;
+		for(auto& it : m_fusedChains)
+			m_fusionBytesSaved += it.second->GetLastBytesSaved();
+		if(m_fusionBytesSaved)
+			LogTrace("Filter fusion saved %zu bytes of memory traffic\n", m_fusionBytesSaved);
+	}
+
 	//Update global performance stats
 	{
 		lock_guard<mutex> lock(m_perfStatsMutex);
@@ -243,7 +331,7 @@ void FilterGraphExecutor::FindConcurrentNodes(
 	else
 	{
 		//Check flags on the anchor node
-		auto flags = anchor->GetExecutionCapabilitiesMask();
+		auto flags = GetExecutionCapabilities(anchor);
 
 		//Short names for some long flags
 		const uint32_t canAppend =
@@ -267,7 +355,7 @@ void FilterGraphExecutor::FindConcurrentNodes(
 			{
 				if(f == anchor)
 					continue;
-				auto mask = f->GetExecutionCapabilitiesMask();
+				auto mask = GetExecutionCapabilities(f);
 
 				//Tail call capability required for now if we already have stuff in the working set
 				//because we can't guarantee a non-tail-callable node is going to execute
@@ -350,7 +438,7 @@ void FilterGraphExecutor::MakeBatchForNodes(
 {
 	LogTrace("Making batch with %zu nodes (needBegin=%d, needEnd=%d)\n",
 		workingSet.size(), needBegin, needEnd);
-	ConcurrentDispatchBatch cbatch(needBegin, needEnd, workingSet);
+	ConcurrentDispatchBatch cbatch(needBegin, needEnd, workingSet, m_fusedChains);
 	for(auto f : workingSet)
 	{
 		m_runnableNodes.erase(f);
@@ -400,7 +488,7 @@ bool FilterGraphExecutor::FindNextHopNodes(SubmitBatch& batch)
 		//If this node is not purely GPU based, stop.
 		//It might do CPU processing beforehand that depends on data we haven't generated yet!
 		//Also bail if it can't be appended to an open command buffer.
-		auto fmask = f->GetExecutionCapabilitiesMask();
+		auto fmask = GetExecutionCapabilities(f);
 		if( (fmask & nextHopMask) != nextHopMask)
 			continue;
 
@@ -412,10 +500,8 @@ bool FilterGraphExecutor::FindNextHopNodes(SubmitBatch& batch)
 		//Not actively running.
 		//Is it blocked by anything earlier in the batch?
 		bool ok = true;
-		for(size_t i=0; i<f->GetInputCount(); i++)
+		for(auto in : GetUpstreamNodes(f))
 		{
-			auto in = f->GetInput(i).m_channel;
-
 			//If the source of this input is already done, we're good
 			if(m_incompleteNodes.find(in) == m_incompleteNodes.end())
 				continue;
@@ -457,7 +543,7 @@ bool FilterGraphExecutor::FindNextHopNodes(SubmitBatch& batch)
 			//If this node is not purely GPU based, stop.
 			//It might do CPU processing beforehand that depends on data we haven't generated yet!
 			//Also bail if it can't be appended to an open command buffer.
-			auto fmask = f->GetExecutionCapabilitiesMask();
+			auto fmask = GetExecutionCapabilities(f);
 			if( (fmask & nextHopMask) != nextHopMask)
 				continue;
 
@@ -468,10 +554,8 @@ bool FilterGraphExecutor::FindNextHopNodes(SubmitBatch& batch)
 			//Not actively running.
 			//Is it blocked by anything earlier in the batch?
 			bool ok = true;
-			for(size_t i=0; i<f->GetInputCount(); i++)
+			for(auto in : GetUpstreamNodes(f))
 			{
-				auto in = f->GetInput(i).m_channel;
-
 				//If the source of this input is already done, we're good
 				if(m_incompleteNodes.find(in) == m_incompleteNodes.end())
 					continue;
@@ -523,9 +607,8 @@ void FilterGraphExecutor::UpdateRunnable()
 		//Not actively running.
 		//Is it blocked by any of our incomplete filters?
 		bool ok = true;
-		for(size_t i=0; i<f->GetInputCount(); i++)
+		for(auto in : GetUpstreamNodes(f))
 		{
-			auto in = f->GetInput(i).m_channel;
 			if(m_incompleteNodes.find(in) != m_incompleteNodes.end())
 			{
 				ok = false;
@@ -539,6 +622,156 @@ void FilterGraphExecutor::UpdateRunnable()
 	}
 }
 
+/**
+	@brief Gets the nodes which have to be complete before a node can run
+
+	For the last filter of a fused chain, these are the sources of every input to the chain.
+ */
+set<FlowGraphNode*> FilterGraphExecutor::GetUpstreamNodes(FlowGraphNode* node)
+{
+	set<FlowGraphNode*> ret;
+
+	auto it = m_fusedChains.find(node);
+	if(it != m_fusedChains.end())
+	{
+		for(auto& s : it->second->GetExternalInputs())
+			ret.emplace(s.m_channel);
+	}
+	else
+	{
+		for(size_t i=0; i<node->GetInputCount(); i++)
+			ret.emplace(node->GetInput(i).m_channel);
+	}
+
+	return ret;
+}
+
+/**
+	@brief Gets the execution capabilities of a node, as used for scheduling
+
+	Fused chains open and submit their own command buffer, and may fall back to running their filters one at a time,
+	so they always get a batch of their own.
+ */
+uint32_t FilterGraphExecutor::GetExecutionCapabilities(FlowGraphNode* node)
+{
+	if(m_fusedChains.find(node) != m_fusedChains.end())
+		return 0;
+	return node->GetExecutionCapabilitiesMask();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shader fusion
+
+/**
+	@brief Looks for linear chains of elementwise filters which can be run as a single shader
+
+	A filter can be merged with the next one in a chain if both provide a kernel, and its output is used only by
+	that filter (not by other filters, or displayed).
+
+	Assumes m_mutex is locked
+
+	@param nodes	The nodes being evaluated
+ */
+void FilterGraphExecutor::FindFusedChains(const set<FlowGraphNode*>& nodes)
+{
+	//Find the consumers of each node
+	map<FlowGraphNode*, vector<FlowGraphNode*> > consumers;
+	for(auto n : nodes)
+	{
+		for(size_t i=0; i<n->GetInputCount(); i++)
+		{
+			auto in = n->GetInput(i).m_channel;
+			if(in)
+				consumers[in].push_back(n);
+		}
+	}
+
+	//Find the upstream filter (if any) each fusible filter can be merged with
+	map<Filter*, Filter*> prev;
+	set<Filter*> hasNext;
+	for(auto n : nodes)
+	{
+		auto g = dynamic_cast<Filter*>(n);
+		if(!g)
+			continue;
+		vector<size_t> ginputs;
+		if(!g->GetFusibleShader(ginputs))
+			continue;
+
+		for(auto j : ginputs)
+		{
+			auto stream = g->GetInput(j);
+			auto f = dynamic_cast<Filter*>(stream.m_channel);
+			if(!f || (nodes.find(f) == nodes.end()) )
+				continue;
+
+			//Intermediate output must not be used by anything else
+			if( (f->GetStreamCount() != 1) || (stream.m_stream != 0) ||
+				(f->GetRefCount() != 1) || (consumers[f].size() != 1) )
+			{
+				continue;
+			}
+
+			//and must be a plain float waveform
+			vector<size_t> finputs;
+			auto fkernel = f->GetFusibleShader(finputs);
+			if(!fkernel || (fkernel->m_outputType != "float") )
+				continue;
+
+			prev[g] = f;
+			hasNext.emplace(f);
+			break;
+		}
+	}
+
+	//Walk back from the end of each chain
+	FusedChainMap chains;
+	for(auto& it : prev)
+	{
+		auto tail = it.first;
+		if(hasNext.find(tail) != hasNext.end())
+			continue;
+
+		vector<Filter*> stages;
+		for(auto f = tail; f != nullptr; )
+		{
+			stages.push_back(f);
+			auto jt = prev.find(f);
+			f = (jt == prev.end()) ? nullptr : jt->second;
+		}
+		reverse(stages.begin(), stages.end());
+
+		//Drop stages from the start of the chain until the shader fits in the available resources
+		while(stages.size() >= 2)
+		{
+			auto chain = make_shared<FusedFilterChain>(stages);
+			if(!chain->IsValid())
+				break;
+
+			if( (chain->GetPushConstantSize() > m_maxFusedPushConstantSize) ||
+				(chain->GetExternalInputs().size() > m_maxFusedInputs) )
+			{
+				stages.erase(stages.begin());
+				continue;
+			}
+
+			//Keep the existing chain (and its compiled shader) if nothing changed
+			auto jt = m_fusedChains.find(tail);
+			if( (jt != m_fusedChains.end()) && jt->second->IsSameAs(*chain) )
+				chains[tail] = jt->second;
+			else
+			{
+				LogDebug("Fusing %zu filters ending at %s (saves %zu bytes of memory traffic per sample)\n",
+					stages.size(), tail->GetDisplayName().c_str(), chain->GetBytesSavedPerSample());
+				chains[tail] = chain;
+			}
+			break;
+		}
+	}
+
+	m_fusedChains = chains;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // 	Main parallel execution logic
 
@@ -576,15 +809,22 @@ void FilterGraphExecutor::DoExecutorThread(size_t i)
 		queue->GetQueue()->m_family );
 	vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
 
-	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
-	vk::raii::CommandBuffer cmdbuf(std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_queues.push_back(queue);
+	}
+
+	//Rotate through several command buffers, so we can record the next batch while the previous one is executing
+	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, m_cmdBufsPerThread);
+	vk::raii::CommandBuffers cmdbufs(*g_vkComputeDevice, bufinfo);
+	vector<QueueTimelinePoint> cmdbufCompletion(m_cmdBufsPerThread);
+	size_t nbuf = 0;
 
 	if(g_hasDebugUtils)
 	{
 		string prefix = string("FilterGraphExecutor[") + to_string(i) + "]";
 
 		string poolname = prefix + ".pool";
-		string bufname = prefix + ".cmdbuf";
 
 		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
 			vk::DebugUtilsObjectNameInfoEXT(
@@ -592,11 +832,16 @@ void FilterGraphExecutor::DoExecutorThread(size_t i)
 				reinterpret_cast<uint64_t>(static_cast<VkCommandPool>(*pool)),
 				poolname.c_str()));
 
-		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
-			vk::DebugUtilsObjectNameInfoEXT(
-				vk::ObjectType::eCommandBuffer,
-				reinterpret_cast<uint64_t>(static_cast<VkCommandBuffer>(*cmdbuf)),
-				bufname.c_str()));
+		for(size_t j=0; j<m_cmdBufsPerThread; j++)
+		{
+			string bufname = prefix + ".cmdbuf[" + to_string(j) + "]";
+
+			g_vkComputeDevice->setDebugUtilsObjectNameEXT(
+				vk::DebugUtilsObjectNameInfoEXT(
+					vk::ObjectType::eCommandBuffer,
+					reinterpret_cast<uint64_t>(static_cast<VkCommandBuffer>(*cmdbufs[j])),
+					bufname.c_str()));
+		}
 	}
 
 	//Main loop
@@ -629,9 +874,19 @@ void FilterGraphExecutor::DoExecutorThread(size_t i)
 			auto filters = batch.GetNodes();
 			LogTrace("Runner %zu: got batch of %zu nodes\n", i, filters.size());
 
-			//Run the batch
+			//Run the batch.
+			//If the command buffer was submitted asynchronously, move on to the next one in the ring
+			//(waiting for it if it's still in flight)
 			double start = GetTime();
-			batch.Run(cmdbuf, queue);
+			auto before = queue->GetLastSubmission().m_value;
+			batch.Run(cmdbufs[nbuf], queue);
+			auto after = queue->GetLastSubmission();
+			if(after.m_value != before)
+			{
+				cmdbufCompletion[nbuf] = after;
+				nbuf = (nbuf + 1) % m_cmdBufsPerThread;
+				cmdbufCompletion[nbuf].Wait();
+			}
 			double dt = GetTime() - start;
 			int64_t fs = dt * FS_PER_SECOND;
 
@@ -49,11 +49,11 @@ class ConcurrentDispatchBatch
 {
 public:
 
-	ConcurrentDispatchBatch(bool needBegin, bool needEnd, const std::set<FlowGraphNode*>& nodes)
-		: m_needBegin(needBegin)
-		, m_needEnd(needEnd)
-		, m_nodes(nodes)
-	{}
+	ConcurrentDispatchBatch(
+		bool needBegin,
+		bool needEnd,
+		const std::set<FlowGraphNode*>& nodes,
+		const FusedChainMap& fusedChains);
 
 	bool GetNeedBegin()
 	{ return m_needBegin; }
@@ -64,19 +64,15 @@ public:
 	const std::set<FlowGraphNode*>& GetNodes()
 	{ return m_nodes; }
 
-	/**
-		@brief Enqueue all of the filters in this batch to the command buffer, and possibly submit it
-	 */
-	void Run(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue)
-	{
-		for(auto p : m_nodes)
-			p->Refresh(cmdBuf, queue);
-	}
+	void Run(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
 
 protected:
 	bool m_needBegin;
 	bool m_needEnd;
 	std::set<FlowGraphNode*> m_nodes;
+
+	///@brief Fused chains to run in place of nodes in m_nodes
+	FusedChainMap m_fusedChains;
 };
 
 /**
@@ -95,6 +91,8 @@ public:
 
 	std::set<FlowGraphNode*> GetNodes();
 
+	static void SetGpuCompletion(FlowGraphNode* node, const QueueTimelinePoint& point);
+
 protected:
 	std::vector<ConcurrentDispatchBatch> m_batches;
 };
@@ -113,6 +111,10 @@ public:
 
 	SubmitBatch GetNextBatch();
 
+	///@brief Get the number of bytes of memory traffic avoided by filter fusion in the most recent evaluation
+	size_t GetFusionBytesSaved()
+	{ return m_fusionBytesSaved; }
+
 	///@brief Get the run times of the most recent filter graph evaluation
 	std::map<FlowGraphNode*, int64_t> GetRunTimes()
 	{
@@ -144,6 +146,10 @@ protected:
 
 	void UpdateRunnable();
 
+	void FindFusedChains(const std::set<FlowGraphNode*>& nodes);
+	std::set<FlowGraphNode*> GetUpstreamNodes(FlowGraphNode* node);
+	uint32_t GetExecutionCapabilities(FlowGraphNode* node);
+
 	///@brief Mutex for access to shared state
 	std::mutex m_mutex;
 
@@ -159,6 +165,24 @@ protected:
 	///@brief Set of thread contexts
 	std::vector<std::unique_ptr<std::thread>> m_threads;
 
+	///@brief Queues used by each thread, drained at the end of each run (protected by m_mutex)
+	std::vector<std::shared_ptr<QueueHandle>> m_queues;
+
+	///@brief Number of command buffers each thread rotates through, so batches can be submitted asynchronously
+	static constexpr size_t m_cmdBufsPerThread = 4;
+
+	///@brief Chains of elementwise filters executed as a single shader, indexed by the last filter in the chain
+	FusedChainMap m_fusedChains;
+
+	///@brief Max push constant size for a fused shader (the minimum every Vulkan implementation supports)
+	static constexpr size_t m_maxFusedPushConstantSize = 128;
+
+	///@brief Max number of input buffers for a fused shader
+	static constexpr size_t m_maxFusedInputs = 8;
+
+	///@brief Bytes of memory traffic avoided by filter fusion in the most recent evaluation
+	size_t m_fusionBytesSaved;
+
 	///@brief Condition variable for waking up worker threads when work arrives
 	std::condition_variable m_workerCvar;
 
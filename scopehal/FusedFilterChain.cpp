@@ -0,0 +1,682 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FusedFilterChain
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "FusedFilterChain.h"
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a fused chain and generates the shader for it
+
+	Check IsValid() afterwards: if any stage does not currently have a kernel, or the chain is not linear, no shader
+	is generated.
+
+	@param stages	The filters in the chain, in execution order. Each filter except the first must take the output of
+					the one before it as one of its kernel's inputs.
+ */
+FusedFilterChain::FusedFilterChain(const vector<Filter*>& stages)
+	: m_stages(stages)
+	, m_digitalOutput(false)
+	, m_pushConstantSize(0)
+	, m_compileFailed(false)
+	, m_lastBytesSaved(0)
+	, m_numCpuTemps(0)
+{
+	if(m_stages.size() < 2)
+		return;
+
+	ShaderBaker baker;
+	vector<shared_ptr<BakedShaderStage> > bakedStages;
+	shared_ptr<FusibleShader> prevKernel;
+	for(size_t i=0; i<m_stages.size(); i++)
+	{
+		auto f = m_stages[i];
+
+		vector<size_t> inputs;
+		auto kernel = f->GetFusibleShader(inputs);
+		if(!kernel || (inputs.size() != kernel->m_inputs.size()) )
+			return;
+
+		//Only the last stage can write something other than float
+		if(prevKernel && (prevKernel->m_outputType != "float") )
+			return;
+
+		//Figure out where each kernel input comes from
+		auto stage = make_shared<BakedShaderStage>(kernel);
+		bool usesPrevious = false;
+		for(auto j : inputs)
+		{
+			auto stream = f->GetInput(j);
+			if( (i > 0) && (stream.m_channel == m_stages[i-1]) && (stream.m_stream == 0) )
+			{
+				stage->m_inputs.push_back(BakedShaderStage::PREVIOUS_STAGE);
+				usesPrevious = true;
+				continue;
+			}
+
+			size_t k = 0;
+			for(; k<m_externalInputs.size(); k++)
+			{
+				if(m_externalInputs[k] == stream)
+					break;
+			}
+			if(k == m_externalInputs.size())
+				m_externalInputs.push_back(stream);
+			stage->m_inputs.push_back(k);
+		}
+
+		//Chain must be linear
+		if( (i > 0) && !usesPrevious)
+			return;
+
+		baker.AddStage(stage);
+		bakedStages.push_back(stage);
+		prevKernel = kernel;
+	}
+
+	m_digitalOutput = (prevKernel->m_outputType == "uint8_t");
+	m_pushConstantSize = baker.GetPushConstantSize();
+	m_source = baker.Bake();
+
+	CompileCpuProgram(bakedStages);
+}
+
+/**
+	@brief Concatenates the CPU implementations of each stage's kernel into a single program
+
+	Leaves m_cpuProgram empty if any stage has no CPU implementation.
+ */
+void FusedFilterChain::CompileCpuProgram(const vector<shared_ptr<BakedShaderStage> >& stages)
+{
+	vector<CpuInstruction> program;
+	size_t nextReg = m_externalInputs.size();
+	int prevResult = 0;
+	size_t pushBase = 1;	//word 0 is the sample count
+	for(auto& stage : stages)
+	{
+		auto kernel = stage->m_shader;
+		if(kernel->m_cpuOps.empty())
+			return;
+
+		//Registers holding the kernel's inputs, followed by the results of each of its operations
+		vector<int> regs;
+		for(auto in : stage->m_inputs)
+			regs.push_back( (in == BakedShaderStage::PREVIOUS_STAGE) ? prevResult : in );
+
+		for(auto& op : kernel->m_cpuOps)
+		{
+			CpuInstruction inst;
+			inst.m_opcode = op.m_opcode;
+			for(size_t j=0; j<3; j++)
+			{
+				int x = op.m_operands[j];
+				if(x >= 0)
+				{
+					if(static_cast<size_t>(x) >= regs.size())
+					{
+						LogError("FusedFilterChain: kernel %s uses nonexistent operand %d\n", kernel->m_name.c_str(), x);
+						return;
+					}
+					inst.m_operands[j] = regs[x];
+				}
+				else
+					inst.m_operands[j] = -1 - static_cast<int>(pushBase + (-1 - x));
+			}
+
+			//Operand a is always a sample, clip level and threshold are always constants
+			bool constB = (op.m_opcode == FusibleCpuOp::OP_CLIP) || (op.m_opcode == FusibleCpuOp::OP_THRESHOLD);
+			bool constC = (op.m_opcode == FusibleCpuOp::OP_CLIP);
+			if( (inst.m_operands[0] < 0) || (constB && (inst.m_operands[1] >= 0)) || (constC && (inst.m_operands[2] >= 0)) )
+			{
+				LogError("FusedFilterChain: kernel %s has invalid operands\n", kernel->m_name.c_str());
+				return;
+			}
+
+			inst.m_dest = nextReg ++;
+			regs.push_back(inst.m_dest);
+			program.push_back(inst);
+		}
+
+		prevResult = regs.back();
+		pushBase += kernel->m_pushConstants.size();
+	}
+
+	m_numCpuTemps = nextReg - m_externalInputs.size();
+	m_cpuProgram = program;
+}
+
+/**
+	@brief Checks if two chains have the same filters, inputs, and shader
+
+	This allows the executor to keep the compiled pipeline from the last run if the graph has not changed.
+ */
+bool FusedFilterChain::IsSameAs(const FusedFilterChain& rhs)
+{
+	return
+		(m_stages == rhs.m_stages) &&
+		(m_externalInputs == rhs.m_externalInputs) &&
+		(m_source == rhs.m_source);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Evaluation
+
+/**
+	@brief Evaluates every filter in the chain
+
+	The output waveform of the last filter is produced by the fused shader if possible. Intermediate filters in the
+	chain have no output waveform in this case.
+ */
+void FusedFilterChain::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	#ifdef HAVE_NVTX
+		nvtx3::scoped_range range("FusedFilterChain::Refresh");
+	#endif
+
+	m_lastBytesSaved = 0;
+
+	//A software Vulkan implementation is far slower than running the chain natively on the CPU
+	if(!g_vulkanDeviceIsSoftware && RefreshFused(cmdBuf, queue))
+		return;
+	if(RefreshFusedCpu())
+		return;
+	RefreshSequential(cmdBuf, queue);
+}
+
+/**
+	@brief Gets the input waveforms for fused evaluation
+
+	@param inputs	Waveform for each external input
+	@param len		Number of samples to process
+
+	@return True if the inputs are suitable for fused evaluation
+ */
+bool FusedFilterChain::GetFusedInputs(vector<UniformAnalogWaveform*>& inputs, size_t& len)
+{
+	//Every input must be uniformly sampled with the same timebase, so sample i of each is the same point in time
+	len = SIZE_MAX;
+	for(auto& s : m_externalInputs)
+	{
+		auto w = dynamic_cast<UniformAnalogWaveform*>(s.GetData());
+		if(!w)
+			return false;
+		if(!inputs.empty() &&
+			( (w->m_timescale != inputs[0]->m_timescale) || (w->m_triggerPhase != inputs[0]->m_triggerPhase) ) )
+		{
+			return false;
+		}
+
+		inputs.push_back(w);
+		len = min(len, w->size());
+	}
+
+	//Let the filters handle empty inputs themselves
+	return !inputs.empty() && (len != 0);
+}
+
+/**
+	@brief Does the CPU side work for each stage and collects the push constants
+
+	@param len				Number of samples to process
+	@param pushConstants	Push constants for the chain
+
+	@return True on success
+ */
+bool FusedFilterChain::PrepareStages(size_t len, vector<uint32_t>& pushConstants)
+{
+	pushConstants.clear();
+	pushConstants.push_back(len);
+	for(auto f : m_stages)
+		f->PrepareFusedRefresh(pushConstants);
+
+	if(pushConstants.size() * sizeof(uint32_t) != m_pushConstantSize)
+	{
+		LogError("FusedFilterChain: expected %zu bytes of push constants, got %zu\n",
+			m_pushConstantSize, pushConstants.size() * sizeof(uint32_t));
+		return false;
+	}
+
+	//Intermediate results are never written out
+	for(auto f : m_stages)
+	{
+		if(f != GetTail())
+			f->SetData(nullptr, 0);
+	}
+
+	return true;
+}
+
+/**
+	@brief Evaluates the chain with the fused shader
+
+	@return True on success, false if the inputs are not suitable (nothing has been done in this case)
+ */
+bool FusedFilterChain::RefreshFused(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	if(!IsValid() || m_compileFailed)
+		return false;
+
+	//Digital output needs 8-bit storage
+	if(m_digitalOutput && !g_hasShaderInt8)
+		return false;
+
+	vector<UniformAnalogWaveform*> inputs;
+	size_t len;
+	if(!GetFusedInputs(inputs, len))
+		return false;
+
+	//Compile the shader the first time we use it
+	if(!m_pipeline)
+	{
+		auto spirv = ShaderBaker::Compile(m_source);
+		if(!spirv)
+		{
+			m_compileFailed = true;
+			return false;
+		}
+
+		m_pipeline = make_unique<ComputePipeline>(
+			spirv,
+			ShaderBaker::GetCacheKey(m_source),
+			m_externalInputs.size() + 1,
+			m_pushConstantSize);
+	}
+
+	vector<uint32_t> push;
+	if(!PrepareStages(len, push))
+		return false;
+
+	//Inputs may still be being written by asynchronous submits from other nodes
+	for(auto w : inputs)
+		queue->AddWait(w->GetGpuCompletion());
+
+	auto tail = GetTail();
+	auto out = tail->SetupFusedOutputWaveform(inputs[0], len, m_digitalOutput);
+	auto dcap = dynamic_cast<UniformDigitalWaveform*>(out);
+	auto acap = dynamic_cast<UniformAnalogWaveform*>(out);
+
+	cmdBuf.begin({});
+	{
+		NamedDebugRange debugRange(cmdBuf, "FusedFilterChain");
+
+		if(dcap)
+			m_pipeline->BindBufferNonblocking(0, dcap->m_samples, cmdBuf, true);
+		else
+			m_pipeline->BindBufferNonblocking(0, acap->m_samples, cmdBuf, true);
+		for(size_t i=0; i<inputs.size(); i++)
+			m_pipeline->BindBufferNonblocking(i+1, inputs[i]->m_samples, cmdBuf);
+
+		const uint32_t compute_block_count = GetComputeBlockCount(len, 64);
+		m_pipeline->Dispatch(cmdBuf, push,
+			min(compute_block_count, 32768u),
+			compute_block_count / 32768 + 1);
+	}
+	cmdBuf.end();
+	auto point = queue->SubmitAsync(cmdBuf);
+
+	if(dcap)
+	{
+		dcap->m_samples.SetGpuCompletion(point);
+		dcap->m_samples.MarkModifiedFromGpu();
+	}
+	else
+	{
+		acap->m_samples.SetGpuCompletion(point);
+		acap->m_samples.MarkModifiedFromGpu();
+	}
+
+	//Each intermediate waveform would have been written once and read once
+	m_lastBytesSaved = GetBytesSavedPerSample() * len;
+	LogTrace("Fused %zu filters ending at %s, saved %zu bytes of memory traffic\n",
+		m_stages.size(), tail->GetDisplayName().c_str(), m_lastBytesSaved);
+
+	return true;
+}
+
+/**
+	@brief Evaluates the chain on the CPU in a single pass
+
+	@return True on success, false if the inputs are not suitable or there is no CPU implementation
+ */
+bool FusedFilterChain::RefreshFusedCpu()
+{
+	if(!IsValid() || !HasCpuImplementation())
+		return false;
+
+	vector<UniformAnalogWaveform*> inputs;
+	size_t len;
+	if(!GetFusedInputs(inputs, len))
+		return false;
+
+	vector<uint32_t> push;
+	if(!PrepareStages(len, push))
+		return false;
+
+	vector<const float*> pin;
+	for(auto w : inputs)
+	{
+		w->PrepareForCpuAccess();
+		pin.push_back(w->m_samples.GetCpuPointer());
+	}
+
+	auto tail = GetTail();
+	auto out = tail->SetupFusedOutputWaveform(inputs[0], len, m_digitalOutput);
+	out->PrepareForCpuAccess();
+	auto dcap = dynamic_cast<UniformDigitalWaveform*>(out);
+	auto acap = dynamic_cast<UniformAnalogWaveform*>(out);
+	float* aout = acap ? acap->m_samples.GetCpuPointer() : nullptr;
+	bool* dout = dcap ? dcap->m_samples.GetCpuPointer() : nullptr;
+
+	//Divide large waveforms into blocks and multithread them
+	auto split = ParallelTuning::GetSplit(ParallelTuning::KERNEL_COPY, len, m_cpuBlockSize, m_cpuProgram.size());
+	if(split.m_threads > 1)
+	{
+		size_t lastblock = split.m_numBlocks - 1;
+		size_t blocksize = split.m_blockSize;
+
+		#pragma omp parallel for num_threads(split.m_threads)
+		for(size_t i=0; i<split.m_numBlocks; i++)
+		{
+			//Last block gets any extra that didn't divide evenly
+			size_t nsamp = blocksize;
+			if(i == lastblock)
+				nsamp = len - i*blocksize;
+
+			EvaluateCpu(pin, push, aout, dout, i*blocksize, nsamp);
+		}
+	}
+	else
+		EvaluateCpu(pin, push, aout, dout, 0, len);
+
+	out->MarkModifiedFromCpu();
+
+	//Each intermediate waveform would have been written once and read once
+	m_lastBytesSaved = GetBytesSavedPerSample() * len;
+	LogTrace("Fused %zu filters ending at %s on CPU, saved %zu bytes of memory traffic\n",
+		m_stages.size(), tail->GetDisplayName().c_str(), m_lastBytesSaved);
+
+	return true;
+}
+
+/**
+	@brief Runs the CPU implementation of the chain on part of the waveform
+
+	@param inputs			Pointers to the external input samples
+	@param pushConstants	Push constants for the chain
+	@param aout				Analog output samples, or nullptr if the output is digital
+	@param dout				Digital output samples, or nullptr if the output is analog
+	@param off				Index of the first sample to process
+	@param count			Number of samples to process
+ */
+void FusedFilterChain::EvaluateCpu(
+	const vector<const float*>& inputs,
+	const vector<uint32_t>& pushConstants,
+	float* aout,
+	bool* dout,
+	size_t off,
+	size_t count)
+{
+	size_t nin = inputs.size();
+	size_t last = m_cpuProgram.size() - 1;
+	vector<float, AlignedAllocator<float, 64> > temps(m_numCpuTemps * m_cpuBlockSize);
+
+	for(size_t base=0; base<count; base += m_cpuBlockSize)
+	{
+		size_t start = off + base;
+		size_t n = min(m_cpuBlockSize, count - base);
+
+		//Run every operation on this block before moving on to the next
+		for(size_t j=0; j<=last; j++)
+		{
+			auto& inst = m_cpuProgram[j];
+
+			float* dst = temps.data() + (inst.m_dest - nin) * m_cpuBlockSize;
+			if( (j == last) && aout)
+				dst = aout + start;
+
+			const float* src[2] = {nullptr, nullptr};
+			for(size_t k=0; k<2; k++)
+			{
+				auto r = inst.m_operands[k];
+				if(r < 0)
+					continue;
+				else if(static_cast<size_t>(r) < nin)
+					src[k] = inputs[r] + start;
+				else
+					src[k] = temps.data() + (r - nin) * m_cpuBlockSize;
+			}
+
+			float bconst = 0;
+			if(inst.m_operands[1] < 0)
+				memcpy(&bconst, &pushConstants[-1 - inst.m_operands[1]], sizeof(bconst));
+			uint32_t cconst = 0;
+			if(inst.m_operands[2] < 0)
+				cconst = pushConstants[-1 - inst.m_operands[2]];
+
+			#ifdef __x86_64__
+			if(g_hasAvx2)
+				RunCpuOpAVX2(inst.m_opcode, src[0], src[1], bconst, cconst, dst, n);
+			else
+			#endif
+				RunCpuOp(inst.m_opcode, src[0], src[1], bconst, cconst, dst, n);
+		}
+
+		if(dout)
+		{
+			const float* result = temps.data() + (m_cpuProgram[last].m_dest - nin) * m_cpuBlockSize;
+			for(size_t i=0; i<n; i++)
+				dout[start + i] = (result[i] != 0);
+		}
+	}
+}
+
+/**
+	@brief Applies one operation to a block of samples
+
+	@param op		The operation
+	@param a		First operand
+	@param b		Second operand, or nullptr to use bconst
+	@param bconst	Second operand, if constant
+	@param cconst	Third operand
+	@param dst		Output
+	@param count	Number of samples
+ */
+void FusedFilterChain::RunCpuOp(
+	FusibleCpuOp::Opcode op, const float* a, const float* b, float bconst, uint32_t cconst, float* dst, size_t count)
+{
+	switch(op)
+	{
+		case FusibleCpuOp::OP_ADD:
+			for(size_t i=0; i<count; i++)
+				dst[i] = a[i] + (b ? b[i] : bconst);
+			break;
+
+		case FusibleCpuOp::OP_SUBTRACT:
+			for(size_t i=0; i<count; i++)
+				dst[i] = a[i] - (b ? b[i] : bconst);
+			break;
+
+		case FusibleCpuOp::OP_MULTIPLY:
+			for(size_t i=0; i<count; i++)
+				dst[i] = a[i] * (b ? b[i] : bconst);
+			break;
+
+		case FusibleCpuOp::OP_NEGATE:
+			for(size_t i=0; i<count; i++)
+				dst[i] = -a[i];
+			break;
+
+		case FusibleCpuOp::OP_CLIP:
+			if(cconst == 1)
+			{
+				for(size_t i=0; i<count; i++)
+					dst[i] = min(a[i], bconst);
+			}
+			else
+			{
+				for(size_t i=0; i<count; i++)
+					dst[i] = max(a[i], bconst);
+			}
+			break;
+
+		case FusibleCpuOp::OP_THRESHOLD:
+			for(size_t i=0; i<count; i++)
+				dst[i] = (a[i] > bconst) ? 1 : 0;
+			break;
+	}
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 optimized version of RunCpuOp()
+ */
+__attribute__((target("avx2")))
+void FusedFilterChain::RunCpuOpAVX2(
+	FusibleCpuOp::Opcode op, const float* a, const float* b, float bconst, uint32_t cconst, float* dst, size_t count)
+{
+	size_t end = count - (count % 8);
+	__m256 vconst = _mm256_set1_ps(bconst);
+
+	switch(op)
+	{
+		case FusibleCpuOp::OP_ADD:
+			for(size_t i=0; i<end; i+=8)
+			{
+				__m256 vb = b ? _mm256_loadu_ps(b + i) : vconst;
+				_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(a + i), vb));
+			}
+			break;
+
+		case FusibleCpuOp::OP_SUBTRACT:
+			for(size_t i=0; i<end; i+=8)
+			{
+				__m256 vb = b ? _mm256_loadu_ps(b + i) : vconst;
+				_mm256_storeu_ps(dst + i, _mm256_sub_ps(_mm256_loadu_ps(a + i), vb));
+			}
+			break;
+
+		case FusibleCpuOp::OP_MULTIPLY:
+			for(size_t i=0; i<end; i+=8)
+			{
+				__m256 vb = b ? _mm256_loadu_ps(b + i) : vconst;
+				_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), vb));
+			}
+			break;
+
+		case FusibleCpuOp::OP_NEGATE:
+			{
+				__m256 sign = _mm256_set1_ps(-0.0f);
+				for(size_t i=0; i<end; i+=8)
+					_mm256_storeu_ps(dst + i, _mm256_xor_ps(_mm256_loadu_ps(a + i), sign));
+			}
+			break;
+
+		case FusibleCpuOp::OP_CLIP:
+			if(cconst == 1)
+			{
+				for(size_t i=0; i<end; i+=8)
+					_mm256_storeu_ps(dst + i, _mm256_min_ps(_mm256_loadu_ps(a + i), vconst));
+			}
+			else
+			{
+				for(size_t i=0; i<end; i+=8)
+					_mm256_storeu_ps(dst + i, _mm256_max_ps(_mm256_loadu_ps(a + i), vconst));
+			}
+			break;
+
+		case FusibleCpuOp::OP_THRESHOLD:
+			{
+				__m256 one = _mm256_set1_ps(1);
+				for(size_t i=0; i<end; i+=8)
+				{
+					__m256 gt = _mm256_cmp_ps(_mm256_loadu_ps(a + i), vconst, _CMP_GT_OQ);
+					_mm256_storeu_ps(dst + i, _mm256_and_ps(gt, one));
+				}
+			}
+			break;
+	}
+
+	//Scalar path for the last few samples
+	if(end < count)
+		RunCpuOp(op, a + end, b ? (b + end) : nullptr, bconst, cconst, dst + end, count - end);
+}
+#endif
+
+/**
+	@brief Evaluates each filter in the chain separately, the same way the executor would if they were not fused
+ */
+void FusedFilterChain::RefreshSequential(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	const uint32_t canAppend = (uint32_t)FlowGraphNode::ExecutionCapabilities::CommandBufferAppend;
+	const uint32_t canTailChain = (uint32_t)FlowGraphNode::ExecutionCapabilities::CommandBufferTailCall;
+
+	for(auto f : m_stages)
+	{
+		for(size_t i=0; i<f->GetInputCount(); i++)
+		{
+			auto data = f->GetInput(i).GetData();
+			if(data)
+				queue->AddWait(data->GetGpuCompletion());
+		}
+
+		auto flags = f->GetExecutionCapabilitiesMask();
+		auto before = queue->GetLastSubmission().m_value;
+
+		if(flags & canAppend)
+			cmdBuf.begin({});
+		f->Refresh(cmdBuf, queue);
+		if(flags & canTailChain)
+		{
+			cmdBuf.end();
+			queue->SubmitAsync(cmdBuf);
+		}
+
+		//If the filter submitted work, the command buffer is in flight and has to finish before the next stage
+		auto after = queue->GetLastSubmission();
+		if(after.m_value != before)
+		{
+			SubmitBatch::SetGpuCompletion(f, after);
+			if(f != GetTail())
+				after.Wait();
+		}
+	}
+}
@@ -0,0 +1,177 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FusedFilterChain
+	@ingroup core
+ */
+#ifndef FusedFilterChain_h
+#define FusedFilterChain_h
+
+#include "ShaderBaker.h"
+
+/**
+	@brief A linear chain of elementwise filters evaluated by a single generated shader
+
+	Each filter in the chain except the last has exactly one consumer, which is the next filter in the chain. The
+	filters' kernels (see Filter::GetFusibleShader()) are baked into one shader which reads the external inputs of the
+	chain and writes only the output of the last filter, so the intermediate waveforms never touch GPU memory.
+
+	The filter graph executor schedules the chain as if it were the last filter, with the inputs of the whole chain.
+	If the inputs at run time are not suitable for the fused shader (sparse, or different timebases), the filters are
+	refreshed one at a time instead.
+
+	If the Vulkan device is a software implementation (or the shader can't be used), the chain is evaluated on the CPU
+	instead, from the kernels' FusibleCpuOp lists: all of the operations are applied to one cache sized block of
+	samples before moving on to the next, so each input is read from memory once and the output written once.
+ */
+class FusedFilterChain
+{
+public:
+	FusedFilterChain(const std::vector<Filter*>& stages);
+
+	void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
+
+	///@brief Returns true if every stage provided a kernel and the shader could be generated
+	bool IsValid()
+	{ return !m_source.empty(); }
+
+	///@brief Returns true if every stage has a CPU implementation
+	bool HasCpuImplementation()
+	{ return !m_cpuProgram.empty(); }
+
+	bool IsSameAs(const FusedFilterChain& rhs);
+
+	///@brief Gets the filters in the chain, in execution order
+	const std::vector<Filter*>& GetStages()
+	{ return m_stages; }
+
+	///@brief Gets the last filter in the chain, which is the only one whose output is produced
+	Filter* GetTail()
+	{ return m_stages.back(); }
+
+	///@brief Gets the inputs to the chain from outside of it
+	const std::vector<StreamDescriptor>& GetExternalInputs()
+	{ return m_externalInputs; }
+
+	///@brief Gets the number of bytes of memory traffic per sample avoided by fusing the chain
+	size_t GetBytesSavedPerSample()
+	{ return (m_stages.size() - 1) * 2 * sizeof(float); }
+
+	///@brief Gets the number of bytes of memory traffic avoided by fusion on the most recent refresh
+	size_t GetLastBytesSaved()
+	{ return m_lastBytesSaved; }
+
+	///@brief Gets the size of the chain's push constants, in bytes
+	size_t GetPushConstantSize()
+	{ return m_pushConstantSize; }
+
+protected:
+	void CompileCpuProgram(const std::vector<std::shared_ptr<BakedShaderStage> >& stages);
+
+	bool GetFusedInputs(std::vector<UniformAnalogWaveform*>& inputs, size_t& len);
+	bool PrepareStages(size_t len, std::vector<uint32_t>& pushConstants);
+
+	bool RefreshFused(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
+	bool RefreshFusedCpu();
+	void RefreshSequential(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
+
+	void EvaluateCpu(
+		const std::vector<const float*>& inputs,
+		const std::vector<uint32_t>& pushConstants,
+		float* aout,
+		bool* dout,
+		size_t off,
+		size_t count);
+
+	static void RunCpuOp(FusibleCpuOp::Opcode op, const float* a, const float* b, float bconst, uint32_t cconst,
+		float* dst, size_t count);
+#ifdef __x86_64__
+	static void RunCpuOpAVX2(FusibleCpuOp::Opcode op, const float* a, const float* b, float bconst, uint32_t cconst,
+		float* dst, size_t count);
+#endif
+
+	/**
+		@brief One operation of the CPU implementation of the whole chain
+
+		Registers 0...N-1 are the external inputs, registers from N on hold temporary results for one block.
+		Negative operands are push constants: -1 is word 0 of the chain's push constants, -2 word 1, etc.
+	 */
+	struct CpuInstruction
+	{
+		///@brief The operation to perform
+		FusibleCpuOp::Opcode m_opcode;
+
+		///@brief Source registers or push constants
+		int m_operands[3];
+
+		///@brief Register to write the result to
+		size_t m_dest;
+	};
+
+	///@brief The filters in the chain, in execution order
+	std::vector<Filter*> m_stages;
+
+	///@brief Inputs to the chain from outside of it (bound to descriptors 1...N of the shader)
+	std::vector<StreamDescriptor> m_externalInputs;
+
+	///@brief True if the last stage produces a digital output
+	bool m_digitalOutput;
+
+	///@brief GLSL source of the baked shader (empty if it could not be generated)
+	std::string m_source;
+
+	///@brief Size of the baked shader's push constants
+	size_t m_pushConstantSize;
+
+	///@brief The compute pipeline for the baked shader (created on first use)
+	std::unique_ptr<ComputePipeline> m_pipeline;
+
+	///@brief Set if the baked shader failed to compile, so we don't try again every refresh
+	bool m_compileFailed;
+
+	///@brief Bytes of memory traffic avoided by fusion on the most recent refresh
+	size_t m_lastBytesSaved;
+
+	///@brief CPU implementation of the chain (empty if any stage doesn't have one)
+	std::vector<CpuInstruction> m_cpuProgram;
+
+	///@brief Number of temporary registers used by m_cpuProgram
+	size_t m_numCpuTemps;
+
+	///@brief Number of samples processed by the CPU implementation at a time (small enough for temporaries to stay in L1)
+	static constexpr size_t m_cpuBlockSize = 1024;
+};
+
+///@brief Fused filter chains, indexed by the last filter in each
+typedef std::map<FlowGraphNode*, std::shared_ptr<FusedFilterChain> > FusedChainMap;
+
+#endif
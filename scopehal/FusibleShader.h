@@ -36,6 +36,9 @@
 #ifndef FusibleShader_h
 #define FusibleShader_h
 
+/**
+	@brief A single input to a FusibleShader
+ */
 class ShaderInputInfo
 {
 public:
@@ -48,6 +51,9 @@ public:
 	std::string m_name;
 };
 
+/**
+	@brief A single push constant used by a FusibleShader
+ */
 class PushConstantInfo
 {
 public:
@@ -60,15 +66,80 @@ public:
 	std::string m_name;
 };
 
+/**
+	@brief One operation of the CPU implementation of a FusibleShader
+
+	Operands are numbered the same way as the kernel's inputs, with the result of each operation numbered after the
+	inputs and any earlier operations. Negative operand values refer to push constants (see PushConstant()).
+ */
+class FusibleCpuOp
+{
+public:
+
+	enum Opcode
+	{
+		///@brief a + b
+		OP_ADD,
+
+		///@brief a - b
+		OP_SUBTRACT,
+
+		///@brief a * b
+		OP_MULTIPLY,
+
+		///@brief -a
+		OP_NEGATE,
+
+		///@brief min(a, b) if c is 1, otherwise max(a, b). b and c must be push constants (float and uint).
+		OP_CLIP,
+
+		///@brief 1 if a > b, otherwise 0. b must be a push constant.
+		OP_THRESHOLD
+	};
+
+	FusibleCpuOp(Opcode op, int a, int b = 0, int c = 0)
+		: m_opcode(op)
+		, m_operands{a, b, c}
+	{}
+
+	///@brief Returns the operand number referring to the kernel's i'th push constant
+	static int PushConstant(size_t i)
+	{ return -1 - static_cast<int>(i); }
+
+	///@brief The operation to perform
+	Opcode m_opcode;
+
+	///@brief Operands of the operation (unused ones are ignored)
+	int m_operands[3];
+};
+
 /**
 	@brief Data for a generic shader kernel that can be fused with others to form a complete compute pipeline
+
+	The kernel is an elementwise function of one or more float inputs, taking one sample of each input and returning
+	one output sample:
+
+	float __kernel__(float a, float b)
+	{
+		return a * __push__scale;
+	}
+
+	__kernel__ is replaced with a unique function name when the shader is baked, and push constants are referenced
+	with the __push__ prefix. All push constants must be 32 bits in size (float, int, or uint).
+
+	The return value is always float. If m_outputType is "uint8_t", the final stage of a chain writes it to an 8-bit
+	buffer (used for digital outputs), so such a kernel can only be the last stage.
+
+	Kernels may also describe the same function as a list of FusibleCpuOp's, so a chain can be evaluated on the CPU
+	when there's no GPU worth using. The result of the last operation is the output of the kernel.
  */
 class FusibleShader
 {
 public:
-	FusibleShader(const std::string& shaderFile, const std::string& name)
-		: m_glslSource(ReadDataFile(std::string("shaderfusion/") + shaderFile))
+	FusibleShader(const std::string& name, const std::string& glslSource)
+		: m_glslSource(glslSource)
 		, m_name(name)
+		, m_outputType("float")
 	{}
 
 	///@brief Inputs we need for this shader
@@ -85,6 +156,12 @@ public:
 
 	///@brief Human readable name for the kernel
 	std::string m_name;
+
+	///@brief Type of the output buffer if this is the last stage ("float" or "uint8_t")
+	std::string m_outputType;
+
+	///@brief CPU implementation of the kernel (empty if there is none)
+	std::vector<FusibleCpuOp> m_cpuOps;
 };
 
 #endif
@@ -0,0 +1,285 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of HostMemoryPolicy
+	@ingroup core
+ */
+
+#include "scopehal.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+using namespace std;
+
+/**
+	@brief Granularity of large mappings
+
+	Large mappings are always rounded up to a 2 MB hugepage so they can be unmapped with the same length no matter
+	what the policy was when they were allocated.
+ */
+#define LARGE_MAPPING_GRANULARITY (2 * 1024 * 1024)
+
+///@brief Stride used when faulting in pages
+#define PREFAULT_STRIDE 4096
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static variables
+
+atomic<HostMemoryPolicy::HugePageMode> HostMemoryPolicy::m_hugePageMode(HostMemoryPolicy::HUGEPAGES_NONE);
+atomic<HostMemoryPolicy::NumaMode> HostMemoryPolicy::m_numaMode(HostMemoryPolicy::NUMA_DEFAULT);
+atomic<bool> HostMemoryPolicy::m_prefault(false);
+atomic<size_t> HostMemoryPolicy::m_threshold(8 * 1024 * 1024);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// NUMA topology
+
+#ifdef __linux__
+/**
+	@brief Gets the IDs of all online NUMA nodes (parsed once from sysfs, e.g. "0-1,3")
+ */
+static const vector<int>& GetOnlineNumaNodes()
+{
+	static vector<int> nodes;
+	static once_flag flag;
+	call_once(flag, []()
+	{
+		FILE* fp = fopen("/sys/devices/system/node/online", "r");
+		if(!fp)
+			return;
+
+		char buf[256] = {0};
+		if(fgets(buf, sizeof(buf), fp))
+		{
+			stringstream ss(buf);
+			string range;
+			while(getline(ss, range, ','))
+			{
+				int first;
+				int last;
+				int n = sscanf(range.c_str(), "%d-%d", &first, &last);
+				if(n == 1)
+					last = first;
+				else if(n != 2)
+					continue;
+
+				for(int i=first; i<=last; i++)
+					nodes.push_back(i);
+			}
+		}
+		fclose(fp);
+	});
+	return nodes;
+}
+#endif
+
+/**
+	@brief Returns the number of online NUMA nodes (1 if not a NUMA system or the topology is unknown)
+ */
+size_t HostMemoryPolicy::GetNumaNodeCount()
+{
+	#ifdef __linux__
+		return max((size_t)1, GetOnlineNumaNodes().size());
+	#else
+		return 1;
+	#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Allocation
+
+/**
+	@brief Checks if an allocation of a given size should go through AllocateLarge()
+
+	@param bytes	Size of the allocation
+ */
+bool HostMemoryPolicy::IsLargeAllocation(size_t bytes)
+{
+	#ifdef _WIN32
+		return false;
+	#else
+		if(bytes < m_threshold)
+			return false;
+
+		//Nothing to do? Use the normal allocator
+		return (m_hugePageMode != HUGEPAGES_NONE) || (m_numaMode != NUMA_DEFAULT) || m_prefault;
+	#endif
+}
+
+/**
+	@brief Gets the actual size of the mapping used for a large allocation
+ */
+size_t HostMemoryPolicy::GetMappingSize(size_t bytes)
+{
+	return (bytes + LARGE_MAPPING_GRANULARITY - 1) & ~(size_t)(LARGE_MAPPING_GRANULARITY - 1);
+}
+
+/**
+	@brief Allocates a large block of memory according to the current policy
+
+	The returned pointer is page aligned. The contents are undefined (zero, in practice).
+
+	@param bytes	Size of the allocation
+ */
+void* HostMemoryPolicy::AllocateLarge(size_t bytes)
+{
+	#ifdef _WIN32
+		LogFatal("HostMemoryPolicy::AllocateLarge is not supported on Windows\n");
+		return nullptr;
+	#else
+		size_t len = GetMappingSize(bytes);
+		HugePageMode hugeMode = m_hugePageMode;
+
+		void* ret = MAP_FAILED;
+		bool explicitHuge = false;
+
+		//Try reserved hugepages first if requested
+		#ifdef __linux__
+			if(hugeMode == HUGEPAGES_EXPLICIT)
+			{
+				ret = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+				if(ret != MAP_FAILED)
+					explicitHuge = true;
+				else
+				{
+					static atomic<bool> warned(false);
+					if(!warned.exchange(true))
+					{
+						LogWarning(
+							"No reserved hugepages available for a %zu byte buffer, "
+							"falling back to transparent hugepages\n", len);
+					}
+				}
+			}
+		#endif
+
+		//Normal anonymous mapping
+		if(ret == MAP_FAILED)
+			ret = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(ret == MAP_FAILED)
+			throw bad_alloc();
+
+		#ifdef __linux__
+			if(!explicitHuge && (hugeMode != HUGEPAGES_NONE) )
+				madvise(ret, len, MADV_HUGEPAGE);
+		#endif
+
+		//Placement has to be set up before anything touches the pages
+		auto numaMode = m_numaMode.load();
+		if(numaMode == NUMA_INTERLEAVE)
+			Interleave(ret, len);
+		if( (numaMode == NUMA_FIRST_TOUCH) || m_prefault)
+			Prefault(ret, len);
+
+		return ret;
+	#endif
+}
+
+/**
+	@brief Frees a block allocated by AllocateLarge()
+
+	@param ptr		The block
+	@param bytes	Size originally requested from AllocateLarge()
+ */
+void HostMemoryPolicy::FreeLarge(void* ptr, size_t bytes)
+{
+	#ifndef _WIN32
+		munmap(ptr, GetMappingSize(bytes));
+	#endif
+}
+
+/**
+	@brief Applies the policy to a file backed mapping (MEM_TYPE_CPU_PAGED)
+
+	These buffers are meant to be paged out, so they are never prefaulted. Hugepage advice only has an effect if the
+	temporary directory is on tmpfs with shmem hugepages enabled.
+ */
+void HostMemoryPolicy::ApplyToFileMapping(void* ptr, size_t bytes)
+{
+	if(bytes < m_threshold)
+		return;
+
+	#ifdef __linux__
+		if(m_hugePageMode != HUGEPAGES_NONE)
+			madvise(ptr, bytes, MADV_HUGEPAGE);
+	#endif
+
+	if(m_numaMode == NUMA_INTERLEAVE)
+		Interleave(ptr, bytes);
+}
+
+/**
+	@brief Interleaves pages of a mapping across all online NUMA nodes
+
+	Calls mbind() directly so we don't need a libnuma dependency.
+ */
+void HostMemoryPolicy::Interleave([[maybe_unused]] void* ptr, [[maybe_unused]] size_t bytes)
+{
+	#ifdef __linux__
+		auto& nodes = GetOnlineNumaNodes();
+		if(nodes.size() < 2)
+			return;
+
+		const size_t bitsPerWord = 8 * sizeof(unsigned long);
+		size_t maxnode = *max_element(nodes.begin(), nodes.end()) + 1;
+		vector<unsigned long> mask( (maxnode + bitsPerWord - 1) / bitsPerWord, 0);
+		for(auto n : nodes)
+			mask[n / bitsPerWord] |= (1UL << (n % bitsPerWord));
+
+		if(0 != syscall(SYS_mbind, ptr, bytes, MPOL_INTERLEAVE, mask.data(), mask.size()*bitsPerWord + 1, 0))
+			LogDebug("mbind(MPOL_INTERLEAVE) failed, using default NUMA placement\n");
+	#endif
+}
+
+/**
+	@brief Faults in every page of a block of memory from all OpenMP worker threads
+
+	Uses a static schedule so that under first-touch placement, each part of the buffer ends up local to the thread
+	which processes the same part in a statically scheduled loop. Existing content is preserved, but the caller must
+	make sure nothing else is writing to the buffer at the same time.
+ */
+void HostMemoryPolicy::Prefault(void* ptr, size_t bytes)
+{
+	auto p = reinterpret_cast<volatile uint8_t*>(ptr);
+	size_t npages = (bytes + PREFAULT_STRIDE - 1) / PREFAULT_STRIDE;
+
+	#pragma omp parallel for schedule(static)
+	for(size_t i=0; i<npages; i++)
+		p[i*PREFAULT_STRIDE] = p[i*PREFAULT_STRIDE];
+}
@@ -0,0 +1,151 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of HostMemoryPolicy
+	@ingroup core
+ */
+#ifndef HostMemoryPolicy_h
+#define HostMemoryPolicy_h
+
+#include <atomic>
+
+/**
+	@brief Placement policy for large CPU-only allocations made by AcceleratorBuffer
+
+	Buffers at or above the size threshold are allocated as anonymous mappings, so they can be backed by hugepages and
+	placed on specific NUMA nodes. This cuts TLB misses and cross-socket traffic when processing very deep captures on
+	large multi-socket machines.
+
+	Pinned buffers are covered too if the Vulkan device supports VK_EXT_external_memory_host: the mapping is made
+	here and imported into Vulkan. Otherwise they're allocated by the driver as usual.
+
+	Everything is off by default, so allocation behaves exactly as it did without the policy until an application
+	opts in with SetHugePageMode(), SetNumaMode() or SetPrefault().
+
+	@ingroup core
+ */
+class HostMemoryPolicy
+{
+public:
+
+	///@brief How to use hugepages for large allocations
+	enum HugePageMode
+	{
+		///@brief Normal pages only
+		HUGEPAGES_NONE,
+
+		///@brief Request transparent hugepages with madvise(MADV_HUGEPAGE)
+		HUGEPAGES_TRANSPARENT,
+
+		///@brief Use explicitly reserved hugepages (MAP_HUGETLB), falling back to transparent if none are free
+		HUGEPAGES_EXPLICIT
+	};
+
+	///@brief Where to place large allocations on NUMA systems
+	enum NumaMode
+	{
+		///@brief Leave it up to the kernel
+		NUMA_DEFAULT,
+
+		/**
+			@brief Fault in pages from all OpenMP worker threads with a static schedule
+
+			Each block of the buffer ends up local to the thread that processes it in a statically scheduled
+			"parallel for" loop over the same buffer.
+		 */
+		NUMA_FIRST_TOUCH,
+
+		///@brief Interleave pages across all online nodes
+		NUMA_INTERLEAVE
+	};
+
+	static void SetHugePageMode(HugePageMode mode)
+	{ m_hugePageMode = mode; }
+
+	static HugePageMode GetHugePageMode()
+	{ return m_hugePageMode; }
+
+	static void SetNumaMode(NumaMode mode)
+	{ m_numaMode = mode; }
+
+	static NumaMode GetNumaMode()
+	{ return m_numaMode; }
+
+	/**
+		@brief Sets whether large allocations should be fully faulted in when they are allocated
+
+		This moves page fault overhead out of the first pass over a newly allocated (or newly enlarged, e.g. reused
+		from a WaveformPool) buffer and into the allocation itself, where it is done in parallel.
+	 */
+	static void SetPrefault(bool prefault)
+	{ m_prefault = prefault; }
+
+	static bool GetPrefault()
+	{ return m_prefault; }
+
+	///@brief Sets the minimum allocation size, in bytes, the policy applies to
+	static void SetThreshold(size_t bytes)
+	{ m_threshold = bytes; }
+
+	static size_t GetThreshold()
+	{ return m_threshold; }
+
+	static bool IsLargeAllocation(size_t bytes);
+
+	static size_t GetMappingSize(size_t bytes);
+	static void* AllocateLarge(size_t bytes);
+	static void FreeLarge(void* ptr, size_t bytes);
+
+	static void ApplyToFileMapping(void* ptr, size_t bytes);
+
+	static void Prefault(void* ptr, size_t bytes);
+
+	static size_t GetNumaNodeCount();
+
+protected:
+	static void Interleave(void* ptr, size_t bytes);
+
+	///@brief Current hugepage mode
+	static std::atomic<HugePageMode> m_hugePageMode;
+
+	///@brief Current NUMA placement mode
+	static std::atomic<NumaMode> m_numaMode;
+
+	///@brief True if large allocations should be prefaulted
+	static std::atomic<bool> m_prefault;
+
+	///@brief Minimum allocation size the policy applies to
+	static std::atomic<size_t> m_threshold;
+};
+
+#endif
@@ -37,16 +37,26 @@
 
 using namespace std;
 
-string IBM8b10bWaveform::GetColor(size_t i)
+vector<string> IBM8b10bWaveform::GetColorPalette()
+{
+	return
+	{
+		StandardColors::colors[StandardColors::COLOR_DATA],
+		StandardColors::colors[StandardColors::COLOR_CONTROL],
+		StandardColors::colors[StandardColors::COLOR_ERROR]
+	};
+}
+
+uint8_t IBM8b10bWaveform::GetColorIndex(size_t i)
 {
 	const IBM8b10bSymbol& s = m_samples[i];
 
 	if(s.m_flags & IBM8b10bSymbol::FLAG_ERROR_MASK)
-		return StandardColors::colors[StandardColors::COLOR_ERROR];
+		return 2;
 	else if(s.m_flags & IBM8b10bSymbol::FLAG_CONTROL)
-		return StandardColors::colors[StandardColors::COLOR_CONTROL];
+		return 1;
 	else
-		return StandardColors::colors[StandardColors::COLOR_DATA];
+		return 0;
 }
 
 string IBM8b10bWaveform::GetText(size_t i)
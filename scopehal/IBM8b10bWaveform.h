@@ -89,7 +89,8 @@ public:
 		m_displayFormat(FORMAT_DOTTED)
 	{};
 	virtual std::string GetText(size_t) override;
-	virtual std::string GetColor(size_t) override;
+	virtual std::vector<std::string> GetColorPalette() override;
+	virtual uint8_t GetColorIndex(size_t i) override;
 	static FilterParameter MakeIBM8b10bDisplayFormatParameter();
 
 	enum DisplayFormat
@@ -0,0 +1,150 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FibonacciLFSR
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "LFSR.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a LFSR and builds its jump tables
+
+	@param width	Number of bits in the LFSR, in [2, 63]
+	@param tapA		First feedback tap, in [1, width]
+	@param tapB		Second feedback tap, in [1, width]
+ */
+FibonacciLFSR::FibonacciLFSR(unsigned int width, unsigned int tapA, unsigned int tapB)
+	: m_width(width)
+	, m_tapA(tapA)
+	, m_tapB(tapB)
+	, m_mask( (1ULL << width) - 1)
+{
+	//Single step matrix, then square it repeatedly
+	m_jump.resize(64 * width);
+	for(size_t j=0; j<width; j++)
+	{
+		uint64_t state = 1ULL << j;
+		Step(state);
+		m_jump[j] = state;
+	}
+	for(size_t k=1; k<64; k++)
+	{
+		const uint64_t* prev = &m_jump[(k-1) * width];
+		for(size_t j=0; j<width; j++)
+			m_jump[k*width + j] = Apply(prev, prev[j]);
+	}
+
+	//Output and final state of 64 steps from every value of each state byte
+	size_t nbytes = (width + 7) / 8;
+	m_nextState.resize(nbytes * 256);
+	m_output.resize(nbytes * 256);
+	for(size_t i=0; i<nbytes; i++)
+	{
+		for(uint64_t v=0; v<256; v++)
+		{
+			uint64_t state = (v << (i*8)) & m_mask;
+			uint64_t out = 0;
+			for(size_t j=0; j<64; j++)
+			{
+				if(Step(state))
+					out |= (1ULL << j);
+			}
+
+			m_output[i*256 + v] = out;
+			m_nextState[i*256 + v] = state;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Stepping
+
+/**
+	@brief Multiplies a state vector by a transition matrix
+ */
+uint64_t FibonacciLFSR::Apply(const uint64_t* matrix, uint64_t state) const
+{
+	uint64_t ret = 0;
+	for(size_t j=0; j<m_width; j++)
+	{
+		if( (state >> j) & 1)
+			ret ^= matrix[j];
+	}
+	return ret;
+}
+
+/**
+	@brief Returns the state n steps after the given one
+
+	Bits of the state above the LFSR width are ignored.
+ */
+uint64_t FibonacciLFSR::Jump(uint64_t state, uint64_t n) const
+{
+	state &= m_mask;
+	for(size_t k=0; n != 0; k++, n >>= 1)
+	{
+		if(n & 1)
+			state = Apply(&m_jump[k * m_width], state);
+	}
+	return state;
+}
+
+/**
+	@brief Advances the LFSR by 64 steps
+
+	Bits of the state above the LFSR width are ignored.
+
+	@param state	LFSR state, updated in place
+
+	@return The 64 output bits, with the first one in the LSB
+ */
+uint64_t FibonacciLFSR::Next64(uint64_t& state) const
+{
+	uint64_t s = state & m_mask;
+	uint64_t out = 0;
+	uint64_t next = 0;
+	size_t nbytes = m_nextState.size() / 256;
+	for(size_t i=0; i<nbytes; i++)
+	{
+		size_t index = i*256 + ( (s >> (i*8)) & 0xff );
+		out ^= m_output[index];
+		next ^= m_nextState[index];
+	}
+	state = next;
+	return out;
+}
@@ -0,0 +1,109 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FibonacciLFSR
+	@ingroup core
+ */
+#ifndef LFSR_h
+#define LFSR_h
+
+#include <vector>
+#include <cstdint>
+
+/**
+	@brief Word-parallel engine for a two-tap Fibonacci LFSR, as used by the standard PRBS polynomials
+
+	Each step computes the XOR of state bits (tapA-1) and (tapB-1), shifts it in at the LSB, and outputs it. Bit k of the
+	state is thus the output from k+1 steps ago, so loading the first "width" bits of a sequence MSB first gives the
+	state needed to predict the rest of it.
+
+	The LFSR is linear over GF(2), so it can be advanced in two ways without stepping one bit at a time:
+	* Jump() moves the state ahead by an arbitrary number of steps in O(log n) using precomputed matrix powers, which
+	  lets a long sequence be split into independent blocks
+	* Next64() produces the next 64 output bits using one table lookup per byte of state
+
+	@ingroup core
+ */
+class FibonacciLFSR
+{
+public:
+	FibonacciLFSR(unsigned int width, unsigned int tapA, unsigned int tapB);
+
+	uint64_t Jump(uint64_t state, uint64_t n) const;
+	uint64_t Next64(uint64_t& state) const;
+
+	/**
+		@brief Runs the LFSR by a single step
+
+		@return The output bit
+	 */
+	bool Step(uint64_t& state) const
+	{
+		uint64_t next = ( (state >> (m_tapA - 1)) ^ (state >> (m_tapB - 1)) ) & 1;
+		state = ( (state << 1) | next) & m_mask;
+		return next;
+	}
+
+	///@brief Returns the number of bits in the LFSR
+	unsigned int GetWidth() const
+	{ return m_width; }
+
+protected:
+	uint64_t Apply(const uint64_t* matrix, uint64_t state) const;
+
+	///@brief Number of bits in the LFSR
+	unsigned int m_width;
+
+	///@brief First feedback tap (1-based)
+	unsigned int m_tapA;
+
+	///@brief Second feedback tap (1-based)
+	unsigned int m_tapB;
+
+	///@brief Mask of valid bits in the state
+	uint64_t m_mask;
+
+	/**
+		@brief Transition matrices for 2^k steps, for k in [0, 63]
+
+		Matrix k starts at index k*width. Column j is the state reached from a state with only bit j set.
+	 */
+	std::vector<uint64_t> m_jump;
+
+	///@brief State 64 steps later, for each byte of the state (indexed by byte*256 + value)
+	std::vector<uint64_t> m_nextState;
+
+	///@brief Output of the next 64 steps, for each byte of the state (indexed by byte*256 + value)
+	std::vector<uint64_t> m_output;
+};
+
+#endif
@@ -1223,55 +1223,6 @@ time_t MagnovaOscilloscope::ExtractTimestamp(const std::string& timeString, doub
 	return mktime(&tstruc);
 }
 
-/**
-	@brief Converts 16-bit ADC samples to floating point
- */
-void MagnovaOscilloscope::Convert16BitSamples(float* pout, const uint16_t* pin, float gain, float offset, size_t count)
-{
-	//Divide large waveforms (>1M points) into blocks and multithread them
-	if(count > 1000000)
-	{
-		//Round blocks to multiples of 64 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 64);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
-		{
-			//Last block gets any extra that didn't divide evenly
-			size_t nsamp = blocksize;
-			if(i == lastblock)
-				nsamp = count - i*blocksize;
-
-			size_t off = i*blocksize;
-			Convert16BitSamplesGeneric(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-		}
-	}
-
-	//Small waveforms get done single threaded to avoid overhead
-	else
-	{
-		Convert16BitSamplesGeneric(pout, pin, gain, offset, count);
-	}
-}
-
-/**
-	@brief Converts raw ADC samples to floating point
- */
-void MagnovaOscilloscope::Convert16BitSamplesGeneric(float* pout, const uint16_t* pin, float gain, float offset, size_t count)
-{
-	for(size_t j=0; j<count; j++)
-		pout[j] = gain*pin[j] - offset;
-}
-
-
 vector<WaveformBase*> MagnovaOscilloscope::ProcessAnalogWaveform(
 	const std::vector<uint8_t>& data,
 	size_t datalen,
@@ -1351,7 +1302,7 @@ vector<WaveformBase*> MagnovaOscilloscope::ProcessAnalogWaveform(
 		cap->PrepareForCpuAccess();
 
 		//Convert raw ADC samples to volts
-		Convert16BitSamples(
+		ConvertUnsigned16BitSamples(
 			cap->m_samples.GetCpuPointer(),
 			(wdata + j * num_per_segment),
 			v_gain,
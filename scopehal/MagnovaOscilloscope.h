@@ -82,10 +82,6 @@ protected:
 	void ParseFirmwareVersion();
 
 public:
-	// Specific 16 bit conversion methods for uint16_t
-	static void Convert16BitSamples(float* pout, const uint16_t* pin, float gain, float offset, size_t count);
-	static void Convert16BitSamplesGeneric(float* pout, const uint16_t* pin, float gain, float offset, size_t count);
-
 	//Device information
 	virtual unsigned int GetInstrumentTypes() const override;
 	virtual unsigned int GetMeasurementTypes();
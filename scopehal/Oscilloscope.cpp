@@ -1024,25 +1024,117 @@ bool Oscilloscope::IsHighRateOffsetCapable([[maybe_unused]] size_t i)
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Helpers for converting raw 8-bit ADC samples to fp32 waveforms
+// Helpers for converting raw ADC samples to fp32 waveforms
 
 /**
 	@brief Converts 8-bit ADC samples to floating point
  */
 void Oscilloscope::Convert8BitSamples(float* pout, const int8_t* pin, float gain, float offset, size_t count)
 {
-	//Divide large waveforms (>1M points) into blocks and multithread them
-	//TODO: tune split
-	if(count > 1000000)
+	ConvertRawSamples(pout, pin, RAW_S8, gain, offset, count);
+}
+
+/**
+	@brief Converts Unsigned 8-bit ADC samples to floating point
+ */
+void Oscilloscope::ConvertUnsigned8BitSamples(float* pout, const uint8_t* pin, float gain, float offset, size_t count)
+{
+	ConvertRawSamples(pout, pin, RAW_U8, gain, offset, count);
+}
+
+/**
+	@brief Converts signed 16-bit little endian ADC samples to floating point
+ */
+void Oscilloscope::Convert16BitSamples(float* pout, const int16_t* pin, float gain, float offset, size_t count)
+{
+	ConvertRawSamples(pout, pin, RAW_S16, gain, offset, count);
+}
+
+/**
+	@brief Converts unsigned 16-bit little endian ADC samples to floating point
+ */
+void Oscilloscope::ConvertUnsigned16BitSamples(float* pout, const uint16_t* pin, float gain, float offset, size_t count)
+{
+	ConvertRawSamples(pout, pin, RAW_U16, gain, offset, count);
+}
+
+/**
+	@brief Returns the number of bytes occupied by one sample in the given raw format
+ */
+size_t Oscilloscope::GetRawSampleSize(RawSampleFormat format)
+{
+	switch(format)
+	{
+		case RAW_S8:
+		case RAW_U8:
+			return 1;
+
+		case RAW_F32:
+			return 4;
+
+		default:
+			return 2;
+	}
+}
+
+/**
+	@brief Converts raw ADC samples to floating point
+
+	Each output sample is raw * gain - offset.
+
+	@param pout		Output buffer
+	@param pin		Raw sample data, no alignment required
+	@param format	Encoding of the raw samples
+	@param gain		Volts per LSB
+	@param offset	Value subtracted after scaling
+	@param count	Number of samples to convert
+ */
+void Oscilloscope::ConvertRawSamples(
+	float* pout,
+	const void* pin,
+	RawSampleFormat format,
+	float gain,
+	float offset,
+	size_t count)
+{
+	ConvertInterleavedRawSamples(&pout, pin, format, 1, &gain, &offset, count);
+}
+
+/**
+	@brief Converts interleaved multi-channel raw ADC samples to floating point, splitting out each channel
+
+	The input is one sample from channel 0, then one from channel 1, etc. for each point in time.
+
+	@param pout		Output buffers, one per channel
+	@param pin		Raw sample data, no alignment required
+	@param format	Encoding of the raw samples
+	@param nchans	Number of interleaved channels. 1, 2, and 4 are vectorized, anything else takes the generic path.
+	@param gains	Volts per LSB, one per channel
+	@param offsets	Value subtracted after scaling, one per channel
+	@param count	Number of samples to convert per channel
+ */
+void Oscilloscope::ConvertInterleavedRawSamples(
+	float* const* pout,
+	const void* pin,
+	RawSampleFormat format,
+	size_t nchans,
+	const float* gains,
+	const float* offsets,
+	size_t count)
+{
+	auto raw = reinterpret_cast<const uint8_t*>(pin);
+	size_t stride = GetRawSampleSize(format) * nchans;
+
+	//Divide large waveforms into blocks and multithread them.
+	//Round blocks to multiples of 64 samples for clean vectorization.
+	auto split = ParallelTuning::GetSplit(ParallelTuning::KERNEL_SAMPLE_CONVERSION, count, 64, nchans);
+	if(split.m_threads > 1)
 	{
-		//Round blocks to multiples of 32 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 32);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
+		size_t lastblock = split.m_numBlocks - 1;
+		size_t blocksize = split.m_blockSize;
+
+		#pragma omp parallel for num_threads(split.m_threads)
+		for(size_t i=0; i<split.m_numBlocks; i++)
 		{
 			//Last block gets any extra that didn't divide evenly
 			size_t nsamp = blocksize;
@@ -1050,242 +1142,411 @@ void Oscilloscope::Convert8BitSamples(float* pout, const int8_t* pin, float gain
 				nsamp = count - i*blocksize;
 
 			size_t off = i*blocksize;
-			#ifdef __x86_64__
-			if(g_hasAvx2)
-			{
-				Convert8BitSamplesAVX2(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-			else
-			#endif /* __x86_64__ */
-			{
-				Convert8BitSamplesGeneric(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
+			ConvertRawSampleBlock(pout, off, raw + off*stride, format, nchans, gains, offsets, nsamp);
 		}
 	}
 
 	//Small waveforms get done single threaded to avoid overhead
+	else
+		ConvertRawSampleBlock(pout, 0, raw, format, nchans, gains, offsets, count);
+}
+
+/**
+	@brief Decodes a single raw sample to a signed integer
+ */
+template<Oscilloscope::RawSampleFormat format>
+static inline int32_t DecodeRawSample(const uint8_t* p)
+{
+	if constexpr(format == Oscilloscope::RAW_S8)
+		return static_cast<int8_t>(p[0]);
+	else if constexpr(format == Oscilloscope::RAW_U8)
+		return p[0];
 	else
 	{
-		#ifdef __x86_64__
-		if(g_hasAvx2)
-			Convert8BitSamplesAVX2(pout, pin, gain, offset, count);
+		constexpr bool bigEndian =
+			(format == Oscilloscope::RAW_S16_BE) || (format == Oscilloscope::RAW_U16_BE) ||
+			(format == Oscilloscope::RAW_S12_BE) || (format == Oscilloscope::RAW_U12_BE);
+		uint16_t word = bigEndian ? ( (p[0] << 8) | p[1] ) : ( (p[1] << 8) | p[0] );
+
+		if constexpr( (format == Oscilloscope::RAW_S16) || (format == Oscilloscope::RAW_S16_BE) )
+			return static_cast<int16_t>(word);
+		else if constexpr( (format == Oscilloscope::RAW_U16) || (format == Oscilloscope::RAW_U16_BE) )
+			return word;
+		else if constexpr( (format == Oscilloscope::RAW_S12) || (format == Oscilloscope::RAW_S12_BE) )
+			return static_cast<int16_t>(word << 4) >> 4;
 		else
-		#endif
-			Convert8BitSamplesGeneric(pout, pin, gain, offset, count);
+			return word & 0xfff;
 	}
 }
 
 /**
-	@brief Generic backend for Convert8BitSamples()
+	@brief Generic backend for ConvertInterleavedRawSamples()
  */
-void Oscilloscope::Convert8BitSamplesGeneric(float* pout, const int8_t* pin, float gain, float offset, size_t count)
-{
-	for(unsigned int k=0; k<count; k++)
-		pout[k] = pin[k] * gain - offset;
+template<Oscilloscope::RawSampleFormat format>
+static void ConvertRawSamplesGeneric(
+	float* const* pout,
+	size_t outoff,
+	const uint8_t* pin,
+	size_t nchans,
+	const float* gains,
+	const float* offsets,
+	size_t count)
+{
+	constexpr size_t size = (format == Oscilloscope::RAW_S8) || (format == Oscilloscope::RAW_U8) ? 1 : 2;
+	for(size_t c=0; c<nchans; c++)
+	{
+		float* out = pout[c] + outoff;
+		float gain = gains[c];
+		float offset = offsets[c];
+
+		if constexpr(format == Oscilloscope::RAW_F32)
+		{
+			const uint8_t* in = pin + c*sizeof(float);
+			for(size_t k=0; k<count; k++)
+			{
+				float sample;
+				memcpy(&sample, in + k*nchans*sizeof(float), sizeof(float));
+				out[k] = sample * gain - offset;
+			}
+		}
+		else
+		{
+			const uint8_t* in = pin + c*size;
+			for(size_t k=0; k<count; k++)
+				out[k] = DecodeRawSample<format>(in + k*nchans*size) * gain - offset;
+		}
+	}
 }
 
 #ifdef __x86_64__
+
 /**
-	@brief Optimized version of Convert8BitSamples()
+	@brief Loads eight raw samples and widens them to 32-bit integers
  */
+template<Oscilloscope::RawSampleFormat format>
 __attribute__((target("avx2")))
-void Oscilloscope::Convert8BitSamplesAVX2(float* pout, const int8_t* pin, float gain, float offset, size_t count)
+static inline __m256i LoadRawSamplesAVX2(const uint8_t* p)
 {
-	unsigned int end = count - (count % 32);
+	if constexpr(format == Oscilloscope::RAW_S8)
+		return _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+	else if constexpr(format == Oscilloscope::RAW_U8)
+		return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+	else
+	{
+		__m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+
+		//Swap bytes within each word for big endian data
+		if constexpr(
+			(format == Oscilloscope::RAW_S16_BE) || (format == Oscilloscope::RAW_U16_BE) ||
+			(format == Oscilloscope::RAW_S12_BE) || (format == Oscilloscope::RAW_U12_BE) )
+		{
+			words = _mm_shuffle_epi8(words, _mm_set_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1));
+		}
+
+		if constexpr( (format == Oscilloscope::RAW_S16) || (format == Oscilloscope::RAW_S16_BE) )
+			return _mm256_cvtepi16_epi32(words);
+		else if constexpr( (format == Oscilloscope::RAW_U16) || (format == Oscilloscope::RAW_U16_BE) )
+			return _mm256_cvtepu16_epi32(words);
+
+		//12-bit samples are right justified, so sign extend from bit 11 or discard the top nibble
+		else if constexpr( (format == Oscilloscope::RAW_S12) || (format == Oscilloscope::RAW_S12_BE) )
+			return _mm256_srai_epi32(_mm256_slli_epi32(_mm256_cvtepu16_epi32(words), 20), 20);
+		else
+			return _mm256_and_si256(_mm256_cvtepu16_epi32(words), _mm256_set1_epi32(0xfff));
+	}
+}
+
+/**
+	@brief AVX2 backend for ConvertInterleavedRawSamples()
+
+	Samples are scaled while still interleaved (using gain/offset vectors repeating with the channel count), then
+	transposed into per-channel vectors of eight samples.
+ */
+template<Oscilloscope::RawSampleFormat format, size_t nchans>
+__attribute__((target("avx2")))
+static void ConvertRawSamplesAVX2(
+	float* const* pout,
+	size_t outoff,
+	const uint8_t* pin,
+	const float* gains,
+	const float* offsets,
+	size_t count)
+{
+	constexpr size_t size = (format == Oscilloscope::RAW_S8) || (format == Oscilloscope::RAW_U8) ? 1 : 2;
+
+	float g[8];
+	float o[8];
+	for(size_t i=0; i<8; i++)
+	{
+		g[i] = gains[i % nchans];
+		o[i] = offsets[i % nchans];
+	}
+	__m256 vgain = _mm256_loadu_ps(g);
+	__m256 voff = _mm256_loadu_ps(o);
 
-	__m256 gains = { gain, gain, gain, gain, gain, gain, gain, gain };
-	__m256 offsets = { offset, offset, offset, offset, offset, offset, offset, offset };
+	//Restores time order after the 4-way transpose, which leaves even and odd points in separate halves
+	__m256i unshuffle4 = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
 
-	for(unsigned int k=0; k<end; k += 32)
+	size_t end = count - (count % 8);
+	for(size_t k=0; k<end; k += 8)
 	{
-		//Load all 32 raw ADC samples, without assuming alignment
-		//(on most modern Intel processors, load and loadu have same latency/throughput)
-		__m256i raw_samples = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k));
-
-		//Extract the low and high 16 samples from the block
-		__m128i block01_x8 = _mm256_extracti128_si256(raw_samples, 0);
-		__m128i block23_x8 = _mm256_extracti128_si256(raw_samples, 1);
-
-		//Swap the low and high halves of these vectors
-		//Ugly casting needed because all permute instrinsics expect float/double datatypes
-		__m128i block10_x8 = _mm_castpd_si128(_mm_permute_pd(_mm_castsi128_pd(block01_x8), 1));
-		__m128i block32_x8 = _mm_castpd_si128(_mm_permute_pd(_mm_castsi128_pd(block23_x8), 1));
-
-		//Divide into blocks of 8 samples and sign extend to 32 bit
-		__m256i block0_int = _mm256_cvtepi8_epi32(block01_x8);
-		__m256i block1_int = _mm256_cvtepi8_epi32(block10_x8);
-		__m256i block2_int = _mm256_cvtepi8_epi32(block23_x8);
-		__m256i block3_int = _mm256_cvtepi8_epi32(block32_x8);
-
-		//Convert the 32-bit int blocks to float.
-		//Apparently there's no direct epi8 to ps conversion instruction.
-		__m256 block0_float = _mm256_cvtepi32_ps(block0_int);
-		__m256 block1_float = _mm256_cvtepi32_ps(block1_int);
-		__m256 block2_float = _mm256_cvtepi32_ps(block2_int);
-		__m256 block3_float = _mm256_cvtepi32_ps(block3_int);
-
-		//Woo! We've finally got floating point data. Now we can do the fun part.
-		block0_float = _mm256_mul_ps(block0_float, gains);
-		block1_float = _mm256_mul_ps(block1_float, gains);
-		block2_float = _mm256_mul_ps(block2_float, gains);
-		block3_float = _mm256_mul_ps(block3_float, gains);
-
-		block0_float = _mm256_sub_ps(block0_float, offsets);
-		block1_float = _mm256_sub_ps(block1_float, offsets);
-		block2_float = _mm256_sub_ps(block2_float, offsets);
-		block3_float = _mm256_sub_ps(block3_float, offsets);
-
-		//All done, store back to the output buffer
-		_mm256_store_ps(pout + k, 		block0_float);
-		_mm256_store_ps(pout + k + 8,	block1_float);
-		_mm256_store_ps(pout + k + 16,	block2_float);
-		_mm256_store_ps(pout + k + 24,	block3_float);
+		//Eight points per channel means nchans vectors of raw samples
+		const uint8_t* p = pin + k*nchans*size;
+		__m256 v[nchans];
+		for(size_t i=0; i<nchans; i++)
+		{
+			v[i] = _mm256_cvtepi32_ps(LoadRawSamplesAVX2<format>(p + i*8*size));
+			v[i] = _mm256_sub_ps(_mm256_mul_ps(v[i], vgain), voff);
+		}
+
+		if constexpr(nchans == 1)
+			_mm256_storeu_ps(pout[0] + outoff + k, v[0]);
+
+		else if constexpr(nchans == 2)
+		{
+			__m256 even = _mm256_shuffle_ps(v[0], v[1], _MM_SHUFFLE(2, 0, 2, 0));
+			__m256 odd = _mm256_shuffle_ps(v[0], v[1], _MM_SHUFFLE(3, 1, 3, 1));
+			even = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(even), _MM_SHUFFLE(3, 1, 2, 0)));
+			odd = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(odd), _MM_SHUFFLE(3, 1, 2, 0)));
+			_mm256_storeu_ps(pout[0] + outoff + k, even);
+			_mm256_storeu_ps(pout[1] + outoff + k, odd);
+		}
+
+		else
+		{
+			__m256 t0 = _mm256_shuffle_ps(v[0], v[1], _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 t1 = _mm256_shuffle_ps(v[0], v[1], _MM_SHUFFLE(3, 2, 3, 2));
+			__m256 t2 = _mm256_shuffle_ps(v[2], v[3], _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 t3 = _mm256_shuffle_ps(v[2], v[3], _MM_SHUFFLE(3, 2, 3, 2));
+
+			__m256 c0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(2, 0, 2, 0));
+			__m256 c1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 1, 3, 1));
+			__m256 c2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(2, 0, 2, 0));
+			__m256 c3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 1, 3, 1));
+
+			_mm256_storeu_ps(pout[0] + outoff + k, _mm256_permutevar8x32_ps(c0, unshuffle4));
+			_mm256_storeu_ps(pout[1] + outoff + k, _mm256_permutevar8x32_ps(c1, unshuffle4));
+			_mm256_storeu_ps(pout[2] + outoff + k, _mm256_permutevar8x32_ps(c2, unshuffle4));
+			_mm256_storeu_ps(pout[3] + outoff + k, _mm256_permutevar8x32_ps(c3, unshuffle4));
+		}
 	}
 
 	//Get any extras we didn't get in the SIMD loop
-	for(unsigned int k=end; k<count; k++)
-		pout[k] = pin[k] * gain - offset;
+	ConvertRawSamplesGeneric<format>(pout, outoff + end, pin + end*nchans*size, nchans, gains, offsets, count - end);
 }
-#endif /* __x86_64__ */
 
 /**
-	@brief Converts Unsigned 8-bit ADC samples to floating point
+	@brief AVX-512 backend for ConvertRawSamples(), single channel only
  */
-void Oscilloscope::ConvertUnsigned8BitSamples(float* pout, const uint8_t* pin, float gain, float offset, size_t count)
-{
-	//Divide large waveforms (>1M points) into blocks and multithread them
-	//TODO: tune split
-	if(count > 1000000)
+template<Oscilloscope::RawSampleFormat format>
+__attribute__((target("avx512f")))
+static void ConvertRawSamplesAVX512F(
+	float* pout,
+	const uint8_t* pin,
+	float gain,
+	float offset,
+	size_t count)
+{
+	constexpr size_t size = (format == Oscilloscope::RAW_S8) || (format == Oscilloscope::RAW_U8) ? 1 : 2;
+
+	__m512 vgain = _mm512_set1_ps(gain);
+	__m512 voff = _mm512_set1_ps(offset);
+
+	size_t end = count - (count % 16);
+	for(size_t k=0; k<end; k += 16)
 	{
-		//Round blocks to multiples of 32 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 32);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
+		const uint8_t* p = pin + k*size;
+		__m512i ints;
+		if constexpr(format == Oscilloscope::RAW_S8)
+			ints = _mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+		else if constexpr(format == Oscilloscope::RAW_U8)
+			ints = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+		else
 		{
-			//Last block gets any extra that didn't divide evenly
-			size_t nsamp = blocksize;
-			if(i == lastblock)
-				nsamp = count - i*blocksize;
-
-			size_t off = i*blocksize;
-			#ifdef __x86_64__
-			if(g_hasAvx2)
+			__m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+			if constexpr(
+				(format == Oscilloscope::RAW_S16_BE) || (format == Oscilloscope::RAW_U16_BE) ||
+				(format == Oscilloscope::RAW_S12_BE) || (format == Oscilloscope::RAW_U12_BE) )
 			{
-				ConvertUnsigned8BitSamplesAVX2(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
+				__m256i swap = _mm256_setr_epi8(
+					1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+					1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+				words = _mm256_shuffle_epi8(words, swap);
 			}
+
+			if constexpr( (format == Oscilloscope::RAW_S16) || (format == Oscilloscope::RAW_S16_BE) )
+				ints = _mm512_cvtepi16_epi32(words);
+			else if constexpr( (format == Oscilloscope::RAW_U16) || (format == Oscilloscope::RAW_U16_BE) )
+				ints = _mm512_cvtepu16_epi32(words);
+			else if constexpr( (format == Oscilloscope::RAW_S12) || (format == Oscilloscope::RAW_S12_BE) )
+				ints = _mm512_srai_epi32(_mm512_slli_epi32(_mm512_cvtepu16_epi32(words), 20), 20);
 			else
-			#endif
+				ints = _mm512_and_si512(_mm512_cvtepu16_epi32(words), _mm512_set1_epi32(0xfff));
+		}
+
+		__m512 f = _mm512_sub_ps(_mm512_mul_ps(_mm512_cvtepi32_ps(ints), vgain), voff);
+		_mm512_storeu_ps(pout + k, f);
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	ConvertRawSamplesGeneric<format>(&pout, end, pin + end*size, 1, &gain, &offset, count - end);
+}
+
+#endif /* __x86_64__ */
+
+/**
+	@brief Picks the best backend for one format
+ */
+template<Oscilloscope::RawSampleFormat format>
+static void ConvertRawSampleBlockForFormat(
+	float* const* pout,
+	size_t outoff,
+	const uint8_t* pin,
+	size_t nchans,
+	const float* gains,
+	const float* offsets,
+	size_t count)
+{
+	#ifdef __x86_64__
+	//Float input is already in the output format, so the integer widening kernels don't apply
+	if constexpr(format != Oscilloscope::RAW_F32)
+	{
+		if( (nchans == 1) && g_hasAvx512F)
+		{
+			ConvertRawSamplesAVX512F<format>(pout[0] + outoff, pin, gains[0], offsets[0], count);
+			return;
+		}
+
+		if(g_hasAvx2)
+		{
+			switch(nchans)
 			{
-				ConvertUnsigned8BitSamplesGeneric(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
+				case 1:
+					ConvertRawSamplesAVX2<format, 1>(pout, outoff, pin, gains, offsets, count);
+					return;
+
+				case 2:
+					ConvertRawSamplesAVX2<format, 2>(pout, outoff, pin, gains, offsets, count);
+					return;
+
+				case 4:
+					ConvertRawSamplesAVX2<format, 4>(pout, outoff, pin, gains, offsets, count);
+					return;
+
+				default:
+					break;
 			}
 		}
 	}
+	#endif /* __x86_64__ */
 
-	//Small waveforms get done single threaded to avoid overhead
-	else
+	ConvertRawSamplesGeneric<format>(pout, outoff, pin, nchans, gains, offsets, count);
+}
+
+/**
+	@brief Converts one block of (possibly interleaved) raw samples, single threaded
+
+	@param pout		Output buffers, one per channel
+	@param outoff	Index of the first output sample to write in each buffer
+	@param pin		Raw sample data for the first point in the block
+	@param format	Encoding of the raw samples
+	@param nchans	Number of interleaved channels
+	@param gains	Volts per LSB, one per channel
+	@param offsets	Value subtracted after scaling, one per channel
+	@param count	Number of samples to convert per channel
+ */
+void Oscilloscope::ConvertRawSampleBlock(
+	float* const* pout,
+	size_t outoff,
+	const uint8_t* pin,
+	RawSampleFormat format,
+	size_t nchans,
+	const float* gains,
+	const float* offsets,
+	size_t count)
+{
+	switch(format)
 	{
-		#ifdef __x86_64__
-		if(g_hasAvx2)
-			ConvertUnsigned8BitSamplesAVX2(pout, pin, gain, offset, count);
-		else
-		#endif
-			ConvertUnsigned8BitSamplesGeneric(pout, pin, gain, offset, count);
+		case RAW_S8:
+			ConvertRawSampleBlockForFormat<RAW_S8>(pout, outoff, pin, nchans, gains, offsets, count);
+			break;
+
+		case RAW_U8:
+			ConvertRawSampleBlockForFormat<RAW_U8>(pout, outoff, pin, nchans, gains, offsets, count);
+			break;
+
+		case RAW_S12:
+			ConvertRawSampleBlockForFormat<RAW_S12>(pout, outoff, pin, nchans, gains, offsets, count);
+			break;
+
+		case RAW_U12:
+			ConvertRawSampleBlockForFormat<RAW_U12>(pout, outoff, pin, nchans, gains, offsets, count);
+			break;
+
+		case RAW_S16:
+			ConvertRawSampleBlockForFormat<RAW_S16>(pout, outoff, pin, nchans, gains, offsets, count);
+			break;
+
+		case RAW_U16:
+			ConvertRawSampleBlockForFormat<RAW_U16>(pout, outoff, pin, nchans, gains, offsets, count);
+			break;
+
+		case RAW_S12_BE:
+			ConvertRawSampleBlockForFormat<RAW_S12_BE>(pout, outoff, pin, nchans, gains, offsets, count);
+			break;
+
+		case RAW_U12_BE:
+			ConvertRawSampleBlockForFormat<RAW_U12_BE>(pout, outoff, pin, nchans, gains, offsets, count);
+			break;
+
+		case RAW_S16_BE:
+			ConvertRawSampleBlockForFormat<RAW_S16_BE>(pout, outoff, pin, nchans, gains, offsets, count);
+			break;
+
+		case RAW_U16_BE:
+			ConvertRawSampleBlockForFormat<RAW_U16_BE>(pout, outoff, pin, nchans, gains, offsets, count);
+			break;
+
+		case RAW_F32:
+			ConvertRawSampleBlockForFormat<RAW_F32>(pout, outoff, pin, nchans, gains, offsets, count);
+			break;
 	}
 }
 
 /**
-	@brief Generic backend for ConvertUnsigned8BitSamples()
+	@brief Generic backend for Convert8BitSamples(), single threaded
+ */
+void Oscilloscope::Convert8BitSamplesGeneric(float* pout, const int8_t* pin, float gain, float offset, size_t count)
+{
+	ConvertRawSamplesGeneric<RAW_S8>(&pout, 0, reinterpret_cast<const uint8_t*>(pin), 1, &gain, &offset, count);
+}
+
+/**
+	@brief Generic backend for ConvertUnsigned8BitSamples(), single threaded
  */
-void Oscilloscope::ConvertUnsigned8BitSamplesGeneric(float* pout, const uint8_t* pin, float gain, float offset, size_t count)
+void Oscilloscope::ConvertUnsigned8BitSamplesGeneric(
+	float* pout, const uint8_t* pin, float gain, float offset, size_t count)
 {
-	for(unsigned int k=0; k<count; k++)
-		pout[k] = pin[k] * gain - offset;
+	ConvertRawSamplesGeneric<RAW_U8>(&pout, 0, pin, 1, &gain, &offset, count);
 }
 
 #ifdef __x86_64__
 /**
-	@brief Optimized version of ConvertUnsigned8BitSamples()
+	@brief Optimized version of Convert8BitSamples(), single threaded
  */
 __attribute__((target("avx2")))
-void Oscilloscope::ConvertUnsigned8BitSamplesAVX2(float* pout, const uint8_t* pin, float gain, float offset, size_t count)
+void Oscilloscope::Convert8BitSamplesAVX2(float* pout, const int8_t* pin, float gain, float offset, size_t count)
 {
-	unsigned int end = count - (count % 32);
-
-	__m256 gains = { gain, gain, gain, gain, gain, gain, gain, gain };
-	__m256 offsets = { offset, offset, offset, offset, offset, offset, offset, offset };
-
-	for(unsigned int k=0; k<end; k += 32)
-	{
-		//Load all 32 raw ADC samples, without assuming alignment
-		//(on most modern Intel processors, load and loadu have same latency/throughput)
-		__m256i raw_samples = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k));
-
-		//Extract the low and high 16 samples from the block
-		__m128i block01_x8 = _mm256_extracti128_si256(raw_samples, 0);
-		__m128i block23_x8 = _mm256_extracti128_si256(raw_samples, 1);
-
-		//Swap the low and high halves of these vectors
-		//Ugly casting needed because all permute instrinsics expect float/double datatypes
-		__m128i block10_x8 = _mm_castpd_si128(_mm_permute_pd(_mm_castsi128_pd(block01_x8), 1));
-		__m128i block32_x8 = _mm_castpd_si128(_mm_permute_pd(_mm_castsi128_pd(block23_x8), 1));
-
-		//Divide into blocks of 8 samples and sign extend to 32 bit
-		__m256i block0_int = _mm256_cvtepu8_epi32(block01_x8);
-		__m256i block1_int = _mm256_cvtepu8_epi32(block10_x8);
-		__m256i block2_int = _mm256_cvtepu8_epi32(block23_x8);
-		__m256i block3_int = _mm256_cvtepu8_epi32(block32_x8);
-
-		//Convert the 32-bit int blocks to float.
-		//Apparently there's no direct epi8 to ps conversion instruction.
-		__m256 block0_float = _mm256_cvtepi32_ps(block0_int);
-		__m256 block1_float = _mm256_cvtepi32_ps(block1_int);
-		__m256 block2_float = _mm256_cvtepi32_ps(block2_int);
-		__m256 block3_float = _mm256_cvtepi32_ps(block3_int);
-
-		//Woo! We've finally got floating point data. Now we can do the fun part.
-		block0_float = _mm256_mul_ps(block0_float, gains);
-		block1_float = _mm256_mul_ps(block1_float, gains);
-		block2_float = _mm256_mul_ps(block2_float, gains);
-		block3_float = _mm256_mul_ps(block3_float, gains);
-
-		block0_float = _mm256_sub_ps(block0_float, offsets);
-		block1_float = _mm256_sub_ps(block1_float, offsets);
-		block2_float = _mm256_sub_ps(block2_float, offsets);
-		block3_float = _mm256_sub_ps(block3_float, offsets);
-
-		//All done, store back to the output buffer
-		_mm256_store_ps(pout + k, 		block0_float);
-		_mm256_store_ps(pout + k + 8,	block1_float);
-		_mm256_store_ps(pout + k + 16,	block2_float);
-		_mm256_store_ps(pout + k + 24,	block3_float);
-	}
+	ConvertRawSamplesAVX2<RAW_S8, 1>(&pout, 0, reinterpret_cast<const uint8_t*>(pin), &gain, &offset, count);
+}
 
-	//Get any extras we didn't get in the SIMD loop
-	for(unsigned int k=end; k<count; k++)
-		pout[k] = pin[k] * gain - offset;
+/**
+	@brief Optimized version of ConvertUnsigned8BitSamples(), single threaded
+ */
+__attribute__((target("avx2")))
+void Oscilloscope::ConvertUnsigned8BitSamplesAVX2(
+	float* pout, const uint8_t* pin, float gain, float offset, size_t count)
+{
+	ConvertRawSamplesAVX2<RAW_U8, 1>(&pout, 0, pin, &gain, &offset, count);
 }
 #endif /* __x86_64__ */
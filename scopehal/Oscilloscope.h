@@ -864,6 +864,47 @@ protected:
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Sample format conversion
 public:
+
+	/**
+		@brief Encodings of raw ADC samples understood by ConvertRawSamples()
+
+		12-bit formats are right justified in a 16-bit word. Left justified 12-bit data is just 16-bit data with a
+		different gain.
+	 */
+	enum RawSampleFormat
+	{
+		RAW_S8,			///< Signed 8-bit
+		RAW_U8,			///< Unsigned 8-bit
+		RAW_S12,		///< Signed 12-bit, little endian
+		RAW_U12,		///< Unsigned 12-bit, little endian
+		RAW_S16,		///< Signed 16-bit, little endian
+		RAW_U16,		///< Unsigned 16-bit, little endian
+		RAW_S12_BE,		///< Signed 12-bit, big endian
+		RAW_U12_BE,		///< Unsigned 12-bit, big endian
+		RAW_S16_BE,		///< Signed 16-bit, big endian
+		RAW_U16_BE,		///< Unsigned 16-bit, big endian
+		RAW_F32			///< 32-bit IEEE float, native byte order (not vectorized)
+	};
+
+	static size_t GetRawSampleSize(RawSampleFormat format);
+
+	static void ConvertRawSamples(
+		float* pout,
+		const void* pin,
+		RawSampleFormat format,
+		float gain,
+		float offset,
+		size_t count);
+
+	static void ConvertInterleavedRawSamples(
+		float* const* pout,
+		const void* pin,
+		RawSampleFormat format,
+		size_t nchans,
+		const float* gains,
+		const float* offsets,
+		size_t count);
+
 	static void Convert8BitSamples(float* pout, const int8_t* pin, float gain, float offset, size_t count);
 	static void Convert8BitSamplesGeneric(float* pout, const int8_t* pin, float gain, float offset, size_t count);
 #ifdef __x86_64__
@@ -876,7 +917,19 @@ public:
 	static void ConvertUnsigned8BitSamplesAVX2(float* pout, const uint8_t* pin, float gain, float offset, size_t count);
 #endif
 
+	static void Convert16BitSamples(float* pout, const int16_t* pin, float gain, float offset, size_t count);
+	static void ConvertUnsigned16BitSamples(float* pout, const uint16_t* pin, float gain, float offset, size_t count);
+
 protected:
+	static void ConvertRawSampleBlock(
+		float* const* pout,
+		size_t outoff,
+		const uint8_t* pin,
+		RawSampleFormat format,
+		size_t nchans,
+		const float* gains,
+		const float* offsets,
+		size_t count);
 
 	///@brief Vulkan queue for GPU waveform processing
 	std::shared_ptr<QueueHandle> m_queue;
@@ -0,0 +1,196 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PackedBits
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "PackedBits.h"
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Packing
+
+/**
+	@brief Packs a digital waveform into a bit array, with sample i in bit i%64 of word i/64
+
+	Two words of zero padding are added at the end so Get() can be used on any sample.
+ */
+void PackedBits::Pack(const bool* samples, size_t len, vector<uint64_t>& bits)
+{
+	bits.clear();
+	bits.resize(len/64 + 2, 0);
+
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		PackAVX2(samples, len, bits.data());
+	else
+	#endif
+		PackGeneric(samples, len, bits.data());
+}
+
+void PackedBits::PackGeneric(const bool* samples, size_t len, uint64_t* bits)
+{
+	for(size_t i=0; i<len; i++)
+		bits[i/64] |= static_cast<uint64_t>(samples[i]) << (i%64);
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 optimized version of PackGeneric()
+ */
+__attribute__((target("avx2")))
+void PackedBits::PackAVX2(const bool* samples, size_t len, uint64_t* bits)
+{
+	//Bools are 0 or 1, so shifting each 16-bit lane left by 7 moves every byte's value into its MSB
+	size_t end = len - (len % 64);
+	for(size_t i=0; i<end; i+=64)
+	{
+		__m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i));
+		__m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i + 32));
+		uint32_t mlo = _mm256_movemask_epi8(_mm256_slli_epi16(lo, 7));
+		uint32_t mhi = _mm256_movemask_epi8(_mm256_slli_epi16(hi, 7));
+		bits[i/64] = (static_cast<uint64_t>(mhi) << 32) | mlo;
+	}
+
+	for(size_t i=end; i<len; i++)
+		bits[i/64] |= static_cast<uint64_t>(samples[i]) << (i%64);
+}
+#endif /* __x86_64__ */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Block alignment
+
+/**
+	@brief Finds the phase of a stream of blocks with two-bit sync headers (64b/66b, 128b/130b)
+
+	A block starting at sample i has a valid header if samples i and i+1 differ. Every offset in [0, blocklen) is
+	scored by the number of blocks starting before end with an invalid header, and the first offset with the fewest
+	errors is returned.
+
+	Rather than walking the capture once per offset, the header checks for all samples are computed 64 at a time into
+	an error mask. The masks of 64 consecutive blocks are then stacked into a 64x64 bit matrix and transposed, which
+	leaves the errors for one offset in each row so they can be counted with a single popcount.
+
+	@param bits		Input samples packed by Pack(). Must contain at least end+1 samples.
+	@param end		Index of the first sample which may not start a block
+	@param blocklen	Block length, in samples
+ */
+size_t PackedBits::FindBlockAlignment(const uint64_t* bits, size_t end, size_t blocklen)
+{
+	//Error mask: bit i is set if samples i and i+1 are equal, for all i before the end.
+	//Pad with zeroes so full 64-bit rows can be read past the end of the last block.
+	size_t nwords = (end + 63) / 64;
+	vector<uint64_t> errs(nwords + (2*blocklen)/64 + 4, 0);
+	for(size_t w=0; w<nwords; w++)
+	{
+		uint64_t e = ~(bits[w] ^ Get(bits, w*64 + 1));
+		size_t valid = end - w*64;
+		if(valid < 64)
+			e &= (1ULL << valid) - 1;
+		errs[w] = e;
+	}
+
+	size_t nblocks = (end + blocklen - 1) / blocklen;
+	size_t ngroups = (nblocks + 63) / 64;
+	size_t nchunks = (blocklen + 63) / 64;
+
+	auto split = ParallelTuning::GetSplit(ParallelTuning::KERNEL_REDUCTION, ngroups, 1, blocklen);
+	size_t lastblock = split.m_numBlocks - 1;
+	size_t blocksize = split.m_blockSize;
+	vector<vector<size_t>> partial(split.m_numBlocks, vector<size_t>(blocklen, 0));
+
+	#pragma omp parallel for if(split.m_threads > 1) num_threads(split.m_threads)
+	for(size_t i=0; i<split.m_numBlocks; i++)
+	{
+		size_t gstart = i*blocksize;
+		size_t gend = (i == lastblock) ? ngroups : gstart + blocksize;
+		auto& counts = partial[i];
+
+		uint64_t rows[64];
+		for(size_t g=gstart; g<gend; g++)
+		{
+			//Each chunk covers up to 64 offsets
+			for(size_t c=0; c<nchunks; c++)
+			{
+				for(size_t r=0; r<64; r++)
+				{
+					size_t k = g*64 + r;
+					rows[r] = (k < nblocks) ? Get(errs.data(), k*blocklen + c*64) : 0;
+				}
+
+				Transpose64(rows);
+
+				size_t nlanes = min(blocklen - c*64, (size_t)64);
+				for(size_t j=0; j<nlanes; j++)
+					counts[c*64 + j] += __builtin_popcountll(rows[j]);
+			}
+		}
+	}
+
+	size_t best_offset = 0;
+	size_t best_errors = end;
+	for(size_t offset=0; offset<blocklen; offset++)
+	{
+		size_t errors = 0;
+		for(auto& counts : partial)
+			errors += counts[offset];
+
+		if(errors < best_errors)
+		{
+			best_offset = offset;
+			best_errors = errors;
+		}
+	}
+	return best_offset;
+}
+
+/**
+	@brief Transposes a 64x64 bit matrix in place, so bit j of row i becomes bit i of row j
+ */
+void PackedBits::Transpose64(uint64_t* rows)
+{
+	uint64_t mask = 0x00000000ffffffffULL;
+	for(size_t j=32; j != 0; j >>= 1, mask ^= (mask << j))
+	{
+		for(size_t k=0; k<64; k = ((k | j) + 1) & ~j)
+		{
+			uint64_t t = ((rows[k] >> j) ^ rows[k | j]) & mask;
+			rows[k | j] ^= t;
+			rows[k] ^= (t << j);
+		}
+	}
+}
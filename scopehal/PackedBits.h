@@ -0,0 +1,109 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PackedBits
+	@ingroup core
+ */
+#ifndef PackedBits_h
+#define PackedBits_h
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+/**
+	@brief Helpers for working on digital waveforms packed one sample per bit
+
+	Sample i is stored in bit i%64 of word i/64, so 64 consecutive samples can be fetched or compared with a handful
+	of shifts regardless of alignment. Used by line code decoders (8b/10b, 64b/66b, 128b/130b) to look at whole symbols
+	at once instead of walking the bool array one sample at a time.
+
+	@ingroup core
+ */
+class PackedBits
+{
+public:
+	static void Pack(const bool* samples, size_t len, std::vector<uint64_t>& bits);
+
+	static size_t FindBlockAlignment(const uint64_t* bits, size_t end, size_t blocklen);
+
+	/**
+		@brief Returns 64 consecutive samples starting at sample i, one per bit with sample i in bit 0
+
+		The bit array must have at least one word of padding past the sample at i.
+	 */
+	static uint64_t Get(const uint64_t* bits, size_t i)
+	{
+		size_t word = i / 64;
+		size_t shift = i % 64;
+		if(shift == 0)
+			return bits[word];
+		return (bits[word] >> shift) | (bits[word+1] << (64 - shift));
+	}
+
+	/**
+		@brief Expands the low n bits of a word into one bool per bit, with bit 0 first
+
+		@param word	Bits to expand
+		@param out	Output array, must have room for n values
+		@param n	Number of bits to expand, at most 64
+	 */
+	static void Unpack(uint64_t word, bool* out, size_t n = 64)
+	{
+		if(word == 0)
+		{
+			memset(out, 0, n);
+			return;
+		}
+
+		//Broadcast each byte of the word to all eight lanes, keep bit k in lane k, then turn any nonzero lane into 1
+		uint8_t tmp[64];
+		for(size_t i=0; i<8; i++)
+		{
+			uint64_t v = ( (word >> (i*8)) & 0xff) * 0x0101010101010101ULL;
+			v &= 0x8040201008040201ULL;
+			v = ( (v + 0x7f7f7f7f7f7f7f7fULL) >> 7) & 0x0101010101010101ULL;
+			memcpy(tmp + i*8, &v, 8);
+		}
+		memcpy(out, tmp, n);
+	}
+
+protected:
+	static void PackGeneric(const bool* samples, size_t len, uint64_t* bits);
+#ifdef __x86_64__
+	static void PackAVX2(const bool* samples, size_t len, uint64_t* bits);
+#endif
+
+	static void Transpose64(uint64_t* rows);
+};
+
+#endif
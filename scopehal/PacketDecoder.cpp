@@ -29,6 +29,7 @@
 
 #include "scopehal.h"
 #include "PacketDecoder.h"
+#include <mutex>
 
 using namespace std;
 
@@ -57,6 +58,7 @@ Packet::Packet()
 	, m_displayForegroundColorPacked(0)
 	, m_displayBackgroundColorPacked(0)
 	, m_packedColorsValid(false)
+	, m_headersFormatted(false)
 {
 }
 
@@ -64,11 +66,183 @@ Packet::~Packet()
 {
 }
 
+/**
+	@brief Returns a pointer to a single shared copy of a string, valid for the lifetime of the process
+
+	Used for typed header names and values so packets can refer to them without copying. This takes a lock, so decoders
+	should intern the strings they need once (e.g. in function-local statics) rather than once per packet.
+ */
+const string* Packet::Intern(const string& str)
+{
+	static mutex internMutex;
+	static set<string> internTable;
+
+	lock_guard<mutex> lock(internMutex);
+	return &*internTable.insert(str).first;
+}
+
+/**
+	@brief Returns the typed header with the given name, adding a new one if there isn't one yet
+ */
+PacketHeader& Packet::GetOrAddHeader(const string* name)
+{
+	m_headersFormatted = false;
+
+	//Replace any text header of the same name
+	if(!m_headers.empty())
+		m_headers.erase(*name);
+
+	for(auto& h : m_typedHeaders)
+	{
+		if(h.m_name == name)
+			return h;
+	}
+
+	m_typedHeaders.push_back(PacketHeader());
+	auto& h = m_typedHeaders.back();
+	h.m_name = name;
+	return h;
+}
+
+/**
+	@brief Sets a header field to an integer value, replacing any previous value
+
+	@param name		Interned column name
+	@param value	Raw value
+	@param format	How to display the value
+	@param width	Number of digits for FORMAT_HEX
+ */
+void Packet::SetHeader(const string* name, uint64_t value, PacketHeader::Format format, uint8_t width)
+{
+	auto& h = GetOrAddHeader(name);
+	h.m_value = value;
+	h.m_format = format;
+	h.m_width = width;
+}
+
+/**
+	@brief Sets a header field to an interned string, replacing any previous value
+ */
+void Packet::SetHeader(const string* name, const string* text)
+{
+	auto& h = GetOrAddHeader(name);
+	h.m_text = text;
+	h.m_format = PacketHeader::FORMAT_STRING;
+	h.m_width = 0;
+}
+
+/**
+	@brief Removes all header fields, both text and typed
+ */
+void Packet::ClearHeaders()
+{
+	m_headers.clear();
+	m_typedHeaders.clear();
+	m_formattedHeaders.clear();
+	m_headersFormatted = false;
+}
+
+/**
+	@brief Returns the typed header with the given interned name, or nullptr if there isn't one
+ */
+const PacketHeader* Packet::FindHeader(const string* name) const
+{
+	for(auto& h : m_typedHeaders)
+	{
+		if(h.m_name == name)
+			return &h;
+	}
+	return nullptr;
+}
+
+/**
+	@brief Returns the text of a single header field, formatting it if needed
+
+	Returns an empty string if the field isn't present.
+ */
+string Packet::GetHeader(const string& name) const
+{
+	for(auto& h : m_typedHeaders)
+	{
+		if(*h.m_name == name)
+			return h.ToString();
+	}
+
+	auto it = m_headers.find(name);
+	if(it == m_headers.end())
+		return "";
+	return it->second;
+}
+
+/**
+	@brief Returns all header fields as text
+
+	Typed headers are formatted the first time this is called, so packets which are never displayed never pay for it.
+	Safe to call from several threads at once (e.g. the UI and a protocol analyzer search) as long as nothing is
+	modifying the packet.
+ */
+const map<string, string>& Packet::GetHeaders() const
+{
+	if(m_typedHeaders.empty())
+		return m_headers;
+
+	//Formatting happens once per packet, so one lock shared by all packets is plenty
+	if(!m_headersFormatted.load(memory_order_acquire))
+	{
+		static mutex formatMutex;
+		lock_guard<mutex> lock(formatMutex);
+
+		if(!m_headersFormatted.load(memory_order_relaxed))
+		{
+			m_formattedHeaders = m_headers;
+			for(auto& h : m_typedHeaders)
+				m_formattedHeaders[*h.m_name] = h.ToString();
+			m_headersFormatted.store(true, memory_order_release);
+		}
+	}
+	return m_formattedHeaders;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PacketHeader
+
+/**
+	@brief Converts the value to text
+ */
+string PacketHeader::ToString() const
+{
+	char tmp[32];
+	switch(m_format)
+	{
+		case FORMAT_HEX:
+			snprintf(tmp, sizeof(tmp), "%0*" PRIx64, (int)m_width, m_value);
+			return tmp;
+
+		case FORMAT_MAC:
+			snprintf(tmp, sizeof(tmp), "%02x:%02x:%02x:%02x:%02x:%02x",
+				(unsigned int)(m_value >> 40) & 0xff,
+				(unsigned int)(m_value >> 32) & 0xff,
+				(unsigned int)(m_value >> 24) & 0xff,
+				(unsigned int)(m_value >> 16) & 0xff,
+				(unsigned int)(m_value >> 8) & 0xff,
+				(unsigned int)(m_value >> 0) & 0xff);
+			return tmp;
+
+		case FORMAT_STRING:
+			return *m_text;
+
+		case FORMAT_DEC:
+		default:
+			return to_string(m_value);
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 PacketDecoder::PacketDecoder(const std::string& color, Category cat)
 	: Filter(color, cat, Unit(Unit::UNIT_FS))
+	, m_indexValid(false)
 {
 	AddProtocolStream("data");
 }
@@ -86,6 +260,40 @@ void PacketDecoder::ClearPackets()
 	for(auto p : m_packets)
 		delete p;
 	m_packets.clear();
+	InvalidateIndex();
+}
+
+/**
+	@brief Marks the search index as stale, so it's rebuilt on the next query
+
+	Decoders which change m_packets other than through ClearPackets() (e.g. editing packets in place) must call this.
+ */
+void PacketDecoder::InvalidateIndex()
+{
+	lock_guard<mutex> lock(m_indexMutex);
+	m_indexValid = false;
+	m_index.Clear();
+}
+
+/**
+	@brief Finds all packets matching a query
+
+	The index is built on the first query after a decode rather than during it, so decoders that are never searched
+	pay nothing for it. Packets appended since the last build are picked up automatically.
+
+	@param query	Conditions to match
+
+	@return Indexes of matching packets within GetPackets(), in ascending order
+ */
+vector<size_t> PacketDecoder::FindPackets(const PacketQuery& query)
+{
+	lock_guard<mutex> lock(m_indexMutex);
+	if(!m_indexValid || (m_index.size() != m_packets.size()) )
+	{
+		m_index.Build(m_packets);
+		m_indexValid = true;
+	}
+	return m_index.Find(m_packets, query);
 }
 
 bool PacketDecoder::GetShowDataColumn()
@@ -31,6 +31,55 @@
 #define PacketDecoder_h
 
 #include "Filter.h"
+#include "PacketIndex.h"
+#include <atomic>
+#include <mutex>
+
+/**
+	@brief A packet header field stored as a raw value, and only converted to text when displayed
+
+	Names and string values are interned with Packet::Intern(), so each field costs a fixed 24 bytes and no allocations.
+ */
+class PacketHeader
+{
+public:
+
+	///@brief How the value is converted to text
+	enum Format : uint8_t
+	{
+		///@brief Unsigned decimal integer
+		FORMAT_DEC,
+
+		///@brief Hexadecimal integer, zero padded to m_width digits
+		FORMAT_HEX,
+
+		///@brief 48-bit MAC address, first byte on the wire in the MSB
+		FORMAT_MAC,
+
+		///@brief Interned string (typically one of a small set of enumerated values)
+		FORMAT_STRING
+	};
+
+	std::string ToString() const;
+
+	///@brief Interned column name
+	const std::string* m_name;
+
+	union
+	{
+		///@brief Raw value for the integer formats
+		uint64_t m_value;
+
+		///@brief Interned text for FORMAT_STRING
+		const std::string* m_text;
+	};
+
+	///@brief Conversion to text
+	Format m_format;
+
+	///@brief Number of digits for FORMAT_HEX
+	uint8_t m_width;
+};
 
 /**
 	@class
@@ -48,9 +97,31 @@ public:
 	///Duration time of the packet (femtoseconds)
 	int64_t m_len;
 
-	//Arbitrary header properties (human readable)
+	/**
+		@brief Arbitrary header properties (human readable)
+
+		Typed headers set with SetHeader() are stored separately and never appear here, so readers should use
+		GetHeaders() or GetHeader(), which include both. Headers are written by the decoder before the packet is
+		published and must not change once other threads can see it.
+	 */
 	std::map<std::string, std::string> m_headers;
 
+	static const std::string* Intern(const std::string& str);
+
+	void SetHeader(const std::string* name, uint64_t value, PacketHeader::Format format = PacketHeader::FORMAT_DEC,
+		uint8_t width = 0);
+	void SetHeader(const std::string* name, const std::string* text);
+
+	void ClearHeaders();
+
+	const PacketHeader* FindHeader(const std::string* name) const;
+	std::string GetHeader(const std::string& name) const;
+	const std::map<std::string, std::string>& GetHeaders() const;
+
+	///@brief Returns the typed header fields, in the order they were first set
+	const std::vector<PacketHeader>& GetTypedHeaders() const
+	{ return m_typedHeaders; }
+
 	//Packet bytes
 	std::vector<uint8_t> m_data;
 
@@ -66,6 +137,19 @@ public:
 
 	bool m_packedColorsValid;
 
+protected:
+	PacketHeader& GetOrAddHeader(const std::string* name);
+
+	///@brief Header fields stored as raw values
+	std::vector<PacketHeader> m_typedHeaders;
+
+	///@brief Text of every header field, text and typed, built on first use by GetHeaders()
+	mutable std::map<std::string, std::string> m_formattedHeaders;
+
+	///@brief True if m_formattedHeaders is up to date
+	mutable std::atomic<bool> m_headersFormatted;
+
+public:
 	void RefreshColors()
 	{
 		if(m_packedColorsValid)
@@ -124,12 +208,27 @@ public:
 		Typically used after copying the packets somewhere else and assuming ownership of them.
 	 */
 	void DetachPackets()
-	{ m_packets.clear(); }
+	{
+		m_packets.clear();
+		InvalidateIndex();
+	}
+
+	std::vector<size_t> FindPackets(const PacketQuery& query);
 
 protected:
 	void ClearPackets();
+	void InvalidateIndex();
 
 	std::vector<Packet*> m_packets;
+
+	///@brief Search index over m_packets, built on the first query after the packets change
+	PacketIndex m_index;
+
+	///@brief True if m_index is up to date with m_packets
+	bool m_indexValid;
+
+	///@brief Mutex protecting m_index
+	std::mutex m_indexMutex;
 };
 
 #endif
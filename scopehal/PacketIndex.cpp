@@ -0,0 +1,320 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PacketIndex
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "PacketDecoder.h"
+#include <algorithm>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+PacketIndex::PacketIndex()
+	: m_timeSorted(true)
+{
+}
+
+/**
+	@brief Discards the contents of the index
+ */
+void PacketIndex::Clear()
+{
+	m_typed.clear();
+	m_typedNames.clear();
+	m_text.clear();
+	m_offsets.clear();
+	m_timeSorted = true;
+	m_timeOrder.clear();
+	m_sortedOffsets.clear();
+	m_signatures.clear();
+}
+
+/**
+	@brief Indexes a list of packets, replacing any previous contents
+
+	Packets are referred to by their position in the list, so the index must be rebuilt if the list changes.
+ */
+void PacketIndex::Build(const vector<Packet*>& packets)
+{
+	Clear();
+
+	size_t npackets = packets.size();
+	m_offsets.resize(npackets);
+	m_signatures.resize(npackets);
+	for(size_t i=0; i<npackets; i++)
+	{
+		auto p = packets[i];
+		m_offsets[i] = p->m_offset;
+		m_signatures[i] = GetByteSignature(p->m_data.data(), p->m_data.size());
+
+		for(auto& h : p->GetTypedHeaders())
+		{
+			uint64_t key = h.m_value;
+			if(h.m_format == PacketHeader::FORMAT_STRING)
+				key = reinterpret_cast<uintptr_t>(h.m_text);
+			m_typed[h.m_name].push_back(pair<uint64_t, uint32_t>(key, i));
+			m_typedNames[*h.m_name] = h.m_name;
+		}
+
+		//Skip text headers hidden by a typed header of the same name
+		for(auto& it : p->m_headers)
+		{
+			bool typed = false;
+			for(auto& h : p->GetTypedHeaders())
+			{
+				if(*h.m_name == it.first)
+				{
+					typed = true;
+					break;
+				}
+			}
+			if(!typed)
+				m_text[it.first][it.second].push_back(i);
+		}
+	}
+
+	//Postings were added in packet order, so a stable sort on the value keeps each value's packets in order
+	for(auto& it : m_typed)
+	{
+		stable_sort(it.second.begin(), it.second.end(),
+			[](const pair<uint64_t, uint32_t>& a, const pair<uint64_t, uint32_t>& b)
+			{ return a.first < b.first; });
+	}
+
+	//Most decoders emit packets in time order, only build a separate time index if they don't
+	m_timeSorted = is_sorted(m_offsets.begin(), m_offsets.end());
+	if(!m_timeSorted)
+	{
+		m_timeOrder.resize(npackets);
+		for(size_t i=0; i<npackets; i++)
+			m_timeOrder[i] = i;
+		stable_sort(m_timeOrder.begin(), m_timeOrder.end(),
+			[&](uint32_t a, uint32_t b)
+			{ return m_offsets[a] < m_offsets[b]; });
+
+		m_sortedOffsets.resize(npackets);
+		for(size_t i=0; i<npackets; i++)
+			m_sortedOffsets[i] = m_offsets[m_timeOrder[i]];
+	}
+}
+
+/**
+	@brief Returns a mask with bit (b % 64) set for every byte value b in a buffer
+ */
+uint64_t PacketIndex::GetByteSignature(const uint8_t* data, size_t len)
+{
+	uint64_t ret = 0;
+	for(size_t i=0; i<len; i++)
+		ret |= (1ULL << (data[i] & 63));
+	return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Queries
+
+/**
+	@brief Finds all packets matching a query
+
+	Each indexed condition produces a sorted list of matching packets, and the lists are intersected starting from the
+	smallest. Payload patterns aren't indexed directly, they're checked only on the packets which survive the other
+	conditions and whose byte signature contains every byte of the pattern.
+
+	@param packets	The packets this index was built from
+	@param query	Conditions to match
+
+	@return Indexes of matching packets within the list, in ascending order
+ */
+vector<size_t> PacketIndex::Find(const vector<Packet*>& packets, const PacketQuery& query) const
+{
+	//Evaluate each indexed condition separately
+	vector<vector<uint32_t> > lists;
+	for(auto& term : query.m_ranges)
+	{
+		lists.push_back(vector<uint32_t>());
+		FindRange(term, lists.back());
+	}
+	for(auto& term : query.m_text)
+	{
+		lists.push_back(vector<uint32_t>());
+		FindText(packets, term.first, term.second, lists.back());
+	}
+	if(query.m_hasTimeWindow)
+	{
+		lists.push_back(vector<uint32_t>());
+		FindTimeWindow(query.m_timeStart, query.m_timeEnd, lists.back());
+	}
+
+	//Intersect, smallest list first so the working set only shrinks
+	sort(lists.begin(), lists.end(),
+		[](const vector<uint32_t>& a, const vector<uint32_t>& b)
+		{ return a.size() < b.size(); });
+
+	vector<uint32_t> matches;
+	if(lists.empty())
+	{
+		matches.resize(m_offsets.size());
+		for(size_t i=0; i<matches.size(); i++)
+			matches[i] = i;
+	}
+	else
+	{
+		matches = lists[0];
+		vector<uint32_t> tmp;
+		for(size_t i=1; (i < lists.size()) && !matches.empty(); i++)
+		{
+			tmp.clear();
+			set_intersection(
+				matches.begin(), matches.end(),
+				lists[i].begin(), lists[i].end(),
+				back_inserter(tmp));
+			matches.swap(tmp);
+		}
+	}
+
+	//Payload search
+	vector<size_t> ret;
+	ret.reserve(matches.size());
+	if(query.m_payload.empty())
+		ret.assign(matches.begin(), matches.end());
+	else
+	{
+		auto& pattern = query.m_payload;
+		uint64_t required = GetByteSignature(pattern.data(), pattern.size());
+		for(auto i : matches)
+		{
+			if( (m_signatures[i] & required) != required)
+				continue;
+
+			auto& data = packets[i]->m_data;
+			if(search(data.begin(), data.end(), pattern.begin(), pattern.end()) != data.end())
+				ret.push_back(i);
+		}
+	}
+
+	return ret;
+}
+
+/**
+	@brief Finds packets whose typed header is within a range, in ascending order
+ */
+void PacketIndex::FindRange(const PacketQuery::RangeTerm& term, vector<uint32_t>& out) const
+{
+	auto it = m_typed.find(term.m_column);
+	if(it == m_typed.end())
+		return;
+
+	auto& postings = it->second;
+	auto first = lower_bound(postings.begin(), postings.end(), term.m_min,
+		[](const pair<uint64_t, uint32_t>& a, uint64_t value)
+		{ return a.first < value; });
+	auto last = upper_bound(first, postings.end(), term.m_max,
+		[](uint64_t value, const pair<uint64_t, uint32_t>& a)
+		{ return value < a.first; });
+
+	out.reserve(last - first);
+	for(auto p = first; p != last; p++)
+		out.push_back(p->second);
+
+	//A single value is already in packet order, a range of values needs sorting
+	if(term.m_min != term.m_max)
+		sort(out.begin(), out.end());
+}
+
+/**
+	@brief Finds packets with a text header equal to a given string, in ascending order
+ */
+void PacketIndex::FindText(
+	const vector<Packet*>& packets,
+	const string& column,
+	const string& value,
+	vector<uint32_t>& out) const
+{
+	//Typed columns have no text index, compare the formatted value of each packet that has the column
+	auto nt = m_typedNames.find(column);
+	if(nt != m_typedNames.end())
+	{
+		for(auto& p : m_typed.find(nt->second)->second)
+		{
+			auto h = packets[p.second]->FindHeader(nt->second);
+			if(h && (h->ToString() == value))
+				out.push_back(p.second);
+		}
+		sort(out.begin(), out.end());
+	}
+
+	auto it = m_text.find(column);
+	if(it == m_text.end())
+		return;
+
+	auto jt = it->second.find(value);
+	if(jt == it->second.end())
+		return;
+
+	//Some packets may have the column as text and others as a typed header
+	if(out.empty())
+		out = jt->second;
+	else
+	{
+		vector<uint32_t> merged;
+		set_union(out.begin(), out.end(), jt->second.begin(), jt->second.end(), back_inserter(merged));
+		out.swap(merged);
+	}
+}
+
+/**
+	@brief Finds packets starting in [start, end), in ascending order
+ */
+void PacketIndex::FindTimeWindow(int64_t start, int64_t end, vector<uint32_t>& out) const
+{
+	auto& offsets = m_timeSorted ? m_offsets : m_sortedOffsets;
+	size_t first = lower_bound(offsets.begin(), offsets.end(), start) - offsets.begin();
+	size_t last = lower_bound(offsets.begin(), offsets.end(), end) - offsets.begin();
+	if(last <= first)
+		return;
+
+	out.resize(last - first);
+	if(m_timeSorted)
+	{
+		for(size_t i=first; i<last; i++)
+			out[i - first] = i;
+	}
+	else
+	{
+		for(size_t i=first; i<last; i++)
+			out[i - first] = m_timeOrder[i];
+		sort(out.begin(), out.end());
+	}
+}
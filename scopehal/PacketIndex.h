@@ -0,0 +1,198 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PacketIndex and PacketQuery
+	@ingroup core
+ */
+#ifndef PacketIndex_h
+#define PacketIndex_h
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class Packet;
+
+/**
+	@brief A conjunction of conditions on packets, evaluated by PacketIndex
+
+	Conditions are added with the builder methods and all must be true for a packet to match. Typed header conditions
+	take the interned column name (and value, for string columns) as returned by Packet::Intern().
+
+	@ingroup core
+ */
+class PacketQuery
+{
+public:
+	PacketQuery()
+		: m_hasTimeWindow(false)
+		, m_timeStart(0)
+		, m_timeEnd(0)
+	{}
+
+	///@brief Matches packets whose typed header has exactly this integer value
+	PacketQuery& Equals(const std::string* column, uint64_t value)
+	{ return Range(column, value, value); }
+
+	///@brief Matches packets whose typed header is this interned string
+	PacketQuery& Equals(const std::string* column, const std::string* text)
+	{
+		auto key = reinterpret_cast<uintptr_t>(text);
+		return Range(column, key, key);
+	}
+
+	///@brief Matches packets whose typed integer header is in [min, max]
+	PacketQuery& Range(const std::string* column, uint64_t min, uint64_t max)
+	{
+		m_ranges.push_back(RangeTerm{column, min, max});
+		return *this;
+	}
+
+	///@brief Matches packets with a text header equal to a string
+	PacketQuery& EqualsText(const std::string& column, const std::string& value)
+	{
+		m_text.push_back(std::make_pair(column, value));
+		return *this;
+	}
+
+	///@brief Matches packets starting in [start, end), in femtoseconds
+	PacketQuery& TimeWindow(int64_t start, int64_t end)
+	{
+		m_hasTimeWindow = true;
+		m_timeStart = start;
+		m_timeEnd = end;
+		return *this;
+	}
+
+	///@brief Matches packets whose payload contains this byte sequence
+	PacketQuery& Payload(const std::vector<uint8_t>& pattern)
+	{
+		m_payload = pattern;
+		return *this;
+	}
+
+protected:
+	friend class PacketIndex;
+
+	///@brief Condition on a typed header
+	struct RangeTerm
+	{
+		const std::string* m_column;
+		uint64_t m_min;
+		uint64_t m_max;
+	};
+
+	///@brief Conditions on typed headers
+	std::vector<RangeTerm> m_ranges;
+
+	///@brief Conditions on text headers, as (column, value) pairs
+	std::vector<std::pair<std::string, std::string> > m_text;
+
+	///@brief True if the time window is set
+	bool m_hasTimeWindow;
+
+	///@brief Start of the time window
+	int64_t m_timeStart;
+
+	///@brief End of the time window
+	int64_t m_timeEnd;
+
+	///@brief Byte sequence to search payloads for, if not empty
+	std::vector<uint8_t> m_payload;
+};
+
+/**
+	@brief Search index over the packets produced by a PacketDecoder
+
+	Contains:
+	* For each typed header column, (value, packet) postings sorted by value. Equality and range conditions are answered
+	  with a binary search, yielding the matching packets directly.
+	* For each text header column, the list of packets for each distinct value. Text conditions on a typed column are
+	  answered from its postings, formatting only the values of packets which have that column.
+	* Packet start times sorted in time order, to answer time windows with a binary search
+	* A 64-bit signature per packet of which byte values its payload contains, so payload searches only have to look
+	  at packets which contain every byte of the pattern
+
+	@ingroup core
+ */
+class PacketIndex
+{
+public:
+	PacketIndex();
+
+	void Build(const std::vector<Packet*>& packets);
+	void Clear();
+
+	std::vector<size_t> Find(const std::vector<Packet*>& packets, const PacketQuery& query) const;
+
+	///@brief Returns the number of packets indexed
+	size_t size() const
+	{ return m_offsets.size(); }
+
+protected:
+	void FindRange(const PacketQuery::RangeTerm& term, std::vector<uint32_t>& out) const;
+	void FindText(
+		const std::vector<Packet*>& packets,
+		const std::string& column,
+		const std::string& value,
+		std::vector<uint32_t>& out) const;
+	void FindTimeWindow(int64_t start, int64_t end, std::vector<uint32_t>& out) const;
+
+	static uint64_t GetByteSignature(const uint8_t* data, size_t len);
+
+	///@brief Postings for each typed header column, sorted by (value, packet index)
+	std::map<const std::string*, std::vector<std::pair<uint64_t, uint32_t> > > m_typed;
+
+	///@brief Interned name of each typed header column, by name
+	std::map<std::string, const std::string*> m_typedNames;
+
+	///@brief Packet indexes for each value of each text header column, in ascending order
+	std::map<std::string, std::map<std::string, std::vector<uint32_t> > > m_text;
+
+	///@brief Start time of each packet, in packet order
+	std::vector<int64_t> m_offsets;
+
+	///@brief True if packets are already in time order, so m_timeOrder is not needed
+	bool m_timeSorted;
+
+	///@brief Packet indexes sorted by start time (only used if m_timeSorted is false)
+	std::vector<uint32_t> m_timeOrder;
+
+	///@brief Start times in the order of m_timeOrder
+	std::vector<int64_t> m_sortedOffsets;
+
+	///@brief Byte signature of each packet's payload
+	std::vector<uint64_t> m_signatures;
+};
+
+#endif
@@ -0,0 +1,516 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of ParallelTuning
+	@ingroup core
+ */
+
+#include "scopehal.h"
+#include <omp.h>
+
+using namespace std;
+
+///@brief Grain size used before calibration, roughly matching the old fixed 1M sample threshold on a 4-8 core host
+#define DEFAULT_GRAIN_SIZE 131072
+
+///@brief Number of elements processed per reference kernel run during calibration
+#define CALIBRATION_COUNT (1024 * 1024)
+
+///@brief Fraction of the best throughput a thread count must reach to count as still scaling
+#define SCALING_THRESHOLD 0.9
+
+///@brief Multiple of the fork/join overhead each thread should get in work, so overhead stays around 10%
+#define OVERHEAD_FACTOR 10
+
+atomic<size_t> ParallelTuning::m_grainSize[KERNEL_COUNT] =
+{
+	DEFAULT_GRAIN_SIZE, DEFAULT_GRAIN_SIZE, DEFAULT_GRAIN_SIZE, DEFAULT_GRAIN_SIZE, DEFAULT_GRAIN_SIZE
+};
+atomic<size_t> ParallelTuning::m_maxThreads[KERNEL_COUNT] = {0, 0, 0, 0, 0};
+atomic<size_t> ParallelTuning::m_overrideGrainSize[KERNEL_COUNT] = {0, 0, 0, 0, 0};
+atomic<size_t> ParallelTuning::m_overrideMaxThreads[KERNEL_COUNT] = {0, 0, 0, 0, 0};
+atomic<bool> ParallelTuning::m_calibrated(false);
+mutex ParallelTuning::m_calibrationMutex;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Queries
+
+/**
+	@brief Decides how to split a loop over count elements
+
+	@param kernel	Class of work the loop does
+	@param count	Number of elements (loop iterations)
+	@param align	Block sizes are rounded down to a multiple of this, e.g. for clean vectorization
+	@param weight	Relative cost of one element compared to the reference kernel (e.g. channels per point when
+					deinterleaving)
+ */
+ParallelTuning::Split ParallelTuning::GetSplit(Kernel kernel, size_t count, size_t align, size_t weight)
+{
+	Split ret;
+	ret.m_threads = 1;
+	ret.m_blockSize = count;
+	ret.m_numBlocks = 1;
+
+	if(!m_calibrated)
+		EnsureCalibrated();
+
+	//Every block needs at least one aligned chunk of elements, however heavy each element is
+	align = max(align, (size_t)1);
+	size_t threads = min(GetMaxThreads(kernel), (count * weight) / GetGrainSize(kernel));
+	threads = min(threads, count / align);
+	if(threads <= 1)
+		return ret;
+
+	size_t blocksize = count / threads;
+	blocksize -= blocksize % align;
+
+	ret.m_threads = threads;
+	ret.m_blockSize = blocksize;
+	ret.m_numBlocks = threads;
+	return ret;
+}
+
+/**
+	@brief Returns the minimum number of elements per thread for a kernel
+ */
+size_t ParallelTuning::GetGrainSize(Kernel kernel)
+{
+	size_t grain = m_overrideGrainSize[kernel];
+	if(grain == 0)
+		grain = m_grainSize[kernel];
+	return max(grain, (size_t)1);
+}
+
+/**
+	@brief Returns the maximum number of threads worth using for a kernel
+ */
+size_t ParallelTuning::GetMaxThreads(Kernel kernel)
+{
+	size_t nthreads = omp_get_max_threads();
+
+	size_t limit;
+	if(m_overrideGrainSize[kernel] != 0)
+		limit = m_overrideMaxThreads[kernel];
+	else
+		limit = m_maxThreads[kernel];
+
+	if(limit == 0)
+		return nthreads;
+	return min(limit, nthreads);
+}
+
+/**
+	@brief Returns a human readable name for a kernel, also used as its key in saved profiles
+ */
+const char* ParallelTuning::GetKernelName(Kernel kernel)
+{
+	switch(kernel)
+	{
+		case KERNEL_SAMPLE_CONVERSION:
+			return "sample_conversion";
+
+		case KERNEL_THRESHOLD:
+			return "threshold";
+
+		case KERNEL_COPY:
+			return "copy";
+
+		case KERNEL_DIGITAL_UNPACK:
+			return "digital_unpack";
+
+		case KERNEL_REDUCTION:
+			return "reduction";
+
+		default:
+			return "invalid";
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Overrides
+
+/**
+	@brief Pins the split for a kernel, ignoring the calibrated profile
+
+	Intended for benchmark harnesses sweeping thread counts and grain sizes.
+
+	@param kernel		Kernel to override
+	@param grainSize	Minimum number of elements per thread
+	@param maxThreads	Maximum number of threads, or zero for no limit
+ */
+void ParallelTuning::SetOverride(Kernel kernel, size_t grainSize, size_t maxThreads)
+{
+	m_overrideMaxThreads[kernel] = maxThreads;
+	m_overrideGrainSize[kernel] = max(grainSize, (size_t)1);
+}
+
+/**
+	@brief Goes back to the calibrated profile for a kernel
+ */
+void ParallelTuning::ClearOverride(Kernel kernel)
+{
+	m_overrideGrainSize[kernel] = 0;
+	m_overrideMaxThreads[kernel] = 0;
+}
+
+/**
+	@brief Goes back to the calibrated profile for all kernels
+ */
+void ParallelTuning::ClearOverrides()
+{
+	for(size_t i=0; i<KERNEL_COUNT; i++)
+		ClearOverride(static_cast<Kernel>(i));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Calibration
+
+/**
+	@brief Measures throughput of each kernel class per thread count and derives the split profile
+
+	For each kernel, the thread limit is the smallest thread count reaching SCALING_THRESHOLD of the best throughput
+	(memory bound kernels stop scaling well before running out of cores). The grain size is the amount of work which
+	takes OVERHEAD_FACTOR times as long as starting and joining a parallel region.
+
+	Takes a few tens of milliseconds. Runs automatically the first time a split is requested, unless a profile was
+	loaded first. The reference data is freed once calibration completes.
+ */
+void ParallelTuning::Calibrate()
+{
+	lock_guard<mutex> lock(m_calibrationMutex);
+	RunCalibration();
+}
+
+/**
+	@brief Calibrates if nobody has calibrated or loaded a profile yet
+
+	Calibration needs the whole thread pool to itself, so inside a parallel region we just keep using the current
+	profile and leave calibration for a later call.
+ */
+void ParallelTuning::EnsureCalibrated()
+{
+	if(omp_in_parallel())
+		return;
+
+	lock_guard<mutex> lock(m_calibrationMutex);
+	if(!m_calibrated)
+		RunCalibration();
+}
+
+/**
+	@brief Does the actual work of Calibrate(). The caller must hold m_calibrationMutex.
+ */
+void ParallelTuning::RunCalibration()
+{
+	LogDebug("Calibrating parallel split heuristics...\n");
+	LogIndenter li;
+
+	CalibrationData data(CALIBRATION_COUNT);
+
+	size_t nthreads = omp_get_max_threads();
+	double overhead = MeasureForkJoinOverhead(nthreads);
+	LogDebug("Fork/join overhead: %.2f us\n", overhead * 1e6);
+
+	for(size_t i=0; i<KERNEL_COUNT; i++)
+	{
+		auto kernel = static_cast<Kernel>(i);
+
+		//Measure throughput at power of two thread counts, plus the full count
+		vector<size_t> counts;
+		for(size_t t=1; t<nthreads; t *= 2)
+			counts.push_back(t);
+		counts.push_back(nthreads);
+
+		vector<double> rates;
+		double best = 0;
+		for(auto t : counts)
+		{
+			//Best of three to reject noise from other processes
+			double dt = RunReferenceKernel(kernel, t, data);
+			dt = min(dt, RunReferenceKernel(kernel, t, data));
+			dt = min(dt, RunReferenceKernel(kernel, t, data));
+
+			double rate = CALIBRATION_COUNT / max(dt, 1e-9);
+			rates.push_back(rate);
+			best = max(best, rate);
+		}
+
+		size_t limit = nthreads;
+		for(size_t j=0; j<counts.size(); j++)
+		{
+			if(rates[j] >= best * SCALING_THRESHOLD)
+			{
+				limit = counts[j];
+				break;
+			}
+		}
+
+		double secPerElement = 1.0 / rates[0];
+		size_t grain = overhead * OVERHEAD_FACTOR / secPerElement;
+		grain = min(max(grain, (size_t)1024), (size_t)16 * 1024 * 1024);
+
+		m_grainSize[kernel] = grain;
+		m_maxThreads[kernel] = (limit == nthreads) ? 0 : limit;
+
+		LogDebug("%-20s %8.1f Melem/s serial, %8.1f Melem/s best, grain %zu, max threads %zu\n",
+			GetKernelName(kernel),
+			rates[0] * 1e-6,
+			best * 1e-6,
+			grain,
+			limit);
+	}
+
+	m_calibrated = true;
+}
+
+/**
+	@brief Measures the time to start and join an empty parallel region
+ */
+double ParallelTuning::MeasureForkJoinOverhead(size_t threads)
+{
+	const int iterations = 100;
+
+	//Give the regions a side effect so they can't be elided
+	static volatile int sink;
+
+	//Warm up the thread pool
+	#pragma omp parallel num_threads(threads)
+	{
+		sink = omp_get_thread_num();
+	}
+
+	double best = 1e9;
+	for(int j=0; j<5; j++)
+	{
+		double start = GetTime();
+		for(int i=0; i<iterations; i++)
+		{
+			#pragma omp parallel num_threads(threads)
+			{
+				sink = omp_get_thread_num();
+			}
+		}
+		best = min(best, (GetTime() - start) / iterations);
+	}
+	return best;
+}
+
+/**
+	@brief Generates a noisy square wave so branches in the reference kernels behave like real data
+ */
+ParallelTuning::CalibrationData::CalibrationData(size_t count)
+	: m_raw(count)
+	, m_samples(count)
+	, m_wide(count)
+	, m_flags(count)
+	, m_durations(count)
+{
+	uint32_t state = 1;
+	for(size_t i=0; i<count; i++)
+	{
+		state = state * 1664525 + 1013904223;
+		m_raw[i] = ((i / 64) & 1) ? 100 : -100;
+		m_raw[i] += (state >> 28);
+		m_samples[i] = m_raw[i];
+		m_wide[i] = m_raw[i];
+		m_durations[i] = 1 + (state >> 30);
+	}
+}
+
+/**
+	@brief Runs a representative loop for one kernel class
+
+	@return Elapsed time, in seconds
+ */
+double ParallelTuning::RunReferenceKernel(Kernel kernel, size_t threads, CalibrationData& data)
+{
+	size_t count = data.m_raw.size();
+	size_t blocksize = count / threads;
+	double start = GetTime();
+
+	switch(kernel)
+	{
+		case KERNEL_SAMPLE_CONVERSION:
+			{
+				float* pout = data.m_samples.data();
+				const int8_t* pin = data.m_raw.data();
+				#pragma omp parallel for num_threads(threads) schedule(static)
+				for(size_t i=0; i<count; i++)
+					pout[i] = pin[i] * 0.01f - 0.5f;
+			}
+			break;
+
+		case KERNEL_THRESHOLD:
+			{
+				uint8_t* pout = data.m_flags.data();
+				const float* pin = data.m_samples.data();
+				#pragma omp parallel for num_threads(threads) schedule(static)
+				for(size_t i=0; i<count; i++)
+					pout[i] = pin[i] > 0;
+			}
+			break;
+
+		case KERNEL_COPY:
+			{
+				float* pout = data.m_samples.data();
+				const double* pin = data.m_wide.data();
+				#pragma omp parallel for num_threads(threads) schedule(static)
+				for(size_t i=0; i<count; i++)
+					pout[i] = pin[i];
+			}
+			break;
+
+		//Each thread deduplicates its own block into run lengths
+		case KERNEL_DIGITAL_UNPACK:
+			{
+				int64_t* pout = data.m_durations.data();
+				const int8_t* pin = data.m_raw.data();
+				#pragma omp parallel for num_threads(threads)
+				for(size_t t=0; t<threads; t++)
+				{
+					size_t base = t * blocksize;
+					size_t end = (t == threads-1) ? count : base + blocksize;
+					bool last = pin[base] & 1;
+					size_t k = base;
+					pout[k] = 1;
+					for(size_t i=base+1; i<end; i++)
+					{
+						bool sample = pin[i] & 1;
+						if(sample == last)
+							pout[k] ++;
+						else
+						{
+							k++;
+							pout[k] = 1;
+							last = sample;
+						}
+					}
+				}
+			}
+			break;
+
+		case KERNEL_REDUCTION:
+			{
+				const float* pin = data.m_samples.data();
+				const int64_t* pdur = data.m_durations.data();
+				int64_t total = 0;
+				#pragma omp parallel for num_threads(threads) reduction(+:total)
+				for(size_t i=0; i<count; i++)
+				{
+					if(pin[i] > 0)
+						total += pdur[i];
+				}
+
+				//Keep the result live so the loop isn't optimized out
+				data.m_flags[0] = total & 1;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	return GetTime() - start;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Persistence
+
+/**
+	@brief Saves the calibrated profile (not overrides) to a YAML file
+
+	@return True on success
+ */
+bool ParallelTuning::SaveProfile(const string& path)
+{
+	YAML::Node node;
+	node["threads"] = omp_get_max_threads();
+	for(size_t i=0; i<KERNEL_COUNT; i++)
+	{
+		auto kernel = static_cast<Kernel>(i);
+		YAML::Node knode;
+		knode["grain"] = m_grainSize[i].load();
+		knode["maxthreads"] = m_maxThreads[i].load();
+		node["kernels"][GetKernelName(kernel)] = knode;
+	}
+
+	YAML::Emitter out;
+	out << node;
+
+	FILE* fp = fopen(path.c_str(), "w");
+	if(!fp)
+	{
+		LogWarning("ParallelTuning: couldn't open %s for writing\n", path.c_str());
+		return false;
+	}
+	bool ok = (fwrite(out.c_str(), 1, out.size(), fp) == out.size());
+	fclose(fp);
+	return ok;
+}
+
+/**
+	@brief Loads a profile previously saved by SaveProfile()
+
+	Profiles recorded with a different number of OpenMP threads are ignored, since they no longer describe this host.
+
+	@return True if the profile was loaded
+ */
+bool ParallelTuning::LoadProfile(const string& path)
+{
+	try
+	{
+		auto node = YAML::LoadFile(path);
+		if(node["threads"].as<int>() != omp_get_max_threads())
+		{
+			LogDebug("ParallelTuning: profile %s is for a different thread count, ignoring\n", path.c_str());
+			return false;
+		}
+
+		auto kernels = node["kernels"];
+		for(size_t i=0; i<KERNEL_COUNT; i++)
+		{
+			auto knode = kernels[GetKernelName(static_cast<Kernel>(i))];
+			if(!knode)
+				continue;
+			m_grainSize[i] = max(knode["grain"].as<size_t>(), (size_t)1);
+			m_maxThreads[i] = knode["maxthreads"].as<size_t>();
+		}
+		m_calibrated = true;
+	}
+	catch(const YAML::Exception& ex)
+	{
+		LogDebug("ParallelTuning: couldn't load profile %s (%s)\n", path.c_str(), ex.what());
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,158 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of ParallelTuning
+	@ingroup core
+ */
+#ifndef ParallelTuning_h
+#define ParallelTuning_h
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/**
+	@brief Central source of OpenMP split decisions for CPU-side sample processing loops
+
+	Whether a loop is worth running in parallel, and on how many threads, depends on how much work it does per element
+	and how much the host's memory bandwidth limits scaling. Rather than have every loop carry its own hard coded
+	threshold, loops name the class of work they do and ask for a split.
+
+	The profile for each class is measured by Calibrate(), which runs the first time a split is requested (outside of
+	a parallel region) so processes which never touch sample data don't pay for it. Profiles can be saved and loaded so
+	apps can skip calibration on later runs. Benchmark harnesses can pin the split for a class with SetOverride().
+
+	@ingroup core
+ */
+class ParallelTuning
+{
+public:
+
+	///@brief Classes of CPU loops with distinct per-element cost and scaling
+	enum Kernel
+	{
+		///@brief Conversion of raw ADC samples to fp32
+		KERNEL_SAMPLE_CONVERSION,
+
+		///@brief Comparing analog samples against a threshold
+		KERNEL_THRESHOLD,
+
+		///@brief Element-wise copy with type conversion
+		KERNEL_COPY,
+
+		///@brief Splitting packed digital samples into deduplicated per-channel waveforms
+		KERNEL_DIGITAL_UNPACK,
+
+		///@brief Summing over samples
+		KERNEL_REDUCTION,
+
+		KERNEL_COUNT
+	};
+
+	///@brief How to divide one loop among threads
+	struct Split
+	{
+		///@brief Number of threads to use. 1 means run serially.
+		size_t m_threads;
+
+		///@brief Number of elements per block. The last block also gets whatever didn't divide evenly.
+		size_t m_blockSize;
+
+		///@brief Number of blocks
+		size_t m_numBlocks;
+	};
+
+	static Split GetSplit(Kernel kernel, size_t count, size_t align = 1, size_t weight = 1);
+
+	/**
+		@brief Returns the number of threads a simple "parallel for" over count elements should use
+
+		Use as "#pragma omp parallel for if(nthreads > 1) num_threads(nthreads)".
+	 */
+	static int GetThreadCount(Kernel kernel, size_t count, size_t weight = 1)
+	{ return GetSplit(kernel, count, 1, weight).m_threads; }
+
+	static size_t GetGrainSize(Kernel kernel);
+	static size_t GetMaxThreads(Kernel kernel);
+
+	static void Calibrate();
+	static bool LoadProfile(const std::string& path);
+	static bool SaveProfile(const std::string& path);
+
+	static void SetOverride(Kernel kernel, size_t grainSize, size_t maxThreads);
+	static void ClearOverride(Kernel kernel);
+	static void ClearOverrides();
+
+	static const char* GetKernelName(Kernel kernel);
+
+protected:
+	///@brief Reference data for the calibration kernels, only kept around while calibrating
+	struct CalibrationData
+	{
+		CalibrationData(size_t count);
+
+		std::vector<int8_t> m_raw;
+		std::vector<float> m_samples;
+		std::vector<double> m_wide;
+		std::vector<uint8_t> m_flags;
+		std::vector<int64_t> m_durations;
+	};
+
+	static void EnsureCalibrated();
+	static void RunCalibration();
+	static double RunReferenceKernel(Kernel kernel, size_t threads, CalibrationData& data);
+	static double MeasureForkJoinOverhead(size_t threads);
+
+	/**
+		@brief Minimum number of elements per thread
+
+		Loops smaller than two grains run serially.
+	 */
+	static std::atomic<size_t> m_grainSize[KERNEL_COUNT];
+
+	///@brief Thread count beyond which the kernel stops scaling (zero for no limit)
+	static std::atomic<size_t> m_maxThreads[KERNEL_COUNT];
+
+	///@brief Grain size set by SetOverride(), or zero if not overridden
+	static std::atomic<size_t> m_overrideGrainSize[KERNEL_COUNT];
+
+	///@brief Thread limit set by SetOverride(), or zero for no limit
+	static std::atomic<size_t> m_overrideMaxThreads[KERNEL_COUNT];
+
+	///@brief True once the profile has been calibrated or loaded
+	static std::atomic<bool> m_calibrated;
+
+	///@brief Serializes calibration
+	static std::mutex m_calibrationMutex;
+};
+
+#endif
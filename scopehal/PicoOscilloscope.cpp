@@ -951,7 +951,8 @@ bool PicoOscilloscope::DoAcquireData(bool keep)
 			}
 
 			//Now that we have the waveform data, unpack it into individual channels
-			#pragma omp parallel for
+			int nthreads = ParallelTuning::GetThreadCount(ParallelTuning::KERNEL_DIGITAL_UNPACK, 8, memdepth);
+			#pragma omp parallel for if(nthreads > 1) num_threads(nthreads)
 			for(size_t j=0; j<8; j++)
 			{
 				//Bitmask for this digital channel
@@ -38,6 +38,7 @@
 
 using namespace std;
 extern bool g_hasDebugUtils;
+extern bool g_hasTimelineSemaphore;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // QueueHandle
@@ -51,12 +52,53 @@ ScratchBufferBase::~ScratchBufferBase()
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// QueueTimeline
+
+QueueTimeline::QueueTimeline(shared_ptr<vk::raii::Device> device, const string& name)
+	: m_device(device)
+	, m_semaphore(*device, vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo>(
+		vk::SemaphoreCreateInfo(),
+		vk::SemaphoreTypeCreateInfo(vk::SemaphoreType::eTimeline, 0)).get<vk::SemaphoreCreateInfo>())
+{
+	if(g_hasDebugUtils)
+	{
+		string semname = name + ".timeline";
+		m_device->setDebugUtilsObjectNameEXT(
+			vk::DebugUtilsObjectNameInfoEXT(
+				vk::ObjectType::eSemaphore,
+				reinterpret_cast<uint64_t>(static_cast<VkSemaphore>(*m_semaphore)),
+				semname.c_str()));
+	}
+}
+
+/**
+	@brief Checks whether the timeline has reached a given value, without blocking
+ */
+bool QueueTimeline::IsComplete(uint64_t value) const
+{
+	return m_semaphore.getCounterValue() >= value;
+}
+
+/**
+	@brief Blocks until the timeline has reached a given value
+ */
+void QueueTimeline::Wait(uint64_t value) const
+{
+	vk::Semaphore sem = *m_semaphore;
+	vk::SemaphoreWaitInfo info({}, sem, value);
+	while(vk::Result::eTimeout == m_device->waitSemaphores(info, 1000 * 1000))
+	{}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// QueueHandle
 
 QueueHandle::QueueHandle(std::shared_ptr<QueueWrapper>& queue, const string& name)
 	: m_queue(queue)
 	, m_fence(make_unique<vk::raii::Fence>(*queue->GetDevice(), vk::FenceCreateInfo()))
 	, m_fenceBusy(false)
 	, m_fenceName(name)
+	, m_timelineValue(0)
 {
 	//Add us as a named user of the physical queue
 	m_queue->AddName(name);
@@ -70,6 +112,9 @@ QueueHandle::QueueHandle(std::shared_ptr<QueueWrapper>& queue, const string& nam
 				reinterpret_cast<uint64_t>(static_cast<VkFence>(**m_fence)),
 				name.c_str()));
 	}
+
+	if(g_hasTimelineSemaphore)
+		m_timeline = make_shared<QueueTimeline>(m_queue->GetDevice(), name);
 }
 
 QueueHandle::~QueueHandle()
@@ -78,6 +123,9 @@ QueueHandle::~QueueHandle()
 
 	{
 		const lock_guard<recursive_mutex> lock(m_queue->GetMutex());
+		if(m_timeline)
+			m_timeline->Wait(m_timelineValue);
+		m_asyncScratchBuffers.clear();
 		m_fence = nullptr;
 	}
 	m_queue = nullptr;
@@ -90,9 +138,7 @@ void QueueHandle::Submit(vk::raii::CommandBuffer const& cmdBuf)
 	_waitFence();
 
 	m_fenceBusy = true;
-
-	vk::SubmitInfo info({}, {}, *cmdBuf);
-	m_queue->GetQueue()->submit(info, **m_fence);
+	_submit(cmdBuf, false);
 }
 
 void QueueHandle::SubmitAndBlock(vk::raii::CommandBuffer const& cmdBuf)
@@ -103,9 +149,7 @@ void QueueHandle::SubmitAndBlock(vk::raii::CommandBuffer const& cmdBuf)
 		_waitFence();
 
 		m_fenceBusy = true;
-
-		vk::SubmitInfo info({}, {}, *cmdBuf);
-		m_queue->GetQueue()->submit(info, **m_fence);
+		_submit(cmdBuf, false);
 	}
 
 	//Then wait while only holding the fence mutex
@@ -113,6 +157,82 @@ void QueueHandle::SubmitAndBlock(vk::raii::CommandBuffer const& cmdBuf)
 	_waitFence();
 }
 
+/**
+	@brief Submit the given command buffer on the queue without waiting for it to complete
+
+	Unlike Submit(), any number of asynchronous submissions may be in flight at once and the fence is not used.
+	The command buffer must not be reset or re-recorded until the returned point has completed.
+
+	Falls back to SubmitAndBlock() if timeline semaphores are not available.
+
+	@param cmdBuf	The command buffer to submit
+
+	@return Completion token for the submission
+ */
+QueueTimelinePoint QueueHandle::SubmitAsync(vk::raii::CommandBuffer const& cmdBuf)
+{
+	if(!m_timeline)
+	{
+		SubmitAndBlock(cmdBuf);
+		return QueueTimelinePoint();
+	}
+
+	const scoped_lock lock(m_queue->GetMutex(), m_fenceMutex);
+
+	//Scratch buffers used so far may be referenced by this submission, so hold them until it completes
+	_retireAsyncScratchBuffers(false);
+	_submit(cmdBuf, true);
+	if(!m_usedScratchBuffers.empty())
+	{
+		m_asyncScratchBuffers.emplace_back(m_timelineValue, std::move(m_usedScratchBuffers));
+		m_usedScratchBuffers.clear();
+	}
+
+	return QueueTimelinePoint(m_timeline, m_timelineValue);
+}
+
+/**
+	@brief Makes the next submission on this queue wait (on the device side) for asynchronous work to complete
+
+	Waits are accumulated until the next call to Submit(), SubmitAndBlock(), or SubmitAsync(), then cleared.
+
+	@param point	Completion token of the work to wait for. Invalid points are ignored.
+ */
+void QueueHandle::AddWait(const QueueTimelinePoint& point)
+{
+	if(!point.IsValid())
+		return;
+
+	//Only keep the latest value of each timeline
+	for(auto& w : m_pendingWaits)
+	{
+		if(w.m_timeline == point.m_timeline)
+		{
+			w.m_value = max(w.m_value, point.m_value);
+			return;
+		}
+	}
+	m_pendingWaits.push_back(point);
+}
+
+/**
+	@brief Wait for all previous submits, blocking or asynchronous, to complete
+ */
+void QueueHandle::WaitIdle()
+{
+	{
+		const lock_guard<recursive_mutex> lock(m_queue->GetMutex());
+		_waitFence();
+	}
+
+	if(m_timeline)
+	{
+		const lock_guard<recursive_mutex> lock(m_fenceMutex);
+		m_timeline->Wait(m_timelineValue);
+		_retireAsyncScratchBuffers(true);
+	}
+}
+
 /**
 	@brief Wait for previous submits to complete, but only up to a timeout
 
@@ -123,18 +243,26 @@ bool QueueHandle::WaitIdleWithTimeout(uint64_t nanoseconds)
 {
 	const lock_guard<recursive_mutex> lock(m_fenceMutex);
 
-	//Not busy? Return immediately
-	if(!m_fenceBusy)
-		return true;
+	if(m_fenceBusy)
+	{
+		//Wait exactly once for the submit, time out if not finished
+		if(vk::Result::eTimeout == m_queue->GetDevice()->waitForFences({**m_fence}, VK_TRUE, nanoseconds))
+			return false;
 
-	//Wait exactly once for the submit, time out if not finished
-	if(vk::Result::eTimeout == m_queue->GetDevice()->waitForFences({**m_fence}, VK_TRUE, nanoseconds))
-		return false;
+		//If we get here, the most recent wait was the one that finished
+		m_fenceBusy = false;
+		m_queue->GetDevice()->resetFences(**m_fence);
+		m_usedScratchBuffers.clear();
+	}
+
+	//Asynchronous submits don't use the fence, check the timeline too
+	if(m_timeline)
+	{
+		if(!m_timeline->IsComplete(m_timelineValue))
+			return false;
+		_retireAsyncScratchBuffers(true);
+	}
 
-	//If we get here, the most recent wait was the one that finished
-	m_fenceBusy = false;
-	m_queue->GetDevice()->resetFences(**m_fence);
-	m_usedScratchBuffers.clear();
 	return true;
 }
 
@@ -152,3 +280,63 @@ void QueueHandle::_waitFence()
 	m_queue->GetDevice()->resetFences(**m_fence);
 	m_usedScratchBuffers.clear();
 }
+
+/**
+	@brief Submits a command buffer along with any pending device side waits
+
+	Must obtain both locks before calling!
+
+	@param cmdBuf	The command buffer to submit
+	@param async	If true, signal the next timeline value rather than the fence
+ */
+void QueueHandle::_submit(vk::raii::CommandBuffer const& cmdBuf, bool async)
+{
+	vector<vk::Semaphore> waitSemaphores;
+	vector<uint64_t> waitValues;
+	vector<vk::PipelineStageFlags> waitStages;
+	for(auto& w : m_pendingWaits)
+	{
+		waitSemaphores.push_back(w.m_timeline->GetSemaphore());
+		waitValues.push_back(w.m_value);
+		waitStages.push_back(vk::PipelineStageFlagBits::eAllCommands);
+	}
+	m_pendingWaits.clear();
+
+	vector<vk::Semaphore> signalSemaphores;
+	vector<uint64_t> signalValues;
+	if(async)
+	{
+		m_timelineValue ++;
+		signalSemaphores.push_back(m_timeline->GetSemaphore());
+		signalValues.push_back(m_timelineValue);
+	}
+
+	vk::SubmitInfo info(waitSemaphores, waitStages, *cmdBuf, signalSemaphores);
+	vk::TimelineSemaphoreSubmitInfo timelineInfo(waitValues, signalValues);
+	if(!waitSemaphores.empty() || !signalSemaphores.empty())
+		info.pNext = &timelineInfo;
+
+	if(async)
+		m_queue->GetQueue()->submit(info);
+	else
+		m_queue->GetQueue()->submit(info, **m_fence);
+}
+
+/**
+	@brief Frees scratch buffers whose asynchronous submissions have completed
+
+	Must obtain the fence lock before calling!
+
+	@param all	If true, the caller has already waited for every submission so everything can be freed
+ */
+void QueueHandle::_retireAsyncScratchBuffers(bool all)
+{
+	if(all)
+	{
+		m_asyncScratchBuffers.clear();
+		return;
+	}
+
+	while(!m_asyncScratchBuffers.empty() && m_timeline->IsComplete(m_asyncScratchBuffers.front().first))
+		m_asyncScratchBuffers.pop_front();
+}
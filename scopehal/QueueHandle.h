@@ -36,6 +36,7 @@
 #ifndef QueueHandle_h
 #define QueueHandle_h
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -53,6 +54,75 @@ public:
 	virtual ~ScratchBufferBase();
 };
 
+/**
+	@brief A timeline semaphore signaled by asynchronous submissions to one QueueHandle
+
+	Shared by every QueueTimelinePoint referring to it, so points stay valid after the QueueHandle is destroyed.
+ */
+class QueueTimeline
+{
+public:
+	QueueTimeline(std::shared_ptr<vk::raii::Device> device, const std::string& name);
+
+	///@brief Returns the underlying semaphore
+	vk::Semaphore GetSemaphore() const
+	{ return *m_semaphore; }
+
+	bool IsComplete(uint64_t value) const;
+	void Wait(uint64_t value) const;
+
+public:
+	//non-copyable
+	QueueTimeline(QueueTimeline const&) = delete;
+	QueueTimeline& operator=(QueueTimeline const&) = delete;
+
+protected:
+	///@brief The device the semaphore belongs to
+	std::shared_ptr<vk::raii::Device> m_device;
+
+	///@brief The semaphore itself
+	vk::raii::Semaphore m_semaphore;
+};
+
+/**
+	@brief Completion token for one asynchronous submission
+
+	A default constructed point does not refer to any GPU work, and is always complete.
+ */
+class QueueTimelinePoint
+{
+public:
+	QueueTimelinePoint()
+		: m_value(0)
+	{}
+
+	QueueTimelinePoint(std::shared_ptr<QueueTimeline> timeline, uint64_t value)
+		: m_timeline(timeline)
+		, m_value(value)
+	{}
+
+	///@brief Returns true if this point refers to a submission (which may or may not have completed yet)
+	bool IsValid() const
+	{ return m_timeline != nullptr; }
+
+	///@brief Returns true if the submission has finished executing
+	bool IsComplete() const
+	{ return !m_timeline || m_timeline->IsComplete(m_value); }
+
+	///@brief Blocks until the submission has finished executing
+	void Wait() const
+	{
+		if(m_timeline)
+			m_timeline->Wait(m_value);
+	}
+
+	///@brief The timeline the submission signals
+	std::shared_ptr<QueueTimeline> m_timeline;
+
+	///@brief Value the timeline reaches once the submission has finished executing
+	uint64_t m_value;
+};
+
 /**
 	@brief Wrapper around a Vulkan Queue object
 
@@ -74,6 +144,22 @@ public:
 	/// Submit the given command buffer on the queue and wait until completion
 	void SubmitAndBlock(vk::raii::CommandBuffer const& cmdBuf);
 
+	QueueTimelinePoint SubmitAsync(vk::raii::CommandBuffer const& cmdBuf);
+
+	void AddWait(const QueueTimelinePoint& point);
+
+	/**
+		@brief Returns the completion token of the most recent SubmitAsync() call
+
+		Not valid if SubmitAsync() has never been called, or timeline semaphores are unavailable.
+	 */
+	QueueTimelinePoint GetLastSubmission()
+	{
+		if(!m_timeline)
+			return QueueTimelinePoint();
+		return QueueTimelinePoint(m_timeline, m_timelineValue);
+	}
+
 	const std::string GetName() const
 	{ return m_queue->GetName(); }
 
@@ -87,14 +173,7 @@ public:
 	template<class T>
 	void MarkScratchBufferUsed(T& buf);
 
-	/**
-		@brief Wait for all previous submits to complete
-	 */
-	void WaitIdle()
-	{
-		const std::lock_guard<std::recursive_mutex> lock(m_queue->GetMutex());
-		_waitFence();
-	}
+	void WaitIdle();
 
 	bool WaitIdleWithTimeout(uint64_t nanoseconds);
 
@@ -111,6 +190,9 @@ protected:
 	/// Must obtain the lock before calling!
 	void _waitFence();
 
+	void _submit(vk::raii::CommandBuffer const& cmdBuf, bool async);
+	void _retireAsyncScratchBuffers(bool all);
+
 protected:
 	friend QueueLock;
 	std::shared_ptr<QueueWrapper> m_queue;
@@ -124,6 +206,18 @@ protected:
 
 	///@brief Scratch buffers used by jobs in the queue
 	std::set<std::unique_ptr<ScratchBufferBase> > m_usedScratchBuffers;
+
+	///@brief Timeline signaled by SubmitAsync() (null if timeline semaphores are unavailable)
+	std::shared_ptr<QueueTimeline> m_timeline;
+
+	///@brief Timeline value signaled by the most recent SubmitAsync() call
+	uint64_t m_timelineValue;
+
+	///@brief Asynchronous work the next submission has to wait for on the device side
+	std::vector<QueueTimelinePoint> m_pendingWaits;
+
+	///@brief Scratch buffers used by asynchronous submissions, with the timeline value that releases them
+	std::deque<std::pair<uint64_t, std::set<std::unique_ptr<ScratchBufferBase> > > > m_asyncScratchBuffers;
 };
 
 
@@ -145,6 +145,7 @@ bool RSRTB2kOscilloscope::sendWithAck(const char* fmt, ...)
 void RSRTB2kOscilloscope::flush()
 {
 	//LogTrace("\n");
+	m_transport->WaitForAsyncReplies();
 	m_transport->ReadReply();
 }
 
@@ -153,7 +154,11 @@ void RSRTB2kOscilloscope::protocolError(bool flush, const char* fmt, va_list ap)
     char opString[128];
     vsnprintf(opString, sizeof(opString), fmt, ap);
     LogError("RTB2k: Protocol error%s: %s.\n", flush ? ", flushing read stream" : "", opString);
-    if(flush) m_transport->ReadReply();
+    if(flush)
+    {
+		m_transport->WaitForAsyncReplies();
+		m_transport->ReadReply();
+    }
 }
 
 void RSRTB2kOscilloscope::protocolError(const char* fmt, ...)
@@ -1218,26 +1223,48 @@ void RSRTB2kOscilloscope::BulkCheckChannelEnableState()
 		}
 	}
 
-	bool digitalModuleOn = false;
+	//Send the logic pod and analog queries at once, rather than waiting a round trip for each
+	vector<string> queries;
 	if(hasUncachedDigital)
-	{	//Digital => first check digital module is ON
-		string probe1 = converse(":LOG1:STAT?");
-		string probe2 = converse(":LOG2:STAT?");
-		digitalModuleOn = (probe1 == "1" || probe2 == "1");
+	{	//Digital => first check which digital modules are ON
+		queries.push_back(":LOG1:STAT?");
+		queries.push_back(":LOG2:STAT?");
 	}
 	for(auto i : uncached)
 	{
-		bool enabled;
-		if((i < m_analogChannelCount))
-		{	// Analog
-			enabled = (converse(":CHAN%zu:STAT?", i + 1) == "1");
-		}
+		if(i < m_analogChannelCount)
+			queries.push_back(string(":CHAN") + to_string(i + 1) + ":STAT?");
+	}
+	auto replies = SendConcurrentQueries(queries, false);
+
+	size_t nreply = 0;
+	bool podOn[2] = {false, false};
+	if(hasUncachedDigital)
+	{
+		podOn[0] = (replies[0] == "1");
+		podOn[1] = (replies[1] == "1");
+		nreply = 2;
+	}
+
+	//Then only ask about digital channels whose pod is on (digital channel numbers are 0 based)
+	vector<string> digitalQueries;
+	for(auto i : uncached)
+	{
+		if( (i >= m_analogChannelCount) && podOn[(i - m_analogChannelCount) / 8] )
+			digitalQueries.push_back(string(":DIG") + to_string(i - m_analogChannelCount) + ":DISP?");
+	}
+	auto digitalReplies = SendConcurrentQueries(digitalQueries, false);
+
+	size_t ndigital = 0;
+	lock_guard<recursive_mutex> lock(m_cacheMutex);
+	for(auto i : uncached)
+	{
+		if(i < m_analogChannelCount)
+			m_channelsEnabled[i] = (replies[nreply++] == "1");
+		else if(podOn[(i - m_analogChannelCount) / 8])
+			m_channelsEnabled[i] = (digitalReplies[ndigital++] == "1");
 		else
-		{	// Digital
-			enabled = digitalModuleOn && (converse(":DIG%zu:DISP?", (i - m_analogChannelCount)) == "1");
-		}
-		lock_guard<recursive_mutex> lock(m_cacheMutex);
-		m_channelsEnabled[i] = enabled;
+			m_channelsEnabled[i] = false;
 	}
 }
 
@@ -2043,109 +2070,6 @@ void RSRTB2kOscilloscope::ForceHDMode(bool mode)
 	m_highDefinition = mode;
 }
 
-/**
-	@brief Converts 16-bit ADC samples to floating point
- */
-void RSRTB2kOscilloscope::Convert16BitSamples(float* pout, const uint16_t* pin, float gain, float offset, size_t count)
-{
-	//LogTrace("\n");
-	//Divide large waveforms (>1M points) into blocks and multithread them
-	if(count > 1000000)
-	{
-		//Round blocks to multiples of 64 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 64);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
-		{
-			//Last block gets any extra that didn't divide evenly
-			size_t nsamp = blocksize;
-			if(i == lastblock)
-				nsamp = count - i*blocksize;
-
-			size_t off = i*blocksize;
-			Convert16BitSamplesGeneric(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-		}
-	}
-
-	//Small waveforms get done single threaded to avoid overhead
-	else
-	{
-		Convert16BitSamplesGeneric(pout, pin, gain, offset, count);
-	}
-}
-
-/**
-	@brief Converts raw ADC samples to floating point
- */
-void RSRTB2kOscilloscope::Convert16BitSamplesGeneric(float* pout, const uint16_t* pin, float gain, float offset, size_t count)
-{
-	//LogTrace("\n");
-	for(size_t j=0; j<count; j++)
-		pout[j] = offset + pin[j] * gain;
-}
-
-/**
-	@brief Converts 8-bit ADC samples to floating point
- */
-void RSRTB2kOscilloscope::Convert8BitSamples(float* pout, const uint8_t* pin, float gain, float offset, size_t count)
-{
-	//LogTrace("\n");
-	//Divide large waveforms (>1M points) into blocks and multithread them
-	//TODO: tune split
-	if(count > 1000000)
-	{
-		//Round blocks to multiples of 32 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 32);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
-		{
-			//Last block gets any extra that didn't divide evenly
-			size_t nsamp = blocksize;
-			if(i == lastblock)
-				nsamp = count - i*blocksize;
-
-			size_t off = i*blocksize;
-			{
-				Convert8BitSamplesGeneric(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-		}
-	}
-
-	//Small waveforms get done single threaded to avoid overhead
-	else
-	{
-			Convert8BitSamplesGeneric(pout, pin, gain, offset, count);
-	}
-}
-
-/**
-	@brief Generic backend for Convert8BitSamples()
- */
-void RSRTB2kOscilloscope::Convert8BitSamplesGeneric(float* pout, const uint8_t* pin, float gain, float offset, size_t count)
-{
-	//LogTrace("\n");
-	for(unsigned int k=0; k<count; k++)
-		pout[k] = offset + pin[k] * gain;
-}
-
 //TODO
 vector<WaveformBase*> RSRTB2kOscilloscope::ProcessAnalogWaveform(
 	const std::vector<uint8_t>& data,
@@ -2176,11 +2100,11 @@ vector<WaveformBase*> RSRTB2kOscilloscope::ProcessAnalogWaveform(
 	if (bytesPerSample == 2)
 	{
 		const uint16_t* wdata = reinterpret_cast<const uint16_t*>(data.data());
-		Convert16BitSamples(
+		ConvertUnsigned16BitSamples(
 			cap->m_samples.GetCpuPointer(),
 			wdata,
 			verticalStep,
-			verticalStart,
+			-verticalStart,
 			sampleCount);
 
 		cap->MarkSamplesModifiedFromCpu();
@@ -2189,11 +2113,11 @@ vector<WaveformBase*> RSRTB2kOscilloscope::ProcessAnalogWaveform(
 	else if (bytesPerSample == 1)
 	{
 		const uint8_t* bdata = reinterpret_cast<const uint8_t*>(data.data());
-		Convert8BitSamples(
+		ConvertUnsigned8BitSamples(
 			cap->m_samples.GetCpuPointer(),
 			bdata,
 			verticalStep,
-			verticalStart,
+			-verticalStart,
 			sampleCount);
 
 		cap->MarkSamplesModifiedFromCpu();
@@ -2334,6 +2258,7 @@ bool RSRTB2kOscilloscope::AcquireData()
 
 	{	// Lock transport from now during all acquisition phase
 		lock_guard<recursive_mutex> lock(m_transport->GetMutex());
+		m_transport->WaitForAsyncReplies();
 		//start = GetTime();
 
 		//Read the data from each analog waveform
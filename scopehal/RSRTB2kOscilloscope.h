@@ -82,13 +82,6 @@ protected:
 	void AddAwgChannel();
 
 public:
-	// Specific 16 bit conversion methods for uint16_t
-	static void Convert16BitSamples(float* pout, const uint16_t* pin, float gain, float offset, size_t count);
-	static void Convert16BitSamplesGeneric(float* pout, const uint16_t* pin, float gain, float offset, size_t count);
-	// Specific 8 bit conversion methods for uint8_t
-	static void Convert8BitSamples(float* pout, const uint8_t* pin, float gain, float offset, size_t count);
-	static void Convert8BitSamplesGeneric(float* pout, const uint8_t* pin, float gain, float offset, size_t count);
-
 	//Device information
 	virtual unsigned int GetInstrumentTypes() const override;
 	virtual uint32_t GetInstrumentTypesForChannel(size_t i) const override;
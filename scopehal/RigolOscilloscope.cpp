@@ -1002,25 +1002,20 @@ bool RigolOscilloscope::AcquireData()
 			cap->Resize(cap->m_samples.size() + header_blocksize);
 			cap->PrepareForCpuAccess();
 
-			const uint16_t* temp_buf_int16 = m_highDefinition ? reinterpret_cast<const uint16_t*>(temp_buf) : NULL;
-			for(size_t j = 0; j < header_blocksize; j++)
-			{	// Handle 8bit / 16bit acquisition modes
-				float v;
-				if(m_highDefinition)
-				{
- 					v = (((static_cast<float>(temp_buf_int16[j]))) - ydelta) * yincrement;
-					//LogDebug("V = %.3f, temp=%d, delta=%f, inc=%f\n", v, temp_buf_int16[j], ydelta, yincrement);
-				}
-				else
-				{
- 					v = (static_cast<float>(temp_buf[j]) - ydelta) * yincrement;
-					//LogDebug("V = %.3f, temp=%d, delta=%f, inc=%f\n", v, temp_buf[j], ydelta, yincrement);
-				}
-				if(m_protocol == DS_OLD)
-					v = (128 - static_cast<float>(temp_buf[j])) * yincrement - ydelta;
-				//LogDebug("V = %.3f, temp=%d, delta=%f, inc=%f\n", v, temp_buf[j], ydelta, yincrement);
-				cap->m_samples[npoint + j] = v;
+			float* pout = cap->m_samples.GetCpuPointer() + npoint;
+			if(m_protocol == DS_OLD)
+				ConvertUnsigned8BitSamples(pout, temp_buf, -yincrement, ydelta - 128*yincrement, header_blocksize);
+			else if(m_highDefinition)
+			{
+				ConvertUnsigned16BitSamples(
+					pout,
+					reinterpret_cast<const uint16_t*>(temp_buf),
+					yincrement,
+					ydelta * yincrement,
+					header_blocksize);
 			}
+			else
+				ConvertUnsigned8BitSamples(pout, temp_buf, yincrement, ydelta * yincrement, header_blocksize);
 			cap->MarkSamplesModifiedFromCpu();
 
 			npoint += header_blocksize;
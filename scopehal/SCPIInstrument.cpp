@@ -56,6 +56,39 @@ void SCPIInstrument::BackgroundProcessing()
 	m_transport->FlushCommandQueue();
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Query helpers
+
+/**
+	@brief Sends a batch of queries with all of them in flight at once, then waits for all of the responses
+
+	Intended for warming caches of instrument state (e.g. on connect), where sending each query only after the previous
+	one was answered would cost one round trip per query. On transports that don't support pipelining, the queries are
+	sent one at a time.
+
+	@param cmds				The queries to send
+	@param endOnSemicolon	Passed to ReadReply() for each response
+
+	@return One response per query, in the same order
+ */
+vector<string> SCPIInstrument::SendConcurrentQueries(const vector<string>& cmds, bool endOnSemicolon)
+{
+	vector<future<string> > replies;
+	replies.reserve(cmds.size());
+	{
+		//The reply thread needs the network mutex to read, so holding it gets every query on the wire first
+		lock_guard<recursive_mutex> lock(m_transport->GetMutex());
+		for(auto& cmd : cmds)
+			replies.push_back(m_transport->SendCommandAsyncWithReply(cmd, endOnSemicolon));
+	}
+
+	vector<string> ret;
+	ret.reserve(cmds.size());
+	for(auto& reply : replies)
+		ret.push_back(reply.get());
+	return ret;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Accessors
 
@@ -90,6 +90,8 @@ public:
 	static std::vector<SCPIInstrumentModel> GetDriverSupportedModels();
 
 protected:
+	std::vector<std::string> SendConcurrentQueries(const std::vector<std::string>& cmds, bool endOnSemicolon = true);
+
 	typedef std::map<std::string, GetTransportsProcType > GetTransportMapType;
 	static GetTransportMapType m_getTransportProcs;
 
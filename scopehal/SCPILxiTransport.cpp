@@ -87,24 +87,17 @@ SCPILxiTransport::SCPILxiTransport(const string& args)
 
 	// When you issue a lxi_receive request, you need to specify the size of the receiving buffer.
 	// However, when the data received is larger than this buffer, liblxi simply discards this data.
-	// ReadReply and ReadRawData expect to be able to fetch received data piecemeal.
-	// The clunky solution is to have an intermediate buffer that is large enough to store all the
-	// data that could possible be returned by a scope.
-	// My Siglent oscilloscope can have a waveform of 140M samples, so I reserve 150M. However,
-	// I haven't been able to fetch waveforms larger than 1.4M (for reasons unknown.)
-	// Maybe we should reduce this number...
-	m_staging_buf_size = 150000000;
-	m_staging_buf = new unsigned char[m_staging_buf_size];
-	if (m_staging_buf == NULL)
-		return;
-	m_data_in_staging_buf = 0;
-	m_data_offset = 0;
-	m_data_depleted = false;
+	// So every receive has to offer room for the largest reply a scope could possibly send.
+	// My Siglent oscilloscope can have a waveform of 140M samples, so we allow 150M.
+	// The read buffer doesn't touch its storage until data arrives, so this is only address space until a reply
+	// actually needs it. Drivers expecting something even bigger can say so with SetExpectedReplySize().
+	m_defaultReplySize = 150000000;
+	m_expectedReplySize = 0;
+	m_replyReceived = false;
 }
 
 SCPILxiTransport::~SCPILxiTransport()
 {
-	delete[] m_staging_buf;
 }
 
 bool SCPILxiTransport::IsConnected()
@@ -135,39 +128,62 @@ bool SCPILxiTransport::SendCommand(const string& cmd)
 	//It doesn't actually change the inputs, so safe to cast.
 	int result = lxi_send(m_device, const_cast<char*>(&cmd[0]), cmd.length(), m_timeout);
 
-	m_data_in_staging_buf = 0;
-	m_data_offset = 0;
-	m_data_depleted = false;
+	m_rxBuffer.Clear();
+	m_replyReceived = false;
 
 	return (result != LXI_ERROR);
 }
 
+/**
+	@brief Fetches the reply to the last command into the read buffer, if we haven't already
+
+	Data in the buffer is assumed to always be a consequence of a SendCommand request. Since we fetch all the reply data
+	in one go, once it has been consumed we don't issue a new lxi_receive until a new SendCommand is issued.
+ */
+void SCPILxiTransport::ReceiveReply()
+{
+	if(m_replyReceived)
+		return;
+	m_replyReceived = true;
+
+	size_t size = min(max(m_defaultReplySize, m_expectedReplySize), (size_t)INT_MAX);
+	m_expectedReplySize = 0;
+
+	auto buf = m_rxBuffer.PrepareWrite(size);
+	if(!buf)
+		return;
+
+	int len = lxi_receive(m_device, (char *)buf, (int)size, m_timeout);
+	if(len > 0)
+		m_rxBuffer.CommitWrite(len);
+}
+
+/**
+	@brief Makes sure the next receive can hold a reply of up to len bytes
+
+	Only ever grows the receive beyond the default size, and applies to the next lxi_receive only.
+ */
+void SCPILxiTransport::SetExpectedReplySize(size_t len)
+{
+	m_expectedReplySize = len;
+}
+
 string SCPILxiTransport::ReadReply(bool endOnSemicolon, [[maybe_unused]] function<void(float)> progress)
 {
-	string ret;
+	ReceiveReply();
 
-	if (!m_staging_buf)
-		return ret;
+	string ret;
+	if(!m_rxBuffer.ExtractLine(ret, endOnSemicolon))
+		ret = m_rxBuffer.ReadRemaining();
+	m_rxBuffer.Trim();
 
-	//FIXME: there *has* to be a more efficient way to do this...
-	char tmp = ' ';
-	while(true)
-	{
-		if (m_data_depleted)
-			break;
-		ReadRawData(1, (unsigned char *)&tmp);
-		if( (tmp == '\n') || ( (tmp == ';') && endOnSemicolon ) )
-			break;
-		else
-			ret += tmp;
-	}
 	LogTrace("Got %s\n", ret.c_str());
 	return ret;
 }
 
 void SCPILxiTransport::SendRawData(size_t len, const unsigned char* buf)
 {
-	// XXX: Should this reset m_data_depleted just like SendCommmand?
+	// XXX: Should this reset m_replyReceived just like SendCommmand?
 
 	//Need the cast when using liblxi versions prior to 63ea109 because they don't have "const" on the argument.
 	//It doesn't actually change the inputs, so safe to cast.
@@ -176,46 +192,19 @@ void SCPILxiTransport::SendRawData(size_t len, const unsigned char* buf)
 
 size_t SCPILxiTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> /*progress*/)
 {
-	// Data in the staging buffer is assumed to always be a consequence of a SendCommand request.
-	// Since we fetch all the reply data in one go, once all this data has been fetched, we mark
-	// the staging buffer as depleted and don't issue a new lxi_receive until a new SendCommand
-	// is issued.
+	ReceiveReply();
 
-	if (!m_staging_buf)
-		return 0;
+	size_t n = m_rxBuffer.Read(buf, len);
+	m_rxBuffer.Trim();
 
-	if (!m_data_depleted)
-	{
-		if (m_data_in_staging_buf == 0)
-		{
-			m_data_in_staging_buf = lxi_receive(m_device, (char *)m_staging_buf, m_staging_buf_size, m_timeout);
-			if (m_data_in_staging_buf == LXI_ERROR)
-				m_data_in_staging_buf = 0;
-			m_data_offset = 0;
-		}
-
-		unsigned int data_left = m_data_in_staging_buf - m_data_offset;
-		if (data_left > 0)
-		{
-			int nr_bytes = len > data_left ? data_left : len;
-
-			memcpy(buf, m_staging_buf + m_data_offset, nr_bytes);
-
-			m_data_offset += nr_bytes;
-		}
-
-		if (m_data_offset == m_data_in_staging_buf)
-				m_data_depleted = true;
-	}
-	else
+	if(n < len)
 	{
 		// When this happens, the SCPIDevice is fetching more data from device than what
 		// could be expected from the SendCommand that was issued.
 		LogDebug("ReadRawData: data depleted.\n");
-		return 0;
 	}
 
-	return len;
+	return n;
 }
 
 bool SCPILxiTransport::IsCommandBatchingSupported()
@@ -64,6 +64,8 @@ public:
 	virtual bool IsCommandBatchingSupported() override;
 	virtual bool IsConnected() override;
 
+	virtual void SetExpectedReplySize(size_t len) override;
+
 	TRANSPORT_INITPROC(SCPILxiTransport)
 
 	const std::string& GetHostname() const
@@ -72,6 +74,8 @@ public:
 	virtual void FlushRXBuffer() override;
 
 protected:
+	void ReceiveReply();
+
 	static bool m_lxi_initialized;
 
 	std::string m_hostname;
@@ -80,11 +84,17 @@ protected:
 	int m_device;
 	int m_timeout;
 
-	int m_staging_buf_size;
-	unsigned char *m_staging_buf;
-	int m_data_in_staging_buf;
-	int m_data_offset;
-	bool m_data_depleted;
+	///@brief Receive size offered to liblxi unless a larger reply has been hinted
+	size_t m_defaultReplySize;
+
+	///@brief Reply size hinted by SetExpectedReplySize() for the next receive, or zero if none
+	size_t m_expectedReplySize;
+
+	///@brief Reply data received but not yet returned to the caller
+	SCPIReadBuffer m_rxBuffer;
+
+	///@brief True if the reply to the last command has already been fetched
+	bool m_replyReceived;
 };
 
 #endif
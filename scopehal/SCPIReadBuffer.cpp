@@ -0,0 +1,315 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of SCPIReadBuffer
+	@ingroup transports
+ */
+
+#include "scopehal.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates an empty buffer
+
+	@param retainSize	Storage is kept for reuse after a transfer as long as no more than this many bytes were used
+ */
+SCPIReadBuffer::SCPIReadBuffer(size_t retainSize)
+	: m_buf(nullptr)
+	, m_capacity(0)
+	, m_start(0)
+	, m_end(0)
+	, m_scanned(0)
+	, m_scannedForSemicolon(false)
+	, m_highWater(0)
+	, m_retainSize(retainSize)
+{
+}
+
+SCPIReadBuffer::~SCPIReadBuffer()
+{
+	free(m_buf);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Filling
+
+/**
+	@brief Makes room for at least len more bytes after the buffered data
+
+	Existing data is moved to the start of the buffer if that frees enough space, otherwise the storage is reallocated.
+
+	@return Pointer to write the new data to, or nullptr if allocation failed. Call CommitWrite() once it's filled.
+ */
+unsigned char* SCPIReadBuffer::PrepareWrite(size_t len)
+{
+	if(m_capacity - m_end >= len)
+		return m_buf + m_end;
+
+	//Compact if that's enough
+	size_t count = size();
+	if(m_capacity - count >= len)
+	{
+		memmove(m_buf, m_buf + m_start, count);
+		m_scanned = (m_scanned > m_start) ? (m_scanned - m_start) : 0;
+		m_start = 0;
+		m_end = count;
+		return m_buf + m_end;
+	}
+
+	//Grow. Deliberately don't touch the new storage so the OS only commits pages we actually write to.
+	size_t newCapacity = max(count + len, max(m_capacity * 2, (size_t)65536));
+	auto newBuf = static_cast<unsigned char*>(malloc(newCapacity));
+	if(!newBuf)
+	{
+		LogError("SCPIReadBuffer: failed to allocate %zu bytes\n", newCapacity);
+		return nullptr;
+	}
+	if(count)
+		memcpy(newBuf, m_buf + m_start, count);
+	free(m_buf);
+
+	m_buf = newBuf;
+	m_capacity = newCapacity;
+	m_scanned = (m_scanned > m_start) ? (m_scanned - m_start) : 0;
+	m_start = 0;
+	m_end = count;
+	return m_buf + m_end;
+}
+
+/**
+	@brief Marks len bytes written after a call to PrepareWrite() as valid
+ */
+void SCPIReadBuffer::CommitWrite(size_t len)
+{
+	m_end += len;
+	m_highWater = max(m_highWater, m_end);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Draining
+
+/**
+	@brief Copies up to len buffered bytes out and consumes them
+
+	@return Number of bytes copied
+ */
+size_t SCPIReadBuffer::Read(unsigned char* buf, size_t len)
+{
+	size_t n = min(len, size());
+	if(n)
+		memcpy(buf, m_buf + m_start, n);
+	Consume(n);
+	return n;
+}
+
+/**
+	@brief Extracts a complete line from the buffered data, if there is one
+
+	Previously scanned data is not searched again, so calling this repeatedly as data trickles in is linear overall.
+
+	@param line				Receives the line, without the delimiter
+	@param endOnSemicolon	True to treat ';' as a delimiter in addition to '\n'
+
+	@return True if a line was extracted, false if no delimiter has been received yet
+ */
+bool SCPIReadBuffer::ExtractLine(string& line, bool endOnSemicolon)
+{
+	if(empty())
+		return false;
+
+	//If the last scan didn't look for semicolons, it may have skipped over one
+	size_t from = m_scanned;
+	if(endOnSemicolon && !m_scannedForSemicolon)
+		from = m_start;
+	from = max(from, m_start);
+
+	auto hit = FindDelimiter(m_buf + from, m_end - from, endOnSemicolon);
+	if(!hit)
+	{
+		m_scanned = m_end;
+		m_scannedForSemicolon = endOnSemicolon;
+		return false;
+	}
+
+	size_t pos = hit - m_buf;
+	line.assign(reinterpret_cast<const char*>(m_buf + m_start), pos - m_start);
+	Consume(pos + 1 - m_start);
+	return true;
+}
+
+/**
+	@brief Reads a line, pulling more data from the device as needed
+
+	@param line				Receives the line, without the delimiter. If the device runs out of data first, this is
+							whatever was received.
+	@param endOnSemicolon	True to treat ';' as a delimiter in addition to '\n'
+	@param chunkSize		Maximum number of bytes to request from the device per fill call
+	@param fill				Callback to read from the device
+
+	@return True if a delimiter was found, false if the line was truncated
+ */
+bool SCPIReadBuffer::ReadLine(string& line, bool endOnSemicolon, size_t chunkSize, const FillFunction& fill)
+{
+	while(!ExtractLine(line, endOnSemicolon))
+	{
+		auto p = PrepareWrite(chunkSize);
+		size_t n = 0;
+		if(p)
+			n = fill(p, chunkSize);
+		if(n == 0)
+		{
+			line = ReadRemaining();
+			return false;
+		}
+		CommitWrite(n);
+	}
+	return true;
+}
+
+/**
+	@brief Consumes and returns all buffered data
+ */
+string SCPIReadBuffer::ReadRemaining()
+{
+	if(empty())
+		return "";
+
+	string ret(reinterpret_cast<const char*>(m_buf + m_start), size());
+	Consume(size());
+	return ret;
+}
+
+/**
+	@brief Discards all buffered data
+ */
+void SCPIReadBuffer::Clear()
+{
+	Consume(size());
+}
+
+/**
+	@brief Releases the storage if it's empty and the last transfer used more than the retain size
+ */
+void SCPIReadBuffer::Trim()
+{
+	if(!empty() || (m_highWater <= m_retainSize) )
+		return;
+
+	free(m_buf);
+	m_buf = nullptr;
+	m_capacity = 0;
+	m_highWater = 0;
+}
+
+void SCPIReadBuffer::Consume(size_t len)
+{
+	m_start += len;
+
+	//Rewind to the start of the buffer once drained so we don't have to compact later
+	if(m_start == m_end)
+	{
+		m_start = 0;
+		m_end = 0;
+		m_scanned = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Delimiter search
+
+/**
+	@brief Finds the first SCPI delimiter in a block of data
+
+	@param p				Start of the data
+	@param len				Number of bytes to search
+	@param endOnSemicolon	True to treat ';' as a delimiter in addition to '\n'
+
+	@return Pointer to the delimiter, or nullptr if none was found
+ */
+const unsigned char* SCPIReadBuffer::FindDelimiter(const unsigned char* p, size_t len, bool endOnSemicolon)
+{
+	//libc memchr is already vectorized
+	if(!endOnSemicolon)
+		return static_cast<const unsigned char*>(memchr(p, '\n', len));
+
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		return FindDelimiterAVX2(p, len);
+	#endif
+
+	for(size_t i=0; i<len; i++)
+	{
+		if( (p[i] == '\n') || (p[i] == ';') )
+			return p + i;
+	}
+	return nullptr;
+}
+
+#ifdef __x86_64__
+/**
+	@brief Searches for '\n' or ';', 32 bytes at a time
+ */
+__attribute__((target("avx2")))
+const unsigned char* SCPIReadBuffer::FindDelimiterAVX2(const unsigned char* p, size_t len)
+{
+	__m256i newline = _mm256_set1_epi8('\n');
+	__m256i semicolon = _mm256_set1_epi8(';');
+
+	size_t end = len - (len % 32);
+	size_t i = 0;
+	for(; i<end; i += 32)
+	{
+		__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+		__m256i hits = _mm256_or_si256(
+			_mm256_cmpeq_epi8(block, newline),
+			_mm256_cmpeq_epi8(block, semicolon));
+		uint32_t mask = _mm256_movemask_epi8(hits);
+		if(mask)
+			return p + i + __builtin_ctz(mask);
+	}
+
+	for(; i<len; i++)
+	{
+		if( (p[i] == '\n') || (p[i] == ';') )
+			return p + i;
+	}
+	return nullptr;
+}
+#endif
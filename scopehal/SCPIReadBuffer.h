@@ -0,0 +1,132 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SCPIReadBuffer
+	@ingroup transports
+ */
+
+#ifndef SCPIReadBuffer_h
+#define SCPIReadBuffer_h
+
+#include <functional>
+#include <string>
+
+/**
+	@brief Growable receive buffer shared by stream-oriented transports
+
+	Transports fill the buffer with bulk reads from the underlying device, then replies are split out of it by scanning
+	for the SCPI delimiter. This avoids the one-call-per-byte pattern of reading a reply a character at a time.
+
+	Storage is allocated on first use and grows as needed. It is left uninitialized, so a large reservation (e.g. for
+	transports which must provide worst case reply size up front) only consumes physical memory for the bytes actually
+	written. Once a large transfer has been fully consumed the storage is released, so one huge waveform doesn't pin
+	memory for the rest of the session.
+
+	Not thread safe; callers are expected to hold the transport's network mutex.
+
+	@ingroup transports
+ */
+class SCPIReadBuffer
+{
+public:
+	SCPIReadBuffer(size_t retainSize = 1024*1024);
+	~SCPIReadBuffer();
+
+	//not copyable or assignable
+	SCPIReadBuffer(const SCPIReadBuffer&) =delete;
+	SCPIReadBuffer& operator=(const SCPIReadBuffer&) =delete;
+
+	/**
+		@brief Fill callback: reads up to len bytes from the device into buf
+
+		Returns the number of bytes read, or zero if no more data is available (timeout, error, or end of message).
+	 */
+	typedef std::function<size_t(unsigned char* buf, size_t len)> FillFunction;
+
+	unsigned char* PrepareWrite(size_t len);
+	void CommitWrite(size_t len);
+
+	///@brief Returns the number of bytes buffered but not yet consumed
+	size_t size() const
+	{ return m_end - m_start; }
+
+	///@brief Returns true if there is no buffered data
+	bool empty() const
+	{ return m_end == m_start; }
+
+	///@brief Returns a pointer to the first unconsumed byte
+	const unsigned char* data() const
+	{ return m_buf + m_start; }
+
+	size_t Read(unsigned char* buf, size_t len);
+	bool ExtractLine(std::string& line, bool endOnSemicolon);
+	bool ReadLine(std::string& line, bool endOnSemicolon, size_t chunkSize, const FillFunction& fill);
+	std::string ReadRemaining();
+
+	void Clear();
+	void Trim();
+
+	static const unsigned char* FindDelimiter(const unsigned char* p, size_t len, bool endOnSemicolon);
+
+protected:
+	void Consume(size_t len);
+
+#ifdef __x86_64__
+	static const unsigned char* FindDelimiterAVX2(const unsigned char* p, size_t len);
+#endif
+
+	///@brief Backing storage (uninitialized)
+	unsigned char* m_buf;
+
+	///@brief Size of m_buf, in bytes
+	size_t m_capacity;
+
+	///@brief Offset of the first unconsumed byte
+	size_t m_start;
+
+	///@brief Offset one past the last valid byte
+	size_t m_end;
+
+	///@brief Offset (relative to m_buf) up to which buffered data is known not to contain a delimiter
+	size_t m_scanned;
+
+	///@brief True if the data up to m_scanned was searched for semicolons as well as newlines
+	bool m_scannedForSemicolon;
+
+	///@brief Highest m_end seen since the storage was last released
+	size_t m_highWater;
+
+	///@brief Storage whose high water mark is at or below this size is kept around for reuse
+	size_t m_retainSize;
+};
+
+#endif
@@ -114,6 +114,8 @@ void SCPISocketTransport::SharedCtorInit()
 
 SCPISocketTransport::~SCPISocketTransport()
 {
+	//Must be gone before the connection is closed
+	StopAsyncReplyThread();
 }
 
 bool SCPISocketTransport::IsConnected()
@@ -144,6 +146,26 @@ bool SCPISocketTransport::SendCommand(const string& cmd)
 	return m_socket.SendLooped((unsigned char*)tempbuf.c_str(), tempbuf.length());
 }
 
+/**
+	@brief Sends several commands in a single write, rather than one TCP segment per command
+ */
+bool SCPISocketTransport::SendCommandBatch(const vector<string>& cmds)
+{
+	size_t len = 0;
+	for(auto& cmd : cmds)
+		len += cmd.length() + 1;
+
+	string tempbuf;
+	tempbuf.reserve(len);
+	for(auto& cmd : cmds)
+	{
+		LogTrace("[%s] Sending %s\n", m_hostname.c_str(), cmd.c_str());
+		tempbuf += cmd;
+		tempbuf += '\n';
+	}
+	return m_socket.SendLooped((unsigned char*)tempbuf.c_str(), tempbuf.length());
+}
+
 string SCPISocketTransport::ReadReply(bool endOnSemicolon, [[maybe_unused]] function<void(float)> progress)
 {
 	//FIXME: there *has* to be a more efficient way to do this...
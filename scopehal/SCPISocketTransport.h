@@ -56,6 +56,7 @@ public:
 
 	virtual void FlushRXBuffer(void) override;
 	virtual bool SendCommand(const std::string& cmd) override;
+	virtual bool SendCommandBatch(const std::vector<std::string>& cmds) override;
 	virtual std::string ReadReply(bool endOnSemicolon = true, std::function<void(float)> progress = nullptr) override;
 	virtual size_t ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr) override;
 	virtual void SendRawData(size_t len, const unsigned char* buf) override;
@@ -63,6 +64,9 @@ public:
 	virtual bool IsCommandBatchingSupported() override;
 	virtual bool IsConnected() override;
 
+	virtual bool IsQueryPipeliningSupported() override
+	{ return true; }
+
 	TRANSPORT_INITPROC(SCPISocketTransport)
 
 	///@brief Returns the hostname of the connected instrument
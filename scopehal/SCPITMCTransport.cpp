@@ -49,18 +49,13 @@ using namespace std;
 
 SCPITMCTransport::SCPITMCTransport(const string& args)
 	: m_devicePath(args)
-	, m_staging_buf_size(0)
-	, m_staging_buf(nullptr)
-	, m_data_in_staging_buf(0)
-	, m_data_offset(0)
-	, m_data_depleted(false)
+	, m_messageComplete(false)
 	, m_fix_buggy_driver(false)
 	, m_transfer_size(48)
 {
 	// TODO: add configuration options:
 	// - set the maximum request size of usbtmc read requests (currently 2032)
 	// - set timeout value (when using kernel that has usbtmc v2 version)
-	// - set size of staging buffer (or get rid of it entirely?)
 
 	// FIXME: currently not used
 	m_timeout = 1000;
@@ -90,19 +85,12 @@ SCPITMCTransport::SCPITMCTransport(const string& args)
 		LogError("Couldn't open %s\n", devicePath);
 		return;
 	}
-
-	// Right now, I'm using an internal staging buffer because this code has been copied from the lxi transport driver.
-	// It's not strictly needed...
-	m_staging_buf_size = 150000000;
-	m_staging_buf = new unsigned char[m_staging_buf_size];
 }
 
 SCPITMCTransport::~SCPITMCTransport()
 {
 	if (IsConnected())
 		close(m_handle);
-
-	delete[] m_staging_buf;
 }
 
 bool SCPITMCTransport::IsConnected()
@@ -132,134 +120,87 @@ bool SCPITMCTransport::SendCommand(const string& cmd)
 
 	int result = write(m_handle, cmd.c_str(), cmd.length());
 
-	m_data_in_staging_buf = 0;
-	m_data_offset = 0;
-	m_data_depleted = false;
+	m_rxBuffer.Clear();
+	m_messageComplete = false;
 
 	return (result == (int)cmd.length());
 }
 
-string SCPITMCTransport::ReadReply(bool endOnSemicolon, [[maybe_unused]] function<void(float)> progress)
+/**
+	@brief Reads the next chunk of the current reply from the device
+
+	The whole reply is assumed to be a consequence of a SendCommand request. Once a short read tells us we've reached
+	the end of it, we don't issue another read until a new SendCommand is issued (since it would just time out).
+
+	@return Number of bytes read, or zero if the reply has already been completely read
+ */
+size_t SCPITMCTransport::ReadFromDevice(unsigned char* buf, size_t len)
 {
-	string ret;
+	if(m_messageComplete)
+		return 0;
 
-	if (!m_staging_buf || !IsConnected())
-		return ret;
+	// FIXME: Workaround for buggy firmware which can't handle large requests
+	if(m_fix_buggy_driver)
+		len = min(len, (size_t)m_transfer_size);
 
-	//FIXME: there *has* to be a more efficient way to do this...
-	char tmp = ' ';
-	while(true)
+	auto bytes_fetched = read(m_handle, (char *)buf, len);
+	if(bytes_fetched <= 0)
 	{
-		if (m_data_depleted)
-			break;
-		ReadRawData(1, (unsigned char *)&tmp);
-		if( (tmp == '\n') || ( (tmp == ';') && endOnSemicolon ) )
-			break;
-		else
-			ret += tmp;
+		m_messageComplete = true;
+		return 0;
 	}
+
+	if((size_t)bytes_fetched < len)
+		m_messageComplete = true;
+	return bytes_fetched;
+}
+
+string SCPITMCTransport::ReadReply(bool endOnSemicolon, [[maybe_unused]] function<void(float)> progress)
+{
+	string ret;
+	if (!IsConnected())
+		return ret;
+
+	m_rxBuffer.ReadLine(ret, endOnSemicolon, m_readChunkSize, [&](unsigned char* buf, size_t len)
+		{ return ReadFromDevice(buf, len); });
+	m_rxBuffer.Trim();
+
 	LogTrace("Got %s\n", ret.c_str());
 	return ret;
 }
 
 void SCPITMCTransport::SendRawData(size_t len, const unsigned char* buf)
 {
-	// XXX: Should this reset m_data_depleted just like SendCommmand?
+	// XXX: Should this reset m_messageComplete just like SendCommmand?
 	write(m_handle, (const char *)buf, len);
 }
 
 size_t SCPITMCTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress)
 {
-	// Data in the staging buffer is assumed to always be a consequence of a SendCommand request.
-	// Since we fetch all the reply data in one go, once all this data has been fetched, we mark
-	// the staging buffer as depleted and don't issue a new read until a new SendCommand
-	// is issued.
-
-	if (!m_staging_buf || !IsConnected())
+	if (!IsConnected())
 		return 0;
 
-	if (!m_data_depleted)
+	//Drain anything ReadReply() pulled in past the end of its line, then read the rest straight into the caller's
+	//buffer with no staging copy
+	size_t pos = m_rxBuffer.Read(buf, len);
+	m_rxBuffer.Trim();
+	while(pos < len)
 	{
-		if (m_data_in_staging_buf == 0 || (m_data_in_staging_buf - m_data_offset) < (int)len)
-		{
-
-			if (m_data_in_staging_buf == 0)
-				m_data_offset = 0;
-#if 0
-			// This is what we'd use if we could be sure that the installed Linux kernel had
-			// usbtmc driver v2.
-			int packet = 0;
-			do
-			{
-				m_data_in_staging_buf += read(m_handle, (char *)m_staging_buf + m_data_in_staging_buf, m_staging_buf_size - m_data_in_staging_buf);
-
-				if (progress && packet > 0)
-					progress((float)(m_data_in_staging_buf - m_data_offset) / (float)len);
-				packet += 1;
-			} while((m_data_in_staging_buf - m_data_offset) < (int)len);
-#else
-			// Split up one potentially large read into a bunch of smaller ones.
-			// The performance impact of this is pretty small.
-			const int max_bytes_per_req = 2032;
-			int i = m_data_in_staging_buf;
-			int bytes_fetched, bytes_requested;
-			int packet = 0;
-
-			do
-			{
-				do
-				{
-					if(m_fix_buggy_driver == false)
-					{
-						bytes_requested = (max_bytes_per_req < len) ? max_bytes_per_req : len;
-						bytes_fetched = read(m_handle, (char *)m_staging_buf + i, m_staging_buf_size - i);
-					}
-					else
-					{
-						// limit each request to m_transfer_size
-						bytes_requested = m_transfer_size;
-						bytes_fetched = read(m_handle, (char *)m_staging_buf + i, m_transfer_size);
-					}
-					i += bytes_fetched;
-				} while(bytes_fetched == bytes_requested);
-
-				if (progress && packet > 0)
-					progress((float)(i - m_data_offset) / (float)len);
-				packet += 1;
-			} while((i - m_data_offset) < (int)len);
-
-			m_data_in_staging_buf = i;
-#endif
-
-			if (m_data_in_staging_buf <= 0)
-				m_data_in_staging_buf = 0;
-			m_data_offset = 0;
-		}
-
-		unsigned int data_left = m_data_in_staging_buf - m_data_offset;
-		if (data_left > 0)
+		size_t n = ReadFromDevice(buf + pos, min(len - pos, m_readChunkSize));
+		if(n == 0)
 		{
-			int nr_bytes = len > data_left ? data_left : len;
-
-			memcpy(buf, m_staging_buf + m_data_offset, nr_bytes);
-
-			m_data_offset += nr_bytes;
+			// When this happens, the SCPIDevice is fetching more data from device than what
+			// could be expected from the SendCommand that was issued.
+			LogDebug("ReadRawData: data depleted.\n");
+			break;
 		}
+		pos += n;
 
-		if (m_data_offset == m_data_in_staging_buf)
-		{
-			m_data_depleted = true;
-		}
-	}
-	else
-	{
-		// When this happens, the SCPIDevice is fetching more data from device than what
-		// could be expected from the SendCommand that was issued.
-		LogDebug("ReadRawData: data depleted.\n");
-		return 0;
+		if(progress)
+			progress((float)pos / (float)len);
 	}
 
-	return len;
+	return pos;
 }
 
 bool SCPITMCTransport::IsCommandBatchingSupported()
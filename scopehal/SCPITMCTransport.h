@@ -69,16 +69,22 @@ public:
 	{ return m_devicePath; }
 
 protected:
+	size_t ReadFromDevice(unsigned char* buf, size_t len);
+
 	std::string m_devicePath;
 
 	int m_handle;
 	int m_timeout;
 
-	int m_staging_buf_size;
-	unsigned char *m_staging_buf;
-	int m_data_in_staging_buf;
-	int m_data_offset;
-	bool m_data_depleted;
+	///@brief Data read from the device but not yet returned to the caller
+	SCPIReadBuffer m_rxBuffer;
+
+	///@brief True if the reply to the last command has been completely read from the device
+	bool m_messageComplete;
+
+	///@brief Maximum number of bytes to request from the driver in a single read
+	static constexpr size_t m_readChunkSize = 1024*1024;
+
 	bool m_fix_buggy_driver;
 	int m_transfer_size;
 };
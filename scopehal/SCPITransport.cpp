@@ -43,13 +43,16 @@ SCPITransport::CreateMapType SCPITransport::m_createprocs;
 SCPITransport::EnumEndpointsMapType SCPITransport::m_enumEndpointsProcs;
 
 SCPITransport::SCPITransport()
-	: m_rateLimitingEnabled(false)
+	: m_asyncThreadQuit(false)
+	, m_rateLimitingEnabled(false)
 	, m_rateLimitingInterval(0)
 {
 }
 
 SCPITransport::~SCPITransport()
 {
+	//Derived transports which support pipelining already did this before closing their connection
+	StopAsyncReplyThread();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -88,86 +91,71 @@ void SCPITransport::SendCommandQueued(const string& cmd)
 {
 	lock_guard<mutex> lock(m_queueMutex);
 
-	//Do deduplication if there are existing queued commands
-	if(!m_dedupCommands.empty() && !m_txQueue.empty())
+	//Only attempt to deduplicate previous instances if this command is on the list of commands where it's OK
+	string subject;
+	string command;
+	if(!m_dedupCommands.empty() &&
+		ParseCommandForDeduplication(cmd, subject, command) &&
+		(m_dedupCommands.find(command) != m_dedupCommands.end()) )
 	{
-		//Parse the INCOMING command into sections
-
-		//Split off subject, if we have one
-		//(ignore leading colon)
-		string tmp = cmd;
-		size_t icolon;
-		if(tmp[0] == ':')
-			icolon = tmp.find(':', 1);
-		else
-			icolon = tmp.find(':', 0);
-		string incoming_subject;
-		if(icolon != string::npos)
+		//Deduplicate if the same command is already queued for the same subject
+		string key = subject + "\n" + command;
+		auto it = m_dedupQueuePositions.find(key);
+		if(it != m_dedupQueuePositions.end())
 		{
-			incoming_subject = tmp.substr(0, icolon);
-			tmp = tmp.substr(icolon + 1);
-		}
-
-		//Split off command from arguments
-		size_t ispace = tmp.find(' ');
-		string incoming_cmd;
-		if(ispace != string::npos)
-			incoming_cmd = tmp.substr(0, ispace);
+			LogTrace("Deduplicating redundant %s command %s and pushing new command %s\n",
+				command.c_str(),
+				it->second->c_str(),
+				cmd.c_str());
 
-		//Only attempt to deduplicate previous instances if this command is on the list of commands where it's OK
-		if(m_dedupCommands.find(incoming_cmd) != m_dedupCommands.end())
-		{
-			auto it = m_txQueue.begin();
-			while(it != m_txQueue.end())
-			{
-				tmp = *it;
-
-				//Split off subject, if we have one
-				//(ignore leading colon)
-				if(tmp[0] == ':')
-					icolon = tmp.find(':', 1);
-				else
-					icolon = tmp.find(':', 0);
-				string subject;
-				if(icolon != string::npos)
-				{
-					subject = tmp.substr(0, icolon);
-					tmp = tmp.substr(icolon + 1);
-				}
-
-				//Split off command from arguments
-				ispace = tmp.find(' ');
-				string ncmd;
-				if(ispace != string::npos)
-					ncmd = tmp.substr(0, ispace);
-
-				//Deduplicate if the same command is operating on the same subject
-				if( (incoming_cmd == ncmd) && (incoming_subject == subject) )
-				{
-					LogTrace("Deduplicating redundant %s command %s and pushing new command %s\n",
-						ncmd.c_str(),
-						(*it).c_str(),
-						cmd.c_str());
-
-					auto oldit = it;
-					it++;
-
-					m_txQueue.erase(oldit);
-				}
-
-				//Nope, skip it
-				else
-					it++;
-			}
+			m_txQueue.erase(it->second);
 		}
 
+		m_txQueue.push_back(cmd);
+		m_dedupQueuePositions[key] = prev(m_txQueue.end());
 	}
-
-	m_txQueue.push_back(cmd);
+	else
+		m_txQueue.push_back(cmd);
 
 	LogTrace("%zu commands now queued\n", m_txQueue.size());
 }
 
+/**
+	@brief Splits a command into subject and command name for deduplication
+
+	For example, "C2:OFFS 1.1" has subject "C2" and command "OFFS". A leading colon is not treated as a separator.
+
+	@return False if the command has no arguments, and thus is never deduplicated
+ */
+bool SCPITransport::ParseCommandForDeduplication(const string& cmd, string& subject, string& command)
+{
+	if(cmd.empty())
+		return false;
+
+	//Split off subject, if we have one
+	//(ignore leading colon)
+	size_t icolon;
+	if(cmd[0] == ':')
+		icolon = cmd.find(':', 1);
+	else
+		icolon = cmd.find(':', 0);
+
+	size_t start = 0;
+	subject.clear();
+	if(icolon != string::npos)
+	{
+		subject = cmd.substr(0, icolon);
+		start = icolon + 1;
+	}
+
+	//Split off command from arguments
+	size_t ispace = cmd.find(' ', start);
+	if(ispace == string::npos)
+		return false;
+	command = cmd.substr(start, ispace - start);
+	return true;
+}
+
 /**
 	@brief Block until it's time to send the next command when rate limiting.
  */
@@ -179,6 +167,9 @@ void SCPITransport::RateLimitingWait()
 
 /**
 	@brief Pushes all pending commands from SendCommandQueued() calls and blocks until they are all sent.
+
+	Unless rate limiting is enabled, the whole queue is handed to SendCommandBatch() at once so transports can
+	coalesce it into a single write.
  */
 bool SCPITransport::FlushCommandQueue()
 {
@@ -190,18 +181,45 @@ bool SCPITransport::FlushCommandQueue()
 		lock_guard<mutex> lock2(m_queueMutex);
 		tmp = std::move(m_txQueue);
 		m_txQueue.clear();
+		m_dedupQueuePositions.clear();
 	}
 
-	if(tmp.size())
-		LogTrace("%zu commands being flushed\n", tmp.size());
+	if(tmp.empty())
+		return true;
 
-	for(auto& str : tmp)
+	LogTrace("%zu commands being flushed\n", tmp.size());
+
+	if(m_rateLimitingEnabled)
 	{
-		if(m_rateLimitingEnabled)
+		for(auto& str : tmp)
+		{
 			RateLimitingWait();
-		SendCommand(str);
+			SendCommand(str);
+		}
+		return true;
 	}
-	return true;
+
+	vector<string> cmds;
+	cmds.reserve(tmp.size());
+	for(auto& str : tmp)
+		cmds.push_back(std::move(str));
+	return SendCommandBatch(cmds);
+}
+
+/**
+	@brief Sends several commands back to back
+
+	The default implementation calls SendCommand() for each one. Stream transports override this to send the whole
+	batch in a single write.
+
+	@return True if all commands were sent successfully
+ */
+bool SCPITransport::SendCommandBatch(const vector<string>& cmds)
+{
+	bool ok = true;
+	for(auto& cmd : cmds)
+		ok &= SendCommand(cmd);
+	return ok;
 }
 
 /**
@@ -223,6 +241,7 @@ string SCPITransport::SendCommandQueuedWithReply(const string& cmd, bool endOnSe
 string SCPITransport::SendCommandImmediateWithReply(const string& cmd, bool endOnSemicolon)
 {
 	lock_guard<recursive_mutex> lock(m_netMutex);
+	WaitForAsyncReplies();
 
 	if(m_rateLimitingEnabled)
 		RateLimitingWait();
@@ -232,6 +251,182 @@ string SCPITransport::SendCommandImmediateWithReply(const string& cmd, bool endO
 	return ReadReply(endOnSemicolon);
 }
 
+/**
+	@brief Sends several queries (flushing any pending/queued commands first), then reads all of the responses.
+
+	All queries are sent in one batch before any response is read, so a bulk refresh of cached instrument state
+	takes one round trip rather than one per query. Only use this with instruments that buffer responses to
+	multiple outstanding queries. If the transport doesn't support pipelining, or rate limiting is enabled, queries are
+	sent and answered one at a time.
+
+	This is an atomic operation requiring no mutexing at the caller side.
+
+	@param cmds				The queries to send
+	@param endOnSemicolon	Passed to ReadReply() for each response
+
+	@return One response per query, in the same order
+ */
+vector<string> SCPITransport::SendPipelinedQueries(const vector<string>& cmds, bool endOnSemicolon)
+{
+	FlushCommandQueue();
+
+	lock_guard<recursive_mutex> lock(m_netMutex);
+	WaitForAsyncReplies();
+
+	vector<string> ret;
+	ret.reserve(cmds.size());
+
+	if(m_rateLimitingEnabled || !IsQueryPipeliningSupported())
+	{
+		for(auto& cmd : cmds)
+		{
+			if(m_rateLimitingEnabled)
+				RateLimitingWait();
+			SendCommand(cmd);
+			ret.push_back(ReadReply(endOnSemicolon));
+		}
+		return ret;
+	}
+
+	SendCommandBatch(cmds);
+	for(size_t i=0; i<cmds.size(); i++)
+		ret.push_back(ReadReply(endOnSemicolon));
+	return ret;
+}
+
+/**
+	@brief Sends a query (flushing any pending/queued commands first) without waiting for the response
+
+	@param cmd				The query to send
+	@param endOnSemicolon	Passed to ReadReply() for the response
+
+	@return Future which becomes ready once the response has been read
+ */
+future<string> SCPITransport::SendCommandAsyncWithReply(const string& cmd, bool endOnSemicolon)
+{
+	if(!IsQueryPipeliningSupported())
+	{
+		promise<string> reply;
+		reply.set_value(SendCommandQueuedWithReply(cmd, endOnSemicolon));
+		return reply.get_future();
+	}
+
+	FlushCommandQueue();
+
+	//Holding the network mutex across the send and the push keeps m_pendingReplies in the same order as the queries
+	lock_guard<recursive_mutex> lock(m_netMutex);
+	if(m_rateLimitingEnabled)
+		RateLimitingWait();
+	SendCommand(cmd);
+
+	future<string> ret;
+	{
+		lock_guard<mutex> lock2(m_asyncMutex);
+		if(m_asyncThreadQuit)
+		{
+			promise<string> reply;
+			reply.set_exception(make_exception_ptr(runtime_error("SCPI transport closed before reply was received")));
+			return reply.get_future();
+		}
+		if(!m_asyncThread.joinable())
+			m_asyncThread = thread(&SCPITransport::AsyncReplyThread, this);
+
+		m_pendingReplies.emplace_back(endOnSemicolon);
+		ret = m_pendingReplies.back().m_reply.get_future();
+	}
+	m_asyncCond.notify_all();
+
+	return ret;
+}
+
+/**
+	@brief Blocks until responses to all queries sent by SendCommandAsyncWithReply() have been read
+
+	Outstanding replies are read on the calling thread rather than waiting for the reader thread to get to them.
+	Takes the network mutex, so no new asynchronous queries can be sent in the meantime.
+ */
+void SCPITransport::WaitForAsyncReplies()
+{
+	lock_guard<recursive_mutex> lock(m_netMutex);
+	while(ReadNextAsyncReply())
+	{}
+}
+
+/**
+	@brief Reads the response to the oldest outstanding asynchronous query, if there is one
+
+	The caller must hold the network mutex.
+
+	@return False if no asynchronous queries were outstanding
+ */
+bool SCPITransport::ReadNextAsyncReply()
+{
+	PendingReply pending(true);
+	{
+		lock_guard<mutex> lock(m_asyncMutex);
+		if(m_pendingReplies.empty())
+			return false;
+		pending = std::move(m_pendingReplies.front());
+		m_pendingReplies.pop_front();
+	}
+
+	pending.m_reply.set_value(ReadReply(pending.m_endOnSemicolon));
+	return true;
+}
+
+/**
+	@brief Reads responses to asynchronous queries in the order they were sent
+ */
+void SCPITransport::AsyncReplyThread()
+{
+	#ifdef __linux__
+	pthread_setname_np(pthread_self(), "SCPIAsyncReply");
+	#endif
+
+	while(true)
+	{
+		{
+			unique_lock<mutex> lock(m_asyncMutex);
+			m_asyncCond.wait(lock, [&]{ return !m_pendingReplies.empty() || m_asyncThreadQuit; });
+			if(m_asyncThreadQuit)
+				break;
+		}
+
+		//A synchronous read may drain the queue while we wait for the network mutex, in which case there's nothing to do
+		lock_guard<recursive_mutex> lock(m_netMutex);
+		ReadNextAsyncReply();
+	}
+}
+
+/**
+	@brief Stops the asynchronous reply thread and fails any queries still waiting for a response
+
+	The thread calls ReadReply(), so transports which support pipelining must call this from their own destructor,
+	before the underlying connection is closed. Calling it more than once is harmless.
+ */
+void SCPITransport::StopAsyncReplyThread()
+{
+	{
+		lock_guard<mutex> lock(m_asyncMutex);
+		m_asyncThreadQuit = true;
+	}
+	m_asyncCond.notify_all();
+	if(m_asyncThread.joinable())
+		m_asyncThread.join();
+
+	//Nobody will ever read these responses, so don't leave callers blocked on the futures forever
+	deque<PendingReply> orphans;
+	{
+		lock_guard<mutex> lock(m_asyncMutex);
+		orphans.swap(m_pendingReplies);
+	}
+	for(auto& pending : orphans)
+	{
+		pending.m_reply.set_exception(
+			make_exception_ptr(runtime_error("SCPI transport closed before reply was received")));
+	}
+}
+
 /**
 	@brief Sends a command (jumping ahead of the queue) which does not require a response.
  */
@@ -251,6 +446,7 @@ void SCPITransport::SendCommandImmediate(const string& cmd)
 void* SCPITransport::SendCommandImmediateWithRawBlockReply(const string& cmd, size_t& len)
 {
 	lock_guard<recursive_mutex> lock(m_netMutex);
+	WaitForAsyncReplies();
 
 	if(m_rateLimitingEnabled)
 		RateLimitingWait();
@@ -38,6 +38,9 @@
 #define SCPITransport_h
 
 #include <chrono>
+#include <unordered_map>
+#include <future>
+#include <condition_variable>
 
 struct TransportEndpoint
 {
@@ -75,8 +78,22 @@ public:
 	void SendCommandImmediate(const std::string& cmd);
 	std::string SendCommandImmediateWithReply(const std::string& cmd, bool endOnSemicolon = true);
 	void* SendCommandImmediateWithRawBlockReply(const std::string& cmd, size_t& len);
+	std::vector<std::string> SendPipelinedQueries(const std::vector<std::string>& cmds, bool endOnSemicolon = true);
 	bool FlushCommandQueue();
 
+	/*
+		Asynchronous query API
+
+		Queries are sent immediately (after flushing the queue) and their responses are read by a background thread
+		in FIFO order, so many queries can be in flight at once. The reader thread holds the network mutex for each
+		read. Every synchronous API call which reads from the instrument drains outstanding asynchronous replies
+		first. Code which calls ReadRawData() etc. directly under GetMutex() must call WaitForAsyncReplies() itself.
+
+		On transports which don't support pipelining, the query is done synchronously and a ready future returned.
+	 */
+	std::future<std::string> SendCommandAsyncWithReply(const std::string& cmd, bool endOnSemicolon = true);
+	void WaitForAsyncReplies();
+
 	//Manual mutex locking for ReadRawData() etc
 	std::recursive_mutex& GetMutex()
 	{ return m_netMutex; }
@@ -84,6 +101,7 @@ public:
 	//Immediate command API
 	virtual void FlushRXBuffer(void);
 	virtual bool SendCommand(const std::string& cmd) =0;
+	virtual bool SendCommandBatch(const std::vector<std::string>& cmds);
 	virtual std::string ReadReply(bool endOnSemicolon = true, std::function<void(float)> progress = nullptr) =0;
 	virtual size_t ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr) =0;
 	virtual void SendRawData(size_t len, const unsigned char* buf) =0;
@@ -91,6 +109,23 @@ public:
 	virtual bool IsCommandBatchingSupported() =0;
 	virtual bool IsConnected() =0;
 
+	/**
+		@brief Hints how large the reply currently being waited for may be, in bytes
+
+		Only matters for transports which must provide room for a whole reply up front (e.g. VXI-11), so the default
+		implementation does nothing. It can only enlarge the transport's own default receive size, never shrink it.
+	 */
+	virtual void SetExpectedReplySize([[maybe_unused]] size_t len)
+	{}
+
+	/**
+		@brief Checks if the transport can have more than one query outstanding at a time
+
+		True for plain byte stream transports, where responses simply arrive in the order queries were sent.
+	 */
+	virtual bool IsQueryPipeliningSupported()
+	{ return false; }
+
 	/**
 		@brief Enables rate limiting. Rate limiting is only applied to the queued command API.
 
@@ -142,6 +177,12 @@ public:
 protected:
 	void RateLimitingWait();
 
+	static bool ParseCommandForDeduplication(const std::string& cmd, std::string& subject, std::string& command);
+
+	void AsyncReplyThread();
+	bool ReadNextAsyncReply();
+	void StopAsyncReplyThread();
+
 	//Class enumeration
 	typedef std::map< std::string, CreateProcType > CreateMapType;
 	static CreateMapType m_createprocs;
@@ -157,6 +198,39 @@ protected:
 	//Set of commands that are OK to deduplicate
 	std::set<std::string> m_dedupCommands;
 
+	/**
+		@brief Map of (subject, command) to the queued instance of each deduplicatable command
+
+		Key is the subject and command separated by a newline, which cannot occur in either one.
+	 */
+	std::unordered_map<std::string, std::list<std::string>::iterator> m_dedupQueuePositions;
+
+	///@brief A query sent with SendCommandAsyncWithReply() that we haven't read the response to yet
+	struct PendingReply
+	{
+		PendingReply(bool endOnSemicolon)
+			: m_endOnSemicolon(endOnSemicolon)
+		{}
+
+		std::promise<std::string> m_reply;
+		bool m_endOnSemicolon;
+	};
+
+	///@brief Mutex protecting m_pendingReplies and m_asyncThreadQuit
+	std::mutex m_asyncMutex;
+
+	///@brief Signaled when a reply is queued, or when m_asyncThreadQuit is set
+	std::condition_variable m_asyncCond;
+
+	///@brief Outstanding asynchronous queries, oldest first. Only popped by a reader holding the network mutex.
+	std::deque<PendingReply> m_pendingReplies;
+
+	///@brief Thread reading asynchronous replies, started on first use
+	std::thread m_asyncThread;
+
+	///@brief Set to stop m_asyncThread
+	bool m_asyncThreadQuit;
+
 	//Rate limiting (send max of one command per X time)
 	bool m_rateLimitingEnabled;
 	std::chrono::system_clock::time_point m_nextCommandReady;
@@ -72,6 +72,8 @@ SCPITwinLanTransport::SCPITwinLanTransport(const string& args)
 
 SCPITwinLanTransport::~SCPITwinLanTransport()
 {
+	//Must be gone before the connection is closed
+	StopAsyncReplyThread();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
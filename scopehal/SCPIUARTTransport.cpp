@@ -77,6 +77,8 @@ SCPIUARTTransport::SCPIUARTTransport(const string& args)
 
 SCPIUARTTransport::~SCPIUARTTransport()
 {
+	//Must be gone before the connection is closed
+	StopAsyncReplyThread();
 }
 
 bool SCPIUARTTransport::IsConnected()
@@ -109,21 +111,36 @@ bool SCPIUARTTransport::SendCommand(const string& cmd)
 	return m_uart.Write((unsigned char*)tempbuf.c_str(), tempbuf.length());
 }
 
-string SCPIUARTTransport::ReadReply(bool endOnSemicolon, [[maybe_unused]] function<void(float)> progress)
+/**
+	@brief Sends several commands in a single write
+ */
+bool SCPIUARTTransport::SendCommandBatch(const vector<string>& cmds)
 {
-	//FIXME: there *has* to be a more efficient way to do this...
-	// (see the same code in Socket)
-	char tmp = ' ';
-	string ret;
-	while(true)
+	size_t len = 0;
+	for(auto& cmd : cmds)
+		len += cmd.length() + 1;
+
+	string tempbuf;
+	tempbuf.reserve(len);
+	for(auto& cmd : cmds)
 	{
-		if(!m_uart.Read((unsigned char*)&tmp, 1))
-			break;
-		if( (tmp == '\n') || ( (tmp == ';') && endOnSemicolon ) )
-			break;
-		else
-			ret += tmp;
+		LogTrace("Sending %s\n", cmd.c_str());
+		tempbuf += cmd;
+		tempbuf += '\n';
 	}
+	return m_uart.Write((unsigned char*)tempbuf.c_str(), tempbuf.length());
+}
+
+string SCPIUARTTransport::ReadReply(bool endOnSemicolon, [[maybe_unused]] function<void(float)> progress)
+{
+	//Take whatever the driver has ready in one call and split the reply out of the buffer. Anything past the
+	//delimiter (e.g. the next pipelined reply) stays buffered for the next read.
+	string ret;
+	m_rxBuffer.ReadLine(ret, endOnSemicolon, 4096, [&](unsigned char* buf, size_t len)
+		{
+			int n = m_uart.PartialRead(buf, len);
+			return (n > 0) ? static_cast<size_t>(n) : 0;
+		});
 	LogTrace("Got %s\n", ret.c_str());
 	return ret;
 }
@@ -146,7 +163,10 @@ size_t SCPIUARTTransport::ReadRawData(size_t len, unsigned char* buf, std::funct
 			chunk_size = 2;	// Always read at least 2 bytes at once since one single byte can block on Windows system
 	}
 
-	for (size_t pos = 0; pos < len; )
+	//Anything left over in the line buffer goes first
+	size_t pos = m_rxBuffer.Read(buf, len);
+
+	while(pos < len)
 	{
 		size_t n = chunk_size;
 		if (n > (len - pos))
@@ -52,6 +52,7 @@ public:
 	virtual std::string GetConnectionString() override;
 
 	virtual bool SendCommand(const std::string& cmd) override;
+	virtual bool SendCommandBatch(const std::vector<std::string>& cmds) override;
 	virtual std::string ReadReply(bool endOnSemicolon = true, std::function<void(float)> progress = nullptr) override;
 	virtual size_t ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr) override;
 	virtual void SendRawData(size_t len, const unsigned char* buf) override;
@@ -59,6 +60,9 @@ public:
 	virtual bool IsCommandBatchingSupported() override;
 	virtual bool IsConnected() override;
 
+	virtual bool IsQueryPipeliningSupported() override
+	{ return true; }
+
 	virtual bool SetTimeouts(unsigned int txUs, unsigned int rxUs) override;
 
 	//This is intentionally not virtual since it's a static method used by enumeration
@@ -74,6 +78,9 @@ public:
 protected:
 	UART m_uart;
 
+	///@brief Receive buffer for ReadReply()
+	SCPIReadBuffer m_rxBuffer;
+
 	std::string m_devfile;
 	unsigned int m_baudrate;
 	bool m_dtrEnable;
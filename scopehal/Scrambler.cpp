@@ -0,0 +1,118 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of AdditiveScrambler
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "Scrambler.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a scrambler and builds its 64-step jump tables
+
+	@param width	Number of bits in the LFSR, in [1, 64]
+	@param poly		Feedback polynomial, without the x^width term (e.g. 0x210125 for the 23-bit PCIe gen3 LFSR)
+ */
+AdditiveScrambler::AdditiveScrambler(unsigned int width, uint64_t poly)
+	: m_width(width)
+	, m_poly(poly)
+{
+	m_mask = (width == 64) ? ~0ULL : ( (1ULL << width) - 1);
+
+	size_t nbytes = (width + 7) / 8;
+	m_nextState.resize(nbytes * 256);
+	m_output.resize(nbytes * 256);
+	for(size_t i=0; i<nbytes; i++)
+	{
+		for(uint64_t v=0; v<256; v++)
+		{
+			uint64_t state = (v << (i*8)) & m_mask;
+			m_output[i*256 + v] = StepSerial(state, 64);
+			m_nextState[i*256 + v] = state;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Scrambling
+
+/**
+	@brief Runs the LFSR one bit at a time, returning the output bits with the first one in the LSB
+
+	Only used to build the jump tables.
+ */
+uint64_t AdditiveScrambler::StepSerial(uint64_t& state, size_t nbits) const
+{
+	uint64_t ret = 0;
+	for(size_t j=0; j<nbits; j++)
+	{
+		bool msb = (state >> (m_width - 1)) & 1;
+		state = (state << 1) & m_mask;
+		if(msb)
+		{
+			state ^= m_poly;
+			ret |= (1ULL << j);
+		}
+	}
+	return ret;
+}
+
+/**
+	@brief Advances the LFSR by 64 bits
+
+	Bits of the state above the LFSR width are ignored.
+
+	@param state	LFSR state, updated in place
+
+	@return The 64 output bits, with the first one in the LSB. Byte k of the return value is the scrambler output for
+			the k'th byte after the starting state.
+ */
+uint64_t AdditiveScrambler::Next64(uint64_t& state) const
+{
+	uint64_t s = state & m_mask;
+	uint64_t out = 0;
+	uint64_t next = 0;
+	size_t nbytes = m_nextState.size() / 256;
+	for(size_t i=0; i<nbytes; i++)
+	{
+		size_t index = i*256 + ( (s >> (i*8)) & 0xff );
+		out ^= m_output[index];
+		next ^= m_nextState[index];
+	}
+	state = next;
+	return out;
+}
@@ -0,0 +1,143 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SelfSyncDescrambler and AdditiveScrambler
+	@ingroup core
+ */
+#ifndef Scrambler_h
+#define Scrambler_h
+
+#include <vector>
+#include <cstdint>
+
+/**
+	@brief Word-parallel descrambler for a self-synchronizing scrambler of the form 1 + x^a + x^b
+
+	Each output bit is the received bit XORed with the received bits a and b positions earlier, so 64 bits can be
+	descrambled at once from the current and previous received words with a few shifts. Bits are in transmission order
+	starting from the LSB.
+
+	Since the state is just the previous received word, any word can be descrambled independently of the others as long
+	as its predecessor is known. This allows long captures to be processed in parallel.
+
+	@ingroup core
+ */
+class SelfSyncDescrambler
+{
+public:
+	/**
+		@brief Creates a descrambler for the polynomial 1 + x^a + x^b
+
+		@param a	First tap, in [1, 63]
+		@param b	Second tap, in [1, 63]
+	 */
+	SelfSyncDescrambler(unsigned int a, unsigned int b)
+		: m_tapA(a)
+		, m_tapB(b)
+		, m_last(0)
+	{}
+
+	/**
+		@brief Descrambles one word given the word received before it
+
+		@param prev	Previous 64 received (scrambled) bits
+		@param in	Current 64 received bits
+	 */
+	uint64_t Descramble(uint64_t prev, uint64_t in) const
+	{
+		return in ^
+			( (in << m_tapA) | (prev >> (64 - m_tapA)) ) ^
+			( (in << m_tapB) | (prev >> (64 - m_tapB)) );
+	}
+
+	///@brief Descrambles the next word of the stream
+	uint64_t Descramble(uint64_t in)
+	{
+		uint64_t ret = Descramble(m_last, in);
+		m_last = in;
+		return ret;
+	}
+
+protected:
+	///@brief First tap position
+	unsigned int m_tapA;
+
+	///@brief Second tap position
+	unsigned int m_tapB;
+
+	///@brief Last word received
+	uint64_t m_last;
+};
+
+/**
+	@brief Word-parallel engine for an additive (synchronous) scrambler built from a Galois LFSR
+
+	Each step outputs the MSB of the state, shifts the state left by one, and XORs in the feedback polynomial if the
+	output bit was set.
+
+	Both the state after 64 steps and the 64 output bits are linear functions of the starting state, so they're
+	precomputed for every value of each byte of the state. Advancing by 64 bits then takes one table lookup per state
+	byte instead of 64 iterations of the LFSR.
+
+	@ingroup core
+ */
+class AdditiveScrambler
+{
+public:
+	AdditiveScrambler(unsigned int width, uint64_t poly);
+
+	uint64_t Next64(uint64_t& state) const;
+
+	///@brief Returns the mask of valid bits in the state
+	uint64_t GetStateMask() const
+	{ return m_mask; }
+
+protected:
+	uint64_t StepSerial(uint64_t& state, size_t nbits) const;
+
+	///@brief Number of bits in the LFSR
+	unsigned int m_width;
+
+	///@brief Feedback polynomial, without the x^width term
+	uint64_t m_poly;
+
+	///@brief Mask of valid bits in the state
+	uint64_t m_mask;
+
+	///@brief State 64 steps later, for each byte of the state (indexed by byte*256 + value)
+	std::vector<uint64_t> m_nextState;
+
+	///@brief Output of the next 64 steps, for each byte of the state (indexed by byte*256 + value)
+	std::vector<uint64_t> m_output;
+};
+
+#endif
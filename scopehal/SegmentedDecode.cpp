@@ -0,0 +1,267 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of SegmentedDecode
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "SegmentedDecode.h"
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Segmentation
+
+/**
+	@brief Returns the number of segments a capture of the given length should be split into for decoding
+
+	Returns 1 if the capture is too small to be worth decoding in parallel.
+ */
+size_t SegmentedDecode::GetSegmentCount(size_t len)
+{
+	return ParallelTuning::GetSplit(ParallelTuning::KERNEL_THRESHOLD, len, 1, m_sampleWeight).m_numBlocks;
+}
+
+/**
+	@brief Splits a digital capture into segments separated by long idle periods
+
+	Split points are placed a fixed time into idle runs of at least a minimum length, so the decoder has time to finish
+	whatever frame preceded the idle period before the next segment starts. Captures too small to benefit, or without
+	any idle runs long enough, come back as a single segment.
+
+	@param sdin		Input waveform, if sparse
+	@param udin		Input waveform, if uniform
+	@param idle		Logic level of the idle line
+	@param minIdle	Minimum length of an idle run to split in, in input timebase units
+	@param guard	Time from the start of the idle run to the split point, in input timebase units
+
+	@return Segments covering the whole capture, in order
+ */
+vector<SegmentedDecode::Segment> SegmentedDecode::FindIdleSegments(
+	SparseDigitalWaveform* sdin,
+	UniformDigitalWaveform* udin,
+	bool idle,
+	int64_t minIdle,
+	int64_t guard)
+{
+	size_t len = sdin ? sdin->size() : udin->size();
+	size_t count = GetSegmentCount(len);
+
+	//Look for one split point in each evenly spaced window.
+	//Windows with no usable idle run don't get a split, and their neighbors grow to cover them.
+	vector<size_t> splits(count, len);
+	#pragma omp parallel for if(count > 2)
+	for(size_t i=1; i<count; i++)
+		splits[i] = FindIdleSplit(sdin, udin, (i * len) / count, ((i+1) * len) / count, idle, minIdle, guard);
+
+	vector<Segment> ret;
+	size_t start = 0;
+	for(size_t i=1; i<count; i++)
+	{
+		if( (splits[i] <= start) || (splits[i] >= len) )
+			continue;
+
+		ret.push_back(Segment{start, splits[i]});
+		start = splits[i];
+	}
+	ret.push_back(Segment{start, len});
+
+	if(ret.size() > 1)
+		LogTrace("Split %zu samples into %zu segments for decoding\n", len, ret.size());
+
+	return ret;
+}
+
+/**
+	@brief Finds the first split point in an idle run starting in [i, end)
+
+	@return Index of the split sample, or the length of the waveform if there isn't one
+ */
+size_t SegmentedDecode::FindIdleSplit(
+	SparseDigitalWaveform* sdin,
+	UniformDigitalWaveform* udin,
+	size_t i,
+	size_t end,
+	bool idle,
+	int64_t minIdle,
+	int64_t guard)
+{
+	size_t len = sdin ? sdin->size() : udin->size();
+
+	while(i < end)
+	{
+		//Find the start of the next idle run, then its end (which may be beyond the window)
+		size_t runstart = FindNextValue(sdin, udin, i, end, idle);
+		if(runstart >= end)
+			break;
+		size_t runend = FindNextValue(sdin, udin, runstart, len, !idle);
+
+		int64_t tstart = ::GetOffset(sdin, udin, runstart);
+		int64_t tend;
+		if(runend < len)
+			tend = ::GetOffset(sdin, udin, runend);
+		else
+			tend = ::GetOffset(sdin, udin, len-1) + ::GetDuration(sdin, udin, len-1);
+
+		if( (tend - tstart) >= minIdle)
+		{
+			//Split on the first sample at least the guard time into the run
+			int64_t tsplit = tstart + guard;
+			size_t split;
+			if(udin)
+				split = runstart + guard;
+			else
+			{
+				split = runstart;
+				while( (split < runend) && (sdin->m_offsets[split] < tsplit) )
+					split ++;
+			}
+
+			if(split < runend)
+				return split;
+		}
+
+		i = runend;
+	}
+
+	return len;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Searching
+
+/**
+	@brief Finds the sample a decoder stepping through events with Filter::AdvanceToTimestampScaled() would be on
+
+	Gives the same index as calling AdvanceToTimestampScaled() starting from sample 0, without the linear scan, so
+	decoders working in the time domain can start a segment in the middle of a waveform.
+
+	@param wfm			The waveform
+	@param len			Number of samples in the waveform
+	@param timestamp	Time to seek to, in X axis units
+ */
+size_t SegmentedDecode::GetIndexAtTimestampScaled(SparseWaveformBase* wfm, size_t len, int64_t timestamp)
+{
+	timestamp -= wfm->m_triggerPhase;
+
+	auto offsets = wfm->m_offsets.GetCpuPointer();
+	auto timescale = wfm->m_timescale;
+	auto it = upper_bound(offsets, offsets + len, timestamp,
+		[timescale](int64_t t, int64_t off) { return t < off * timescale; });
+
+	size_t i = it - offsets;
+	if(i == 0)
+		return 0;
+	return i - 1;
+}
+
+/**
+	@brief Finds the sample a decoder stepping through events with Filter::AdvanceToTimestampScaled() would be on
+
+	@param wfm			The waveform
+	@param len			Number of samples in the waveform
+	@param timestamp	Time to seek to, in X axis units
+ */
+size_t SegmentedDecode::GetIndexAtTimestampScaled(UniformWaveformBase* wfm, size_t len, int64_t timestamp)
+{
+	timestamp -= wfm->m_triggerPhase;
+	if( (timestamp <= 0) || (len == 0) )
+		return 0;
+
+	return min(static_cast<size_t>(timestamp / wfm->m_timescale), len - 1);
+}
+
+
+/**
+	@brief Finds the first sample in [i, end) with a given value
+
+	@return Index of the sample, or end if there is none
+ */
+size_t SegmentedDecode::FindNextValue(
+	SparseDigitalWaveform* sdin,
+	UniformDigitalWaveform* udin,
+	size_t i,
+	size_t end,
+	bool value)
+{
+	if(udin)
+	{
+		auto samples = udin->m_samples.GetCpuPointer();
+
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			return FindNextValueAVX2(samples, i, end, value);
+		#endif
+
+		for(; i<end; i++)
+		{
+			if(samples[i] == value)
+				return i;
+		}
+		return end;
+	}
+
+	for(; i<end; i++)
+	{
+		if(sdin->m_samples[i] == value)
+			return i;
+	}
+	return end;
+}
+
+#ifdef __x86_64__
+/**
+	@brief Finds the first sample in [i, end) with a given value, checking 32 samples at a time
+ */
+__attribute__((target("avx2")))
+size_t SegmentedDecode::FindNextValueAVX2(const bool* samples, size_t i, size_t end, bool value)
+{
+	__m256i target = _mm256_set1_epi8(value ? 1 : 0);
+	for(; i+32 <= end; i += 32)
+	{
+		__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i));
+		uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, target));
+		if(mask)
+			return i + __builtin_ctz(mask);
+	}
+
+	for(; i<end; i++)
+	{
+		if(samples[i] == value)
+			return i;
+	}
+	return end;
+}
+#endif
@@ -0,0 +1,263 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2026 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SegmentedDecode and SegmentSymbols
+	@ingroup core
+ */
+#ifndef SegmentedDecode_h
+#define SegmentedDecode_h
+
+#include "PacketDecoder.h"
+
+/**
+	@brief Symbols and packets produced by decoding one segment of a capture
+
+	Member names match SparseWaveform so decoder loops can write to either with the same code.
+
+	Packets in m_packets are owned by this object until handed over with Append() or Commit().
+
+	@ingroup core
+ */
+template<class S>
+class SegmentSymbols
+{
+public:
+	SegmentSymbols()
+	{}
+
+	~SegmentSymbols()
+	{ Clear(); }
+
+	SegmentSymbols(const SegmentSymbols&) = delete;
+	SegmentSymbols& operator=(const SegmentSymbols&) = delete;
+
+	///@brief Discard all symbols and free all packets
+	void Clear()
+	{
+		for(auto p : m_packets)
+			delete p;
+		m_packets.clear();
+
+		m_offsets.clear();
+		m_durations.clear();
+		m_samples.clear();
+	}
+
+	///@brief Moves the contents of another segment onto the end of this one
+	void Append(SegmentSymbols<S>& rhs)
+	{
+		m_offsets.insert(m_offsets.end(), rhs.m_offsets.begin(), rhs.m_offsets.end());
+		m_durations.insert(m_durations.end(), rhs.m_durations.begin(), rhs.m_durations.end());
+		m_samples.insert(m_samples.end(), rhs.m_samples.begin(), rhs.m_samples.end());
+		m_packets.insert(m_packets.end(), rhs.m_packets.begin(), rhs.m_packets.end());
+
+		rhs.m_packets.clear();
+		rhs.Clear();
+	}
+
+	/**
+		@brief Copies the symbols to an output waveform and hands the packets over to a decoder
+
+		@param cap		Waveform to write symbols to (any existing content is replaced)
+		@param packets	Packet list to append packets to
+	 */
+	void Commit(SparseWaveform<S>* cap, std::vector<Packet*>& packets)
+	{
+		Commit(cap);
+
+		packets.insert(packets.end(), m_packets.begin(), m_packets.end());
+		m_packets.clear();
+	}
+
+	/**
+		@brief Copies the symbols to an output waveform, for decoders which do not produce packets
+
+		@param cap		Waveform to write symbols to (any existing content is replaced)
+	 */
+	void Commit(SparseWaveform<S>* cap)
+	{
+		size_t len = m_samples.size();
+		cap->Resize(len);
+		if(len)
+		{
+			memcpy(cap->m_offsets.GetCpuPointer(), m_offsets.data(), len * sizeof(int64_t));
+			memcpy(cap->m_durations.GetCpuPointer(), m_durations.data(), len * sizeof(int64_t));
+			std::copy(m_samples.begin(), m_samples.end(), cap->m_samples.GetCpuPointer());
+		}
+
+		cap->MarkModifiedFromCpu();
+	}
+
+	///@brief Start time of each symbol, in input timebase units
+	std::vector<int64_t> m_offsets;
+
+	///@brief Duration of each symbol, in input timebase units
+	std::vector<int64_t> m_durations;
+
+	///@brief Symbol values
+	std::vector<S> m_samples;
+
+	///@brief Packets completed in this segment
+	std::vector<Packet*> m_packets;
+};
+
+/**
+	@brief Helpers for running a serial protocol decoder on several parts of a capture at once
+
+	Most serial protocols have points where a receiver resynchronizes from scratch: long idle periods on a UART line,
+	bus idle after a CAN frame, a STOP condition on I2C. A decoder splits the capture at such points, decodes each
+	segment on its own thread, then stitches symbols and packets back together in order.
+
+	Splitting only at points where the decoder is normally idle is not enough on its own to give identical output, since
+	a corrupted or unusual capture can leave the decoder mid-frame at a split. So each segment other than the first
+	starts from a guess at the decoder state, and Run() checks every guess against the real state at the end of the
+	previous segment. Segments that guessed wrong are decoded again serially from the real state.
+
+	A decoder's state type must provide:
+	* bool Matches(const State& entry) const: true if decoding onward from this state gives the same output as
+	  decoding from entry
+	* void Discard(): frees anything owned by a state which is being thrown away
+
+	@ingroup core
+ */
+class SegmentedDecode
+{
+public:
+
+	///@brief A range of input samples decoded as one unit
+	struct Segment
+	{
+		///@brief Index of the first sample
+		size_t m_start;
+
+		///@brief Index one past the last sample
+		size_t m_end;
+	};
+
+	static size_t GetSegmentCount(size_t len);
+
+	static std::vector<Segment> FindIdleSegments(
+		SparseDigitalWaveform* sdin,
+		UniformDigitalWaveform* udin,
+		bool idle,
+		int64_t minIdle,
+		int64_t guard);
+
+	static size_t FindNextValue(
+		SparseDigitalWaveform* sdin,
+		UniformDigitalWaveform* udin,
+		size_t i,
+		size_t end,
+		bool value);
+
+	///@brief Finds the first sample in [i, end) of a sparse waveform with a given value
+	static size_t FindNextValue(SparseDigitalWaveform* wfm, size_t i, size_t end, bool value)
+	{ return FindNextValue(wfm, nullptr, i, end, value); }
+
+	///@brief Finds the first sample in [i, end) of a uniform waveform with a given value
+	static size_t FindNextValue(UniformDigitalWaveform* wfm, size_t i, size_t end, bool value)
+	{ return FindNextValue(nullptr, wfm, i, end, value); }
+
+	static size_t GetIndexAtTimestampScaled(SparseWaveformBase* wfm, size_t len, int64_t timestamp);
+	static size_t GetIndexAtTimestampScaled(UniformWaveformBase* wfm, size_t len, int64_t timestamp);
+
+	/**
+		@brief Decodes a set of segments in parallel and stitches the results back together in order
+
+		The output is always identical to decoding the whole capture in one pass.
+
+		@param entries	Starting state for each segment. Element 0 is the decoder's real initial state, the rest are
+						guesses at the state the decoder will be in at the start of that segment.
+		@param result	Output for the whole capture
+		@param decode	Called as decode(size_t segment, State& state, Output& out). Decodes one segment starting from
+						state, appends symbols and packets to out, and leaves state as it was at the end of the segment.
+						Calls for different segments run concurrently.
+
+		@return Decoder state at the end of the last segment
+	 */
+	template<class State, class Output, class DecodeFunc>
+	static State Run(const std::vector<State>& entries, Output& result, DecodeFunc decode)
+	{
+		size_t count = entries.size();
+		std::vector<State> exits(entries);
+		std::vector<Output> outputs(count);
+
+		#pragma omp parallel for schedule(dynamic, 1) if(count > 1)
+		for(size_t i=0; i<count; i++)
+		{
+			if(i == 0)
+				decode(i, exits[i], result);
+			else
+				decode(i, exits[i], outputs[i]);
+		}
+
+		//Stitch in order, redoing any segment whose starting state guess was wrong
+		State state = exits[0];
+		for(size_t i=1; i<count; i++)
+		{
+			if(state.Matches(entries[i]))
+			{
+				result.Append(outputs[i]);
+				state = exits[i];
+			}
+			else
+			{
+				LogTrace("Segment %zu did not start in the expected state, decoding it again\n", i);
+
+				exits[i].Discard();
+				outputs[i].Clear();
+				decode(i, state, result);
+			}
+		}
+
+		return state;
+	}
+
+protected:
+	static size_t FindIdleSplit(
+		SparseDigitalWaveform* sdin,
+		UniformDigitalWaveform* udin,
+		size_t i,
+		size_t end,
+		bool idle,
+		int64_t minIdle,
+		int64_t guard);
+
+#ifdef __x86_64__
+	static size_t FindNextValueAVX2(const bool* samples, size_t i, size_t end, bool value);
+#endif
+
+	///@brief Cost of decoding one sample relative to the ParallelTuning threshold kernel
+	static constexpr size_t m_sampleWeight = 8;
+};
+
+#endif
@@ -35,9 +35,14 @@
  */
 #include "scopehal.h"
 #include "ShaderBaker.h"
+#include "PipelineCacheManager.h"
+#include <glslang_c_interface.h>
 
 using namespace std;
 
+mutex ShaderBaker::m_cacheMutex;
+map<string, shared_ptr<vector<uint32_t> > > ShaderBaker::m_compiledCache;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -45,11 +50,41 @@ ShaderBaker::ShaderBaker()
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+/**
+	@brief Returns the number of input buffers used by the baked shader
+ */
+size_t ShaderBaker::GetNumInputBuffers()
+{
+	int ret = 0;
+	for(auto& stage : m_stages)
+	{
+		for(auto i : stage->m_inputs)
+			ret = max(ret, i + 1);
+	}
+	return ret;
+}
+
+/**
+	@brief Returns the size of the push constants used by the baked shader, in bytes
+ */
+size_t ShaderBaker::GetPushConstantSize()
+{
+	size_t words = 1;
+	for(auto& stage : m_stages)
+		words += stage->m_shader->m_pushConstants.size();
+	return words * sizeof(uint32_t);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual baking logic
 
 string ShaderBaker::Bake()
 {
+	bool int8Output = !m_stages.empty() && (m_stages.back()->m_shader->m_outputType == "uint8_t");
+
 	//Generate the output shader
 	string ret;
 	ret += "//Baked shader\n";
@@ -65,24 +100,215 @@ string ShaderBaker::Bake()
 		for(auto& ext : stage->m_shader->m_extensions)
 			combinedExtensions.emplace(ext);
 	}
+	if(int8Output)
+		combinedExtensions.emplace("GL_EXT_shader_8bit_storage");
 	for(auto& ext : combinedExtensions)
 		ret += string("#extension ") + ext + " : require\n";
 
+	//SSBO output
+	ret += "\n";
+	ret += "layout(std430, binding=0) restrict writeonly buffer buf_dout\n";
+	ret += "{\n";
+	ret += string("\t") + (int8Output ? "uint8_t" : "float") + " dout[];\n";
+	ret += "};\n";
+
 	//SSBO inputs
+	auto nin = GetNumInputBuffers();
+	for(size_t i=0; i<nin; i++)
+	{
+		auto si = to_string(i);
+		ret += "\n";
+		ret += string("layout(std430, binding=") + to_string(i+1) + ") restrict readonly buffer buf_in" + si + "\n";
+		ret += "{\n";
+		ret += string("\tfloat in") + si + "[];\n";
+		ret += "};\n";
+	}
+
+	//Push constants, prefixed with the stage number to keep them unique
+	ret += "\n";
+	ret += "layout(std430, push_constant) uniform constants\n";
+	ret += "{\n";
+	ret += "\tuint size;\n";
+	for(size_t i=0; i<m_stages.size(); i++)
+	{
+		for(auto& pc : m_stages[i]->m_shader->m_pushConstants)
+			ret += string("\t") + pc.m_type + " stage" + to_string(i) + "_" + pc.m_name + ";\n";
+	}
+	ret += "};\n";
+	ret += "\n";
+	ret += "layout(local_size_x=64, local_size_y=1, local_size_z=1) in;\n";
 
 	//The actual shader kernels
 	for(size_t i=0; i<m_stages.size(); i++)
 	{
 		ret += "\n\n";
 
-		ret += string("//BEGIN SHADER BLOCK ") + to_string(i) + "\n";
+		ret += string("//BEGIN SHADER BLOCK ") + to_string(i) + " (" + m_stages[i]->m_shader->m_name + ")\n";
 
 		string kernelName = string("shaderKernel_stage") + to_string(i);
-		ret += str_replace("__kernel__", kernelName, m_stages[i]->m_shader->m_glslSource);
+		string pushPrefix = string("stage") + to_string(i) + "_";
+		ret += str_replace("__push__", pushPrefix,
+			str_replace("__kernel__", kernelName, m_stages[i]->m_shader->m_glslSource));
 
 		ret += string("//END SHADER BLOCK ") + to_string(i) + "\n";
-		ret += "\n\n";
 	}
 
+	//Main function: evaluate each stage in turn
+	ret += "\n\n";
+	ret += "void main()\n";
+	ret += "{\n";
+	ret += "\tuint i = (gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x) + gl_GlobalInvocationID.x;\n";
+	ret += "\tif(i >= size)\n";
+	ret += "\t\treturn;\n";
+	ret += "\n";
+	for(size_t i=0; i<m_stages.size(); i++)
+	{
+		string args;
+		for(auto in : m_stages[i]->m_inputs)
+		{
+			if(!args.empty())
+				args += ", ";
+
+			if(in >= 0)
+				args += string("in") + to_string(in) + "[i]";
+			else if(i > 0)
+				args += string("v") + to_string(i-1);
+			else
+			{
+				LogError("ShaderBaker: first stage cannot use the output of a previous stage\n");
+				args += "0";
+			}
+		}
+
+		ret += string("\tfloat v") + to_string(i) + " = shaderKernel_stage" + to_string(i) + "(" + args + ");\n";
+	}
+	if(!m_stages.empty())
+	{
+		auto vlast = string("v") + to_string(m_stages.size() - 1);
+		if(int8Output)
+			ret += string("\tdout[i] = uint8_t(uint(") + vlast + "));\n";
+		else
+			ret += string("\tdout[i] = ") + vlast + ";\n";
+	}
+	ret += "}\n";
+
+	return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Compilation
+
+/**
+	@brief Gets a unique name for a baked shader, used as the key for the pipeline cache
+
+	@param source	GLSL source code, as returned by Bake()
+ */
+string ShaderBaker::GetCacheKey(const string& source)
+{
+	char key[64];
+	snprintf(key, sizeof(key), "FusedShader_%016zx_%zu", hash<string>{}(source), source.size());
+	return key;
+}
+
+/**
+	@brief Compiles a baked shader to SPIR-V
+
+	Results are cached in memory, and in the pipeline cache so they persist across sessions.
+
+	@param source	GLSL source code, as returned by Bake()
+
+	@return SPIR-V binary, or nullptr on failure
+ */
+shared_ptr<vector<uint32_t> > ShaderBaker::Compile(const string& source)
+{
+	lock_guard<mutex> lock(m_cacheMutex);
+
+	//Already compiled this session?
+	auto it = m_compiledCache.find(source);
+	if(it != m_compiledCache.end())
+		return it->second;
+
+	//Compiled in a previous session?
+	auto key = GetCacheKey(source);
+	auto blob = g_pipelineCacheMgr->LookupRaw(key);
+	if(blob && !blob->empty() && ( (blob->size() % sizeof(uint32_t)) == 0) )
+	{
+		auto ret = make_shared<vector<uint32_t> >(blob->size() / sizeof(uint32_t));
+		memcpy(ret->data(), blob->data(), blob->size());
+		m_compiledCache[source] = ret;
+		return ret;
+	}
+
+	LogTrace("Compiling fused shader %s\n", key.c_str());
+
+	//Resource limits only matter for compute shader validation
+	glslang_resource_t resources = {};
+	resources.max_compute_work_group_count_x = 65535;
+	resources.max_compute_work_group_count_y = 65535;
+	resources.max_compute_work_group_count_z = 65535;
+	resources.max_compute_work_group_size_x = 1024;
+	resources.max_compute_work_group_size_y = 1024;
+	resources.max_compute_work_group_size_z = 64;
+	resources.max_compute_uniform_components = 1024;
+	resources.max_compute_texture_image_units = 16;
+	resources.max_compute_image_uniforms = 8;
+	resources.max_compute_atomic_counters = 8;
+	resources.max_compute_atomic_counter_buffers = 1;
+	resources.limits.non_inductive_for_loops = true;
+	resources.limits.while_loops = true;
+	resources.limits.do_while_loops = true;
+	resources.limits.general_uniform_indexing = true;
+	resources.limits.general_attribute_matrix_vector_indexing = true;
+	resources.limits.general_varying_indexing = true;
+	resources.limits.general_sampler_indexing = true;
+	resources.limits.general_variable_indexing = true;
+	resources.limits.general_constant_matrix_vector_indexing = true;
+
+	glslang_input_t input = {};
+	input.language = GLSLANG_SOURCE_GLSL;
+	input.stage = GLSLANG_STAGE_COMPUTE;
+	input.client = GLSLANG_CLIENT_VULKAN;
+	input.client_version = GLSLANG_TARGET_VULKAN_1_0;
+	input.target_language = GLSLANG_TARGET_SPV;
+	input.target_language_version = GLSLANG_TARGET_SPV_1_0;
+	input.code = source.c_str();
+	input.default_version = 460;
+	input.default_profile = GLSLANG_NO_PROFILE;
+	input.force_default_version_and_profile = false;
+	input.forward_compatible = false;
+	input.messages = GLSLANG_MSG_DEFAULT_BIT;
+	input.resource = &resources;
+
+	glslang_shader_t* shader = glslang_shader_create(&input);
+	if(!glslang_shader_preprocess(shader, &input) || !glslang_shader_parse(shader, &input))
+	{
+		LogError("Failed to compile fused shader:\n%s\n", glslang_shader_get_info_log(shader));
+		glslang_shader_delete(shader);
+		return nullptr;
+	}
+
+	glslang_program_t* program = glslang_program_create();
+	glslang_program_add_shader(program, shader);
+	if(!glslang_program_link(program, GLSLANG_MSG_SPV_RULES_BIT | GLSLANG_MSG_VULKAN_RULES_BIT))
+	{
+		LogError("Failed to link fused shader:\n%s\n", glslang_program_get_info_log(program));
+		glslang_program_delete(program);
+		glslang_shader_delete(shader);
+		return nullptr;
+	}
+
+	glslang_program_SPIRV_generate(program, GLSLANG_STAGE_COMPUTE);
+	auto ret = make_shared<vector<uint32_t> >(glslang_program_SPIRV_get_size(program));
+	glslang_program_SPIRV_get(program, ret->data());
+
+	glslang_program_delete(program);
+	glslang_shader_delete(shader);
+
+	//Save it for next time
+	auto bytes = make_shared<vector<uint8_t> >(ret->size() * sizeof(uint32_t));
+	memcpy(bytes->data(), ret->data(), bytes->size());
+	g_pipelineCacheMgr->StoreRaw(key, bytes);
+
+	m_compiledCache[source] = ret;
 	return ret;
 }
@@ -48,11 +48,25 @@ public:
 		: m_shader(shader)
 	{}
 
+	///@brief Value in m_inputs indicating the input comes from the output of the previous stage
+	static const int PREVIOUS_STAGE = -1;
+
 	std::shared_ptr<FusibleShader> m_shader;
+
+	/**
+		@brief Source of each kernel input
+
+		Either the index of an input buffer (bound at descriptor 1 + index), or PREVIOUS_STAGE.
+	 */
+	std::vector<int> m_inputs;
 };
 
 /**
 	@brief Takes one or more FusibleShader's and concatenates them into a shader
+
+	The baked shader evaluates each stage in order for one sample per thread. Descriptor 0 is the output buffer
+	and descriptors 1...N are the input buffers. Push constants are a uint sample count followed by the push
+	constants of each stage, in order.
  */
 class ShaderBaker
 {
@@ -63,8 +77,20 @@ public:
 	void AddStage(std::shared_ptr<BakedShaderStage> stage)
 	{ m_stages.push_back(stage); }
 
+	size_t GetNumInputBuffers();
+	size_t GetPushConstantSize();
+
+	static std::shared_ptr<std::vector<uint32_t> > Compile(const std::string& source);
+	static std::string GetCacheKey(const std::string& source);
+
 protected:
 	std::vector< std::shared_ptr<BakedShaderStage> > m_stages;
+
+	///@brief Mutex protecting m_compiledCache
+	static std::mutex m_cacheMutex;
+
+	///@brief SPIR-V for every shader compiled so far, indexed by source
+	static std::map<std::string, std::shared_ptr<std::vector<uint32_t> > > m_compiledCache;
 };
 
 #endif
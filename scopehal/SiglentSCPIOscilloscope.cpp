@@ -1625,6 +1625,10 @@ Oscilloscope::TriggerMode SiglentSCPIOscilloscope::PollTrigger()
 int SiglentSCPIOscilloscope::ReadWaveformBlock(uint32_t maxsize, size_t& readBytes, char* data, bool hdSizeWorkaround, std::function<void(float)> progress)
 {
 	readBytes = 0;
+
+	//Leave room for the reply prefix and block header on transports which receive a whole reply at once
+	m_transport->SetExpectedReplySize(maxsize + 64);
+
 	//Read and discard data until we see the '#'
 	uint8_t tmp;
 	for(int i=0; i<20; i++)
@@ -421,11 +421,10 @@ bool UHDBridgeSDR::AcquireData()
 		//TODO: do this in a shader
 		icap->PrepareForCpuAccess();
 		qcap->PrepareForCpuAccess();
-		for(size_t j=0; j<depth; j++)
-		{
-			icap->m_samples[j] = buf[j*2];
-			qcap->m_samples[j] = buf[j*2 + 1];
-		}
+		float* iq[2] = { icap->m_samples.GetCpuPointer(), qcap->m_samples.GetCpuPointer() };
+		const float gains[2] = { 1, 1 };
+		const float offsets[2] = { 0, 0 };
+		ConvertInterleavedRawSamples(iq, buf, RAW_F32, 2, gains, offsets, depth);
 		icap->MarkSamplesModifiedFromCpu();
 		qcap->MarkSamplesModifiedFromCpu();
 
@@ -194,6 +194,12 @@ bool g_hasShaderAtomicFloat = false;
  */
 bool g_hasShaderAtomicInt64 = false;
 
+/**
+	@brief Indicates whether timeline semaphores are available, allowing asynchronous submission in the filter graph
+	@ingroup vksupport
+ */
+bool g_hasTimelineSemaphore = false;
+
 /**
 	@brief Indicates whether the VK_EXT_debug_utils extension is available
 	@ingroup vksupport
@@ -212,6 +218,21 @@ bool g_hasMemoryBudget = false;
  */
 bool g_hasPushDescriptor = false;
 
+/**
+	@brief Indicates whether the VK_EXT_external_memory_host extension is available
+
+	If so, large pinned buffers are allocated by HostMemoryPolicy and imported, rather than allocated by the driver.
+
+	@ingroup vksupport
+ */
+bool g_hasExternalMemoryHost = false;
+
+/**
+	@brief Required alignment of host pointers imported with VK_EXT_external_memory_host
+	@ingroup vksupport
+ */
+size_t g_vkMinImportedHostPointerAlignment = 4096;
+
 /**
 	@brief Indicates whether the Vulkan device is unified memory
 	@ingroup vksupport
@@ -258,6 +279,15 @@ bool g_vulkanDeviceIsMoltenVK = false;
  */
 bool g_vulkanDeviceIsApplePV = false;
 
+/**
+	@brief Indicates that the Vulkan device is a software implementation running on the CPU (lavapipe, SwiftShader, etc)
+	@ingroup vksupport
+
+	Filters with a native CPU implementation (e.g. FFTs via CPUFFTPlan) should prefer it over dispatching shaders to
+	an emulated GPU.
+ */
+bool g_vulkanDeviceIsSoftware = false;
+
 void VulkanCleanup();
 
 bool VulkanInitInstance(
@@ -670,6 +700,9 @@ void VulkanCreateDevice(
 	auto properties = device.getProperties();
 	g_vkComputeDeviceDriverVer = properties.driverVersion;
 	memcpy(g_vkComputeDeviceUuid, properties.pipelineCacheUUID, 16);
+	g_vulkanDeviceIsSoftware = (properties.deviceType == vk::PhysicalDeviceType::eCpu);
+	if(g_vulkanDeviceIsSoftware)
+		LogDebug("Software Vulkan device, using native CPU implementations where available\n");
 
 	//Detect driver (used by some workarounds for bugs etc)
 	if(vulkan11Available)
@@ -847,6 +880,14 @@ void VulkanCreateDevice(
 				g_hasShaderInt8 = true;
 			}
 
+			//Enable timeline semaphores so filters don't have to block on every submit
+			if(vulkan12Features.timelineSemaphore)
+			{
+				featuresVulkan12.timelineSemaphore = true;
+				LogDebug("Enabling timeline semaphores\n");
+				g_hasTimelineSemaphore = true;
+			}
+
 			featuresVulkan12.pNext = pNext;
 			pNext = &featuresVulkan12;
 		}
@@ -916,6 +957,18 @@ void VulkanCreateDevice(
 			LogDebug("Device has VK_KHR_shader_atomic_int64, requesting it\n");
 		}
 
+		if(!strcmp(&ext.extensionName[0], "VK_EXT_external_memory_host") && hasPhysicalDeviceProperties2)
+		{
+			g_hasExternalMemoryHost = true;
+			LogDebug("Device has VK_EXT_external_memory_host, requesting it\n");
+
+			auto props = device.getProperties2<
+				vk::PhysicalDeviceProperties2,
+				vk::PhysicalDeviceExternalMemoryHostPropertiesEXT>();
+			g_vkMinImportedHostPointerAlignment =
+				props.get<vk::PhysicalDeviceExternalMemoryHostPropertiesEXT>().minImportedHostPointerAlignment;
+		}
+
 		if(!strcmp(&ext.extensionName[0], "VK_EXT_memory_budget"))
 		{
 			if(!hasPhysicalDeviceProperties2)
@@ -943,6 +996,8 @@ void VulkanCreateDevice(
 		devextensions.push_back("VK_EXT_memory_budget");
 	if(g_hasPushDescriptor)
 		devextensions.push_back("VK_KHR_push_descriptor");
+	if(g_hasExternalMemoryHost)
+		devextensions.push_back("VK_EXT_external_memory_host");
 	vk::DeviceCreateInfo devinfo(
 		{},
 		qinfo,
@@ -38,6 +38,10 @@
 #include "Waveform.h"
 #include "Filter.h"
 
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 template<class T>
@@ -331,6 +335,18 @@ uint32_t ColorFromString(const string& str, unsigned int alpha)
 	return (b << IM_COL32_B_SHIFT) | (g << IM_COL32_G_SHIFT) | (r << IM_COL32_R_SHIFT) | (alpha << IM_COL32_A_SHIFT);
 }
 
+/**
+	@brief Default implementation of GetColor() for waveforms using palette-indexed colors
+ */
+string WaveformBase::GetColor(size_t i)
+{
+	auto palette = GetColorPalette();
+	auto index = GetColorIndex(i);
+	if(index < palette.size())
+		return palette[index];
+	return StandardColors::colors[StandardColors::COLOR_ERROR];
+}
+
 /**
 	@brief Updates the cache of packed colors to avoid string parsing every frame
  */
@@ -346,8 +362,85 @@ void WaveformBase::CacheColors()
 	m_protocolColors.resize(s);
 	m_protocolColors.PrepareForCpuAccess();
 
-	for(size_t i=0; i<s; i++)
-		m_protocolColors[i] = ColorFromString(GetColor(i), 0xff);
+	//Fast path for waveforms with a fixed palette
+	auto palette = GetColorPalette();
+	if(!palette.empty())
+		CacheColorsFromPalette(palette);
+
+	//Slow path, parse every sample's color
+	else
+	{
+		for(size_t i=0; i<s; i++)
+			m_protocolColors[i] = ColorFromString(GetColor(i), 0xff);
+	}
 
 	m_protocolColors.MarkModifiedFromCpu();
 }
+
+/**
+	@brief Fills m_protocolColors from GetColorIndex() and a palette
+
+	m_protocolColors must already be sized and ready for CPU access.
+ */
+void WaveformBase::CacheColorsFromPalette(const vector<string>& palette)
+{
+	//Parse the palette once, padding it to 256 entries so any index is in bounds
+	uint32_t table[256];
+	uint32_t errorColor = ColorFromString(StandardColors::colors[StandardColors::COLOR_ERROR], 0xff);
+	for(size_t i=0; i<256; i++)
+	{
+		if(i < palette.size())
+			table[i] = ColorFromString(palette[i], 0xff);
+		else
+			table[i] = errorColor;
+	}
+
+	//Fetch one block of indexes at a time, then convert the whole block to colors
+	const size_t blocksize = 4096;
+	size_t len = size();
+	size_t nblocks = (len + blocksize - 1) / blocksize;
+	uint32_t* out = m_protocolColors.GetCpuPointer();
+
+	#pragma omp parallel for if(nblocks > 16)
+	for(size_t block=0; block<nblocks; block++)
+	{
+		uint8_t indexes[blocksize];
+		size_t start = block * blocksize;
+		size_t count = min(blocksize, len - start);
+
+		for(size_t i=0; i<count; i++)
+			indexes[i] = GetColorIndex(start + i);
+
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+		{
+			LookupPaletteColorsAVX2(indexes, table, out + start, count);
+			continue;
+		}
+		#endif
+
+		for(size_t i=0; i<count; i++)
+			out[start + i] = table[indexes[i]];
+	}
+}
+
+#ifdef __x86_64__
+/**
+	@brief Converts a block of palette indexes to colors, eight at a time using a gather
+ */
+__attribute__((target("avx2")))
+void WaveformBase::LookupPaletteColorsAVX2(const uint8_t* indexes, const uint32_t* table, uint32_t* out, size_t count)
+{
+	size_t end = count - (count % 8);
+	for(size_t i=0; i<end; i+=8)
+	{
+		__m128i idx8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(indexes + i));
+		__m256i idx32 = _mm256_cvtepu8_epi32(idx8);
+		__m256i colors = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), idx32, 4);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), colors);
+	}
+
+	for(size_t i=end; i<count; i++)
+		out[i] = table[indexes[i]];
+}
+#endif /* __x86_64__ */
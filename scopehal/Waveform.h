@@ -196,10 +196,30 @@ public:
 
 		@param i	Sample index
 	 */
-	virtual std::string GetColor(size_t /*i*/)
-	{
-		return StandardColors::colors[StandardColors::COLOR_ERROR];
-	}
+	virtual std::string GetColor(size_t i);
+
+	/**
+		@brief Returns the palette of colors (in HTML #rrggbb or #rrggbbaa notation) indexed by GetColorIndex()
+
+		Protocol waveforms whose color only depends on a small per-sample type field should implement this and
+		GetColorIndex() instead of GetColor(). CacheColors() then parses each palette entry once and fills the cache
+		with a table lookup, rather than building and parsing a string for every sample.
+
+		An empty palette (the default) means GetColor() is used instead.
+	 */
+	virtual std::vector<std::string> GetColorPalette()
+	{ return {}; }
+
+	/**
+		@brief Returns the index into GetColorPalette() of the color of a given protocol sample
+
+		Indexes past the end of the palette are displayed in the error color. Called from multiple threads at once,
+		so implementations must not modify any state.
+
+		@param i	Sample index
+	 */
+	virtual uint8_t GetColorIndex(size_t /*i*/)
+	{ return 0; }
 
 	/**
 		@brief Returns the packed RGBA32 color of a given protocol sample calculated by CacheColors()
@@ -218,6 +238,20 @@ public:
 	 */
 	virtual void PrepareForCpuAccess() =0;
 
+	/**
+		@brief Records that this waveform is being written by GPU work which may still be executing
+
+		Set by the filter graph executor when a node's command buffer was submitted with QueueHandle::SubmitAsync().
+		The token is stored in each of the waveform's buffers, so any CPU access through AcceleratorBuffer blocks until
+		the work has completed. GPU consumers wait for it on the device side.
+
+		@param point	Completion token of the submission writing this waveform
+	 */
+	virtual void SetGpuCompletion(const QueueTimelinePoint& point) =0;
+
+	///@brief Returns the completion token of the GPU work writing this waveform (invalid if none)
+	virtual const QueueTimelinePoint& GetGpuCompletion() const =0;
+
 	/**
 		@brief Indicates that this waveform is going to be used by the CPU in the near future.
 
@@ -268,6 +302,11 @@ public:
 	virtual bool HasGpuBuffer() =0;
 
 protected:
+	void CacheColorsFromPalette(const std::vector<std::string>& palette);
+
+#ifdef __x86_64__
+	static void LookupPaletteColorsAVX2(const uint8_t* indexes, const uint32_t* table, uint32_t* out, size_t count);
+#endif
 
 	///@brief Cache of packed RGBA32 data with colors for each protocol decode event. Empty for non-protocol waveforms.
 	AcceleratorBuffer<uint32_t> m_protocolColors;
@@ -475,6 +514,12 @@ public:
 	virtual void PrepareForCpuAccess() override
 	{ m_samples.PrepareForCpuAccess(); }
 
+	virtual void SetGpuCompletion(const QueueTimelinePoint& point) override
+	{ m_samples.SetGpuCompletion(point); }
+
+	virtual const QueueTimelinePoint& GetGpuCompletion() const override
+	{ return m_samples.GetGpuCompletion(); }
+
 	virtual void PrepareForGpuAccess() override
 	{ m_samples.PrepareForGpuAccess(); }
 
@@ -635,6 +680,16 @@ public:
 		m_samples.PrepareForCpuAccess();
 	}
 
+	virtual void SetGpuCompletion(const QueueTimelinePoint& point) override
+	{
+		m_offsets.SetGpuCompletion(point);
+		m_durations.SetGpuCompletion(point);
+		m_samples.SetGpuCompletion(point);
+	}
+
+	virtual const QueueTimelinePoint& GetGpuCompletion() const override
+	{ return m_samples.GetGpuCompletion(); }
+
 	virtual void PrepareForCpuAccessNonblocking(vk::raii::CommandBuffer& cmdBuf) override
 	{
 		m_samples.PrepareForCpuAccessNonblocking(cmdBuf);
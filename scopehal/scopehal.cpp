@@ -187,21 +187,6 @@ static const uint32_t g_crc32Table[] =
 recursive_mutex AcceleratorBufferBase::m_objectListMutex;
 set<AcceleratorBufferBase*> AcceleratorBufferBase::m_objectList;
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// AcceleratorBuffer performance counters, should probably be moved to its own file eventually
-
-atomic<int64_t> AcceleratorBufferPerformanceCounters::m_hostDeviceCopiesBlocking;
-atomic<int64_t> AcceleratorBufferPerformanceCounters::m_hostDeviceCopiesNonBlocking;
-atomic<int64_t> AcceleratorBufferPerformanceCounters::m_hostDeviceCopiesSkipped;
-
-atomic<int64_t> AcceleratorBufferPerformanceCounters::m_deviceHostCopiesBlocking;
-atomic<int64_t> AcceleratorBufferPerformanceCounters::m_deviceHostCopiesNonBlocking;
-atomic<int64_t> AcceleratorBufferPerformanceCounters::m_deviceHostCopiesSkipped;
-
-atomic<int64_t> AcceleratorBufferPerformanceCounters::m_deviceDeviceCopiesBlocking;
-atomic<int64_t> AcceleratorBufferPerformanceCounters::m_deviceDeviceCopiesNonBlocking;
-atomic<int64_t> AcceleratorBufferPerformanceCounters::m_deviceDeviceCopiesSkipped;
-
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 vector<string> g_searchPaths;
@@ -103,6 +103,9 @@ extern bool g_hasShaderAtomicFloat;
 extern bool g_hasDebugUtils;
 extern bool g_hasMemoryBudget;
 extern bool g_hasPushDescriptor;
+extern bool g_hasExternalMemoryHost;
+extern size_t g_vkMinImportedHostPointerAlignment;
+extern bool g_hasTimelineSemaphore;
 
 extern size_t g_maxComputeGroupCount[3];
 
@@ -120,8 +123,10 @@ uint32_t GetComputeBlockCount(size_t numGlobal, size_t blockSize);
 
 #include "AcceleratorBuffer.h"
 #include "ScratchBufferManager.h"
+#include "ParallelTuning.h"
 #include "ComputePipeline.h"
 
+#include "SCPIReadBuffer.h"
 #include "SCPITransport.h"
 #include "SCPISocketTransport.h"
 #include "SCPITwinLanTransport.h"
@@ -142,6 +147,7 @@ uint32_t GetComputeBlockCount(size_t numGlobal, size_t blockSize);
 #endif
 
 #include "FlowGraphNode.h"
+#include "ByteArenaWaveform.h"
 #include "SinkNode.h"
 #include "Instrument.h"
 #include "StreamDescriptor.h"
@@ -199,6 +205,7 @@ uint32_t GetComputeBlockCount(size_t numGlobal, size_t blockSize);
 #include "IBISParser.h"
 
 #include "FilterParameter.h"
+#include "FusibleShader.h"
 #include "Filter.h"
 #include "ImportFilter.h"
 #include "PeakDetectionFilter.h"
@@ -206,6 +213,7 @@ uint32_t GetComputeBlockCount(size_t numGlobal, size_t blockSize);
 #include "SParameterSourceFilter.h"
 #include "SParameterFilter.h"
 
+#include "FusedFilterChain.h"
 #include "FilterGraphExecutor.h"
 
 #include "QueueManager.h"
@@ -290,6 +298,7 @@ extern bool g_vulkanDeviceIsIntelMesa;
 extern bool g_vulkanDeviceIsAnyMesa;
 extern bool g_vulkanDeviceIsMoltenVK;
 extern bool g_vulkanDeviceIsApplePV;
+extern bool g_vulkanDeviceIsSoftware;
 extern uint32_t g_vkPinnedMemoryHeap;
 extern uint32_t g_vkLocalMemoryHeap;
 extern bool g_vulkanDeviceHasUnifiedMemory;
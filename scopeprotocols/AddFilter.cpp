@@ -32,6 +32,8 @@
 
 using namespace std;
 
+shared_ptr<FusibleShader> AddFilter::m_fusibleShader;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -277,12 +279,58 @@ void AddFilter::DoRefreshVectorVector(vk::raii::CommandBuffer& cmdBuf, std::shar
 			compute_block_count / 32768 + 1);
 
 		cmdBuf.end();
-		queue->SubmitAndBlock(cmdBuf);
+		auto point = queue->SubmitAsync(cmdBuf);
 
 		if(scap)
+		{
+			scap->m_samples.SetGpuCompletion(point);
 			scap->m_samples.MarkModifiedFromGpu();
+		}
 		else
+		{
+			ucap->m_samples.SetGpuCompletion(point);
 			ucap->m_samples.MarkModifiedFromGpu();
+		}
 	}
 
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shader fusion
+
+shared_ptr<FusibleShader> AddFilter::GetFusibleShader(vector<size_t>& inputs)
+{
+	//Only vector-vector addition is a pure elementwise operation (degrees need wrapping, done on the CPU)
+	if( (GetInput(0).GetType() != Stream::STREAM_TYPE_ANALOG) || (GetInput(1).GetType() != Stream::STREAM_TYPE_ANALOG) )
+		return nullptr;
+	if( (m_inputs[0]->GetXAxisUnits() != m_inputs[1]->GetXAxisUnits()) ||
+		(m_inputs[0]->GetYAxisUnits() != m_inputs[1]->GetYAxisUnits()) ||
+		(m_inputs[0]->GetYAxisUnits() == Unit::UNIT_DEGREES) )
+	{
+		return nullptr;
+	}
+
+	if(!m_fusibleShader)
+	{
+		m_fusibleShader = make_shared<FusibleShader>(
+			"Add",
+			"float __kernel__(float a, float b)\n"
+			"{\n"
+			"\treturn a + b;\n"
+			"}\n");
+		m_fusibleShader->m_inputs.push_back(ShaderInputInfo("float", "a"));
+		m_fusibleShader->m_inputs.push_back(ShaderInputInfo("float", "b"));
+		m_fusibleShader->m_cpuOps.push_back(FusibleCpuOp(FusibleCpuOp::OP_ADD, 0, 1));
+	}
+
+	inputs = { 0, 1 };
+	return m_fusibleShader;
+}
+
+void AddFilter::PrepareFusedRefresh(vector<uint32_t>& /*pushConstants*/)
+{
+	ClearMessages();
+	m_streams[0].m_stype = Stream::STREAM_TYPE_ANALOG;
+	SetYAxisUnits(m_inputs[0]->GetYAxisUnits(), 0);
+	m_xAxisUnit = m_inputs[0]->GetXAxisUnits();
+}
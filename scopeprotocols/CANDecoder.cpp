@@ -38,6 +38,34 @@
 
 using namespace std;
 
+/**
+	@brief Interned names and values of the packet headers set by the CAN decoder
+ */
+struct CANHeaderNames
+{
+	const string* id = Packet::Intern("ID");
+	const string* format = Packet::Intern("Format");
+	const string* mode = Packet::Intern("Mode");
+	const string* type = Packet::Intern("Type");
+	const string* ack = Packet::Intern("Ack");
+	const string* len = Packet::Intern("Len");
+
+	const string* base = Packet::Intern("Base");
+	const string* ext = Packet::Intern("Ext");
+	const string* can = Packet::Intern("CAN");
+	const string* canfd = Packet::Intern("CAN-FD");
+	const string* data = Packet::Intern("Data");
+	const string* rtr = Packet::Intern("RTR");
+	const string* ackOk = Packet::Intern("ACK");
+	const string* nak = Packet::Intern("NAK");
+};
+
+static const CANHeaderNames& GetHeaderNames()
+{
+	static const CANHeaderNames names;
+	return names;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -97,54 +125,81 @@ void CANDecoder::Refresh(
 	int64_t fs_per_ui = FS_PER_SECOND / bitrate;
 	int64_t samples_per_ui = fs_per_ui / din->m_timescale;
 
-	enum
+	//Split the capture at bus idle periods and decode the pieces in parallel.
+	//The ACK delimiter and EOF are the last eight bits of a frame and all recessive, so ten UIs into an idle run the
+	//decoder has gone back to waiting for a SOF. Sparse inputs only lock in one bit per sample, so a long recessive run
+	//doesn't reliably end a frame and they're always decoded in one piece.
+	vector<SegmentedDecode::Segment> segments;
+	if(udiff)
+		segments = SegmentedDecode::FindIdleSegments(sdiff, udiff, false, 11 * samples_per_ui, 10 * samples_per_ui);
+	else
+		segments.push_back(SegmentedDecode::Segment{0, din->size()});
+	vector<DecodeState> entries(segments.size());
+	for(size_t i=1; i<segments.size(); i++)
 	{
-		STATE_WAIT_FOR_IDLE,
-		STATE_IDLE,
-		STATE_SOF,
-		STATE_ID,
-		STATE_EXT_ID,
-		STATE_RTR,
-		STATE_IDE,
-		STATE_FD,
-		STATE_R0,
-		STATE_DLC,
-		STATE_DATA,
-		STATE_CRC,
-
-		STATE_CRC_DELIM,
-		STATE_ACK,
-		STATE_ACK_DELIM,
-		STATE_EOF
-	} state = STATE_WAIT_FOR_IDLE;
+		entries[i].m_state = STATE_IDLE;
+		entries[i].m_sampledValue = true;
+		entries[i].m_lastSampledValue = true;
+	}
 
+	SegmentSymbols<CANSymbol> symbols;
+	SegmentedDecode::Run(entries, symbols,
+		[&](size_t i, DecodeState& state, SegmentSymbols<CANSymbol>& out)
+		{
+			DecodeSegment(din, sdiff, udiff, segments[i].m_start, segments[i].m_end, samples_per_ui, state, out);
+		});
+
+	symbols.Commit(cap, m_packets);
+}
+
+/**
+	@brief Decodes one segment of the input
+
+	@param din				Input waveform
+	@param sdiff			Input waveform, if sparse
+	@param udiff			Input waveform, if uniform
+	@param istart			Index of the first sample in the segment
+	@param iend				Index one past the last sample in the segment
+	@param samples_per_ui	Length of one UI, in input timebase units
+	@param st				Decoder state at the start of the segment on entry, at the end on exit
+	@param out				Decoded symbols and packets
+ */
+void CANDecoder::DecodeSegment(
+	WaveformBase* din,
+	SparseDigitalWaveform* sdiff,
+	UniformDigitalWaveform* udiff,
+	size_t istart,
+	size_t iend,
+	int64_t samples_per_ui,
+	DecodeState& st,
+	SegmentSymbols<CANSymbol>& out)
+{
 	//LogDebug("Starting CAN decode\n");
 	//LogIndenter li;
 
-	Packet* pack = nullptr;
-
-	size_t len = din->size();
-	int64_t tbitstart = 0;
-	int64_t tblockstart = 0;
-	bool vlast = true;
-	int nbit = 0;
-	bool sampled = false;
-	bool sampled_value = false;
-	bool last_sampled_value = false;
-	int bits_since_toggle = 0;
-	uint32_t current_field = 0;
-	bool frame_is_rtr = false;
-	bool extended_id = false;
-	bool fd_mode = false;
-	int frame_bytes_left = 0;
-	int32_t frame_id = 0;
-	char tmp[128];
+	FrameState state = st.m_state;
+	Packet* pack = st.m_pack;
+	int64_t tbitstart = st.m_tbitstart;
+	int64_t tblockstart = st.m_tblockstart;
+	bool vlast = st.m_vlast;
+	int nbit = st.m_nbit;
+	bool sampled = st.m_sampled;
+	bool sampled_value = st.m_sampledValue;
+	bool last_sampled_value = st.m_lastSampledValue;
+	int bits_since_toggle = st.m_bitsSinceToggle;
+	uint32_t current_field = st.m_currentField;
+	bool frame_is_rtr = st.m_frameIsRtr;
+	bool extended_id = st.m_extendedId;
+	bool fd_mode = st.m_fdMode;
+	int frame_bytes_left = st.m_frameBytesLeft;
+	int32_t frame_id = st.m_frameId;
+	auto& names = GetHeaderNames();
 
 	// CRC (http://esd.cs.ucr.edu/webres/can20.pdf page 13)
 	const uint16_t crc_poly = 0x4599;
-	uint16_t crc = 0;
+	uint16_t crc = st.m_crc;
 
-	for(size_t i = 0; i < len; i++)
+	for(size_t i = istart; i < iend; i++)
 	{
 		bool v = GetValue(sdiff, udiff, i);
 		bool toggle = (v != vlast);
@@ -262,11 +317,11 @@ void CANDecoder::Refresh(
 					pack = new Packet;
 					pack->m_offset = off * din->m_timescale;
 					pack->m_len = 0;
-					m_packets.push_back(pack);
+					out.m_packets.push_back(pack);
 
-					cap->m_offsets.push_back(tblockstart);
-					cap->m_durations.push_back(off - tblockstart);
-					cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_SOF, 0));
+					out.m_offsets.push_back(tblockstart);
+					out.m_durations.push_back(off - tblockstart);
+					out.m_samples.push_back(CANSymbol(CANSymbol::TYPE_SOF, 0));
 
 					extended_id = false;
 					fd_mode = false;
@@ -284,19 +339,18 @@ void CANDecoder::Refresh(
 					//When we've read 11 bits, the ID is over
 					if(nbit == 11)
 					{
-						cap->m_offsets.push_back(tblockstart);
-						cap->m_durations.push_back(end - tblockstart);
-						cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_ID, current_field));
+						out.m_offsets.push_back(tblockstart);
+						out.m_durations.push_back(end - tblockstart);
+						out.m_samples.push_back(CANSymbol(CANSymbol::TYPE_ID, current_field));
 
 						state = STATE_RTR;
 
 						frame_id = current_field;
 
-						snprintf(tmp, sizeof(tmp), "%03x", frame_id);
-						pack->m_headers["ID"] = tmp;
-						pack->m_headers["Format"] = "Base";
-						pack->m_headers["Mode"] = "CAN";
-						pack->m_headers["Type"] = "Data";
+						pack->SetHeader(names.id, frame_id, PacketHeader::FORMAT_HEX, 3);
+						pack->SetHeader(names.format, names.base);
+						pack->SetHeader(names.mode, names.can);
+						pack->SetHeader(names.type, names.data);
 					}
 
 					break;
@@ -305,13 +359,13 @@ void CANDecoder::Refresh(
 				case STATE_RTR:
 					frame_is_rtr = sampled_value;
 
-					cap->m_offsets.push_back(tbitstart);
-					cap->m_durations.push_back(end - tbitstart);
-					cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_RTR, frame_is_rtr));
+					out.m_offsets.push_back(tbitstart);
+					out.m_durations.push_back(end - tbitstart);
+					out.m_samples.push_back(CANSymbol(CANSymbol::TYPE_RTR, frame_is_rtr));
 
 					if(frame_is_rtr)
 					{
-						pack->m_headers["Type"] = "RTR";
+						pack->SetHeader(names.type, names.rtr);
 						pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
 					}
 					else
@@ -333,9 +387,9 @@ void CANDecoder::Refresh(
 						//Delete the old ID and SRR
 						for(int n=0; n<2; n++)
 						{
-							cap->m_offsets.pop_back();
-							cap->m_durations.pop_back();
-							cap->m_samples.pop_back();
+							out.m_offsets.pop_back();
+							out.m_durations.pop_back();
+							out.m_samples.pop_back();
 						}
 
 						nbit = 0;
@@ -356,13 +410,12 @@ void CANDecoder::Refresh(
 					{
 						frame_id = (frame_id << 18) | current_field;
 
-						cap->m_offsets.push_back(tblockstart);
-						cap->m_durations.push_back(end - tblockstart);
-						cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_ID, frame_id));
+						out.m_offsets.push_back(tblockstart);
+						out.m_durations.push_back(end - tblockstart);
+						out.m_samples.push_back(CANSymbol(CANSymbol::TYPE_ID, frame_id));
 
-						snprintf(tmp, sizeof(tmp), "%08x", frame_id);
-						pack->m_headers["ID"] = tmp;
-						pack->m_headers["Format"] = "Ext";
+						pack->SetHeader(names.id, frame_id, PacketHeader::FORMAT_HEX, 8);
+						pack->SetHeader(names.format, names.ext);
 
 						state = STATE_RTR;
 					}
@@ -371,9 +424,9 @@ void CANDecoder::Refresh(
 
 				//Reserved bit (should always be zero)
 				case STATE_R0:
-					cap->m_offsets.push_back(tbitstart);
-					cap->m_durations.push_back(end - tbitstart);
-					cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_R0, sampled_value));
+					out.m_offsets.push_back(tbitstart);
+					out.m_durations.push_back(end - tbitstart);
+					out.m_samples.push_back(CANSymbol(CANSymbol::TYPE_R0, sampled_value));
 
 					state = STATE_DLC;
 					tblockstart = off;
@@ -383,13 +436,13 @@ void CANDecoder::Refresh(
 
 				//FD mode (currently ignored)
 				case STATE_FD:
-					cap->m_offsets.push_back(tbitstart);
-					cap->m_durations.push_back(end - tbitstart);
-					cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_FD, sampled_value));
+					out.m_offsets.push_back(tbitstart);
+					out.m_durations.push_back(end - tbitstart);
+					out.m_samples.push_back(CANSymbol(CANSymbol::TYPE_FD, sampled_value));
 
 					fd_mode = sampled_value;
 					if(fd_mode)
-						pack->m_headers["Mode"] = "CAN-FD";
+						pack->SetHeader(names.mode, names.canfd);
 
 					state = STATE_R0;
 					break;
@@ -400,9 +453,9 @@ void CANDecoder::Refresh(
 					//When we've read 4 bits, the DLC is over
 					if(nbit == 4)
 					{
-						cap->m_offsets.push_back(tblockstart);
-						cap->m_durations.push_back(end - tblockstart);
-						cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_DLC, current_field));
+						out.m_offsets.push_back(tblockstart);
+						out.m_durations.push_back(end - tblockstart);
+						out.m_samples.push_back(CANSymbol(CANSymbol::TYPE_DLC, current_field));
 
 						frame_bytes_left = current_field;
 
@@ -425,9 +478,9 @@ void CANDecoder::Refresh(
 					//Data is in 8-bit bytes
 					if(nbit == 8)
 					{
-						cap->m_offsets.push_back(tblockstart);
-						cap->m_durations.push_back(end - tblockstart);
-						cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_DATA, current_field));
+						out.m_offsets.push_back(tblockstart);
+						out.m_durations.push_back(end - tblockstart);
+						out.m_samples.push_back(CANSymbol(CANSymbol::TYPE_DATA, current_field));
 
 						pack->m_data.push_back(current_field);
 
@@ -453,9 +506,9 @@ void CANDecoder::Refresh(
 						bool crc_ok = (current_field == (crc & 0x7fff));
 						auto type = crc_ok ? CANSymbol::TYPE_CRC_OK : CANSymbol::TYPE_CRC_BAD;
 
-						cap->m_offsets.push_back(tblockstart);
-						cap->m_durations.push_back(end - tblockstart);
-						cap->m_samples.push_back(CANSymbol(type, current_field));
+						out.m_offsets.push_back(tblockstart);
+						out.m_durations.push_back(end - tblockstart);
+						out.m_samples.push_back(CANSymbol(type, current_field));
 
 						state = STATE_CRC_DELIM;
 					}
@@ -464,32 +517,32 @@ void CANDecoder::Refresh(
 
 				//CRC delimiter
 				case STATE_CRC_DELIM:
-					cap->m_offsets.push_back(tbitstart);
-					cap->m_durations.push_back(end - tbitstart);
-					cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_CRC_DELIM, sampled_value));
+					out.m_offsets.push_back(tbitstart);
+					out.m_durations.push_back(end - tbitstart);
+					out.m_samples.push_back(CANSymbol(CANSymbol::TYPE_CRC_DELIM, sampled_value));
 
 					state = STATE_ACK;
 					break;
 
 				//ACK bit
 				case STATE_ACK:
-					cap->m_offsets.push_back(tbitstart);
-					cap->m_durations.push_back(end - tbitstart);
-					cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_ACK, sampled_value));
+					out.m_offsets.push_back(tbitstart);
+					out.m_durations.push_back(end - tbitstart);
+					out.m_samples.push_back(CANSymbol(CANSymbol::TYPE_ACK, sampled_value));
 
 					if(sampled_value)
-						pack->m_headers["Ack"] = "NAK";
+						pack->SetHeader(names.ack, names.nak);
 					else
-						pack->m_headers["Ack"] = "ACK";
+						pack->SetHeader(names.ack, names.ackOk);
 
 					state = STATE_ACK_DELIM;
 					break;
 
 				//ACK delimiter
 				case STATE_ACK_DELIM:
-					cap->m_offsets.push_back(tbitstart);
-					cap->m_durations.push_back(end - tbitstart);
-					cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_ACK_DELIM, sampled_value));
+					out.m_offsets.push_back(tbitstart);
+					out.m_durations.push_back(end - tbitstart);
+					out.m_samples.push_back(CANSymbol(CANSymbol::TYPE_ACK_DELIM, sampled_value));
 
 					state = STATE_EOF;
 					tblockstart = end;
@@ -504,14 +557,13 @@ void CANDecoder::Refresh(
 					if(nbit == 7)
 					{
 						if(frame_is_rtr)
-							snprintf(tmp, sizeof(tmp), "%d", (int)frame_bytes_left);
+							pack->SetHeader(names.len, frame_bytes_left);
 						else
-							snprintf(tmp, sizeof(tmp), "%d", (int)pack->m_data.size());
-						pack->m_headers["Len"] = tmp;
+							pack->SetHeader(names.len, pack->m_data.size());
 
-						cap->m_offsets.push_back(tblockstart);
-						cap->m_durations.push_back(end - tblockstart);
-						cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_EOF, current_field));
+						out.m_offsets.push_back(tblockstart);
+						out.m_durations.push_back(end - tblockstart);
+						out.m_samples.push_back(CANSymbol(CANSymbol::TYPE_EOF, current_field));
 
 						pack->m_len = pack->m_offset - (end * din->m_timescale);
 
@@ -530,7 +582,23 @@ void CANDecoder::Refresh(
 		}
 	}
 
-	cap->MarkModifiedFromCpu();
+	st.m_state = state;
+	st.m_pack = pack;
+	st.m_tbitstart = tbitstart;
+	st.m_tblockstart = tblockstart;
+	st.m_vlast = vlast;
+	st.m_nbit = nbit;
+	st.m_sampled = sampled;
+	st.m_sampledValue = sampled_value;
+	st.m_lastSampledValue = last_sampled_value;
+	st.m_bitsSinceToggle = bits_since_toggle;
+	st.m_currentField = current_field;
+	st.m_frameIsRtr = frame_is_rtr;
+	st.m_extendedId = extended_id;
+	st.m_fdMode = fd_mode;
+	st.m_frameBytesLeft = frame_bytes_left;
+	st.m_frameId = frame_id;
+	st.m_crc = crc;
 }
 
 vector<string> CANDecoder::GetHeaders()
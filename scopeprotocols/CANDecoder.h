@@ -36,7 +36,7 @@
 #ifndef CANDecoder_h
 #define CANDecoder_h
 
-#include "PacketDecoder.h"
+#include "SegmentedDecode.h"
 
 class CANDecoder : public PacketDecoder
 {
@@ -52,6 +52,101 @@ public:
 	PROTOCOL_DECODER_INITPROC(CANDecoder)
 
 protected:
+
+	enum FrameState
+	{
+		STATE_WAIT_FOR_IDLE,
+		STATE_IDLE,
+		STATE_SOF,
+		STATE_ID,
+		STATE_EXT_ID,
+		STATE_RTR,
+		STATE_IDE,
+		STATE_FD,
+		STATE_R0,
+		STATE_DLC,
+		STATE_DATA,
+		STATE_CRC,
+
+		STATE_CRC_DELIM,
+		STATE_ACK,
+		STATE_ACK_DELIM,
+		STATE_EOF
+	};
+
+	///@brief Everything the decoder carries from one sample to the next, for decoding segments in parallel
+	class DecodeState
+	{
+	public:
+		DecodeState()
+			: m_state(STATE_WAIT_FOR_IDLE)
+			, m_pack(nullptr)
+			, m_tbitstart(0)
+			, m_tblockstart(0)
+			, m_vlast(true)
+			, m_nbit(0)
+			, m_sampled(false)
+			, m_sampledValue(false)
+			, m_lastSampledValue(false)
+			, m_bitsSinceToggle(0)
+			, m_currentField(0)
+			, m_frameIsRtr(false)
+			, m_extendedId(false)
+			, m_fdMode(false)
+			, m_frameBytesLeft(0)
+			, m_frameId(0)
+			, m_crc(0)
+		{}
+
+		/**
+			@brief Checks if decoding from this state gives the same output as decoding from another
+
+			Once idle, everything except the bit sampler is reinitialized at the next SOF, so only idle states are
+			compared.
+		 */
+		bool Matches(const DecodeState& entry) const
+		{
+			return
+				(m_state == STATE_IDLE) &&
+				(entry.m_state == STATE_IDLE) &&
+				(m_sampled == entry.m_sampled) &&
+				(m_sampledValue == entry.m_sampledValue) &&
+				(m_lastSampledValue == entry.m_lastSampledValue);
+		}
+
+		///@brief Nothing to free, the current packet belongs to the segment's packet list
+		void Discard()
+		{}
+
+		FrameState m_state;
+		Packet* m_pack;
+		int64_t m_tbitstart;
+		int64_t m_tblockstart;
+		bool m_vlast;
+		int m_nbit;
+		bool m_sampled;
+		bool m_sampledValue;
+		bool m_lastSampledValue;
+		int m_bitsSinceToggle;
+		uint32_t m_currentField;
+		bool m_frameIsRtr;
+		bool m_extendedId;
+		bool m_fdMode;
+		int m_frameBytesLeft;
+		int32_t m_frameId;
+		uint16_t m_crc;
+	};
+
+	static void DecodeSegment(
+		WaveformBase* din,
+		SparseDigitalWaveform* sdiff,
+		UniformDigitalWaveform* udiff,
+		size_t istart,
+		size_t iend,
+		int64_t samples_per_ui,
+		DecodeState& st,
+		SegmentSymbols<CANSymbol>& out);
+
 	FilterParameter& m_baudrate;
 };
 
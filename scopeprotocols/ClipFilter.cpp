@@ -32,6 +32,8 @@
 
 using namespace std;
 
+shared_ptr<FusibleShader> ClipFilter::m_fusibleShader;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -124,3 +126,42 @@ void ClipFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle
 	cmdBuf.end();
 	queue->SubmitAndBlock(cmdBuf);
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shader fusion
+
+shared_ptr<FusibleShader> ClipFilter::GetFusibleShader(vector<size_t>& inputs)
+{
+	if(!m_fusibleShader)
+	{
+		m_fusibleShader = make_shared<FusibleShader>(
+			"Clip",
+			"float __kernel__(float din)\n"
+			"{\n"
+			"\tif(__push__clipAbove == 1)\n"
+			"\t\treturn min(din, __push__level);\n"
+			"\telse\n"
+			"\t\treturn max(din, __push__level);\n"
+			"}\n");
+		m_fusibleShader->m_inputs.push_back(ShaderInputInfo("float", "din"));
+		m_fusibleShader->m_pushConstants.push_back(PushConstantInfo("uint", "clipAbove"));
+		m_fusibleShader->m_pushConstants.push_back(PushConstantInfo("float", "level"));
+		m_fusibleShader->m_cpuOps.push_back(FusibleCpuOp(
+			FusibleCpuOp::OP_CLIP, 0, FusibleCpuOp::PushConstant(1), FusibleCpuOp::PushConstant(0)));
+	}
+
+	inputs = { 0 };
+	return m_fusibleShader;
+}
+
+void ClipFilter::PrepareFusedRefresh(vector<uint32_t>& pushConstants)
+{
+	ClearMessages();
+
+	float level = m_clipLevel.GetFloatVal();
+	uint32_t word;
+	memcpy(&word, &level, sizeof(word));
+
+	pushConstants.push_back(m_clipAbove.GetIntVal());
+	pushConstants.push_back(word);
+}
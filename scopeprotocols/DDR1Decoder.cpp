@@ -97,16 +97,9 @@ void DDR1Decoder::Refresh(
 
 	//Sample all of the inputs
 	auto cclk = caps[0];
-	SparseDigitalWaveform we;
-	SparseDigitalWaveform ras;
-	SparseDigitalWaveform cas;
-	SparseDigitalWaveform cs;
-	SparseDigitalWaveform a10;
-	SampleOnRisingEdgesBase(caps[1], cclk, we);
-	SampleOnRisingEdgesBase(caps[2], cclk, ras);
-	SampleOnRisingEdgesBase(caps[3], cclk, cas);
-	SampleOnRisingEdgesBase(caps[4], cclk, cs);
-	SampleOnRisingEdgesBase(caps[5], cclk, a10);
+	//Bits are WE, RAS, CAS, CS, A10
+	SparseDigitalBusWaveform32 bus;
+	SampleBusOnRisingEdges(vector<WaveformBase*>(caps + 1, caps + 6), cclk, bus);
 
 	//Create the capture
 	auto cap = SetupEmptyWaveform<SDRAMWaveform>(nullptr, 0);
@@ -116,18 +109,15 @@ void DDR1Decoder::Refresh(
 	cap->PrepareForCpuAccess();
 
 	//Loop over the data and look for events on clock edges
-	size_t len = we.size();
-	len = min(len, ras.size());
-	len = min(len, cas.size());
-	len = min(len, cs.size());
-	len = min(len, a10.size());
+	size_t len = bus.size();
 	for(size_t i=0; i<len; i++)
 	{
-		bool swe = we.m_samples[i];
-		bool sras = ras.m_samples[i];
-		bool scas = cas.m_samples[i];
-		bool scs = cs.m_samples[i];
-		bool sa10 = a10.m_samples[i];
+		uint32_t word = bus.m_samples[i];
+		bool swe = (word >> 0) & 1;
+		bool sras = (word >> 1) & 1;
+		bool scas = (word >> 2) & 1;
+		bool scs = (word >> 3) & 1;
+		bool sa10 = (word >> 4) & 1;
 
 		if(!scs)
 		{
@@ -170,8 +160,8 @@ void DDR1Decoder::Refresh(
 				LogDebug("[%zu] Unknown command (RAS=%d, CAS=%d, WE=%d, A10=%d)\n", i, sras, scas, swe, sa10);
 
 			//Create the symbol
-			cap->m_offsets.push_back(we.m_offsets[i]);
-			cap->m_durations.push_back(we.m_durations[i]);
+			cap->m_offsets.push_back(bus.m_offsets[i]);
+			cap->m_durations.push_back(bus.m_durations[i]);
 			cap->m_samples.push_back(sym);
 		}
 	}
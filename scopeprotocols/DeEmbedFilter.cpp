@@ -180,10 +180,20 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	}
 
 	//Set up new FFT plans
-	if(!m_vkForwardPlan)
-		m_vkForwardPlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
-	if(!m_vkReversePlan)
-		m_vkReversePlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
+	if(CPUFFTPlan::IsPreferred())
+	{
+		if(!m_cpuForwardPlan || (m_cpuForwardPlan->size() != npoints) )
+			m_cpuForwardPlan = CPUFFTPlan::Get(npoints, CPUFFTPlan::DIRECTION_FORWARD);
+		if(!m_cpuReversePlan || (m_cpuReversePlan->size() != npoints) )
+			m_cpuReversePlan = CPUFFTPlan::Get(npoints, CPUFFTPlan::DIRECTION_REVERSE);
+	}
+	else
+	{
+		if(!m_vkForwardPlan)
+			m_vkForwardPlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+		if(!m_vkReversePlan)
+			m_vkReversePlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
+	}
 
 	//Calculate size of each bin
 	double fs = din->m_timescale;
@@ -265,9 +275,6 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	m_cachedOutLen = outlen;
 	m_cachedNouts = nouts;
 
-	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
-	cmdBuf.begin({});
-
 	//Copy and zero-pad the input as needed
 	WindowFunctionArgs args;
 	args.numActualSamples = npoints_raw;
@@ -277,6 +284,17 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	args.alpha1 = 0;
 	args.offsetIn = 0;
 	args.offsetOut = 0;
+
+	//Software Vulkan: do everything natively rather than emulating shaders
+	if(CPUFFTPlan::IsPreferred())
+	{
+		DoRefreshCPU(din, cap, args, nouts, istart, outlen, scale);
+		return;
+	}
+
+	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
+	cmdBuf.begin({});
+
 	m_rectangularComputePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
 	m_rectangularComputePipeline.BindBufferNonblocking(1, m_forwardInBuf, cmdBuf, true);
 	m_rectangularComputePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(npoints, 64));
@@ -320,6 +338,57 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	cap->MarkModifiedFromGpu();
 }
 
+/**
+	@brief Native CPU implementation of the de-embed pipeline, for software Vulkan devices
+
+	Does exactly the same math as the shaders in DoRefresh().
+ */
+void DeEmbedFilter::DoRefreshCPU(
+	UniformAnalogWaveform* din,
+	UniformAnalogWaveform* cap,
+	const WindowFunctionArgs& args,
+	size_t nouts,
+	size_t istart,
+	size_t outlen,
+	float scale)
+{
+	din->PrepareForCpuAccess();
+	cap->PrepareForCpuAccess();
+	m_forwardInBuf.PrepareForCpuAccess();
+	m_forwardOutBuf.PrepareForCpuAccess();
+	m_reverseOutBuf.PrepareForCpuAccess();
+	m_resampledSparamSines.PrepareForCpuAccess();
+	m_resampledSparamCosines.PrepareForCpuAccess();
+
+	//Copy and zero-pad the input, then do the forward FFT
+	CPUFFTPlan::ApplyRectangularWindow(din->m_samples.GetCpuPointer(), m_forwardInBuf.GetCpuPointer(), args);
+	m_cpuForwardPlan->Forward(m_forwardInBuf.GetCpuPointer(), m_forwardOutBuf.GetCpuPointer());
+
+	//Apply the interpolated S-parameters
+	float* data = m_forwardOutBuf.GetCpuPointer();
+	const float* sines = m_resampledSparamSines.GetCpuPointer();
+	const float* cosines = m_resampledSparamCosines.GetCpuPointer();
+	for(size_t i=0; i<nouts; i++)
+	{
+		float real_orig = data[i*2 + 0];
+		float imag_orig = data[i*2 + 1];
+		data[i*2 + 0] = real_orig*cosines[i] - imag_orig*sines[i];
+		data[i*2 + 1] = real_orig*sines[i] + imag_orig*cosines[i];
+	}
+
+	//Inverse FFT, then copy and normalize output
+	m_cpuReversePlan->Reverse(m_forwardOutBuf.GetCpuPointer(), m_reverseOutBuf.GetCpuPointer());
+	const float* rev = m_reverseOutBuf.GetCpuPointer();
+	float* fout = cap->m_samples.GetCpuPointer();
+	for(size_t i=0; i<outlen; i++)
+		fout[i] = rev[i + istart] * scale;
+
+	m_forwardInBuf.MarkModifiedFromCpu();
+	m_forwardOutBuf.MarkModifiedFromCpu();
+	m_reverseOutBuf.MarkModifiedFromCpu();
+	cap->MarkModifiedFromCpu();
+}
+
 /**
 	@brief Returns the max mid-band group delay of the channel
  */
@@ -75,6 +75,8 @@ public:
 protected:
 	virtual int64_t GetGroupDelay();
 	void DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
+	void DoRefreshCPU(UniformAnalogWaveform* din, UniformAnalogWaveform* cap, const WindowFunctionArgs& args,
+		size_t nouts, size_t istart, size_t outlen, float scale);
 	virtual void InterpolateSparameters(float bin_hz, bool invert, size_t nouts);
 
 	std::string m_maxGainName;
@@ -112,6 +114,8 @@ protected:
 	ComputePipeline m_normalizeComputePipeline;
 	std::unique_ptr<VulkanFFTPlan> m_vkForwardPlan;
 	std::unique_ptr<VulkanFFTPlan> m_vkReversePlan;
+	std::shared_ptr<CPUFFTPlan> m_cpuForwardPlan;
+	std::shared_ptr<CPUFFTPlan> m_cpuReversePlan;
 };
 
 #endif
@@ -829,7 +829,7 @@ void Ethernet100BaseT1Decoder::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_p
 	}
 
 	//Calculate color for each protocol event and cache it so we don't have to do a ton of string manipulation later
-	cap->PreCacheColors();
+	cap->CacheColors();
 
 	cap->MarkModifiedFromCpu();
 }
@@ -590,7 +590,7 @@ void Ethernet100BaseTXDecoder::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_p
 	}
 
 	//Calculate color for each protocol event and cache it so we don't have to do a ton of string manipulation later
-	cap->PreCacheColors();
+	cap->CacheColors();
 
 	cap->MarkModifiedFromCpu();
 }
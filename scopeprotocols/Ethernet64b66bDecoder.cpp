@@ -35,6 +35,8 @@
 
 #include "../scopehal/scopehal.h"
 #include "Ethernet64b66bDecoder.h"
+#include "../scopehal/PackedBits.h"
+#include "../scopehal/Scrambler.h"
 
 #include <cinttypes>
 
@@ -89,84 +91,60 @@ void Ethernet64b66bDecoder::Refresh(
 	auto cap = SetupEmptyWaveform<Ethernet64b66bWaveform>(din, 0);
 	cap->PrepareForCpuAccess();
 
-	//Look at each phase and figure out block alignment
-	size_t end = din->size() - 66;
-	size_t best_offset = 0;
-	size_t best_errors = end;
-	for(size_t offset=0; offset < 66; offset ++)
+	//Need at least one full block
+	size_t len = din->size();
+	if(len <= 66)
 	{
-		size_t errors = 0;
-		for(size_t i=offset; i<end; i+= 66)
-		{
-			if(din->m_samples[i] == din->m_samples[i+1])
-				errors ++;
-		}
-
-		if(errors < best_errors)
-		{
-			best_offset = offset;
-			best_errors = errors;
-		}
+		cap->MarkModifiedFromCpu();
+		return;
 	}
+	size_t end = len - 66;
+
+	//Pack the input so blocks can be pulled out a word at a time
+	vector<uint64_t> bits;
+	PackedBits::Pack(din->m_samples.GetCpuPointer(), len, bits);
 
-	//Decode the actual data
-	bool first		= true;
-	uint64_t lfsr	= 0;
+	//Look at each phase and figure out block alignment
+	size_t best_offset = PackedBits::FindBlockAlignment(bits.data(), end, 66);
+	if(best_offset >= end)
+	{
+		cap->MarkModifiedFromCpu();
+		return;
+	}
 
-	for(size_t i=best_offset; i<end; i += 66)
+	//The first block just primes the scrambler, we can't decode it.
+	//Every other block only depends on the raw bits of the one before it, so they can be decoded in any order.
+	size_t nblocks = (end - best_offset + 65) / 66;
+	size_t nout = nblocks - 1;
+	cap->Resize(nout);
+
+	auto poffs = din->m_offsets.GetCpuPointer();
+	auto pdurs = din->m_durations.GetCpuPointer();
+	auto offsets = cap->m_offsets.GetCpuPointer();
+	auto durations = cap->m_durations.GetCpuPointer();
+	auto samples = cap->m_samples.GetCpuPointer();
+	const uint64_t* pbits = bits.data();
+	SelfSyncDescrambler descrambler(39, 58);
+
+	int nthreads = ParallelTuning::GetThreadCount(ParallelTuning::KERNEL_SAMPLE_CONVERSION, nout, 8);
+	#pragma omp parallel for if(nthreads > 1) num_threads(nthreads)
+	for(size_t n=0; n<nout; n++)
 	{
+		size_t i = best_offset + (n+1)*66;
+
 		//Extract the header bits
-		uint8_t header =
-			(din->m_samples[i] ? 2 : 0) |
-			(din->m_samples[i+1] ? 1 : 0);
-
-		//Extract the data bits and descramble them.
-		uint64_t codeword = 0;
-		for(size_t j=0; j<64; j++)
-		{
-			bool b = din->m_samples[i + 2 + j];
-
-			codeword >>= 1;
-			if(b ^ ( (lfsr >> 38) & 1) ^ ( (lfsr >> 57) & 1) )
-				codeword |= 0x8000000000000000L;
-
-			lfsr = (lfsr << 1) | b;
-		}
-
-		//Need to swap bit/byte ordering around a bunch.
-		uint64_t bytes[8] =
-		{
-			(codeword >> 56) & 0xff,
-			(codeword >> 48) & 0xff,
-			(codeword >> 40) & 0xff,
-			(codeword >> 32) & 0xff,
-			(codeword >> 24) & 0xff,
-			(codeword >> 16) & 0xff,
-			(codeword >> 8) & 0xff,
-			(codeword >> 0) & 0xff,
-		};
-
-		codeword =
-			(bytes[7] << 56) |
-			(bytes[6] << 48) |
-			(bytes[5] << 40) |
-			(bytes[4] << 32) |
-			(bytes[3] << 24) |
-			(bytes[2] << 16) |
-			(bytes[1] << 8) |
-			bytes[0];
-
-		//Just prime the scrambler, we can't decode yet
-		if(first)
-			first = false;
-
-		//Process descrambled data
-		else
-		{
-			cap->m_offsets.push_back(din->m_offsets[i] - din->m_durations[i]/2);
-			cap->m_durations.push_back(din->m_offsets[i+66] - din->m_offsets[i]);
-			cap->m_samples.push_back(Ethernet64b66bSymbol(header, codeword));
-		}
+		uint64_t hbits = PackedBits::Get(pbits, i);
+		uint8_t header = ( (hbits & 1) << 1) | ( (hbits >> 1) & 1);
+
+		//Extract the data bits and descramble them
+		uint64_t codeword = descrambler.Descramble(PackedBits::Get(pbits, i - 64), PackedBits::Get(pbits, i + 2));
+
+		//Reverse byte order so the first byte on the wire ends up in the MSB
+		codeword = __builtin_bswap64(codeword);
+
+		offsets[n] = poffs[i] - pdurs[i]/2;
+		durations[n] = poffs[i+66] - poffs[i];
+		samples[n] = Ethernet64b66bSymbol(header, codeword);
 	}
 
 	cap->MarkModifiedFromCpu();
@@ -35,6 +35,31 @@ using namespace std;
 
 static const char g_hex[] = "0123456789abcdef";
 
+/**
+	@brief Interned names and values of the packet headers set by the Ethernet decoders
+ */
+struct EthernetHeaderNames
+{
+	const string* dstMac = Packet::Intern("Dest MAC");
+	const string* srcMac = Packet::Intern("Src MAC");
+	const string* vlan = Packet::Intern("VLAN");
+	const string* ethertype = Packet::Intern("Ethertype");
+
+	const string* llc = Packet::Intern("LLC");
+	const string* stp = Packet::Intern("STP");
+	const string* ipv4 = Packet::Intern("IPv4");
+	const string* arp = Packet::Intern("ARP");
+	const string* dot1q = Packet::Intern("802.1q");
+	const string* ipv6 = Packet::Intern("IPv6");
+	const string* lldp = Packet::Intern("LLDP");
+};
+
+static const EthernetHeaderNames& GetHeaderNames()
+{
+	static const EthernetHeaderNames names;
+	return names;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -81,6 +106,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 		return;
 	}
 
+	auto& names = GetHeaderNames();
 	Packet* pack = new Packet;
 	pack->m_data.reserve(1500);
 
@@ -178,15 +204,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 					cap->m_samples.push_back(segment);
 
 					//Format the content for display
-					char tmp[64];
-					snprintf(tmp, sizeof(tmp), "%02x:%02x:%02x:%02x:%02x:%02x",
-						static_cast<uint32_t>((segment.m_data >> 40) & 0xff),
-						static_cast<uint32_t>((segment.m_data >> 32) & 0xff),
-						static_cast<uint32_t>((segment.m_data >> 24) & 0xff),
-						static_cast<uint32_t>((segment.m_data >> 16) & 0xff),
-						static_cast<uint32_t>((segment.m_data >> 8) & 0xff),
-						static_cast<uint32_t>((segment.m_data >> 0) & 0xff));
-					pack->m_headers["Dest MAC"] = tmp;
+					pack->SetHeader(names.dstMac, segment.m_data, PacketHeader::FORMAT_MAC);
 
 					//Reset for next block of the frame
 					segment.m_type = EthernetFrameSegment::TYPE_SRC_MAC;
@@ -216,15 +234,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 					cap->m_samples.push_back(segment);
 
 					//Format the content for display
-					char tmp[64];
-					snprintf(tmp, sizeof(tmp), "%02x:%02x:%02x:%02x:%02x:%02x",
-						static_cast<uint32_t>((segment.m_data >> 40) & 0xff),
-						static_cast<uint32_t>((segment.m_data >> 32) & 0xff),
-						static_cast<uint32_t>((segment.m_data >> 24) & 0xff),
-						static_cast<uint32_t>((segment.m_data >> 16) & 0xff),
-						static_cast<uint32_t>((segment.m_data >> 8) & 0xff),
-						static_cast<uint32_t>((segment.m_data >> 0) & 0xff));
-					pack->m_headers["Src MAC"] = tmp;
+					pack->SetHeader(names.srcMac, segment.m_data, PacketHeader::FORMAT_MAC);
 
 					//Reset for next block of the frame
 					segment.m_type = EthernetFrameSegment::TYPE_ETHERTYPE;
@@ -266,7 +276,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 					if(ethertype < 1500)
 					{
 						//Default to unknown LLC
-						pack->m_headers["Ethertype"] = "LLC";
+						pack->SetHeader(names.ethertype, names.llc);
 						pack->m_displayBackgroundColor = "#33a02c";
 						pack->m_displayForegroundColor = "#000000";
 
@@ -275,7 +285,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 						{
 							if(bytes[i+1] == 0x42)
 							{
-								pack->m_headers["Ethertype"] = "STP";
+								pack->SetHeader(names.ethertype, names.stp);
 								pack->m_displayBackgroundColor = "#fdbf6f";
 								pack->m_displayForegroundColor = "#000000";
 							}
@@ -283,43 +293,41 @@ void EthernetProtocolDecoder::BytesToFrames(
 					}
 					else
 					{
-						char tmp[64];
 						switch(ethertype)
 						{
 							case 0x0800:
-								pack->m_headers["Ethertype"] = "IPv4";
+								pack->SetHeader(names.ethertype, names.ipv4);
 								pack->m_displayBackgroundColor = "#a6cee3";
 								pack->m_displayForegroundColor = "#000000";
 								break;
 
 							case 0x0806:
-								pack->m_headers["Ethertype"] = "ARP";
+								pack->SetHeader(names.ethertype, names.arp);
 								pack->m_displayBackgroundColor = "#ffff99";
 								pack->m_displayForegroundColor = "#000000";
 								break;
 
 							//TODO: decoder inner ethertype too?
 							case 0x8100:
-								pack->m_headers["Ethertype"] = "802.1q";
+								pack->SetHeader(names.ethertype, names.dot1q);
 								pack->m_displayBackgroundColor = "#b2df8a";
 								pack->m_displayForegroundColor = "#000000";
 								break;
 
 							case 0x86DD:
-								pack->m_headers["Ethertype"] = "IPv6";
+								pack->SetHeader(names.ethertype, names.ipv6);
 								pack->m_displayBackgroundColor = "#1f78b4";
 								pack->m_displayForegroundColor = "#ffffff";
 								break;
 
 							case 0x88cc:
-								pack->m_headers["Ethertype"] = "LLDP";
+								pack->SetHeader(names.ethertype, names.lldp);
 								pack->m_displayBackgroundColor = "#5e4fa2";
 								pack->m_displayForegroundColor = "#ffffff";
 								break;
 
 							default:
-								snprintf(tmp, sizeof(tmp), "%04x", (uint32_t)segment.m_data);
-								pack->m_headers["Ethertype"] = tmp;
+								pack->SetHeader(names.ethertype, segment.m_data, PacketHeader::FORMAT_HEX, 4);
 								pack->m_displayBackgroundColor = "#fb9a99";
 								pack->m_displayForegroundColor = "#000000";
 								break;
@@ -357,13 +365,13 @@ void EthernetProtocolDecoder::BytesToFrames(
 					cap->m_durations.push_back( (ends[i] - start) / cap->m_timescale);
 					cap->m_samples.push_back(segment);
 
+					//Format the content for display
+					pack->SetHeader(names.vlan, segment.m_data & 0xfff);
+
 					//Reset for the internal ethertype
 					segment.m_type = EthernetFrameSegment::TYPE_ETHERTYPE;
 					segment.m_data = 0;
 					nbytes = 0;
-
-					//Format the content for display
-					pack->m_headers["VLAN"] = to_string(segment.m_data & 0xfff);
 				}
 
 				break;
@@ -454,6 +462,7 @@ void EthernetProtocolDecoder::BytesToFramesUnitTimescale(
 		EthernetWaveform* cap,
 		bool suppressedPreambleAndFCS)
 {
+	auto& names = GetHeaderNames();
 	Packet* pack = new Packet;
 
 	EthernetFrameSegment segment;
@@ -551,28 +560,7 @@ void EthernetProtocolDecoder::BytesToFramesUnitTimescale(
 					cap->m_samples.push_back(segment);
 
 					//Format the content for display
-					char tmp[] =
-					{
-						g_hex[ (segment.m_data >> 44) & 0xf],
-						g_hex[ (segment.m_data >> 40) & 0xf],
-						':',
-						g_hex[ (segment.m_data >> 36) & 0xf],
-						g_hex[ (segment.m_data >> 32) & 0xf],
-						':',
-						g_hex[ (segment.m_data >> 28) & 0xf],
-						g_hex[ (segment.m_data >> 24) & 0xf],
-						':',
-						g_hex[ (segment.m_data >> 20) & 0xf],
-						g_hex[ (segment.m_data >> 16) & 0xf],
-						':',
-						g_hex[ (segment.m_data >> 12) & 0xf],
-						g_hex[ (segment.m_data >> 8) & 0xf],
-						':',
-						g_hex[ (segment.m_data >> 4) & 0xf],
-						g_hex[ (segment.m_data >> 0) & 0xf],
-						'\0'
-					};
-					pack->m_headers["Dest MAC"] = tmp;
+					pack->SetHeader(names.dstMac, segment.m_data, PacketHeader::FORMAT_MAC);
 
 					//Reset for next block of the frame
 					segment.m_type = EthernetFrameSegment::TYPE_SRC_MAC;
@@ -602,28 +590,7 @@ void EthernetProtocolDecoder::BytesToFramesUnitTimescale(
 					cap->m_samples.push_back(segment);
 
 					//Format the content for display
-					char tmp[] =
-					{
-						g_hex[ (segment.m_data >> 44) & 0xf],
-						g_hex[ (segment.m_data >> 40) & 0xf],
-						':',
-						g_hex[ (segment.m_data >> 36) & 0xf],
-						g_hex[ (segment.m_data >> 32) & 0xf],
-						':',
-						g_hex[ (segment.m_data >> 28) & 0xf],
-						g_hex[ (segment.m_data >> 24) & 0xf],
-						':',
-						g_hex[ (segment.m_data >> 20) & 0xf],
-						g_hex[ (segment.m_data >> 16) & 0xf],
-						':',
-						g_hex[ (segment.m_data >> 12) & 0xf],
-						g_hex[ (segment.m_data >> 8) & 0xf],
-						':',
-						g_hex[ (segment.m_data >> 4) & 0xf],
-						g_hex[ (segment.m_data >> 0) & 0xf],
-						'\0'
-					};
-					pack->m_headers["Src MAC"] = tmp;
+					pack->SetHeader(names.srcMac, segment.m_data, PacketHeader::FORMAT_MAC);
 
 					//Reset for next block of the frame
 					segment.m_type = EthernetFrameSegment::TYPE_ETHERTYPE;
@@ -665,7 +632,7 @@ void EthernetProtocolDecoder::BytesToFramesUnitTimescale(
 					if(ethertype < 1500)
 					{
 						//Default to unknown LLC
-						pack->m_headers["Ethertype"] = "LLC";
+						pack->SetHeader(names.ethertype, names.llc);
 						pack->m_displayBackgroundColor = "#33a02c";
 						pack->m_displayForegroundColor = "#000000";
 
@@ -674,7 +641,7 @@ void EthernetProtocolDecoder::BytesToFramesUnitTimescale(
 						{
 							if(bytes[i+1] == 0x42)
 							{
-								pack->m_headers["Ethertype"] = "STP";
+								pack->SetHeader(names.ethertype, names.stp);
 								pack->m_displayBackgroundColor = "#fdbf6f";
 								pack->m_displayForegroundColor = "#000000";
 							}
@@ -685,38 +652,38 @@ void EthernetProtocolDecoder::BytesToFramesUnitTimescale(
 						switch(ethertype)
 						{
 							case 0x0800:
-								pack->m_headers["Ethertype"] = "IPv4";
+								pack->SetHeader(names.ethertype, names.ipv4);
 								pack->m_displayBackgroundColor = "#a6cee3";
 								pack->m_displayForegroundColor = "#000000";
 								break;
 
 							case 0x0806:
-								pack->m_headers["Ethertype"] = "ARP";
+								pack->SetHeader(names.ethertype, names.arp);
 								pack->m_displayBackgroundColor = "#ffff99";
 								pack->m_displayForegroundColor = "#000000";
 								break;
 
 							//TODO: decoder inner ethertype too?
 							case 0x8100:
-								pack->m_headers["Ethertype"] = "802.1q";
+								pack->SetHeader(names.ethertype, names.dot1q);
 								pack->m_displayBackgroundColor = "#b2df8a";
 								pack->m_displayForegroundColor = "#000000";
 								break;
 
 							case 0x86DD:
-								pack->m_headers["Ethertype"] = "IPv6";
+								pack->SetHeader(names.ethertype, names.ipv6);
 								pack->m_displayBackgroundColor = "#1f78b4";
 								pack->m_displayForegroundColor = "#ffffff";
 								break;
 
 							case 0x88cc:
-								pack->m_headers["Ethertype"] = "LLDP";
+								pack->SetHeader(names.ethertype, names.lldp);
 								pack->m_displayBackgroundColor = "#5e4fa2";
 								pack->m_displayForegroundColor = "#ffffff";
 								break;
 
 							default:
-								pack->m_headers["Ethertype"] = to_string_hex(segment.m_data);
+								pack->SetHeader(names.ethertype, segment.m_data, PacketHeader::FORMAT_HEX);
 								pack->m_displayBackgroundColor = "#fb9a99";
 								pack->m_displayForegroundColor = "#000000";
 								break;
@@ -781,13 +748,13 @@ void EthernetProtocolDecoder::BytesToFramesUnitTimescale(
 					cap->m_durations.push_back(ends[i] - start);
 					cap->m_samples.push_back(segment);
 
+					//Format the content for display
+					pack->SetHeader(names.vlan, segment.m_data & 0xfff);
+
 					//Reset for the internal ethertype
 					segment.m_type = EthernetFrameSegment::TYPE_ETHERTYPE;
 					segment.m_data = 0;
 					nbytes = 0;
-
-					//Format the content for display
-					pack->m_headers["VLAN"] = to_string(segment.m_data & 0xfff);
 				}
 
 				break;
@@ -867,88 +834,39 @@ void EthernetProtocolDecoder::BytesToFramesUnitTimescale(
 	delete pack;
 }
 
-string EthernetWaveform::GetColor(size_t i)
-{
-	switch(m_samples[i].m_type)
-	{
-		//Preamble/SFD: gray (not interesting)
-		case EthernetFrameSegment::TYPE_INBAND_STATUS:
-		case EthernetFrameSegment::TYPE_PREAMBLE:
-		case EthernetFrameSegment::TYPE_SFD:
-			return StandardColors::colors[StandardColors::COLOR_PREAMBLE];
-
-		//MAC addresses (src or dest)
-		case EthernetFrameSegment::TYPE_DST_MAC:
-		case EthernetFrameSegment::TYPE_SRC_MAC:
-			return StandardColors::colors[StandardColors::COLOR_ADDRESS];
-
-		//Control codes
-		case EthernetFrameSegment::TYPE_ETHERTYPE:
-		case EthernetFrameSegment::TYPE_VLAN_TAG:
-			return StandardColors::colors[StandardColors::COLOR_CONTROL];
-
-		case EthernetFrameSegment::TYPE_FCS_GOOD:
-			return StandardColors::colors[StandardColors::COLOR_CHECKSUM_OK];
-		case EthernetFrameSegment::TYPE_FCS_BAD:
-			return StandardColors::colors[StandardColors::COLOR_CHECKSUM_BAD];
-
-		//Signal has entirely disappeared, or fault condition reported
-		case EthernetFrameSegment::TYPE_NO_CARRIER:
-		case EthernetFrameSegment::TYPE_TX_ERROR:
-		case EthernetFrameSegment::TYPE_REMOTE_FAULT:
-		case EthernetFrameSegment::TYPE_LOCAL_FAULT:
-		case EthernetFrameSegment::TYPE_LINK_INTERRUPTION:
-			return StandardColors::colors[StandardColors::COLOR_ERROR];
-
-		//Payload
-		default:
-			return StandardColors::colors[StandardColors::COLOR_DATA];
-	}
-}
-
-void EthernetWaveform::PreCacheColors()
+vector<string> EthernetWaveform::GetColorPalette()
 {
 	//must be same order as SegmentType in header
-	uint32_t colors[] =
+	return
 	{
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_DATA]),			//TYPE_INVALID
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_PREAMBLE]),		//TYPE_PREAMBLE
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_PREAMBLE]),		//TYPE_SFD
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_ADDRESS]),			//TYPE_DST_MAC
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_ADDRESS]),			//TYPE_SRC_MAC
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_CONTROL]),			//TYPE_ETHERTYPE
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_CONTROL]),			//TYPE_VLAN_TAG
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_DATA]),			//TYPE_PAYLOAD
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_CHECKSUM_OK]),		//TYPE_FCS_GOOD
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_CHECKSUM_BAD]),	//TYPE_FCS_BAD
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_PREAMBLE]),		//TYPE_INBAND_STATUS
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_ERROR]),			//TYPE_NO_CARRIER
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_ERROR]),			//TYPE_REMOTE_FAULT
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_ERROR]),			//TYPE_LOCAL_FAULT
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_ERROR]),			//TYPE_LINK_INTERRUPTION
-		ColorFromString(StandardColors::colors[StandardColors::COLOR_ERROR])			//TYPE_TX_ERROR
+		StandardColors::colors[StandardColors::COLOR_DATA],			//TYPE_INVALID
+		StandardColors::colors[StandardColors::COLOR_PREAMBLE],		//TYPE_PREAMBLE
+		StandardColors::colors[StandardColors::COLOR_PREAMBLE],		//TYPE_SFD
+		StandardColors::colors[StandardColors::COLOR_ADDRESS],		//TYPE_DST_MAC
+		StandardColors::colors[StandardColors::COLOR_ADDRESS],		//TYPE_SRC_MAC
+		StandardColors::colors[StandardColors::COLOR_CONTROL],		//TYPE_ETHERTYPE
+		StandardColors::colors[StandardColors::COLOR_CONTROL],		//TYPE_VLAN_TAG
+		StandardColors::colors[StandardColors::COLOR_DATA],			//TYPE_PAYLOAD
+		StandardColors::colors[StandardColors::COLOR_CHECKSUM_OK],	//TYPE_FCS_GOOD
+		StandardColors::colors[StandardColors::COLOR_CHECKSUM_BAD],	//TYPE_FCS_BAD
+		StandardColors::colors[StandardColors::COLOR_PREAMBLE],		//TYPE_INBAND_STATUS
+		StandardColors::colors[StandardColors::COLOR_ERROR],		//TYPE_NO_CARRIER
+		StandardColors::colors[StandardColors::COLOR_ERROR],		//TYPE_REMOTE_FAULT
+		StandardColors::colors[StandardColors::COLOR_ERROR],		//TYPE_LOCAL_FAULT
+		StandardColors::colors[StandardColors::COLOR_ERROR],		//TYPE_LINK_INTERRUPTION
+		StandardColors::colors[StandardColors::COLOR_ERROR]			//TYPE_TX_ERROR
 	};
+}
 
-	m_cachedColorRevision = m_revision;
-
-	auto s = size();
-	m_protocolColors.resize(s);
-	m_protocolColors.PrepareForCpuAccess();
-
-	for(size_t i=0; i<s; i++)
-	{
-		auto type = m_samples[i].m_type;
-
-		//bounds check
-		if( (type > EthernetFrameSegment::TYPE_TX_ERROR) || (type < 0) )
-			m_protocolColors[i] = colors[EthernetFrameSegment::TYPE_TX_ERROR];
+uint8_t EthernetWaveform::GetColorIndex(size_t i)
+{
+	auto type = m_samples[i].m_type;
 
-		//table lookup
-		else
-			m_protocolColors[i] = colors[type];
-	}
+	//bounds check
+	if( (type > EthernetFrameSegment::TYPE_TX_ERROR) || (type < 0) )
+		return EthernetFrameSegment::TYPE_TX_ERROR;
 
-	m_protocolColors.MarkModifiedFromCpu();
+	return type;
 }
 
 string EthernetWaveform::GetText(size_t i)
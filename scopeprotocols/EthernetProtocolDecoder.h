@@ -85,9 +85,8 @@ public:
 		: SparseWaveform<EthernetFrameSegment>()
 	{};
 	virtual std::string GetText(size_t) override;
-	virtual std::string GetColor(size_t) override;
-
-	void PreCacheColors();
+	virtual std::vector<std::string> GetColorPalette() override;
+	virtual uint8_t GetColorIndex(size_t i) override;
 };
 
 class EthernetProtocolDecoder : public PacketDecoder
@@ -50,6 +50,7 @@ EyePattern::EyePattern(const string& color)
 	, m_xoff(0)
 	, m_xscale(0)
 	, m_lastClockAlign(ALIGN_CENTER)
+	, m_lastIntegrationMode(INTEGRATE_ACQUISITION)
 	, m_saturationName("Saturation Level")
 	, m_centerName("Center Voltage")
 	, m_maskName("Mask")
@@ -60,6 +61,12 @@ EyePattern::EyePattern(const string& color)
 	, m_rateModeName("Bit Rate Mode")
 	, m_rateName("Bit Rate")
 	, m_numLevelsName("Modulation Levels")
+	, m_integrationModeName("Integration Mode")
+	, m_batchSizeName("Batch Size")
+	, m_hitLimitName("Mask Hit Limit")
+	, m_rateLimitName("Mask Hit Rate Limit")
+	, m_incrementalHits(0)
+	, m_maskLimitExceeded(false)
 	, m_clockEdges("EyePattern.clockEdges")
 	, m_indexBuffer("EyePattern.indexBuffer")
 {
@@ -67,6 +74,7 @@ EyePattern::EyePattern(const string& color)
 	AddStream(Unit(Unit::UNIT_RATIO_SCI), "hitrate", Stream::STREAM_TYPE_ANALOG_SCALAR);
 	AddStream(Unit(Unit::UNIT_UI), "uisIntegrated", Stream::STREAM_TYPE_ANALOG_SCALAR);
 	AddStream(Unit(Unit::UNIT_SAMPLEDEPTH), "samplesIntegrated", Stream::STREAM_TYPE_ANALOG_SCALAR);
+	AddStream(Unit(Unit::UNIT_FS), "batchLatency", Stream::STREAM_TYPE_ANALOG_SCALAR);
 
 	CreateInput<InputConstraintStreamType>("din", Stream::STREAM_TYPE_ANALOG);
 	CreateInput<InputConstraintStreamType>("clk", Stream::STREAM_TYPE_DIGITAL);
@@ -111,6 +119,21 @@ EyePattern::EyePattern(const string& color)
 	m_parameters[m_rateName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_BITRATE));
 	m_parameters[m_rateName].SetIntVal(1250000000);
 
+	m_parameters[m_integrationModeName] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_integrationModeName].AddEnumValue("Full acquisition", INTEGRATE_ACQUISITION);
+	m_parameters[m_integrationModeName].AddEnumValue("Incremental", INTEGRATE_INCREMENTAL);
+	m_parameters[m_integrationModeName].SetIntVal(INTEGRATE_ACQUISITION);
+
+	m_parameters[m_batchSizeName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_UI));
+	m_parameters[m_batchSizeName].SetIntVal(100000);
+
+	//zero means no limit
+	m_parameters[m_hitLimitName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_hitLimitName].SetIntVal(0);
+
+	m_parameters[m_rateLimitName] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_RATIO_SCI));
+	m_parameters[m_rateLimitName].SetFloatVal(0);
+
 	if(g_hasShaderInt64 && g_hasShaderAtomicInt64)
 	{
 		m_scratchZeroComputePipeline =
@@ -214,10 +237,36 @@ void EyePattern::Refresh(
 		m_lastClockAlign = clock_align;
 	}
 
+	//If integration mode was changed, reset existing eye data so the incremental hit count stays consistent
+	auto integration_mode = static_cast<IntegrationMode>(m_parameters[m_integrationModeName].GetIntVal());
+	bool incremental = (integration_mode == INTEGRATE_INCREMENTAL);
+	if(m_lastIntegrationMode != integration_mode)
+	{
+		SetData(nullptr, 0);
+		cap = nullptr;
+		m_lastIntegrationMode = integration_mode;
+	}
+
 	//Load the mask, if needed
+	//(hits counted incrementally against the old mask are meaningless, so start over)
 	string maskpath = m_parameters[m_maskName].GetFileName();
-	if(maskpath != m_mask.GetFileName())
+	if(maskpath != m_maskPath)
+	{
+		m_maskPath = maskpath;
 		m_mask.Load(maskpath);
+		if(incremental)
+		{
+			SetData(nullptr, 0);
+			cap = nullptr;
+		}
+	}
+
+	//If a previous incremental run already failed the mask test, stop integrating until the eye is cleared
+	if(cap && incremental && m_maskLimitExceeded)
+	{
+		AddErrorMessage("Mask test failed", "Mask hit limit exceeded, integration stopped. Clear sweeps to restart.");
+		return;
+	}
 
 	//Initialize the capture
 	//TODO: timestamps? do we need those?
@@ -235,7 +284,6 @@ void EyePattern::Refresh(
 	}
 	cap->m_saturationLevel = m_parameters[m_saturationName].GetFloatVal();
 	cap->m_numLevels = m_parameters[m_numLevelsName].GetIntVal();
-	int64_t* data = cap->GetAccumData();
 
 	//Find all toggles in the clock
 	auto sclk = dynamic_cast<SparseDigitalWaveform*>(clock);
@@ -334,13 +382,56 @@ void EyePattern::Refresh(
 	int32_t xmax = m_width - 1;
 	auto swfm = dynamic_cast<SparseAnalogWaveform*>(waveform);
 	auto uwfm = dynamic_cast<UniformAnalogWaveform*>(waveform);
+	size_t uisIntegrated = m_clockEdgesMuxed->size();
+	size_t samplesIntegrated = waveform->size();
+	bool hasMask = (m_mask.GetFileName() != "") && !m_mask.empty();
 	if(m_xscale > FLT_EPSILON)
 	{
+		//Everything but the GPU path integrates into the accumulator on the CPU
+		bool gpuIntegrate = !incremental && uwfm && g_hasShaderInt64 && g_hasShaderAtomicInt64;
+		int64_t* data = nullptr;
+		if(!gpuIntegrate)
+		{
+			cap->GetAccumBuffer().PrepareForCpuAccess();
+			data = cap->GetAccumData();
+		}
+
+		//Incremental integration: CPU only, batch by batch, counting mask hits as we go
+		if(incremental)
+		{
+			const uint8_t* hitWeights = nullptr;
+			if(hasMask)
+			{
+				PrepareHitWeights(cap);
+				hitWeights = m_hitWeights.data();
+			}
+
+			bool failed;
+			if(uwfm)
+			{
+				failed = IncrementalInnerLoop(
+					uwfm, data, wend, cend, xmax, ymax, xtimescale, yscale, yoff,
+					hitWeights, uisIntegrated, samplesIntegrated);
+			}
+			else
+			{
+				failed = IncrementalInnerLoop(
+					swfm, data, wend, cend, xmax, ymax, xtimescale, yscale, yoff,
+					hitWeights, uisIntegrated, samplesIntegrated);
+			}
+
+			if(failed)
+			{
+				m_maskLimitExceeded = true;
+				AddErrorMessage("Mask test failed", "Mask hit limit exceeded, integration stopped. Clear sweeps to restart.");
+			}
+		}
+
 		//Optimized inner loop for uniformly sampled waveforms
-		if(uwfm)
+		else if(uwfm)
 		{
 			//GPU path requires native int64 support with atomics
-			if(g_hasShaderInt64 && g_hasShaderAtomicInt64)
+			if(gpuIntegrate)
 			{
 				DensePackedInnerLoopGPU(
 					cmdBuf,
@@ -374,6 +465,9 @@ void EyePattern::Refresh(
 		//Normal main loop
 		else
 			SparsePackedInnerLoop(swfm, data, wend, cend, xmax, ymax, xtimescale, yscale, yoff);
+
+		if(!gpuIntegrate)
+			cap->GetAccumBuffer().MarkModifiedFromCpu();
 	}
 	else
 	{
@@ -381,7 +475,7 @@ void EyePattern::Refresh(
 	}
 
 	//Count total number of UIs we've integrated
-	cap->IntegrateUIs(m_clockEdgesMuxed->size(), waveform->size());
+	cap->IntegrateUIs(uisIntegrated, samplesIntegrated);
 
 	//Normalize the waveform and copy the right to the left
 	if(g_hasShaderInt64 && g_hasShaderAtomicInt64)
@@ -472,10 +566,205 @@ void EyePattern::Refresh(
 	m_streams[3].m_value = cap->GetTotalSamples();
 
 	//If we have an eye mask, prepare it for processing
-	if(m_mask.GetFileName() != "")
+	//In incremental mode the hits were already counted during integration
+	if(incremental && hasMask)
+	{
+		float rate = m_incrementalHits * 1.0 / (cap->GetTotalSamples() * EYE_ACCUM_SCALE);
+		m_streams[1].m_value = rate;
+		cap->SetMaskHitRate(rate);
+	}
+	else if(m_mask.GetFileName() != "")
 		DoMaskTest(cap);
 }
 
+/**
+	@brief Builds the per-pixel mask hit weights for incremental integration
+
+	Samples are only plotted into the right half of the accumulator, then copied to the left half by Normalize().
+	To get the same hit count CalculateHitRate() would see after normalization, each right-half pixel is weighted by
+	how many of its two copies fall inside the mask.
+ */
+void EyePattern::PrepareHitWeights(EyeWaveform* cap)
+{
+	//Nothing to do if the mask hasn't been re-rendered since last time
+	auto raster = m_mask.GetRaster(cap, m_width, m_height, GetVoltageRange(0), m_xscale, m_xoff);
+	if(raster == m_hitWeightsRaster)
+		return;
+	m_hitWeightsRaster = raster;
+
+	size_t halfwidth = m_width / 2;
+	m_hitWeights.clear();
+	m_hitWeights.resize(m_width * m_height, 0);
+	for(size_t y=0; y<m_height; y++)
+	{
+		auto wrow = m_hitWeights.data() + y*m_width;
+		for(auto span = raster->GetRowBegin(y); span != raster->GetRowEnd(y); span++)
+		{
+			for(size_t x=span->m_start; x<span->m_end; x++)
+			{
+				wrow[x] ++;
+				if(x + halfwidth < m_width)
+					wrow[x + halfwidth] ++;
+			}
+		}
+	}
+}
+
+/**
+	@brief Integrates an acquisition in batches of UIs, counting mask hits as samples are plotted
+
+	Produces the same accumulator contents as the full-acquisition inner loops. Between batches the running hit count
+	is checked against the configured limits, so a failing link is detected without waiting for the whole acquisition.
+
+	@param waveform				Input waveform (sparse or uniform)
+	@param hitWeights			Per-pixel mask hit weights, or null if there is no mask
+	@param uisIntegrated		Number of UIs actually integrated
+	@param samplesIntegrated	Number of samples actually integrated
+
+	@return True if a mask hit limit was exceeded and integration stopped early
+ */
+template<class T>
+bool EyePattern::IncrementalInnerLoop(
+	T* waveform,
+	int64_t* data,
+	size_t wend,
+	size_t cend,
+	int32_t xmax,
+	int32_t ymax,
+	float xtimescale,
+	float yscale,
+	float yoff,
+	const uint8_t* hitWeights,
+	size_t& uisIntegrated,
+	size_t& samplesIntegrated
+	)
+{
+	m_clockEdgesMuxed->PrepareForCpuAccess();
+	waveform->PrepareForCpuAccess();
+	auto& edges = *m_clockEdgesMuxed;
+
+	auto cap = dynamic_cast<EyeWaveform*>(GetData(0));
+	int64_t width = cap->GetUIWidth();
+	int64_t halfwidth = width/2;
+
+	size_t batchSize = max(m_parameters[m_batchSizeName].GetIntVal(), (int64_t)1);
+	size_t hitLimit = max(m_parameters[m_hitLimitName].GetIntVal(), (int64_t)0);
+	double rateLimit = m_parameters[m_rateLimitName].GetFloatVal();
+
+	size_t nbatches = 0;
+	double totalLatency = 0;
+	double maxLatency = 0;
+	bool failed = false;
+
+	size_t i = 0;
+	size_t iclock = 0;
+	while( (i < wend) && (iclock < cend) )
+	{
+		double tstartBatch = GetTime();
+
+		//Same math as DensePackedInnerLoop / SparsePackedInnerLoop, just stopping at the end of the batch
+		size_t cstop = min(cend, iclock + batchSize);
+		for(; i<wend && iclock < cstop; i++)
+		{
+			//Find time of this sample.
+			//If it's past the end of the current UI, move to the next clock edge
+			int64_t tstart = GetOffsetScaled(waveform, i);
+			int64_t offset = tstart - edges[iclock];
+			if(offset < 0)
+				continue;
+			size_t nextclk = iclock + 1;
+			int64_t tnext = edges[nextclk];
+			if(tstart >= tnext)
+			{
+				//Move to the next clock edge
+				iclock ++;
+				if(iclock >= cend)
+					break;
+
+				//Figure out the offset to the next edge
+				offset = tstart - tnext;
+			}
+
+			//Drop anything past half a UI if the next clock edge is a long ways out
+			//(this is needed for irregularly sampled data like DDR RAM)
+			int64_t ttnext = tnext - tstart;
+			if( (offset > halfwidth) && (ttnext > width) )
+				continue;
+
+			//Interpolate position
+			int64_t dt = GetOffset(waveform, i+1) - GetOffset(waveform, i);
+			float pixel_x_f = (offset - m_xoff) * m_xscale;
+			float pixel_x_fround = floor(pixel_x_f);
+			float dx_frac = (pixel_x_f - pixel_x_fround ) / (dt * xtimescale );
+
+			//Early out if off end of plot
+			int32_t pixel_x_round = floor(pixel_x_f);
+			if(pixel_x_round > xmax)
+				continue;
+
+			//Interpolate voltage, early out if clipping
+			float dv = waveform->m_samples[i+1] - waveform->m_samples[i];
+			float nominal_voltage = waveform->m_samples[i] + dv*dx_frac;
+			float nominal_pixel_y = nominal_voltage*yscale + yoff;
+			int32_t y1 = static_cast<int32_t>(nominal_pixel_y);
+			if( (y1 >= ymax) || (y1 < 0) )
+				continue;
+
+			//Calculate how much of the pixel's intensity to put in each row
+			float yfrac = nominal_pixel_y - floor(nominal_pixel_y);
+			int32_t bin2 = yfrac * EYE_ACCUM_SCALE;
+			size_t off = y1*m_width + pixel_x_round;
+			int64_t* pix = data + off;
+
+			//Plot each point (this only draws the right half of the eye, we copy to the left later)
+			pix[0] 		 += EYE_ACCUM_SCALE - bin2;
+			pix[m_width] += bin2;
+
+			//Count mask hits on the fly
+			if(hitWeights)
+				m_incrementalHits += (EYE_ACCUM_SCALE - bin2)*hitWeights[off] + bin2*hitWeights[off + m_width];
+		}
+
+		double dt = GetTime() - tstartBatch;
+		totalLatency += dt;
+		maxLatency = max(maxLatency, dt);
+		nbatches ++;
+
+		//Check the running totals against the limits
+		if(hitWeights)
+		{
+			size_t nsamples = cap->GetTotalSamples() + i;
+			if( (hitLimit > 0) && (m_incrementalHits / EYE_ACCUM_SCALE >= hitLimit) )
+				failed = true;
+			else if( (rateLimit > 0) && (m_incrementalHits > rateLimit * nsamples * EYE_ACCUM_SCALE) )
+				failed = true;
+
+			if(failed)
+			{
+				LogTrace("Mask hit limit exceeded after %zu batches (%zu hits)\n",
+					nbatches, m_incrementalHits / EYE_ACCUM_SCALE);
+				break;
+			}
+		}
+	}
+
+	//Only report what we actually integrated if we stopped early
+	if(failed)
+	{
+		uisIntegrated = iclock;
+		samplesIntegrated = i;
+	}
+
+	if(nbatches)
+	{
+		m_streams[4].m_value = totalLatency * FS_PER_SECOND / nbatches;
+		LogTrace("Integrated %zu batches, mean latency %.3f ms, max %.3f ms\n",
+			nbatches, totalLatency * 1000 / nbatches, maxLatency * 1000);
+	}
+
+	return failed;
+}
+
 /**
 	@brief Finds the mass weighted center of a histogram peak
  */
@@ -692,8 +981,6 @@ void EyePattern::DensePackedInnerLoopAVX2(
 		pix[0] 		 += EYE_ACCUM_SCALE - bin2;
 		pix[m_width] += bin2;
 	}
-
-	waveform->MarkModifiedFromCpu();
 }
 
 __attribute__((target("avx2,fma")))
@@ -891,8 +1178,6 @@ void EyePattern::DensePackedInnerLoopAVX2FMA(
 		pix[0] 		 += EYE_ACCUM_SCALE - bin2;
 		pix[m_width] += bin2;
 	}
-
-	waveform->MarkModifiedFromCpu();
 }
 
 __attribute__((target("avx512f,fma")))
@@ -1081,8 +1366,6 @@ void EyePattern::DensePackedInnerLoopAVX512F(
 		pix[0] 		 += EYE_ACCUM_SCALE - bin2;
 		pix[m_width] += bin2;
 	}
-
-	waveform->MarkModifiedFromCpu();
 }
 #endif /* __x86_64__ */
 
@@ -1266,8 +1549,6 @@ void EyePattern::DensePackedInnerLoop(
 		pix[0] 		 += 64 - bin2;
 		pix[m_width] += bin2;
 	}
-
-	waveform->MarkModifiedFromCpu();
 }
 
 void EyePattern::SparsePackedInnerLoop(
@@ -1346,8 +1627,6 @@ void EyePattern::SparsePackedInnerLoop(
 		pix[0] 		 += 64 - bin2;
 		pix[m_width] += bin2;
 	}
-
-	waveform->MarkModifiedFromCpu();
 }
 
 EyeWaveform* EyePattern::ReallocateWaveform()
@@ -1355,6 +1634,9 @@ EyeWaveform* EyePattern::ReallocateWaveform()
 	auto cap = new EyeWaveform(m_width, m_height, m_parameters[m_centerName].GetFloatVal(), EyeWaveform::EYE_NORMAL);
 	cap->m_timescale = 1;
 	SetData(cap, 0);
+
+	m_incrementalHits = 0;
+	m_maskLimitExceeded = false;
 	return cap;
 }
 
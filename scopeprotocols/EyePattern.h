@@ -142,6 +142,12 @@ public:
 		MODE_FIXED
 	};
 
+	enum IntegrationMode
+	{
+		INTEGRATE_ACQUISITION,
+		INTEGRATE_INCREMENTAL
+	};
+
 	PROTOCOL_DECODER_INITPROC(EyePattern)
 
 protected:
@@ -173,6 +179,24 @@ protected:
 		float yoff
 		);
 
+	template<class T>
+	bool IncrementalInnerLoop(
+		T* waveform,
+		int64_t* data,
+		size_t wend,
+		size_t cend,
+		int32_t xmax,
+		int32_t ymax,
+		float xtimescale,
+		float yscale,
+		float yoff,
+		const uint8_t* hitWeights,
+		size_t& uisIntegrated,
+		size_t& samplesIntegrated
+		);
+
+	void PrepareHitWeights(EyeWaveform* cap);
+
 	void DensePackedInnerLoopGPU(
 		vk::raii::CommandBuffer& cmdBuf,
 		std::shared_ptr<QueueHandle> queue,
@@ -231,6 +255,7 @@ protected:
 	int64_t m_xoff;
 	float m_xscale;
 	ClockAlignment m_lastClockAlign;
+	IntegrationMode m_lastIntegrationMode;
 
 	std::string m_saturationName;
 	std::string m_centerName;
@@ -242,9 +267,33 @@ protected:
 	std::string m_rateModeName;
 	std::string m_rateName;
 	std::string m_numLevelsName;
+	std::string m_integrationModeName;
+	std::string m_batchSizeName;
+	std::string m_hitLimitName;
+	std::string m_rateLimitName;
 
 	EyeMask m_mask;
 
+	///@brief Path m_mask was last loaded from, even if the load failed (so we don't retry every refresh)
+	std::string m_maskPath;
+
+	/**
+		@brief Mask hit weight for each pixel in the right half of the eye (incremental mode only)
+
+		Each sample is only plotted in the right half of the accumulator and mirrored to the left during normalization,
+		so a pixel's weight is the number of times it lands inside the mask counting both copies.
+	 */
+	std::vector<uint8_t> m_hitWeights;
+
+	///@brief The mask raster m_hitWeights was generated from
+	std::shared_ptr<const EyeMaskRaster> m_hitWeightsRaster;
+
+	///@brief Mask hits counted during incremental integration, in EYE_ACCUM_SCALE units
+	size_t m_incrementalHits;
+
+	///@brief True if incremental integration stopped early because the mask hit limit was exceeded
+	bool m_maskLimitExceeded;
+
 	AcceleratorBuffer<int64_t> m_clockEdges;
 	AcceleratorBuffer<uint32_t> m_indexBuffer;
 
@@ -104,6 +104,10 @@ string FFTFilter::GetProtocolName()
 
 uint32_t FFTFilter::GetExecutionCapabilitiesMask()
 {
+	//Native CPU FFT doesn't touch the command buffer at all
+	if(UseCPUFFT())
+		return 0;
+
 	if(m_numpeaks.GetIntVal() > 0)
 	{
 		return
@@ -126,6 +130,22 @@ void FFTFilter::ReallocateBuffers(size_t npoints_raw, size_t npoints, size_t nou
 	if(m_cachedNumPointsFFT != npoints)
 		m_cachedNumPointsFFT = npoints;
 
+	//Software Vulkan: run the FFT natively and keep the scratch buffers on the CPU side
+	if(UseCPUFFT())
+	{
+		m_rdinbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		m_rdinbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+		m_rdoutbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		m_rdoutbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+
+		m_vkPlan = nullptr;
+		m_cpuPlan = CPUFFTPlan::Get(npoints, CPUFFTPlan::DIRECTION_FORWARD);
+
+		m_rdinbuf.resize(npoints);
+		m_rdoutbuf.resize(2*nouts);
+		return;
+	}
+
 	//Update our FFT plan if it's out of date
 	m_rdinbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
 	m_rdinbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
@@ -262,6 +282,14 @@ void FFTFilter::DoRefresh(
 	}
 	args.alpha1 = 1 - args.alpha0;
 
+	if(UseCPUFFT())
+	{
+		DoRefreshCPU(cap, data, args, window, nouts, scale, log_output);
+		if(m_numpeaks.GetIntVal() > 0)
+			FindPeaks(cap, cmdBuf, queue);
+		return;
+	}
+
 	{
 		NamedDebugRange debugRange(cmdBuf, "FFTFilter");
 		const uint32_t compute_block_count = GetComputeBlockCount(npoints, 64);
@@ -338,3 +366,70 @@ void FFTFilter::DoRefresh(
 		FindPeaks(cap, cmdBuf, queue);
 	}
 }
+
+/**
+	@brief Native CPU implementation of the window / FFT / magnitude pipeline, for software Vulkan devices
+
+	Does exactly the same math as the shaders in DoRefresh().
+ */
+void FFTFilter::DoRefreshCPU(
+	UniformAnalogWaveform* cap,
+	AcceleratorBuffer<float>& data,
+	const WindowFunctionArgs& args,
+	WindowFunction window,
+	size_t nouts,
+	float scale,
+	bool log_output)
+{
+	data.PrepareForCpuAccess();
+	m_rdinbuf.PrepareForCpuAccess();
+	m_rdoutbuf.PrepareForCpuAccess();
+	cap->PrepareForCpuAccess();
+
+	//Apply the window function
+	switch(window)
+	{
+		case WINDOW_BLACKMAN_HARRIS:
+			CPUFFTPlan::ApplyBlackmanHarrisWindow(data.GetCpuPointer(), m_rdinbuf.GetCpuPointer(), args);
+			break;
+
+		case WINDOW_HANN:
+		case WINDOW_HAMMING:
+			CPUFFTPlan::ApplyCosineSumWindow(data.GetCpuPointer(), m_rdinbuf.GetCpuPointer(), args);
+			break;
+
+		default:
+		case WINDOW_RECTANGULAR:
+			CPUFFTPlan::ApplyRectangularWindow(data.GetCpuPointer(), m_rdinbuf.GetCpuPointer(), args);
+			break;
+	}
+
+	//Do the actual FFT operation
+	m_cpuPlan->Forward(m_rdinbuf.GetCpuPointer(), m_rdoutbuf.GetCpuPointer());
+
+	//Convert complex to real
+	float* fin = m_rdoutbuf.GetCpuPointer();
+	float* fout = cap->m_samples.GetCpuPointer();
+	if(log_output)
+	{
+		const float impedance = 50;
+		float lscale = scale * scale / impedance;
+		for(size_t i=0; i<nouts; i++)
+		{
+			float re = fin[i*2];
+			float im = fin[i*2 + 1];
+			fout[i] = 10 * log10f( (re*re + im*im) * lscale) + 30;
+		}
+	}
+	else
+	{
+		for(size_t i=0; i<nouts; i++)
+		{
+			float re = fin[i*2];
+			float im = fin[i*2 + 1];
+			fout[i] = sqrtf(re*re + im*im) * scale;
+		}
+	}
+
+	cap->MarkModifiedFromCpu();
+}
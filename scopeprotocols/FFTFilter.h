@@ -36,6 +36,7 @@
 #define FFTFilter_h
 
 #include "VulkanFFTPlan.h"
+#include "CPUFFTPlan.h"
 
 class QueueHandle;
 
@@ -87,6 +88,19 @@ protected:
 
 	void ReallocateBuffers(size_t npoints_raw, size_t npoints, size_t nouts);
 
+	///@brief Returns true if the FFT should run natively on the CPU rather than through Vulkan
+	bool UseCPUFFT()
+	{ return CPUFFTPlan::IsPreferred(); }
+
+	void DoRefreshCPU(
+		UniformAnalogWaveform* cap,
+		AcceleratorBuffer<float>& data,
+		const WindowFunctionArgs& args,
+		WindowFunction window,
+		size_t nouts,
+		float scale,
+		bool log_output);
+
 	void DoRefresh(
 		WaveformBase* din,
 		AcceleratorBuffer<float>& data,
@@ -110,6 +124,7 @@ protected:
 	std::string m_windowName;
 
 	std::unique_ptr<VulkanFFTPlan> m_vkPlan;
+	std::shared_ptr<CPUFFTPlan> m_cpuPlan;
 
 	ComputePipeline m_blackmanHarrisComputePipeline;
 	ComputePipeline m_rectangularComputePipeline;
@@ -40,6 +40,25 @@
 
 using namespace std;
 
+/**
+	@brief Interned names and values of the packet headers set by the I2C decoder
+ */
+struct I2CHeaderNames
+{
+	const string* address = Packet::Intern("Address");
+	const string* op = Packet::Intern("Op");
+	const string* len = Packet::Intern("Len");
+
+	const string* read = Packet::Intern("Read");
+	const string* write = Packet::Intern("Write");
+};
+
+static const I2CHeaderNames& GetHeaderNames()
+{
+	static const I2CHeaderNames names;
+	return names;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -73,21 +92,151 @@ vector<string> I2CDecoder::GetHeaders()
 template<class T, class U>
 void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 {
-	Packet* pack = nullptr;
+	//Split the capture after STOP conditions and decode the pieces in parallel
+	vector<SegmentStart> starts;
+	vector<DecodeState> entries;
+	FindSegments(sda, scl, starts, entries);
+
+	SegmentSymbols<I2CSymbol> symbols;
+	auto state = SegmentedDecode::Run(entries, symbols,
+		[&](size_t i, DecodeState& st, SegmentSymbols<I2CSymbol>& out)
+		{
+			int64_t tnext = INT64_MAX;
+			if(i+1 < starts.size())
+				tnext = starts[i+1].m_timestamp;
+			DecodeSegment(sda, scl, starts[i], tnext, st, out);
+		});
+
+	symbols.Commit(cap, m_packets);
+
+	if(state.m_pack)
+		delete state.m_pack;
+}
+
+/**
+	@brief Finds points to split a capture for decoding in parallel
+
+	Each segment after the first starts at the first event after a STOP condition. The decoder has just emitted the
+	STOP symbol and finished its packet there, so we know exactly what state it should be in.
+
+	@param sda		SDA waveform
+	@param scl		SCL waveform
+	@param starts	Position of the start of each segment
+	@param entries	Expected decoder state at the start of each segment
+ */
+template<class T, class U>
+void I2CDecoder::FindSegments(T* sda, U* scl, vector<SegmentStart>& starts, vector<DecodeState>& entries)
+{
+	size_t sdalen = sda->size();
+	size_t scllen = scl->size();
+
+	//Look for one STOP in each evenly spaced window of SDA samples
+	size_t count = SegmentedDecode::GetSegmentCount(sdalen);
+	vector<SegmentStart> candidates(count);
+	vector<int64_t> stops(count, 0);
+
+	#pragma omp parallel for if(count > 2)
+	for(size_t i=1; i<count; i++)
+	{
+		candidates[i].m_timestamp = INT64_MAX;
+
+		size_t end = ((i+1) * sdalen) / count;
+		size_t j = (i * sdalen) / count;
+		while(j < end)
+		{
+			//Find the next rising edge on SDA
+			size_t low = SegmentedDecode::FindNextValue(sda, j, end, false);
+			if(low >= end)
+				break;
+			size_t rise = SegmentedDecode::FindNextValue(sda, low, sdalen, true);
+			if(rise >= sdalen)
+				break;
+			j = rise;
+
+			//It's a STOP if SCL is high
+			int64_t tstop = ::GetOffsetScaled(sda, rise);
+			size_t iscl = SegmentedDecode::GetIndexAtTimestampScaled(scl, scllen, tstop);
+			if(!scl->m_samples[iscl])
+				continue;
+
+			//Segment starts at the next event on either line
+			int64_t next_sda = Filter::GetNextEventTimestampScaled(sda, rise, sdalen, tstop);
+			int64_t next_scl = Filter::GetNextEventTimestampScaled(scl, iscl, scllen, tstop);
+			int64_t next_timestamp = min(next_sda, next_scl);
+			if(next_timestamp == tstop)
+				break;
+
+			size_t isda = rise;
+			Filter::AdvanceToTimestampScaled(sda, isda, sdalen, next_timestamp);
+			Filter::AdvanceToTimestampScaled(scl, iscl, scllen, next_timestamp);
+
+			candidates[i].m_timestamp = next_timestamp;
+			candidates[i].m_isda = isda;
+			candidates[i].m_iscl = iscl;
+			stops[i] = tstop;
+			break;
+		}
+	}
+
+	//The first segment starts from the beginning, in the decoder's initial state
+	starts.push_back(SegmentStart{0, 0, 0});
+	entries.push_back(DecodeState());
+
+	for(size_t i=1; i<count; i++)
+	{
+		if( (candidates[i].m_timestamp == INT64_MAX) || (candidates[i].m_timestamp <= starts.back().m_timestamp) )
+			continue;
+
+		//State right after a STOP: the last data bit clocked was the low SDA before the STOP,
+		//and the next START will be treated as a restart that began at the STOP
+		DecodeState entry;
+		entry.m_tstart = stops[i];
+		entry.m_currentType = I2CSymbol::TYPE_DATA;
+		entry.m_bitcount = 1;
+
+		starts.push_back(candidates[i]);
+		entries.push_back(entry);
+	}
+}
+
+/**
+	@brief Decodes one segment of the capture
+
+	@param sda		SDA waveform
+	@param scl		SCL waveform
+	@param start	Position of the first event in the segment
+	@param tnext	Timestamp of the first event in the next segment
+	@param st		Decoder state at the start of the segment on entry, at the end on exit
+	@param out		Decoded symbols and packets
+ */
+template<class T, class U>
+void I2CDecoder::DecodeSegment(
+	T* sda,
+	U* scl,
+	const SegmentStart& start,
+	int64_t tnext,
+	DecodeState& st,
+	SegmentSymbols<I2CSymbol>& out)
+{
+	if(st.m_done)
+		return;
+
+	auto& names = GetHeaderNames();
+	Packet* pack = st.m_pack;
 
 	//Loop over the data and look for transactions
-	bool				last_scl = true;
-	bool 				last_sda = true;
-	int64_t				tstart	= 0;
-	I2CSymbol::stype	current_type = I2CSymbol::TYPE_ERROR;
-	uint8_t				current_byte = 0;
-	uint8_t				bitcount = 0;
-	bool				last_was_start	= 0;
+	bool				last_scl = st.m_lastScl;
+	bool 				last_sda = st.m_lastSda;
+	int64_t				tstart	= st.m_tstart;
+	I2CSymbol::stype	current_type = st.m_currentType;
+	uint8_t				current_byte = st.m_currentByte;
+	uint8_t				bitcount = st.m_bitcount;
+	bool				last_was_start	= st.m_lastWasStart;
 	size_t				sdalen = sda->size();
 	size_t 				scllen = scl->size();
-	size_t 				isda = 0;
-	size_t 				iscl = 0;
-	int64_t 			timestamp	= 0;
+	size_t 				isda = start.m_isda;
+	size_t 				iscl = start.m_iscl;
+	int64_t 			timestamp	= start.m_timestamp;
 
 	while(true)
 	{
@@ -108,8 +257,8 @@ void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 				if(pack)
 				{
 					pack->m_len = timestamp - pack->m_offset;
-					pack->m_headers["Len"] = to_string(pack->m_data.size());
-					m_packets.push_back(pack);
+					pack->SetHeader(names.len, pack->m_data.size());
+					out.m_packets.push_back(pack);
 					pack = nullptr;
 				}
 			}
@@ -125,7 +274,7 @@ void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 			if(pack)
 			{
 				pack->m_data.clear();
-				pack->m_headers.clear();
+				pack->ClearHeaders();
 			}
 			else
 				pack = new Packet;
@@ -138,9 +287,9 @@ void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 		else if( ((current_type == I2CSymbol::TYPE_START) || (current_type == I2CSymbol::TYPE_RESTART)) &&
 				(cur_sda || !cur_scl) )
 		{
-			cap->m_offsets.push_back(tstart);
-			cap->m_durations.push_back(timestamp - tstart);
-			cap->m_samples.push_back(I2CSymbol(current_type, 0));
+			out.m_offsets.push_back(tstart);
+			out.m_durations.push_back(timestamp - tstart);
+			out.m_samples.push_back(I2CSymbol(current_type, 0));
 
 			last_was_start	= true;
 			current_type = I2CSymbol::TYPE_DATA;
@@ -154,9 +303,9 @@ void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 		{
 			LogTrace("found i2c stop at time %" PRIx64 "\n", timestamp);
 
-			cap->m_offsets.push_back(tstart);
-			cap->m_durations.push_back(timestamp - tstart);
-			cap->m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_STOP, 0));
+			out.m_offsets.push_back(tstart);
+			out.m_durations.push_back(timestamp - tstart);
+			out.m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_STOP, 0));
 
 			last_was_start	= false;
 
@@ -166,8 +315,8 @@ void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 			if(pack)
 			{
 				pack->m_len = timestamp - pack->m_offset;
-				pack->m_headers["Len"] = to_string(pack->m_data.size());
-				m_packets.push_back(pack);
+				pack->SetHeader(names.len, pack->m_data.size());
+				out.m_packets.push_back(pack);
 				pack = nullptr;
 			}
 		}
@@ -191,41 +340,41 @@ void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 					if(last_was_start)
 					{
 						//If the start bit was insanely long, shorten it
-						size_t nlast = cap->m_offsets.size() - 1;
-						if(cap->m_durations[nlast] > 3*this_len)
+						size_t nlast = out.m_offsets.size() - 1;
+						if(out.m_durations[nlast] > 3*this_len)
 						{
-							int64_t tend = cap->m_offsets[nlast] + cap->m_durations[nlast];
-							cap->m_durations[nlast] = this_len;
-							cap->m_offsets[nlast] = tend - this_len;
+							int64_t tend = out.m_offsets[nlast] + out.m_durations[nlast];
+							out.m_durations[nlast] = this_len;
+							out.m_offsets[nlast] = tend - this_len;
 						}
 
-						cap->m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_ADDRESS, current_byte));
+						out.m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_ADDRESS, current_byte));
 
 						if(pack)
 						{
-							pack->m_headers["Address"] = to_string_hex(current_byte & 0xfe);
+							pack->SetHeader(names.address, current_byte & 0xfe, PacketHeader::FORMAT_HEX);
 							if(current_byte & 1)
 							{
-								pack->m_headers["Op"] = "Read";
+								pack->SetHeader(names.op, names.read);
 								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
 							}
 							else
 							{
-								pack->m_headers["Op"] = "Write";
+								pack->SetHeader(names.op, names.write);
 								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
 							}
 						}
 					}
 					else
 					{
-						cap->m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_DATA, current_byte));
+						out.m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_DATA, current_byte));
 
 						if(pack)
 							pack->m_data.push_back(current_byte);
 					}
 
-					cap->m_offsets.push_back(tstart);
-					cap->m_durations.push_back(this_len);
+					out.m_offsets.push_back(tstart);
+					out.m_durations.push_back(this_len);
 
 					last_was_start	= false;
 
@@ -240,9 +389,9 @@ void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 			//ACK/NAK
 			else if(current_type == I2CSymbol::TYPE_ACK)
 			{
-				cap->m_offsets.push_back(tstart);
-				cap->m_durations.push_back(timestamp - tstart);
-				cap->m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_ACK, cur_sda));
+				out.m_offsets.push_back(tstart);
+				out.m_durations.push_back(timestamp - tstart);
+				out.m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_ACK, cur_sda));
 
 				last_was_start	= false;
 
@@ -260,14 +409,28 @@ void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 		int64_t next_scl = Filter::GetNextEventTimestampScaled(scl, iscl, scllen, timestamp);
 		int64_t next_timestamp = min(next_sda, next_scl);
 		if(next_timestamp == timestamp)
+		{
+			st.m_done = true;
 			break;
+		}
+
+		//Stop at the start of the next segment
+		if(next_timestamp >= tnext)
+			break;
+
 		timestamp = next_timestamp;
 		Filter::AdvanceToTimestampScaled(sda, isda, sdalen, timestamp);
 		Filter::AdvanceToTimestampScaled(scl, iscl, scllen, timestamp);
 	}
 
-	if(pack)
-		delete pack;
+	st.m_pack = pack;
+	st.m_lastScl = last_scl;
+	st.m_lastSda = last_sda;
+	st.m_tstart = tstart;
+	st.m_currentType = current_type;
+	st.m_currentByte = current_byte;
+	st.m_bitcount = bitcount;
+	st.m_lastWasStart = last_was_start;
 }
 
 void I2CDecoder::Refresh(
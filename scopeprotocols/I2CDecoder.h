@@ -36,7 +36,7 @@
 #ifndef I2CDecoder_h
 #define I2CDecoder_h
 
-#include "../scopehal/PacketDecoder.h"
+#include "../scopehal/SegmentedDecode.h"
 
 class I2CSymbol
 {
@@ -92,7 +92,85 @@ public:
 	PROTOCOL_DECODER_INITPROC(I2CDecoder)
 
 protected:
+
+	///@brief Position of the first event in a segment of the capture
+	struct SegmentStart
+	{
+		///@brief Timestamp of the event
+		int64_t m_timestamp;
+
+		///@brief Index of the SDA sample at that time
+		size_t m_isda;
+
+		///@brief Index of the SCL sample at that time
+		size_t m_iscl;
+	};
+
+	///@brief Everything the decoder carries from one event to the next, for decoding segments in parallel
+	class DecodeState
+	{
+	public:
+		DecodeState()
+			: m_done(false)
+			, m_pack(nullptr)
+			, m_lastScl(true)
+			, m_lastSda(true)
+			, m_tstart(0)
+			, m_currentType(I2CSymbol::TYPE_ERROR)
+			, m_currentByte(0)
+			, m_bitcount(0)
+			, m_lastWasStart(false)
+		{}
+
+		///@brief Checks if decoding from this state gives the same output as decoding from another
+		bool Matches(const DecodeState& entry) const
+		{
+			return
+				(m_done == entry.m_done) &&
+				(m_pack == nullptr) &&
+				(entry.m_pack == nullptr) &&
+				(m_lastScl == entry.m_lastScl) &&
+				(m_lastSda == entry.m_lastSda) &&
+				(m_tstart == entry.m_tstart) &&
+				(m_currentType == entry.m_currentType) &&
+				(m_currentByte == entry.m_currentByte) &&
+				(m_bitcount == entry.m_bitcount) &&
+				(m_lastWasStart == entry.m_lastWasStart);
+		}
+
+		///@brief Frees the packet in progress
+		void Discard()
+		{
+			delete m_pack;
+			m_pack = nullptr;
+		}
+
+		///@brief True if the end of the capture has been reached
+		bool m_done;
+
+		Packet* m_pack;
+		bool m_lastScl;
+		bool m_lastSda;
+		int64_t m_tstart;
+		I2CSymbol::stype m_currentType;
+		uint8_t m_currentByte;
+		uint8_t m_bitcount;
+		bool m_lastWasStart;
+	};
+
 	template<class T, class U> void InnerLoop(T* sda, U* scl, I2CWaveform* cap);
+
+	template<class T, class U>
+	void FindSegments(T* sda, U* scl, std::vector<SegmentStart>& starts, std::vector<DecodeState>& entries);
+
+	template<class T, class U>
+	void DecodeSegment(
+		T* sda,
+		U* scl,
+		const SegmentStart& start,
+		int64_t tnext,
+		DecodeState& st,
+		SegmentSymbols<I2CSymbol>& out);
 };
 
 #endif
@@ -101,12 +101,7 @@ void IBM8b10bDecoder::Refresh(
 	cap->PrepareForCpuAccess();
 	cap->SetDisplayFormat(m_displayFormat.GetEnumVal<IBM8b10bWaveform::DisplayFormat>());
 
-	//Preallocate output buffer
-	cap->Reserve(din->m_samples.size() / 10);
-
 	//Decode the actual data
-	int last_disp = -1;
-	bool first = true;
 	size_t nsamples = din->m_samples.size();
 	if(nsamples < 11)
 	{
@@ -115,13 +110,95 @@ void IBM8b10bDecoder::Refresh(
 		return;
 	}
 	size_t dlen = nsamples - 11;
-	int64_t lastSymbolLength = 0;
-	int64_t lastSymbolEnd = 0;
-	int64_t lastSymbolStart = 0;
-	size_t numBadSymbols		= 0;
-	size_t timeSinceBadSymbol	= 0;
-	size_t resyncCooldown = 0;
-	for(size_t i=0; i<dlen;i+=10)
+
+	//Pack the input one bit per sample, with a couple of words of padding for PackedBits::Get()
+	vector<uint64_t> bits;
+	PackedBits::Pack(din->m_samples.GetCpuPointer(), nsamples, bits);
+
+	//Initial state: realign at the first symbol
+	DecodeState initial;
+	initial.m_i = 0;
+	initial.m_first = true;
+	initial.m_lastDisp = -1;
+	initial.m_lastSymbolLength = 0;
+	initial.m_lastSymbolEnd = 0;
+	initial.m_lastSymbolStart = 0;
+	initial.m_numBadSymbols = 0;
+	initial.m_timeSinceBadSymbol = 0;
+	initial.m_resyncCooldown = 0;
+	vector<DecodeState> entries;
+	entries.push_back(initial);
+
+	//Split long captures at commas.
+	//Guess that the decoder is locked with no recent errors, and that the running disparity is whatever the comma
+	//character was encoded for.
+	size_t nsegs = SegmentedDecode::GetSegmentCount(nsamples);
+	for(size_t k=1; k<nsegs; k++)
+	{
+		size_t start = max(k * nsamples / nsegs, entries.rbegin()->m_i + 10);
+		size_t end = min(dlen, (k+1) * nsamples / nsegs);
+		size_t p = FindComma(bits.data(), start, end);
+		if(p >= end)
+			continue;
+
+		DecodeState guess;
+		guess.m_i = p;
+		guess.m_first = false;
+		guess.m_lastDisp = din->m_samples[p+2] ? -1 : 1;
+		guess.m_lastSymbolLength = din->m_offsets[p] - din->m_offsets[p-10];
+		guess.m_lastSymbolStart = din->m_offsets[p-10] - din->m_durations[p-10]/2;
+		guess.m_lastSymbolEnd = guess.m_lastSymbolStart + guess.m_lastSymbolLength;
+		guess.m_numBadSymbols = 0;
+		guess.m_timeSinceBadSymbol = m_errorMemory + 1;
+		guess.m_resyncCooldown = 0;
+		entries.push_back(guess);
+	}
+
+	SegmentSymbols<IBM8b10bSymbol> symbols;
+	SegmentedDecode::Run(entries, symbols,
+		[&](size_t k, DecodeState& state, SegmentSymbols<IBM8b10bSymbol>& out)
+		{
+			size_t end = (k+1 < entries.size()) ? entries[k+1].m_i : dlen;
+			DecodeSegment(din, bits.data(), end, state, out);
+		});
+
+	symbols.Commit(cap);
+}
+
+/**
+	@brief Decodes symbols starting at state.m_i until reaching sample index end
+
+	@param din		Input waveform
+	@param bits		Input samples packed by PackedBits::Pack()
+	@param end		Index to stop at. The last symbol decoded starts before this point.
+	@param state	Decoder state, updated in place
+	@param out		Output symbols
+ */
+void IBM8b10bDecoder::DecodeSegment(
+	SparseDigitalWaveform* din,
+	const uint64_t* bits,
+	size_t end,
+	DecodeState& state,
+	SegmentSymbols<IBM8b10bSymbol>& out)
+{
+	auto table = GetCodeTable();
+	size_t nsamples = din->m_samples.size();
+
+	//Preallocate output buffer
+	out.m_offsets.reserve(out.m_offsets.size() + (end - state.m_i) / 10);
+	out.m_durations.reserve(out.m_durations.size() + (end - state.m_i) / 10);
+	out.m_samples.reserve(out.m_samples.size() + (end - state.m_i) / 10);
+
+	int last_disp = state.m_lastDisp;
+	bool first = state.m_first;
+	int64_t lastSymbolLength = state.m_lastSymbolLength;
+	int64_t lastSymbolEnd = state.m_lastSymbolEnd;
+	int64_t lastSymbolStart = state.m_lastSymbolStart;
+	size_t numBadSymbols		= state.m_numBadSymbols;
+	size_t timeSinceBadSymbol	= state.m_timeSinceBadSymbol;
+	size_t resyncCooldown = state.m_resyncCooldown;
+	size_t i = state.m_i;
+	for(; i<end; i+=10)
 	{
 		//Re-synchronize at start of waveform or if squelch is reopening
 		//If we have a gap
@@ -132,19 +209,100 @@ void IBM8b10bDecoder::Refresh(
 		if(first)
 		{
 			LogTrace("Realigning at t=%s\n", Unit(Unit::UNIT_FS).PrettyPrint(din->m_offsets[i]).c_str());
-			Align(din, i);
+			Align(bits, nsamples, i);
+		}
+
+		//Look up the whole code group at once
+		auto& code = table[PackedBits::Get(bits, i) & 0x3ff];
+
+		//Disparity tracking
+		if(first)
+		{
+			if(code.m_disparity < 0)
+				last_disp = 1;
+			else
+				last_disp = -1;
+			first = false;
+		}
+		int dispIndex = (last_disp + 3) / 2;
+		bool disperr = code.m_disparityError[dispIndex];
+		last_disp = code.m_nextDisparity[dispIndex];
+
+		//Horizontally shift the decoded symbol back by half a UI
+		//since the recovered clock edge is in the middle of the UI.
+		//We want the decoded signal boundaries to line up with the data edge, not the middle of the UI.
+		auto symbolStart = din->m_offsets[i] - din->m_durations[i]/2;
+		auto symbolLength = din->m_offsets[i+10] - din->m_offsets[i];
+		if( (symbolStart - lastSymbolStart) > 5*symbolLength)
+		{
+			LogTrace("Sync lost (big gap)\n");
+			first = true;
+		}
+		else
+		{
+			out.m_offsets.push_back(symbolStart);
+			out.m_durations.push_back(lastSymbolLength);
+			out.m_samples.push_back(IBM8b10bSymbol(
+				code.m_control, code.m_error5, code.m_error3, disperr, code.m_data, last_disp));
+		}
+
+		//If we're in the cool-down window after a resync, don't try to resync immediately
+		if(resyncCooldown)
+			resyncCooldown --;
+
+		//Monitor errors
+		else
+		{
+			if(code.m_error3 || code.m_error5 || disperr)
+			{
+				numBadSymbols ++;
+				timeSinceBadSymbol = 0;
+
+				//After 50 bad symbols in a burst, declare sync to be lost and try again
+				//If this resync is unsuccessful, don't try to resync for a while
+				if(numBadSymbols > 50)
+				{
+					numBadSymbols = 0;
+					resyncCooldown = 5000;
+					first = true;
+				}
+			}
+			else
+			{
+				//Forget about errors after a while.
+				//Stop counting once we have, so the decoder state doesn't depend on how long ago that was.
+				if(timeSinceBadSymbol <= m_errorMemory)
+					timeSinceBadSymbol ++;
+				if(timeSinceBadSymbol > m_errorMemory)
+					numBadSymbols = 0;
+			}
 		}
 
-		//5b/6b decode
+		lastSymbolLength = symbolLength;
+		lastSymbolEnd = symbolStart + symbolLength;
+		lastSymbolStart = symbolStart;
+	}
+
+	state.m_i = i;
+	state.m_first = first;
+	state.m_lastDisp = last_disp;
+	state.m_lastSymbolLength = lastSymbolLength;
+	state.m_lastSymbolEnd = lastSymbolEnd;
+	state.m_lastSymbolStart = lastSymbolStart;
+	state.m_numBadSymbols = numBadSymbols;
+	state.m_timeSinceBadSymbol = timeSinceBadSymbol;
+	state.m_resyncCooldown = resyncCooldown;
+}
 
-		uint8_t code6 =
-			(din->m_samples[i+0] ? 32 : 0) |
-			(din->m_samples[i+1] ? 16 : 0) |
-			(din->m_samples[i+2] ? 8 : 0) |
-			(din->m_samples[i+3] ? 4 : 0) |
-			(din->m_samples[i+4] ? 2 : 0) |
-			(din->m_samples[i+5] ? 1 : 0);
+/**
+	@brief Returns the decode table for all 1024 10-bit code groups
 
+	The table is indexed by the code group as returned by PackedBits::Get(), i.e. with the first (a) bit in the LSB.
+ */
+const IBM8b10bDecoder::CodeInfo* IBM8b10bDecoder::GetCodeTable()
+{
+	static const vector<CodeInfo> table = []()
+	{
 		static const int code5_table[64] =
 		{
 			 0,  0,  0,  0,  0, 23,  8,  7,	//00-07
@@ -193,18 +351,6 @@ void IBM8b10bDecoder::Refresh(
 			false, false, false, false, false, false, false, false  //38-3f
 		};
 
-		int code5 = code5_table[code6];
-		int disp5 = disp5_table[code6];
-		bool err5 = err5_table[code6];
-		bool ctl5 = ctl5_table[code6];
-
-		//3b/4b decode
-		uint8_t code4 =
-			(din->m_samples[i+6] ? 8 : 0) |
-			(din->m_samples[i+7] ? 4 : 0) |
-			(din->m_samples[i+8] ? 2 : 0) |
-			(din->m_samples[i+9] ? 1 : 0);
-
 		static const bool err3_ctl_table[16] =
 		{
 			 true,  true, false, false, false, false, false, false,
@@ -242,127 +388,135 @@ void IBM8b10bDecoder::Refresh(
 		};
 
 		//true only for Dx.A7
-		const bool alt3_table[16] =
+		static const bool alt3_table[16] =
 		{
 			0, 0, 0, 0, 0, 0, 0, 1,
 			1, 0, 0, 0, 0, 0, 0, 0
 		};
 
-		int code3 = false;
-		int disp3 = 0;
-		int err3 = false;
-		if(ctl5)
-		{
-			if(disp5 >= 0)
-				code3 = code3_pos_ctl_table[code4];
-			else
-				code3 = code3_neg_ctl_table[code4];
-			err3 = err3_ctl_table[code4];
-		}
-		else
-		{
-			code3 = code3_table[code4];
-			err3 = err3_table[code4];
-		}
-		disp3 = disp3_table[code4];
-
-		//Disparity tracking
-		int total_disp = disp3 + disp5;
-		if(first)
+		vector<CodeInfo> ret(1024);
+		for(size_t raw=0; raw<1024; raw++)
 		{
-			if(total_disp < 0)
-				last_disp = 1;
+			//Sub-blocks are transmitted MSB first
+			uint8_t code6 = 0;
+			for(int j=0; j<6; j++)
+				code6 = (code6 << 1) | ((raw >> j) & 1);
+			uint8_t code4 = 0;
+			for(int j=6; j<10; j++)
+				code4 = (code4 << 1) | ((raw >> j) & 1);
+
+			//5b/6b decode
+			int code5 = code5_table[code6];
+			int disp5 = disp5_table[code6];
+			bool err5 = err5_table[code6];
+			bool ctl5 = ctl5_table[code6];
+
+			//3b/4b decode
+			int code3 = 0;
+			bool err3 = false;
+			if(ctl5)
+			{
+				if(disp5 >= 0)
+					code3 = code3_pos_ctl_table[code4];
+				else
+					code3 = code3_neg_ctl_table[code4];
+				err3 = err3_ctl_table[code4];
+			}
 			else
-				last_disp = -1;
-			first = false;
-		}
-
-		bool disperr = false;
-		if(total_disp > 0 && last_disp > 0)
-		{
-			disperr = true;
-			last_disp = 1;
-		}
-		else if(total_disp < 0 && last_disp < 0)
-		{
-			disperr = true;
-			last_disp = -1;
-		}
-		else
-			last_disp += total_disp;
-
-		//Special processing for a few control codes that use the .A7 format
-		bool alt = alt3_table[code4];
-		if(alt)
-		{
-			if( (code5 == 23) || (code5 == 27) || (code5 == 29) || (code5 == 30) )
-				ctl5 = true;
-		}
+			{
+				code3 = code3_table[code4];
+				err3 = err3_table[code4];
+			}
+			int disp3 = disp3_table[code4];
 
-		//Horizontally shift the decoded symbol back by half a UI
-		//since the recovered clock edge is in the middle of the UI.
-		//We want the decoded signal boundaries to line up with the data edge, not the middle of the UI.
-		auto symbolStart = din->m_offsets[i] - din->m_durations[i]/2;
-		auto symbolLength = din->m_offsets[i+10] - din->m_offsets[i];
-		if( (symbolStart - lastSymbolStart) > 5*symbolLength)
-		{
-			LogTrace("Sync lost (big gap)\n");
-			first = true;
-		}
-		else
-		{
-			cap->m_offsets.push_back(symbolStart);
-			cap->m_durations.push_back(lastSymbolLength);
-			cap->m_samples.push_back(IBM8b10bSymbol(ctl5, err5, err3, disperr, (code3 << 5) | code5, last_disp));
-		}
+			//Special processing for a few control codes that use the .A7 format
+			if(alt3_table[code4])
+			{
+				if( (code5 == 23) || (code5 == 27) || (code5 == 29) || (code5 == 30) )
+					ctl5 = true;
+			}
 
-		//If we're in the cool-down window after a resync, don't try to resync immediately
-		if(resyncCooldown)
-			resyncCooldown --;
+			auto& info = ret[raw];
+			info.m_data = (code3 << 5) | code5;
+			info.m_control = ctl5;
+			info.m_error5 = err5;
+			info.m_error3 = err3;
+			info.m_disparity = disp3 + disp5;
 
-		//Monitor errors
-		else
-		{
-			if(err3 || err5 || disperr)
+			//Disparity transitions
+			for(int k=0; k<4; k++)
 			{
-				numBadSymbols ++;
-				timeSinceBadSymbol = 0;
+				int last_disp = k*2 - 3;
+				int total_disp = info.m_disparity;
 
-				//After 50 bad symbols in a burst, declare sync to be lost and try again
-				//If this resync is unsuccessful, don't try to resync for a while
-				if(numBadSymbols > 50)
+				bool disperr = false;
+				if(total_disp > 0 && last_disp > 0)
 				{
-					numBadSymbols = 0;
-					resyncCooldown = 5000;
-					first = true;
+					disperr = true;
+					last_disp = 1;
 				}
-			}
-			else
-			{
-				//Forget about errors after a while
-				timeSinceBadSymbol ++;
-				if(timeSinceBadSymbol > 512)
-					numBadSymbols = 0;
+				else if(total_disp < 0 && last_disp < 0)
+				{
+					disperr = true;
+					last_disp = -1;
+				}
+				else
+					last_disp += total_disp;
+
+				info.m_nextDisparity[k] = last_disp;
+				info.m_disparityError[k] = disperr;
 			}
 		}
+		return ret;
+	}();
 
-		lastSymbolLength = symbolLength;
-		lastSymbolEnd = symbolStart + lastSymbolEnd;
-		lastSymbolStart = symbolStart;
-	}
+	return table.data();
+}
+
+/**
+	@brief Finds the first comma sequence (0011111 or 1100000) at or after sample i
+
+	Unlike the looser check in Align(), this only matches the seven bit comma sequence, which valid code groups never
+	produce across a symbol boundary. Checks 64 candidate symbol positions per iteration using transition masks.
+
+	@param bits		Input samples packed by PackedBits::Pack()
+	@param i		First candidate symbol start
+	@param end		Index one past the last candidate symbol start
 
-	cap->MarkModifiedFromCpu();
+	@return Start of the symbol containing the comma, or end if there is none
+ */
+size_t IBM8b10bDecoder::FindComma(const uint64_t* bits, size_t i, size_t end)
+{
+	for(; i<end; i+=64)
+	{
+		//Bit k of edges[j] is set if samples i+j+k and i+j+k+1 differ
+		uint64_t edges[7];
+		for(size_t j=0; j<7; j++)
+			edges[j] = PackedBits::Get(bits, i+j) ^ PackedBits::Get(bits, i+j+1);
+
+		//A comma has a transition after bit 1 and after bit 6 of the symbol, and none elsewhere in bits 0-6
+		uint64_t commas = ~edges[0] & edges[1] & ~edges[2] & ~edges[3] & ~edges[4] & ~edges[5] & edges[6];
+		if(commas)
+			return min(end, i + __builtin_ctzll(commas));
+	}
+	return end;
 }
 
-void IBM8b10bDecoder::Align(SparseDigitalWaveform* din, size_t& i)
+/**
+	@brief Finds the symbol alignment with the most commas in the next few symbols, and advances i to it
+
+	@param bits		Input samples packed by PackedBits::Pack()
+	@param len		Number of input samples
+	@param i		Sample index to search from, updated to the start of the first aligned symbol
+ */
+void IBM8b10bDecoder::Align(const uint64_t* bits, size_t len, size_t& i)
 {
 	size_t range = m_commaSearchWindow.GetIntVal();
 
 	//Look for commas in the data stream
-	//TODO: make this more efficient?
 	size_t max_commas = 0;
 	size_t max_offset = 0;
-	size_t dend = din->m_samples.size() - 20;
+	size_t dend = (len > 20) ? (len - 20) : 0;
 	for(size_t offset=0; offset < 10; offset ++)
 	{
 		size_t num_commas = 0;
@@ -377,28 +531,15 @@ void IBM8b10bDecoder::Align(SparseDigitalWaveform* din, size_t& i)
 				break;
 
 			//Check if we have a comma (five identical bits) anywhere in the data stream
-			//Commas are always at positions 2...6 within the symbol (left-right bit ordering)
-			bool comma = true;
-			for(int j=3; j<=6; j++)
-			{
-				if(din->m_samples[base+j] != din->m_samples[base+2])
-				{
-					comma = false;
-					break;
-				}
-			}
-
-			//Comma is always exactly five identical bits (so 1 and 7 must be different)
-			if(din->m_samples[base+1] == din->m_samples[base+2])
-				comma = false;
-			if(din->m_samples[base+7] == din->m_samples[base+2])
-				comma = false;
+			//Commas are always at positions 2...6 within the symbol (left-right bit ordering),
+			//and are always exactly five identical bits (so 1 and 7 must be different)
+			uint64_t symbol = PackedBits::Get(bits, base);
+			uint64_t edges = symbol ^ (symbol >> 1);
+			bool comma = ( (edges >> 1) & 0x3f ) == 0x21;
 
 			//Count number of 0s and 1s in the symbol
 			//Should always be equal (5/5) or two greater (4/6 or 6/4)
-			int nones = 0;
-			for(int j=0; j<10; j++)
-				nones += din->m_samples[base+j];
+			int nones = __builtin_popcountll(symbol & 0x3ff);
 			if( (nones != 4) && (nones != 5) && (nones != 6) )
 				num_errors ++;
 
@@ -37,6 +37,8 @@
 #define IBM8b10bDecoder_h
 
 #include "../scopehal/IBM8b10bWaveform.h"
+#include "../scopehal/SegmentedDecode.h"
+#include "../scopehal/PackedBits.h"
 
 class IBM8b10bDecoder : public Filter
 {
@@ -53,7 +55,95 @@ protected:
 	FilterParameter& m_displayFormat;
 	FilterParameter& m_commaSearchWindow;
 
-	void Align(SparseDigitalWaveform* din, size_t& i);
+	/**
+		@brief Decode of one 10-bit code group, including its effect on running disparity
+
+		Running disparity before a code group is always -3, -1, 1 or 3 (the odd values only after a disparity error),
+		and is stored in the tables below as index (disparity + 3) / 2.
+	 */
+	struct CodeInfo
+	{
+		///@brief Decoded byte
+		uint8_t m_data;
+
+		///@brief True for a K character
+		bool m_control;
+
+		///@brief True if the 5b/6b sub-block is invalid
+		bool m_error5;
+
+		///@brief True if the 3b/4b sub-block is invalid
+		bool m_error3;
+
+		///@brief Disparity of the code group
+		int8_t m_disparity;
+
+		///@brief Running disparity after this code group, for each running disparity before it
+		int8_t m_nextDisparity[4];
+
+		///@brief True if this code group is a disparity error, for each running disparity before it
+		bool m_disparityError[4];
+	};
+
+	/**
+		@brief Decoder state between two symbols
+	 */
+	class DecodeState
+	{
+	public:
+		///@brief Index of the first sample of the next symbol
+		size_t m_i;
+
+		///@brief True if we need to realign before the next symbol
+		bool m_first;
+
+		///@brief Running disparity
+		int m_lastDisp;
+
+		int64_t m_lastSymbolLength;
+		int64_t m_lastSymbolEnd;
+		int64_t m_lastSymbolStart;
+
+		size_t m_numBadSymbols;
+
+		///@brief Symbols since the last error, saturating once it's long enough to forget about errors
+		size_t m_timeSinceBadSymbol;
+
+		size_t m_resyncCooldown;
+
+		bool Matches(const DecodeState& entry) const
+		{
+			return
+				(m_i == entry.m_i) &&
+				(m_first == entry.m_first) &&
+				(m_lastDisp == entry.m_lastDisp) &&
+				(m_lastSymbolLength == entry.m_lastSymbolLength) &&
+				(m_lastSymbolEnd == entry.m_lastSymbolEnd) &&
+				(m_lastSymbolStart == entry.m_lastSymbolStart) &&
+				(m_numBadSymbols == entry.m_numBadSymbols) &&
+				(m_timeSinceBadSymbol == entry.m_timeSinceBadSymbol) &&
+				(m_resyncCooldown == entry.m_resyncCooldown);
+		}
+
+		void Discard()
+		{}
+	};
+
+	void DecodeSegment(
+		SparseDigitalWaveform* din,
+		const uint64_t* bits,
+		size_t end,
+		DecodeState& state,
+		SegmentSymbols<IBM8b10bSymbol>& out);
+
+	void Align(const uint64_t* bits, size_t len, size_t& i);
+
+	static const CodeInfo* GetCodeTable();
+
+	static size_t FindComma(const uint64_t* bits, size_t i, size_t end);
+
+	///@brief Number of symbols without errors after which an error burst is forgotten
+	static constexpr size_t m_errorMemory = 512;
 };
 
 #endif
@@ -83,6 +83,7 @@ void IPv4Decoder::Refresh(
 	//Loop over the events and process stuff
 	auto cap = SetupEmptyWaveform<IPv4Waveform>(din, 0);
 	cap->PrepareForCpuAccess();
+	cap->m_arena.reserve(len);
 
 	int state = 0;
 	int header_len = 0;
@@ -153,7 +154,7 @@ void IPv4Decoder::Refresh(
 					{
 						cap->m_offsets.push_back(din->m_offsets[i]);
 						cap->m_durations.push_back(halfdur);
-						cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_VERSION, 4));
+						cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_VERSION, cap->AddByte(4)));
 					}
 					else
 					{
@@ -166,7 +167,7 @@ void IPv4Decoder::Refresh(
 
 					cap->m_offsets.push_back(din->m_offsets[i] + halfdur);
 					cap->m_durations.push_back(halfdur);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_HEADER_LEN, header_len));
+					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_HEADER_LEN, cap->AddByte(header_len)));
 
 					state = 6;
 				}
@@ -181,7 +182,7 @@ void IPv4Decoder::Refresh(
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_DIFFSERV, s.m_data));
+					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_DIFFSERV, cap->AddByte(s.m_data)));
 					state = 7;
 				}
 				else
@@ -194,7 +195,7 @@ void IPv4Decoder::Refresh(
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_LENGTH, s.m_data));
+					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_LENGTH, cap->AddByte(s.m_data)));
 					state = 8;
 				}
 				else
@@ -206,7 +207,7 @@ void IPv4Decoder::Refresh(
 					//Append to the previous sample
 					size_t n = cap->m_offsets.size() - 1;
 					cap->m_durations[n] = din->m_offsets[i] + din->m_durations[i] - cap->m_offsets[n];
-					cap->m_samples[n].m_data.push_back(s.m_data);
+					cap->AppendByte(cap->m_samples[n].m_data, s.m_data);
 					state = 9;
 				}
 				else
@@ -219,7 +220,7 @@ void IPv4Decoder::Refresh(
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_ID, s.m_data));
+					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_ID, cap->AddByte(s.m_data)));
 					state = 10;
 				}
 				else
@@ -231,7 +232,7 @@ void IPv4Decoder::Refresh(
 					//Append to the previous sample
 					size_t n = cap->m_offsets.size() - 1;
 					cap->m_durations[n] = din->m_offsets[i] + din->m_durations[i] - cap->m_offsets[n];
-					cap->m_samples[n].m_data.push_back(s.m_data);
+					cap->AppendByte(cap->m_samples[n].m_data, s.m_data);
 					state = 11;
 				}
 				else
@@ -245,12 +246,12 @@ void IPv4Decoder::Refresh(
 					//Flags
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(halfdur);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_FLAGS, s.m_data >> 5));
+					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_FLAGS, cap->AddByte(s.m_data >> 5)));
 
 					//Frag offset, high 5 bits
 					cap->m_offsets.push_back(din->m_offsets[i] + halfdur);
 					cap->m_durations.push_back(halfdur);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_FRAG_OFFSET, s.m_data & 0x1f));
+					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_FRAG_OFFSET, cap->AddByte(s.m_data & 0x1f)));
 					state = 12;
 				}
 				else
@@ -262,7 +263,7 @@ void IPv4Decoder::Refresh(
 					//Append to the previous sample
 					size_t n = cap->m_offsets.size() - 1;
 					cap->m_durations[n] = din->m_offsets[i] + din->m_durations[i] - cap->m_offsets[n];
-					cap->m_samples[n].m_data.push_back(s.m_data);
+					cap->AppendByte(cap->m_samples[n].m_data, s.m_data);
 					state = 13;
 				}
 				else
@@ -275,7 +276,7 @@ void IPv4Decoder::Refresh(
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_TTL, s.m_data));
+					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_TTL, cap->AddByte(s.m_data)));
 					state = 14;
 				}
 				else
@@ -288,7 +289,7 @@ void IPv4Decoder::Refresh(
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_PROTOCOL, s.m_data));
+					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_PROTOCOL, cap->AddByte(s.m_data)));
 					state = 15;
 				}
 				else
@@ -301,7 +302,7 @@ void IPv4Decoder::Refresh(
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_HEADER_CHECKSUM, s.m_data));
+					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_HEADER_CHECKSUM, cap->AddByte(s.m_data)));
 					state = 16;
 				}
 				else
@@ -313,7 +314,7 @@ void IPv4Decoder::Refresh(
 					//Append to the previous sample
 					size_t n = cap->m_offsets.size() - 1;
 					cap->m_durations[n] = din->m_offsets[i] + din->m_durations[i] - cap->m_offsets[n];
-					cap->m_samples[n].m_data.push_back(s.m_data);
+					cap->AppendByte(cap->m_samples[n].m_data, s.m_data);
 					state = 17;
 				}
 				else
@@ -326,7 +327,7 @@ void IPv4Decoder::Refresh(
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_SOURCE_IP, s.m_data));
+					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_SOURCE_IP, cap->AddByte(s.m_data)));
 					state = 18;
 				}
 				else
@@ -340,7 +341,7 @@ void IPv4Decoder::Refresh(
 					//Append to the previous sample
 					size_t n = cap->m_offsets.size() - 1;
 					cap->m_durations[n] = din->m_offsets[i] + din->m_durations[i] - cap->m_offsets[n];
-					cap->m_samples[n].m_data.push_back(s.m_data);
+					cap->AppendByte(cap->m_samples[n].m_data, s.m_data);
 					state++;
 				}
 				else
@@ -353,7 +354,7 @@ void IPv4Decoder::Refresh(
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_DEST_IP, s.m_data));
+					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_DEST_IP, cap->AddByte(s.m_data)));
 					state = 22;
 				}
 				else
@@ -367,7 +368,7 @@ void IPv4Decoder::Refresh(
 					//Append to the previous sample
 					size_t n = cap->m_offsets.size() - 1;
 					cap->m_durations[n] = din->m_offsets[i] + din->m_durations[i] - cap->m_offsets[n];
-					cap->m_samples[n].m_data.push_back(s.m_data);
+					cap->AppendByte(cap->m_samples[n].m_data, s.m_data);
 					state++;
 				}
 				else
@@ -380,7 +381,7 @@ void IPv4Decoder::Refresh(
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_DATA, s.m_data));
+					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_DATA, cap->AddByte(s.m_data)));
 				}
 
 				//terminate the packet on FCS or error
@@ -435,27 +436,31 @@ string IPv4Waveform::GetText(size_t i)
 {
 	char tmp[128];
 
+	//Zero pad short (truncated) fields
 	auto sample = m_samples[i];
+	uint8_t data[4] = {0};
+	memcpy(data, GetBytes(sample.m_data), min((size_t)sample.m_data.m_length, sizeof(data)));
+
 	switch(sample.m_type)
 	{
 		case IPv4Symbol::TYPE_VERSION:
-			snprintf(tmp, sizeof(tmp), "V%d", sample.m_data[0]);
+			snprintf(tmp, sizeof(tmp), "V%d", data[0]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_HEADER_LEN:
-			if(sample.m_data[0] == 5)
+			if(data[0] == 5)
 				return "No opts";
 			else
 			{
-				snprintf(tmp, sizeof(tmp), "%d header words", sample.m_data[0]);
+				snprintf(tmp, sizeof(tmp), "%d header words", data[0]);
 				return string(tmp);
 			}
 
 		case IPv4Symbol::TYPE_DIFFSERV:
 			{
-				snprintf(tmp, sizeof(tmp), "DSCP: %d", sample.m_data[0] >> 2);
+				snprintf(tmp, sizeof(tmp), "DSCP: %d", data[0] >> 2);
 				string ret = tmp;
-				switch(sample.m_data[0] & 0x3)
+				switch(data[0] & 0x3)
 				{
 					case 0:
 						ret += ", Non-ECT";
@@ -477,21 +482,21 @@ string IPv4Waveform::GetText(size_t i)
 			}
 
 		case IPv4Symbol::TYPE_LENGTH:
-			snprintf(tmp, sizeof(tmp), "Length: %d", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "Length: %d", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_ID:
-			snprintf(tmp, sizeof(tmp), "ID: 0x%04x", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "ID: 0x%04x", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_FLAGS:
 			{
 				string ret;
-				if(sample.m_data[0] & 4)
+				if(data[0] & 4)
 					ret = "Evil ";
-				if(sample.m_data[0] & 2)
+				if(data[0] & 2)
 					ret += "DF ";
-				if(sample.m_data[0] & 1)
+				if(data[0] & 1)
 					ret += "MF ";
 				if(ret == "")
 					ret = "No flag";
@@ -499,15 +504,15 @@ string IPv4Waveform::GetText(size_t i)
 			}
 
 		case IPv4Symbol::TYPE_FRAG_OFFSET:
-			snprintf(tmp, sizeof(tmp), "Offset: 0x%04x", 8*( (sample.m_data[0] << 8) | sample.m_data[1]));
+			snprintf(tmp, sizeof(tmp), "Offset: 0x%04x", 8*( (data[0] << 8) | data[1]));
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_TTL:
-			snprintf(tmp, sizeof(tmp), "TTL: %d", sample.m_data[0]);
+			snprintf(tmp, sizeof(tmp), "TTL: %d", data[0]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_PROTOCOL:
-			switch(sample.m_data[0])
+			switch(data[0])
 			{
 				case 0x01:
 					return "ICMP";
@@ -529,28 +534,28 @@ string IPv4Waveform::GetText(size_t i)
 					return "FCoIP";
 
 				default:
-					snprintf(tmp, sizeof(tmp), "Protocol: 0x%02x", sample.m_data[0]);
+					snprintf(tmp, sizeof(tmp), "Protocol: 0x%02x", data[0]);
 					return string(tmp);
 			}
 			break;
 
 		case IPv4Symbol::TYPE_HEADER_CHECKSUM:
-			snprintf(tmp, sizeof(tmp), "Checksum: 0x%04x", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "Checksum: 0x%04x", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_SOURCE_IP:
 			snprintf(tmp, sizeof(tmp), "Source: %d.%d.%d.%d",
-				sample.m_data[0], sample.m_data[1], sample.m_data[2], sample.m_data[3]);
+				data[0], data[1], data[2], data[3]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_DEST_IP:
 			snprintf(tmp, sizeof(tmp), "Dest: %d.%d.%d.%d",
-				sample.m_data[0], sample.m_data[1], sample.m_data[2], sample.m_data[3]);
+				data[0], data[1], data[2], data[3]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_DATA:
 		case IPv4Symbol::TYPE_OPTIONS:
-			snprintf(tmp, sizeof(tmp), "%02x", sample.m_data[0]);
+			snprintf(tmp, sizeof(tmp), "%02x", data[0]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_ERROR:
@@ -35,6 +35,11 @@
 #ifndef IPv4Decoder_h
 #define IPv4Decoder_h
 
+/**
+	@brief A single field of an IPv4 packet
+
+	The field bytes live in the payload arena of the parent IPv4Waveform, so this class is POD.
+ */
 class IPv4Symbol
 {
 public:
@@ -58,14 +63,16 @@ public:
 		TYPE_DATA
 	} m_type;
 
-	std::vector<uint8_t> m_data;
+	///@brief Bytes of the field, in the parent waveform's arena
+	ByteArenaRef m_data;
 
 	IPv4Symbol()
 	{}
 
-	IPv4Symbol(SegmentType type, uint8_t value)
+	IPv4Symbol(SegmentType type, ByteArenaRef data)
 		: m_type(type)
-	{ m_data.push_back(value); }
+		, m_data(data)
+	{}
 
 	bool operator==(const IPv4Symbol& rhs) const
 	{
@@ -73,10 +80,10 @@ public:
 	}
 };
 
-class IPv4Waveform : public SparseWaveform<IPv4Symbol>
+class IPv4Waveform : public ByteArenaWaveform<IPv4Symbol>
 {
 public:
-	IPv4Waveform () : SparseWaveform<IPv4Symbol>() {};
+	IPv4Waveform () : ByteArenaWaveform<IPv4Symbol>() {};
 	virtual std::string GetText(size_t) override;
 	virtual std::string GetColor(size_t) override;
 };
@@ -32,6 +32,8 @@
 
 using namespace std;
 
+shared_ptr<FusibleShader> InvertFilter::m_fusibleShader;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -186,3 +188,34 @@ void InvertFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHand
 		return;
 	}
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shader fusion
+
+shared_ptr<FusibleShader> InvertFilter::GetFusibleShader(vector<size_t>& inputs)
+{
+	//Digital inversion works on packed bits, only the analog path is fusible
+	if(GetInput(0).GetType() != Stream::STREAM_TYPE_ANALOG)
+		return nullptr;
+
+	if(!m_fusibleShader)
+	{
+		m_fusibleShader = make_shared<FusibleShader>(
+			"Invert",
+			"float __kernel__(float din)\n"
+			"{\n"
+			"\treturn -din;\n"
+			"}\n");
+		m_fusibleShader->m_inputs.push_back(ShaderInputInfo("float", "din"));
+		m_fusibleShader->m_cpuOps.push_back(FusibleCpuOp(FusibleCpuOp::OP_NEGATE, 0));
+	}
+
+	inputs = { 0 };
+	return m_fusibleShader;
+}
+
+void InvertFilter::PrepareFusedRefresh(vector<uint32_t>& /*pushConstants*/)
+{
+	ClearMessages();
+	m_streams[0].m_stype = Stream::STREAM_TYPE_ANALOG;
+}
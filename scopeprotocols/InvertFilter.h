@@ -45,11 +45,17 @@ public:
 	static std::string GetProtocolName();
 	virtual void SetDefaultName() override;
 
+	virtual std::shared_ptr<FusibleShader> GetFusibleShader(std::vector<size_t>& inputs) override;
+	virtual void PrepareFusedRefresh(std::vector<uint32_t>& pushConstants) override;
+
 	PROTOCOL_DECODER_INITPROC(InvertFilter)
 
 protected:
 	ComputePipeline m_computePipeline;
 	ComputePipeline m_digitalComputePipeline;
+
+	///@brief Elementwise kernel for shader fusion
+	static std::shared_ptr<FusibleShader> m_fusibleShader;
 };
 
 #endif
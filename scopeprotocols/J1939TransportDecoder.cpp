@@ -119,7 +119,7 @@ void J1939TransportDecoder::Refresh(
 	auto& srcPackets = dynamic_cast<PacketDecoder*>(GetInput(0).m_channel)->GetPackets();
 	for(auto p : srcPackets)
 	{
-		if(p->m_headers["Source"] == starget)
+		if(p->GetHeader("Source") == starget)
 		{
 			auto np = new Packet;
 			*np = *p;
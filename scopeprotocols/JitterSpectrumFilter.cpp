@@ -236,6 +236,13 @@ void JitterSpectrumFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Q
 
 	//and do the actual FFT processing
 
+	//Native CPU FFT runs synchronously and never touches the command buffer
+	if(UseCPUFFT())
+	{
+		DoRefresh(din, *extended_samples, ui_width_final, num_uis, nouts, false, cmdBuf, queue);
+		return;
+	}
+
 	//FIXME: CPU side processing, so we need to open the command buffer ourself after doing the setup
 	cmdBuf.begin({});
 
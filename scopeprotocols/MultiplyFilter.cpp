@@ -32,6 +32,9 @@
 
 using namespace std;
 
+shared_ptr<FusibleShader> MultiplyFilter::m_fusibleShader;
+shared_ptr<FusibleShader> MultiplyFilter::m_fusibleScaleShader;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -234,3 +237,79 @@ void MultiplyFilter::RefreshVectorVector(vk::raii::CommandBuffer& cmdBuf, shared
 	cmdBuf.end();
 	queue->SubmitAndBlock(cmdBuf);
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shader fusion
+
+shared_ptr<FusibleShader> MultiplyFilter::GetFusibleShader(vector<size_t>& inputs)
+{
+	bool veca = GetInput(0).GetType() == Stream::STREAM_TYPE_ANALOG;
+	bool vecb = GetInput(1).GetType() == Stream::STREAM_TYPE_ANALOG;
+	bool scala = GetInput(0).GetType() == Stream::STREAM_TYPE_ANALOG_SCALAR;
+	bool scalb = GetInput(1).GetType() == Stream::STREAM_TYPE_ANALOG_SCALAR;
+
+	//Vector times vector
+	if(veca && vecb)
+	{
+		if(!m_fusibleShader)
+		{
+			m_fusibleShader = make_shared<FusibleShader>(
+				"Multiply",
+				"float __kernel__(float a, float b)\n"
+				"{\n"
+				"\treturn a * b;\n"
+				"}\n");
+			m_fusibleShader->m_inputs.push_back(ShaderInputInfo("float", "a"));
+			m_fusibleShader->m_inputs.push_back(ShaderInputInfo("float", "b"));
+			m_fusibleShader->m_cpuOps.push_back(FusibleCpuOp(FusibleCpuOp::OP_MULTIPLY, 0, 1));
+		}
+
+		inputs = { 0, 1 };
+		return m_fusibleShader;
+	}
+
+	//Vector times scalar (scaling)
+	else if( (veca && scalb) || (scala && vecb) )
+	{
+		if(!m_fusibleScaleShader)
+		{
+			m_fusibleScaleShader = make_shared<FusibleShader>(
+				"MultiplyByConstant",
+				"float __kernel__(float din)\n"
+				"{\n"
+				"\treturn din * __push__scale;\n"
+				"}\n");
+			m_fusibleScaleShader->m_inputs.push_back(ShaderInputInfo("float", "din"));
+			m_fusibleScaleShader->m_pushConstants.push_back(PushConstantInfo("float", "scale"));
+			m_fusibleScaleShader->m_cpuOps.push_back(
+				FusibleCpuOp(FusibleCpuOp::OP_MULTIPLY, 0, FusibleCpuOp::PushConstant(0)));
+		}
+
+		inputs = { veca ? 0u : 1u };
+		return m_fusibleScaleShader;
+	}
+
+	return nullptr;
+}
+
+void MultiplyFilter::PrepareFusedRefresh(vector<uint32_t>& pushConstants)
+{
+	ClearMessages();
+	m_streams[0].m_stype = Stream::STREAM_TYPE_ANALOG;
+	SetYAxisUnits(m_inputs[0]->GetYAxisUnits() * m_inputs[1]->GetYAxisUnits(), 0);
+
+	bool veca = GetInput(0).GetType() == Stream::STREAM_TYPE_ANALOG;
+	bool vecb = GetInput(1).GetType() == Stream::STREAM_TYPE_ANALOG;
+	if(veca && vecb)
+		SetXAxisUnits(m_inputs[0]->GetXAxisUnits());
+	else
+	{
+		size_t iVector = veca ? 0 : 1;
+		SetXAxisUnits(GetInput(iVector).GetXAxisUnits());
+
+		float scale = GetInput(1 - iVector).GetScalarValue();
+		uint32_t word;
+		memcpy(&word, &scale, sizeof(word));
+		pushConstants.push_back(word);
+	}
+}
@@ -49,6 +49,9 @@ public:
 
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
+	virtual std::shared_ptr<FusibleShader> GetFusibleShader(std::vector<size_t>& inputs) override;
+	virtual void PrepareFusedRefresh(std::vector<uint32_t>& pushConstants) override;
+
 	static std::string GetProtocolName();
 
 	PROTOCOL_DECODER_INITPROC(MultiplyFilter)
@@ -64,6 +67,12 @@ protected:
 
 	ComputePipeline m_multiplyByConstantPipeline;
 	ComputePipeline m_multiplyVectorVectorPipeline;
+
+	///@brief Elementwise kernel for shader fusion (vector-vector)
+	static std::shared_ptr<FusibleShader> m_fusibleShader;
+
+	///@brief Elementwise kernel for shader fusion (scalar-vector)
+	static std::shared_ptr<FusibleShader> m_fusibleScaleShader;
 };
 
 #endif
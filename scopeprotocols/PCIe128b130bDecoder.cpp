@@ -35,6 +35,7 @@
 
 #include "../scopehal/scopehal.h"
 #include "PCIe128b130bDecoder.h"
+#include "../scopehal/PackedBits.h"
 
 using namespace std;
 
@@ -43,6 +44,7 @@ using namespace std;
 
 PCIe128b130bDecoder::PCIe128b130bDecoder(const string& color)
 	: Filter(color, CAT_SERIAL)
+	, m_scrambler(23, 0x210125)
 {
 	AddProtocolStream("data");
 
@@ -83,36 +85,32 @@ void PCIe128b130bDecoder::Refresh(
 	auto cap = SetupEmptyWaveform<PCIe128b130bWaveform>(din, 0);
 	cap->PrepareForCpuAccess();
 
-	//Look at each phase and figure out block alignment
-	size_t end = din->size() - 130;
-	size_t best_offset = 0;
-	size_t best_errors = end;
-	for(size_t offset=0; offset < 130; offset ++)
+	//Need at least one full block
+	size_t nsamples = din->size();
+	if(nsamples <= 130)
 	{
-		size_t errors = 0;
-		for(size_t i=offset; i<end; i+= 130)
-		{
-			if(din->m_samples[i] == din->m_samples[i+1])
-				errors ++;
-		}
-
-		if(errors < best_errors)
-		{
-			best_offset = offset;
-			best_errors = errors;
-		}
+		cap->MarkModifiedFromCpu();
+		return;
 	}
+	size_t end = nsamples - 130;
+
+	//Pack the input so blocks can be pulled out a word at a time
+	vector<uint64_t> bits;
+	PackedBits::Pack(din->m_samples.GetCpuPointer(), nsamples, bits);
+	const uint64_t* pbits = bits.data();
+
+	//Look at each phase and figure out block alignment
+	size_t best_offset = PackedBits::FindBlockAlignment(pbits, end, 130);
 
 	//Decode the actual data
 	uint8_t symbols[32] = {0};
 	bool scrambler_locked = false;
-	uint32_t scrambler = 0;
+	uint64_t scrambler = 0;
 	for(size_t i=best_offset; i<end; i += 130)
 	{
 		//Extract the header bits
-		uint8_t header =
-			(din->m_samples[i] ? 2 : 0) |
-			(din->m_samples[i+1] ? 1 : 0);
+		uint64_t hbits = PackedBits::Get(pbits, i);
+		uint8_t header = ( (hbits & 1) << 1) | ( (hbits >> 1) & 1);
 
 		//Figure out type
 		PCIe128b130bSymbol::type_t type;
@@ -128,15 +126,16 @@ void PCIe128b130bDecoder::Refresh(
 		else
 			type = PCIe128b130bSymbol::TYPE_ORDERED_SET;
 
-		//Extract the data bytes, but don't descramble yet
+		//Extract the data bytes, but don't descramble yet.
+		//Bytes are sent LSB first, so each 64-bit word holds eight bytes in little endian order.
 		size_t len = 16;
-		for(size_t j=0; j<16; j++)
+		uint64_t payload[2] =
 		{
-			uint8_t tmp = 0;
-			for(size_t k=0; k<8; k++)
-				tmp |= (din->m_samples[i + j*8 + k + 2] << ( /* 7- */ k) );
-			symbols[j] = tmp;
-		}
+			PackedBits::Get(pbits, i + 2),
+			PackedBits::Get(pbits, i + 66)
+		};
+		for(size_t j=0; j<16; j++)
+			symbols[j] = payload[j / 8] >> ( (j % 8) * 8);
 
 		//TODO: If this is a skip ordered set (SOS) it can vary in length if bridging is used
 
@@ -166,18 +165,17 @@ void PCIe128b130bDecoder::Refresh(
 		//Iterate scrambler for everything but SOS
 		if(!is_sos)
 		{
-			//Throw away scrambler output for ordered sets
-			if(type == PCIe128b130bSymbol::TYPE_ORDERED_SET)
+			uint64_t key[2] =
 			{
-				for(size_t j=0; j<len; j++)
-					RunScrambler(scrambler);
-			}
+				m_scrambler.Next64(scrambler),
+				m_scrambler.Next64(scrambler)
+			};
 
-			//Descramble data
-			else
+			//Throw away scrambler output for ordered sets, descramble data
+			if(type != PCIe128b130bSymbol::TYPE_ORDERED_SET)
 			{
 				for(size_t j=0; j<len; j++)
-					symbols[j] ^= RunScrambler(scrambler);
+					symbols[j] ^= key[j / 8] >> ( (j % 8) * 8);
 			}
 		}
 
@@ -249,21 +247,3 @@ string PCIe128b130bWaveform::GetText(size_t i)
 
 	return ret;
 }
-
-uint8_t PCIe128b130bDecoder::RunScrambler(uint32_t& state)
-{
-	uint8_t ret = 0;
-
-	for(int j=0; j<8; j++)
-	{
-		bool b22 = (state & 0x400000);
-		state <<= 1;
-		if(b22)
-		{
-			state ^= 0x210125;
-			ret |= (1 << j);
-		}
-	}
-
-	return ret;
-}
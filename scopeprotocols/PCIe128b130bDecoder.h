@@ -36,6 +36,8 @@
 #ifndef PCIe128b130bDecoder_h
 #define PCIe128b130bDecoder_h
 
+#include "../scopehal/Scrambler.h"
+
 class PCIe128b130bSymbol
 {
 public:
@@ -88,7 +90,8 @@ public:
 	PROTOCOL_DECODER_INITPROC(PCIe128b130bDecoder)
 
 protected:
-	uint8_t RunScrambler(uint32_t& state);
+	///@brief Gen3 data scrambler, x^23 + x^21 + x^16 + x^8 + x^5 + x^2 + 1
+	AdditiveScrambler m_scrambler;
 };
 
 #endif
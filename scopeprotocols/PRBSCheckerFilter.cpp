@@ -30,6 +30,7 @@
 #include "../scopehal/scopehal.h"
 #include "PRBSCheckerFilter.h"
 #include "PRBSGeneratorFilter.h"
+#include "../scopehal/PackedBits.h"
 
 using namespace std;
 
@@ -41,8 +42,10 @@ PRBSCheckerFilter::PRBSCheckerFilter(const string& color)
 	, m_poly(m_parameters["Polynomial"])
 	, m_lastSize(0)
 	, m_prbs23Table("PRBSCheckerFilter.m_prbs23Table")
+	, m_errorCount("PRBSCheckerFilter.m_errorCount")
 {
 	AddDigitalStream("data");
+	AddStream(Unit(Unit::UNIT_COUNTS), "errors", Stream::STREAM_TYPE_ANALOG_SCALAR);
 
 	CreateInput<InputConstraintSparseStreamType>("sampledData", Stream::STREAM_TYPE_DIGITAL);
 
@@ -59,32 +62,32 @@ PRBSCheckerFilter::PRBSCheckerFilter(const string& color)
 	{
 		m_prbs7Pipeline = make_shared<ComputePipeline>(
 			"shaders/PRBS7Checker.spv",
-			2,
+			3,
 			sizeof(PRBSCheckerConstants));
 
 		m_prbs9Pipeline = make_shared<ComputePipeline>(
 			"shaders/PRBS9Checker.spv",
-			2,
+			3,
 			sizeof(PRBSCheckerConstants));
 
 		m_prbs11Pipeline = make_shared<ComputePipeline>(
 			"shaders/PRBS11Checker.spv",
-			2,
+			3,
 			sizeof(PRBSCheckerConstants));
 
 		m_prbs15Pipeline = make_shared<ComputePipeline>(
 			"shaders/PRBS15Checker.spv",
-			2,
+			3,
 			sizeof(PRBSCheckerConstants));
 
 		//PRBS-23 and up need table for lookahead since they don't run an entire LFSR cycle per thread
 		m_prbs23Pipeline = make_shared<ComputePipeline>(
 			"shaders/PRBS23Checker.spv",
-			3,
+			4,
 			sizeof(PRBSCheckerBlockConstants));
 		m_prbs31Pipeline = make_shared<ComputePipeline>(
 			"shaders/PRBS31Checker.spv",
-			3,
+			4,
 			sizeof(PRBSCheckerBlockConstants));
 
 		//Fill lookahead table for PRBS-23
@@ -113,6 +116,10 @@ PRBSCheckerFilter::PRBSCheckerFilter(const string& color)
 				m_prbs31Table[row*cols + col] = g_prbs31Table[row][col];
 		}
 		m_prbs31Table.MarkModifiedFromCpu();
+
+		//Bit error counter, accumulated by the shaders
+		m_errorCount.resize(1);
+		m_errorCount.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
 	}
 }
 
@@ -187,6 +194,7 @@ void PRBSCheckerFilter::Refresh(
 			AddErrorMessage("Invalid input", "Expected a digital waveform");
 
 		SetData(nullptr, 0);
+		m_streams[1].m_value = 0;
 		return;
 	}
 
@@ -200,6 +208,7 @@ void PRBSCheckerFilter::Refresh(
 	{
 		AddErrorMessage("Input too short", "Cannot verify a PRBS with input shorter than the polynomial length");
 		SetData(nullptr, 0);
+		m_streams[1].m_value = 0;
 		return;
 	}
 
@@ -285,6 +294,11 @@ void PRBSCheckerFilter::Refresh(
 		const uint32_t threadsPerBlock = 64;
 		const uint32_t compute_block_count = GetComputeBlockCount(numThreads, threadsPerBlock);
 
+		//Clear the error counter
+		m_errorCount.PrepareForCpuAccessIgnoringGpuData();
+		m_errorCount[0] = 0;
+		m_errorCount.MarkModifiedFromCpu();
+
 		switch(poly)
 		{
 			//Each thread checks a full PRBS cycle from the chosen offset
@@ -301,9 +315,14 @@ void PRBSCheckerFilter::Refresh(
 						pipe->BindBufferNonblocking(0, udin->m_samples, cmdBuf);
 
 					pipe->BindBufferNonblocking(1, dout->m_samples, cmdBuf, true);
+					pipe->BindBufferNonblocking(2, m_errorCount, cmdBuf);
 					pipe->Dispatch(cmdBuf, cfg,
 						min(compute_block_count, 32768u),
 						compute_block_count / 32768 + 1);
+					pipe->AddComputeMemoryBarrier(cmdBuf);
+
+					m_errorCount.MarkModifiedFromGpu();
+					m_errorCount.PrepareForCpuAccessNonblocking(cmdBuf);
 
 					cmdBuf.end();
 					queue->SubmitAndBlock(cmdBuf);
@@ -329,10 +348,15 @@ void PRBSCheckerFilter::Refresh(
 						pipe->BindBufferNonblocking(2, m_prbs23Table, cmdBuf);
 					else
 						pipe->BindBufferNonblocking(2, m_prbs31Table, cmdBuf);
+					pipe->BindBufferNonblocking(3, m_errorCount, cmdBuf);
 
 					pipe->Dispatch(cmdBuf, blockcfg,
 						min(compute_block_count, 32768u),
 						compute_block_count / 32768 + 1);
+					pipe->AddComputeMemoryBarrier(cmdBuf);
+
+					m_errorCount.MarkModifiedFromGpu();
+					m_errorCount.PrepareForCpuAccessNonblocking(cmdBuf);
 
 					cmdBuf.end();
 					queue->SubmitAndBlock(cmdBuf);
@@ -344,56 +368,91 @@ void PRBSCheckerFilter::Refresh(
 			default:
 				break;
 		}
+
+		//Only the error count comes back to the CPU, the per-bit flags stay on the GPU
+		m_streams[1].m_value = m_errorCount[0];
 	}
 
 	//CPU fallback if we get to this point
 	else
 	{
-		//Sparse path
-		uint32_t prbs = 0;
+		dout->m_samples.PrepareForCpuAccess();
+
+		const bool* samples;
 		if(sdin)
 		{
-			dout->m_samples.PrepareForCpuAccess();
 			sdin->m_samples.PrepareForCpuAccess();
-
-			//Read the first N bits of state into the seed
-			for(size_t i=0; i<statesize; i++)
-			{
-				prbs = (prbs << 1) | sdin->m_samples[i];
-				dout->m_samples[i] = 0;
-			}
-
-			//Start checking actual data bits
-			for(size_t i=statesize; i<len; i++)
-			{
-				bool value = PRBSGeneratorFilter::RunPRBS(prbs, poly);
-				dout->m_samples[i] = (value != sdin->m_samples[i]);
-			}
-
-			dout->m_samples.MarkModifiedFromCpu();
+			samples = sdin->m_samples.GetCpuPointer();
 		}
-
-		//Uniform path
 		else
 		{
-			dout->m_samples.PrepareForCpuAccess();
 			udin->m_samples.PrepareForCpuAccess();
+			samples = udin->m_samples.GetCpuPointer();
+		}
+
+		m_streams[1].m_value = Check(samples, dout->m_samples.GetCpuPointer(), len, poly);
+
+		dout->m_samples.MarkModifiedFromCpu();
+	}
+}
+
+/**
+	@brief Checks a PRBS on the CPU
+
+	The LFSR is seeded from the first N input bits, then the rest of the input is compared against the sequence
+	predicted from that seed, 64 bits at a time. The input is split into blocks which are checked in parallel, each
+	starting from the seed jumped ahead to the start of the block.
+
+	@param in		Input data bits
+	@param errs		Output array, set to true for every bit which didn't match the expected sequence
+	@param len		Number of input bits, at least the polynomial length
+	@param poly		Polynomial to check against
 
-			//Read the first N bits of state into the seed
-			for(size_t i=0; i<statesize; i++)
-			{
-				prbs = (prbs << 1) | udin->m_samples[i];
-				dout->m_samples[i] = 0;
-			}
-
-			//Start checking actual data bits
-			for(size_t i=statesize; i<len; i++)
-			{
-				bool value = PRBSGeneratorFilter::RunPRBS(prbs, poly);
-				dout->m_samples[i] = (value != udin->m_samples[i]);
-			}
-
-			dout->m_samples.MarkModifiedFromCpu();
+	@return Number of bit errors
+ */
+size_t PRBSCheckerFilter::Check(const bool* in, bool* errs, size_t len, PRBSGeneratorFilter::Polynomials poly)
+{
+	auto& lfsr = PRBSGeneratorFilter::GetLFSR(poly);
+	size_t statesize = lfsr.GetWidth();
+
+	//Read the first N bits of state into the seed
+	uint64_t seed = 0;
+	for(size_t i=0; i<statesize; i++)
+	{
+		seed = (seed << 1) | in[i];
+		errs[i] = 0;
+	}
+
+	//Pack the input so it can be compared a word at a time
+	vector<uint64_t> bits;
+	PackedBits::Pack(in, len, bits);
+	const uint64_t* pbits = bits.data();
+
+	//Start checking actual data bits
+	size_t count = len - statesize;
+	auto split = ParallelTuning::GetSplit(ParallelTuning::KERNEL_THRESHOLD, count, 64);
+	size_t lastblock = split.m_numBlocks - 1;
+	size_t blocksize = split.m_blockSize;
+
+	size_t errors = 0;
+	#pragma omp parallel for if(split.m_threads > 1) num_threads(split.m_threads) reduction(+:errors)
+	for(size_t i=0; i<split.m_numBlocks; i++)
+	{
+		size_t start = i*blocksize;
+		size_t end = (i == lastblock) ? count : start + blocksize;
+
+		uint64_t state = lfsr.Jump(seed, start);
+		for(size_t j=start; j<end; j+=64)
+		{
+			size_t n = min(end - j, (size_t)64);
+			uint64_t diff = lfsr.Next64(state) ^ PackedBits::Get(pbits, statesize + j);
+			if(n < 64)
+				diff &= (1ULL << n) - 1;
+
+			errors += __builtin_popcountll(diff);
+			PackedBits::Unpack(diff, errs + statesize + j, n);
 		}
 	}
+
+	return errors;
 }
@@ -35,6 +35,8 @@
 #ifndef PRBSCheckerFilter_h
 #define PRBSCheckerFilter_h
 
+#include "PRBSGeneratorFilter.h"
+
 class PRBSCheckerConstants
 {
 public:
@@ -61,6 +63,8 @@ public:
 	PROTOCOL_DECODER_INITPROC(PRBSCheckerFilter)
 
 protected:
+	static size_t Check(const bool* in, bool* errs, size_t len, PRBSGeneratorFilter::Polynomials poly);
+
 	FilterParameter& m_poly;
 
 	std::shared_ptr<ComputePipeline> m_prbs7Pipeline;
@@ -77,6 +81,9 @@ protected:
 
 	///@brief LFSR lookahead table for PRBS-31 polynomial
 	AcceleratorBuffer<uint32_t> m_prbs31Table;
+
+	///@brief Total bit error count from the GPU checker
+	AcceleratorBuffer<uint32_t> m_errorCount;
 };
 
 #endif
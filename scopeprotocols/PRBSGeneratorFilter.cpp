@@ -29,6 +29,7 @@
 
 #include "../scopehal/scopehal.h"
 #include "PRBSGeneratorFilter.h"
+#include "../scopehal/PackedBits.h"
 
 using namespace std;
 
@@ -267,6 +268,74 @@ bool PRBSGeneratorFilter::RunPRBS(uint32_t& state, Polynomials poly)
 	return (bool)next;
 }
 
+/**
+	@brief Returns the word-parallel LFSR engine for a polynomial
+
+	Taps match RunPRBS(). Engines are built on first use and shared by all generator and checker instances.
+ */
+const FibonacciLFSR& PRBSGeneratorFilter::GetLFSR(Polynomials poly)
+{
+	static const FibonacciLFSR prbs7(7, 7, 6);
+	static const FibonacciLFSR prbs9(9, 9, 5);
+	static const FibonacciLFSR prbs11(11, 11, 9);
+	static const FibonacciLFSR prbs15(15, 15, 14);
+	static const FibonacciLFSR prbs23(23, 23, 18);
+	static const FibonacciLFSR prbs31(31, 31, 28);
+
+	switch(poly)
+	{
+		case POLY_PRBS7:
+			return prbs7;
+
+		case POLY_PRBS9:
+			return prbs9;
+
+		case POLY_PRBS11:
+			return prbs11;
+
+		case POLY_PRBS15:
+			return prbs15;
+
+		case POLY_PRBS23:
+			return prbs23;
+
+		case POLY_PRBS31:
+		default:
+			return prbs31;
+	}
+}
+
+/**
+	@brief Generates a PRBS on the CPU, producing the same output as calling RunPRBS() len times
+
+	The output is split into blocks which are generated in parallel, each starting from the seed jumped ahead to the
+	start of the block.
+
+	@param out		Output array
+	@param len		Number of bits to generate
+	@param seed		Initial LFSR state
+	@param poly		Polynomial to use
+ */
+void PRBSGeneratorFilter::Generate(bool* out, size_t len, uint64_t seed, Polynomials poly)
+{
+	auto& lfsr = GetLFSR(poly);
+
+	auto split = ParallelTuning::GetSplit(ParallelTuning::KERNEL_COPY, len, 64);
+	size_t lastblock = split.m_numBlocks - 1;
+	size_t blocksize = split.m_blockSize;
+
+	#pragma omp parallel for if(split.m_threads > 1) num_threads(split.m_threads)
+	for(size_t i=0; i<split.m_numBlocks; i++)
+	{
+		size_t start = i*blocksize;
+		size_t end = (i == lastblock) ? len : start + blocksize;
+
+		uint64_t state = lfsr.Jump(seed, start);
+		for(size_t j=start; j<end; j+=64)
+			PackedBits::Unpack(lfsr.Next64(state), out + j, min(end - j, (size_t)64));
+	}
+}
+
 void PRBSGeneratorFilter::Refresh(
 	[[maybe_unused]] vk::raii::CommandBuffer& cmdBuf,
 	[[maybe_unused]] shared_ptr<QueueHandle> queue)
@@ -433,9 +502,7 @@ void PRBSGeneratorFilter::Refresh(
 					//Always generate the PRBS
 					dat->m_samples.PrepareForCpuAccess();
 
-					uint32_t prbs = cfg.seed;
-					for(size_t i=0; i<depth; i++)
-						dat->m_samples[i] = RunPRBS(prbs, poly);
+					Generate(dat->m_samples.GetCpuPointer(), depth, cfg.seed, poly);
 
 					dat->m_samples.MarkModifiedFromCpu();
 				}
@@ -449,9 +516,7 @@ void PRBSGeneratorFilter::Refresh(
 		//Always generate the PRBS CPU side
 		dat->m_samples.PrepareForCpuAccess();
 
-		uint32_t prbs = rand();
-		for(size_t i=0; i<depth; i++)
-			dat->m_samples[i] = RunPRBS(prbs, poly);
+		Generate(dat->m_samples.GetCpuPointer(), depth, rand(), poly);
 
 		dat->m_samples.MarkModifiedFromCpu();
 	}
@@ -35,6 +35,8 @@
 #ifndef PRBSGeneratorFilter_h
 #define PRBSGeneratorFilter_h
 
+#include "../scopehal/LFSR.h"
+
 //Small PRBSes that run one iteration per thread block
 class PRBSGeneratorConstants
 {
@@ -75,6 +77,8 @@ public:
 	};
 
 	static bool RunPRBS(uint32_t& state, Polynomials poly);
+	static const FibonacciLFSR& GetLFSR(Polynomials poly);
+	static void Generate(bool* out, size_t len, uint64_t seed, Polynomials poly);
 
 protected:
 	FilterParameter& m_baud;
@@ -29,6 +29,9 @@
 
 #include "../scopehal/scopehal.h"
 #include "ParallelBus.h"
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
@@ -104,11 +107,14 @@ void ParallelBus::Refresh(
 	}
 
 	//Make sure we have an input for each channel in use
-	vector<UniformDigitalWaveform*> inputs;
+	vector<WaveformBase*> inputs;
+	vector<UniformDigitalWaveform*> uinputs;
 	for(size_t i=0; i<width; i++)
 	{
-		auto din = dynamic_cast<UniformDigitalWaveform*>(GetInputWaveform(i));
-		if(din == nullptr)
+		auto din = GetInputWaveform(i);
+		auto udin = dynamic_cast<UniformDigitalWaveform*>(din);
+		auto sdin = dynamic_cast<SparseDigitalWaveform*>(din);
+		if( (udin == nullptr) && (sdin == nullptr) )
 		{
 			AddErrorMessage("Missing input", "One or more inputs are unconnected or invalid");
 			SetData(nullptr, 0);
@@ -116,6 +122,8 @@ void ParallelBus::Refresh(
 		}
 		din->PrepareForCpuAccess();
 		inputs.push_back(din);
+		if(udin)
+			uinputs.push_back(udin);
 	}
 	if(inputs.empty())
 	{
@@ -124,6 +132,20 @@ void ParallelBus::Refresh(
 		return;
 	}
 
+	//Any sparse input means we have to merge change events rather than packing sample by sample
+	if(uinputs.size() == inputs.size())
+		RefreshUniform(uinputs);
+	else
+		RefreshSparse(inputs);
+}
+
+/**
+	@brief Packs uniformly sampled inputs into bus words, one output sample per input sample
+ */
+void ParallelBus::RefreshUniform(const vector<UniformDigitalWaveform*>& inputs)
+{
+	size_t width = inputs.size();
+
 	//Figure out length of the output
 	size_t len = inputs[0]->m_samples.size();
 	for(size_t j=1; j<width; j++)
@@ -134,15 +156,209 @@ void ParallelBus::Refresh(
 	cap->PrepareForCpuAccess();
 	cap->Resize(len);
 
-	//Pack it
-	//TODO: how to shader with dynamic number of inputs? do we make one for each count and dynamic dispatch?
-	for(size_t i=0; i<len; i++)
+	vector<const bool*> in(width);
+	for(size_t j=0; j<width; j++)
+		in[j] = inputs[j]->m_samples.GetCpuPointer();
+	uint32_t* out = cap->m_samples.GetCpuPointer();
+
+	//Divide large waveforms into blocks and multithread them.
+	//Round blocks to multiples of 32 samples for clean vectorization.
+	auto split = ParallelTuning::GetSplit(ParallelTuning::KERNEL_DIGITAL_UNPACK, len, 32, width);
+	size_t lastblock = split.m_numBlocks - 1;
+	size_t blocksize = split.m_blockSize;
+
+	#pragma omp parallel for if(split.m_threads > 1) num_threads(split.m_threads)
+	for(size_t i=0; i<split.m_numBlocks; i++)
+	{
+		//Last block gets any extra that didn't divide evenly
+		size_t nsamp = blocksize;
+		if(i == lastblock)
+			nsamp = len - i*blocksize;
+
+		size_t off = i*blocksize;
+		const bool* blockin[32];
+		for(size_t j=0; j<width; j++)
+			blockin[j] = in[j] + off;
+
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			PackBlockAVX2(out + off, blockin, width, nsamp);
+		else
+		#endif
+			PackBlock(out + off, blockin, width, nsamp);
+	}
+
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Packs inputs of which at least one is sparse into bus words
+
+	The change events of all inputs are merged, and a new output sample is only started when the bus value changes.
+	The output has a time scale in femtoseconds and ends when the shortest input does.
+ */
+void ParallelBus::RefreshSparse(const vector<WaveformBase*>& inputs)
+{
+	size_t width = inputs.size();
+
+	//Per-input read cursors
+	struct BusInput
+	{
+		SparseDigitalWaveform* m_sparse;
+		UniformDigitalWaveform* m_uniform;
+		size_t m_len;
+		size_t m_index;
+		int64_t m_next;
+	};
+	vector<BusInput> cursors(width);
+
+	//Start once every input has a valid sample, and stop once any of them runs out
+	int64_t tstart = INT64_MIN;
+	int64_t tend = INT64_MAX;
+	for(size_t j=0; j<width; j++)
+	{
+		auto& c = cursors[j];
+		c.m_sparse = dynamic_cast<SparseDigitalWaveform*>(inputs[j]);
+		c.m_uniform = dynamic_cast<UniformDigitalWaveform*>(inputs[j]);
+		c.m_len = inputs[j]->size();
+		c.m_index = 0;
+		if(!c.m_len)
+			tend = INT64_MIN;
+		else
+		{
+			tstart = max(tstart, GetOffsetScaled(c.m_sparse, c.m_uniform, 0));
+			tend = min(tend,
+				GetOffsetScaled(c.m_sparse, c.m_uniform, c.m_len-1) +
+				GetDurationScaled(c.m_sparse, c.m_uniform, c.m_len-1));
+		}
+	}
+
+	auto cap = SetupEmptyWaveform<SparseDigitalBusWaveform32>(inputs[0], 0);
+	cap->m_timescale = 1;
+	cap->m_triggerPhase = 0;
+	cap->PrepareForCpuAccess();
+	if(tstart >= tend)
+	{
+		cap->MarkModifiedFromCpu();
+		return;
+	}
+
+	//Sync every input to the start time, then merge their sample boundaries in time order
+	int64_t timestamp = tstart;
+	uint32_t word = 0;
+	for(size_t j=0; j<width; j++)
+	{
+		auto& c = cursors[j];
+		AdvanceToTimestampScaled(c.m_sparse, c.m_uniform, c.m_index, c.m_len, timestamp);
+		c.m_next = GetNextEventTimestampScaled(c.m_sparse, c.m_uniform, c.m_index, c.m_len, INT64_MAX);
+		if(GetValue(c.m_sparse, c.m_uniform, c.m_index))
+			word |= (1U << j);
+	}
+	cap->m_offsets.push_back(timestamp);
+	cap->m_samples.push_back(word);
+
+	while(true)
 	{
-		uint32_t n = 0;
+		int64_t next = INT64_MAX;
+		for(auto& c : cursors)
+			next = min(next, c.m_next);
+		if(next >= tend)
+			break;
+		timestamp = next;
+
+		//Step every input with an event here
+		word = 0;
 		for(size_t j=0; j<width; j++)
-			n |= inputs[j]->m_samples[i] << j;
-		cap->m_samples[i] = n;
+		{
+			auto& c = cursors[j];
+			if(c.m_next == timestamp)
+			{
+				c.m_index ++;
+				c.m_next = GetNextEventTimestampScaled(c.m_sparse, c.m_uniform, c.m_index, c.m_len, INT64_MAX);
+			}
+			if(GetValue(c.m_sparse, c.m_uniform, c.m_index))
+				word |= (1U << j);
+		}
+
+		//Only start a new sample if the bus value changed
+		if(word != cap->m_samples[cap->m_samples.size() - 1])
+		{
+			cap->m_durations.push_back(timestamp - cap->m_offsets[cap->m_offsets.size() - 1]);
+			cap->m_offsets.push_back(timestamp);
+			cap->m_samples.push_back(word);
+		}
 	}
+	cap->m_durations.push_back(tend - cap->m_offsets[cap->m_offsets.size() - 1]);
 
 	cap->MarkModifiedFromCpu();
 }
+
+/**
+	@brief Packs a block of byte-per-sample inputs into bus words
+ */
+void ParallelBus::PackBlock(uint32_t* out, const bool* const* in, size_t width, size_t count)
+{
+	memset(out, 0, count * sizeof(uint32_t));
+	for(size_t j=0; j<width; j++)
+	{
+		const bool* p = in[j];
+		for(size_t i=0; i<count; i++)
+			out[i] |= p[i] << j;
+	}
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 optimized version of PackBlock()
+
+	Each group of eight inputs is combined into one byte per sample with shifts and ORs, then the (up to) four byte
+	lanes are interleaved into 32-bit words.
+ */
+__attribute__((target("avx2")))
+void ParallelBus::PackBlockAVX2(uint32_t* out, const bool* const* in, size_t width, size_t count)
+{
+	size_t end = count - (count % 32);
+	for(size_t i=0; i<end; i+=32)
+	{
+		//Bytes 0-3 of the bus word for each of 32 samples
+		__m256i lanes[4] =
+		{
+			_mm256_setzero_si256(),
+			_mm256_setzero_si256(),
+			_mm256_setzero_si256(),
+			_mm256_setzero_si256()
+		};
+		for(size_t j=0; j<width; j++)
+		{
+			//Bools are 0 or 1 so shifting within 16-bit lanes never carries into the neighboring byte
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in[j] + i));
+			v = _mm256_sll_epi16(v, _mm_cvtsi32_si128(j & 7));
+			lanes[j >> 3] = _mm256_or_si256(lanes[j >> 3], v);
+		}
+
+		//Interleave bytes into words. Unpacks work within 128-bit halves, so samples 0-7 and 16-23 end up in
+		//the low halves and 8-15 and 24-31 in the high halves.
+		__m256i lo01 = _mm256_unpacklo_epi8(lanes[0], lanes[1]);
+		__m256i hi01 = _mm256_unpackhi_epi8(lanes[0], lanes[1]);
+		__m256i lo23 = _mm256_unpacklo_epi8(lanes[2], lanes[3]);
+		__m256i hi23 = _mm256_unpackhi_epi8(lanes[2], lanes[3]);
+
+		__m256i w0 = _mm256_unpacklo_epi16(lo01, lo23);		//samples 0-3, 16-19
+		__m256i w1 = _mm256_unpackhi_epi16(lo01, lo23);		//samples 4-7, 20-23
+		__m256i w2 = _mm256_unpacklo_epi16(hi01, hi23);		//samples 8-11, 24-27
+		__m256i w3 = _mm256_unpackhi_epi16(hi01, hi23);		//samples 12-15, 28-31
+
+		__m256i* pout = reinterpret_cast<__m256i*>(out + i);
+		_mm256_storeu_si256(pout + 0, _mm256_permute2x128_si256(w0, w1, 0x20));
+		_mm256_storeu_si256(pout + 1, _mm256_permute2x128_si256(w2, w3, 0x20));
+		_mm256_storeu_si256(pout + 2, _mm256_permute2x128_si256(w0, w1, 0x31));
+		_mm256_storeu_si256(pout + 3, _mm256_permute2x128_si256(w2, w3, 0x31));
+	}
+
+	//Do the tail
+	const bool* tail[32];
+	for(size_t j=0; j<width; j++)
+		tail[j] = in[j] + end;
+	PackBlock(out + end, tail, width, count - end);
+}
+#endif /* __x86_64__ */
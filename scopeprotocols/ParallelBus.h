@@ -50,6 +50,14 @@ protected:
 	FilterParameter& m_width;
 
 	void OnWidthChanged();
+
+	void RefreshUniform(const std::vector<UniformDigitalWaveform*>& inputs);
+	void RefreshSparse(const std::vector<WaveformBase*>& inputs);
+
+	static void PackBlock(uint32_t* out, const bool* const* in, size_t width, size_t count);
+#ifdef __x86_64__
+	static void PackBlockAVX2(uint32_t* out, const bool* const* in, size_t width, size_t count);
+#endif
 };
 
 #endif
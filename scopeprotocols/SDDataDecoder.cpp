@@ -318,7 +318,7 @@ Packet* SDDataDecoder::FindCommandBusPacket(SDCmdDecoder* decode, int64_t timest
 	for(auto p : packets)
 	{
 		//If it's not a command, ignore it
-		if(p->m_headers["Type"] != "Command")
+		if(p->GetHeader("Type") != "Command")
 			continue;
 
 		//If it's after the timestamp, we're done
@@ -270,21 +270,30 @@ void SPIDecoder::Refresh(
 	cap->MarkModifiedFromCpu();
 }
 
-string SPIWaveform::GetColor(size_t i)
+vector<string> SPIWaveform::GetColorPalette()
 {
-	const SPISymbol& s = m_samples[i];
-	switch(s.m_stype)
+	return
+	{
+		StandardColors::colors[StandardColors::COLOR_CONTROL],
+		StandardColors::colors[StandardColors::COLOR_DATA],
+		StandardColors::colors[StandardColors::COLOR_ERROR]
+	};
+}
+
+uint8_t SPIWaveform::GetColorIndex(size_t i)
+{
+	switch(m_samples[i].m_stype)
 	{
 		case SPISymbol::TYPE_SELECT:
 		case SPISymbol::TYPE_DESELECT:
-			return StandardColors::colors[StandardColors::COLOR_CONTROL];
+			return 0;
 
 		case SPISymbol::TYPE_DATA:
-			return StandardColors::colors[StandardColors::COLOR_DATA];
+			return 1;
 
 		case SPISymbol::TYPE_ERROR:
 		default:
-			return StandardColors::colors[StandardColors::COLOR_ERROR];
+			return 2;
 	}
 }
 
@@ -69,7 +69,8 @@ class SPIWaveform : public SparseWaveform<SPISymbol>
 public:
 	SPIWaveform () : SparseWaveform<SPISymbol>() {};
 	virtual std::string GetText(size_t) override;
-	virtual std::string GetColor(size_t) override;
+	virtual std::vector<std::string> GetColorPalette() override;
+	virtual uint8_t GetColorIndex(size_t i) override;
 };
 
 class SPIDecoder : public Filter
@@ -143,6 +143,20 @@ void SpectrogramFilter::ReallocateBuffers(size_t fftlen, size_t nblocks)
 	m_cachedFFTNumBlocks = nblocks;
 
 	size_t nouts = fftlen/2 + 1;
+
+	//Software Vulkan: run the FFT natively and keep the scratch buffers on the CPU side
+	if(CPUFFTPlan::IsPreferred())
+	{
+		m_vkPlan = nullptr;
+		m_cpuPlan = CPUFFTPlan::Get(fftlen, CPUFFTPlan::DIRECTION_FORWARD, nblocks);
+
+		m_rdinbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		m_rdinbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+		m_rdoutbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		m_rdoutbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+		return;
+	}
+
 	if(m_vkPlan)
 	{
 		if(m_vkPlan->size() != fftlen)
@@ -225,7 +239,10 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 	cap->m_startFemtoseconds = din->m_startFemtoseconds;
 	cap->m_triggerPhase = din->m_triggerPhase;
 	cap->m_timescale = fs_per_sample * fftlen;
-	cap->PrepareForGpuAccess();
+	if(CPUFFTPlan::IsPreferred())
+		cap->PrepareForCpuAccess();
+	else
+		cap->PrepareForGpuAccess();
 	SetData(cap, 0);
 
 	//We also need to adjust the scale by the coherent power gain of the window function
@@ -299,6 +316,24 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 	float fullscale = m_rangeMax.GetFloatVal();
 	float range = fullscale - minscale;
 
+	//Configure the postprocessing
+	const float impedance = 50;
+	SpectrogramPostprocessArgs postargs;
+	postargs.nblocks = nblocks;
+	postargs.nouts = nouts;
+	postargs.logscale = 10.0 / log(10);
+	postargs.impscale = scale*scale / impedance;
+	postargs.minscale = minscale;
+	postargs.irange = 1.0 / range;
+	postargs.ygrid = min(g_maxComputeGroupCount[2], nblocks);
+
+	//Software Vulkan: do everything natively rather than emulating shaders
+	if(CPUFFTPlan::IsPreferred())
+	{
+		RefreshCPU(din, cap, args, window, fftlen, nblocks, postargs);
+		return;
+	}
+
 	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
 	cmdBuf.begin({});
 
@@ -324,15 +359,6 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 		cmdBuf);
 
 	//Postprocess the output
-	const float impedance = 50;
-	SpectrogramPostprocessArgs postargs;
-	postargs.nblocks = nblocks;
-	postargs.nouts = nouts;
-	postargs.logscale = 10.0 / log(10);
-	postargs.impscale = scale*scale / impedance;
-	postargs.minscale = minscale;
-	postargs.irange = 1.0 / range;
-	postargs.ygrid = min(g_maxComputeGroupCount[2], nblocks);
 	m_postprocessComputePipeline.AddComputeMemoryBarrier(cmdBuf);
 	m_postprocessComputePipeline.BindBufferNonblocking(0, m_rdoutbuf, cmdBuf);
 	m_postprocessComputePipeline.BindBufferNonblocking(1, cap->GetOutData(), cmdBuf, true);
@@ -350,3 +376,76 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 
 	cap->MarkModifiedFromGpu();
 }
+
+/**
+	@brief Native CPU implementation of the window / FFT / postprocess pipeline, for software Vulkan devices
+
+	Does exactly the same math as the shaders in Refresh().
+ */
+void SpectrogramFilter::RefreshCPU(
+	UniformAnalogWaveform* din,
+	SpectrogramWaveform* cap,
+	WindowFunctionArgs& args,
+	FFTFilter::WindowFunction window,
+	size_t fftlen,
+	size_t nblocks,
+	const SpectrogramPostprocessArgs& postargs)
+{
+	din->PrepareForCpuAccess();
+	m_rdinbuf.PrepareForCpuAccess();
+	m_rdoutbuf.PrepareForCpuAccess();
+
+	//Grab the input and apply the window function
+	const float* fin = din->m_samples.GetCpuPointer();
+	float* fwin = m_rdinbuf.GetCpuPointer();
+	for(size_t block=0; block<nblocks; block++)
+	{
+		args.offsetIn = block*fftlen;
+		args.offsetOut = block*fftlen;
+
+		switch(window)
+		{
+			case FFTFilter::WINDOW_BLACKMAN_HARRIS:
+				CPUFFTPlan::ApplyBlackmanHarrisWindow(fin, fwin, args);
+				break;
+
+			case FFTFilter::WINDOW_HANN:
+			case FFTFilter::WINDOW_HAMMING:
+				CPUFFTPlan::ApplyCosineSumWindow(fin, fwin, args);
+				break;
+
+			default:
+			case FFTFilter::WINDOW_RECTANGULAR:
+				CPUFFTPlan::ApplyRectangularWindow(fin, fwin, args);
+				break;
+		}
+	}
+
+	//Do the actual FFT
+	m_cpuPlan->Forward(m_rdinbuf.GetCpuPointer(), m_rdoutbuf.GetCpuPointer());
+
+	//Postprocess the output (transposing so each block is one column)
+	const float* fft = m_rdoutbuf.GetCpuPointer();
+	float* fout = cap->GetOutData().GetCpuPointer();
+	size_t nouts = postargs.nouts;
+
+	#pragma omp parallel for
+	for(size_t block=0; block<nblocks; block++)
+	{
+		for(size_t x=0; x<nouts; x++)
+		{
+			size_t nin = (nouts*block + x)*2;
+			float real = fft[nin];
+			float imag = fft[nin + 1];
+
+			float vsq = real*real + imag*imag;
+			float dbm = postargs.logscale * logf(vsq * postargs.impscale) + 30;
+			if(dbm < postargs.minscale)
+				fout[x*nblocks + block] = 0;
+			else
+				fout[x*nblocks + block] = (dbm - postargs.minscale) * postargs.irange;
+		}
+	}
+
+	cap->MarkModifiedFromCpu();
+}
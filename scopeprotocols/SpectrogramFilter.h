@@ -37,6 +37,7 @@
 #define SpectrogramFilter_h
 
 #include "VulkanFFTPlan.h"
+#include "CPUFFTPlan.h"
 
 #include "../scopehal/DensityFunctionWaveform.h"
 
@@ -111,6 +112,15 @@ public:
 protected:
 	virtual void ReallocateBuffers(size_t fftlen, size_t nblocks);
 
+	void RefreshCPU(
+		UniformAnalogWaveform* din,
+		SpectrogramWaveform* cap,
+		WindowFunctionArgs& args,
+		FFTFilter::WindowFunction window,
+		size_t fftlen,
+		size_t nblocks,
+		const SpectrogramPostprocessArgs& postargs);
+
 	AcceleratorBuffer<float> m_rdinbuf;
 	AcceleratorBuffer<float> m_rdoutbuf;
 
@@ -126,6 +136,7 @@ protected:
 	FilterParameter& m_rangeMax;
 
 	std::unique_ptr<VulkanFFTPlan> m_vkPlan;
+	std::shared_ptr<CPUFFTPlan> m_cpuPlan;
 
 	ComputePipeline m_blackmanHarrisComputePipeline;
 	ComputePipeline m_rectangularComputePipeline;
@@ -32,6 +32,8 @@
 
 using namespace std;
 
+shared_ptr<FusibleShader> SubtractFilter::m_fusibleShader;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -337,3 +339,44 @@ void SubtractFilter::DoRefreshScalarVector(size_t iScalar, size_t iVector)
 		cap->MarkModifiedFromCpu();
 	}
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shader fusion
+
+shared_ptr<FusibleShader> SubtractFilter::GetFusibleShader(vector<size_t>& inputs)
+{
+	//Only vector-vector subtraction is a pure elementwise operation (degrees need wrapping, done on the CPU).
+	//Skew between the inputs is not an issue, fused chains are only run on inputs with the same trigger phase.
+	if( (GetInput(0).GetType() != Stream::STREAM_TYPE_ANALOG) || (GetInput(1).GetType() != Stream::STREAM_TYPE_ANALOG) )
+		return nullptr;
+	if( (m_inputs[0]->GetXAxisUnits() != m_inputs[1]->GetXAxisUnits()) ||
+		(m_inputs[0]->GetYAxisUnits() != m_inputs[1]->GetYAxisUnits()) ||
+		(m_inputs[0]->GetYAxisUnits() == Unit::UNIT_DEGREES) )
+	{
+		return nullptr;
+	}
+
+	if(!m_fusibleShader)
+	{
+		m_fusibleShader = make_shared<FusibleShader>(
+			"Subtract",
+			"float __kernel__(float a, float b)\n"
+			"{\n"
+			"\treturn a - b;\n"
+			"}\n");
+		m_fusibleShader->m_inputs.push_back(ShaderInputInfo("float", "a"));
+		m_fusibleShader->m_inputs.push_back(ShaderInputInfo("float", "b"));
+		m_fusibleShader->m_cpuOps.push_back(FusibleCpuOp(FusibleCpuOp::OP_SUBTRACT, 0, 1));
+	}
+
+	inputs = { 0, 1 };
+	return m_fusibleShader;
+}
+
+void SubtractFilter::PrepareFusedRefresh(vector<uint32_t>& /*pushConstants*/)
+{
+	ClearMessages();
+	m_streams[0].m_stype = Stream::STREAM_TYPE_ANALOG;
+	m_xAxisUnit = m_inputs[0]->GetXAxisUnits();
+	SetYAxisUnits(m_inputs[0]->GetYAxisUnits(), 0);
+}
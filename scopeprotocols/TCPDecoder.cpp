@@ -79,6 +79,7 @@ void TCPDecoder::Refresh(
 	//Loop over the events and process stuff
 	auto cap = SetupEmptyWaveform<TCPWaveform>(din, 0);
 	cap->PrepareForCpuAccess();
+	cap->m_arena.reserve(din->m_arena.size());
 
 	int state = 0;
 	int option_len = 0;
@@ -91,9 +92,7 @@ void TCPDecoder::Refresh(
 		int64_t end = off + dur;
 		int64_t halfdur = dur/2;
 
-		uint8_t bin = 0;
-		if(din->m_samples[i].m_data.size())
-			bin = din->m_samples[i].m_data[0];
+		uint8_t bin = din->GetByte(s.m_data, 0);
 
 		switch(state)
 		{
@@ -121,7 +120,7 @@ void TCPDecoder::Refresh(
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_SOURCE_PORT, bin));
+					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_SOURCE_PORT, cap->AddByte(bin)));
 				}
 				break;
 
@@ -129,7 +128,7 @@ void TCPDecoder::Refresh(
 			case 3:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendByte(cap->m_samples[caplen-1].m_data, bin);
 					cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 					state = 4;
 				}
@@ -145,7 +144,7 @@ void TCPDecoder::Refresh(
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_DEST_PORT, bin));
+					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_DEST_PORT, cap->AddByte(bin)));
 				}
 				else
 					state = 0;
@@ -155,7 +154,7 @@ void TCPDecoder::Refresh(
 			case 5:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendByte(cap->m_samples[caplen-1].m_data, bin);
 					cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 					state = 6;
 				}
@@ -171,7 +170,7 @@ void TCPDecoder::Refresh(
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_SEQ, bin));
+					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_SEQ, cap->AddByte(bin)));
 				}
 				else
 					state = 0;
@@ -181,9 +180,9 @@ void TCPDecoder::Refresh(
 			case 7:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendByte(cap->m_samples[caplen-1].m_data, bin);
 
-					if(cap->m_samples[caplen-1].m_data.size() == 4)
+					if(cap->m_samples[caplen-1].m_data.m_length == 4)
 					{
 						cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 						state = 8;
@@ -201,7 +200,7 @@ void TCPDecoder::Refresh(
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_ACK, bin));
+					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_ACK, cap->AddByte(bin)));
 				}
 				else
 					state = 0;
@@ -211,9 +210,9 @@ void TCPDecoder::Refresh(
 			case 9:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendByte(cap->m_samples[caplen-1].m_data, bin);
 
-					if(cap->m_samples[caplen-1].m_data.size() == 4)
+					if(cap->m_samples[caplen-1].m_data.m_length == 4)
 					{
 						cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 						state = 10;
@@ -231,14 +230,14 @@ void TCPDecoder::Refresh(
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(halfdur);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_DATA_OFFSET, bin >> 4));
+					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_DATA_OFFSET, cap->AddByte(bin >> 4)));
 
 					option_len = ( (bin >> 4) * 4) - 20;
 
 					//Also push the NS bit of the flags
 					cap->m_offsets.push_back(off + halfdur);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_FLAGS, bin & 0xf));
+					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_FLAGS, cap->AddByte(bin & 0xf)));
 				}
 				else
 					state = 0;
@@ -248,7 +247,7 @@ void TCPDecoder::Refresh(
 			case 11:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendByte(cap->m_samples[caplen-1].m_data, bin);
 					cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 					state = 12;
 				}
@@ -264,7 +263,7 @@ void TCPDecoder::Refresh(
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_WINDOW, bin));
+					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_WINDOW, cap->AddByte(bin)));
 				}
 				else
 					state = 0;
@@ -274,7 +273,7 @@ void TCPDecoder::Refresh(
 			case 13:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendByte(cap->m_samples[caplen-1].m_data, bin);
 					cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 					state = 14;
 				}
@@ -290,7 +289,7 @@ void TCPDecoder::Refresh(
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_CHECKSUM, bin));
+					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_CHECKSUM, cap->AddByte(bin)));
 				}
 				else
 					state = 0;
@@ -300,7 +299,7 @@ void TCPDecoder::Refresh(
 			case 15:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendByte(cap->m_samples[caplen-1].m_data, bin);
 					cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 					state = 16;
 				}
@@ -316,7 +315,7 @@ void TCPDecoder::Refresh(
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_URGENT, bin));
+					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_URGENT, cap->AddByte(bin)));
 				}
 				else
 					state = 0;
@@ -326,7 +325,7 @@ void TCPDecoder::Refresh(
 			case 17:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendByte(cap->m_samples[caplen-1].m_data, bin);
 					cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 					state = 18;
 				}
@@ -343,7 +342,7 @@ void TCPDecoder::Refresh(
 					{
 						cap->m_offsets.push_back(din->m_offsets[i]);
 						cap->m_durations.push_back(din->m_durations[i]);
-						cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_DATA, bin));
+						cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_DATA, cap->AddByte(bin)));
 
 						state = 19;
 					}
@@ -353,7 +352,7 @@ void TCPDecoder::Refresh(
 					{
 						cap->m_offsets.push_back(din->m_offsets[i]);
 						cap->m_durations.push_back(din->m_durations[i]);
-						cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_OPTIONS, bin));
+						cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_OPTIONS, cap->AddByte(bin)));
 
 						option_len --;
 					}
@@ -367,7 +366,7 @@ void TCPDecoder::Refresh(
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_DATA, bin));
+					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_DATA, cap->AddByte(bin)));
 				}
 				else
 					state = 0;
@@ -416,72 +415,76 @@ std::string TCPWaveform::GetColor(size_t i)
 string TCPWaveform::GetText(size_t i)
 {
 	char tmp[128];
+
+	//Zero pad short (truncated) fields
 	auto sample = m_samples[i];
+	uint8_t data[4] = {0};
+	memcpy(data, GetBytes(sample.m_data), min((size_t)sample.m_data.m_length, sizeof(data)));
 
 	switch(sample.m_type)
 	{
 		case TCPSymbol::TYPE_SEQ:
 			snprintf(tmp, sizeof(tmp), "Seq: %08x",
-				(sample.m_data[0] << 24) | (sample.m_data[1] << 16) | (sample.m_data[2] << 8) | sample.m_data[3]);
+				(data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_ACK:
 			snprintf(tmp, sizeof(tmp), "Ack: %08x",
-				(sample.m_data[0] << 24) | (sample.m_data[1] << 16) | (sample.m_data[2] << 8) | sample.m_data[3]);
+				(data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_DATA_OFFSET:
-			snprintf(tmp, sizeof(tmp), "Data off: %d", sample.m_data[0]);
+			snprintf(tmp, sizeof(tmp), "Data off: %d", data[0]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_FLAGS:
 			{
 				string s;
-				if(sample.m_data[1] & 0x01)
+				if(data[1] & 0x01)
 					s += "FIN ";
-				if(sample.m_data[1] & 0x02)
+				if(data[1] & 0x02)
 					s += "SYN ";
-				if(sample.m_data[1] & 0x04)
+				if(data[1] & 0x04)
 					s += "RST ";
-				if(sample.m_data[1] & 0x08)
+				if(data[1] & 0x08)
 					s += "PSH ";
-				if(sample.m_data[1] & 0x10)
+				if(data[1] & 0x10)
 					s += "ACK ";
-				if(sample.m_data[1] & 0x20)
+				if(data[1] & 0x20)
 					s += "URG ";
-				if(sample.m_data[1] & 0x40)
+				if(data[1] & 0x40)
 					s += "ECE ";
-				if(sample.m_data[1] & 0x80)
+				if(data[1] & 0x80)
 					s += "CWR ";
-				if(sample.m_data[0] & 1)
+				if(data[0] & 1)
 					s += "NS ";
 				return s;
 			}
 
 		case TCPSymbol::TYPE_WINDOW:
-			snprintf(tmp, sizeof(tmp), "Window: %d", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "Window: %d", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_CHECKSUM:
-			snprintf(tmp, sizeof(tmp), "Checksum: %x", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "Checksum: %x", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_URGENT:
-			snprintf(tmp, sizeof(tmp), "Urgent: %x", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "Urgent: %x", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_SOURCE_PORT:
-			snprintf(tmp, sizeof(tmp), "Source: %d", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "Source: %d", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_DEST_PORT:
 			snprintf(tmp, sizeof(tmp), "Dest: %d",
-				(sample.m_data[0] << 8) | sample.m_data[1]);
+				(data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_DATA:
 		case TCPSymbol::TYPE_OPTIONS:
-			snprintf(tmp, sizeof(tmp), "%02x", sample.m_data[0]);
+			snprintf(tmp, sizeof(tmp), "%02x", data[0]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_ERROR:
@@ -37,6 +37,11 @@
 
 #include "IPv4Decoder.h"
 
+/**
+	@brief A single field of a TCP segment
+
+	The field bytes live in the payload arena of the parent TCPWaveform, so this class is POD.
+ */
 class TCPSymbol
 {
 public:
@@ -57,14 +62,16 @@ public:
 		TYPE_DATA
 	} m_type;
 
-	std::vector<uint8_t> m_data;
+	///@brief Bytes of the field, in the parent waveform's arena
+	ByteArenaRef m_data;
 
 	TCPSymbol()
 	{}
 
-	TCPSymbol(SegmentType type, uint8_t value)
+	TCPSymbol(SegmentType type, ByteArenaRef data)
 		: m_type(type)
-	{ m_data.push_back(value); }
+		, m_data(data)
+	{}
 
 	bool operator==(const TCPSymbol& rhs) const
 	{
@@ -72,10 +79,10 @@ public:
 	}
 };
 
-class TCPWaveform : public SparseWaveform<TCPSymbol>
+class TCPWaveform : public ByteArenaWaveform<TCPSymbol>
 {
 public:
-	TCPWaveform () : SparseWaveform<TCPSymbol>() {};
+	TCPWaveform () : ByteArenaWaveform<TCPSymbol>() {};
 	virtual std::string GetText(size_t) override;
 	virtual std::string GetColor(size_t) override;
 };
@@ -32,6 +32,8 @@
 
 using namespace std;
 
+shared_ptr<FusibleShader> ThresholdFilter::m_fusibleShader;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -129,7 +131,7 @@ void ThresholdFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<Q
 					compute_block_count / 32768 + 1);
 
 				cmdBuf.end();
-				queue->SubmitAndBlock(cmdBuf);
+				cap->m_samples.SetGpuCompletion(queue->SubmitAsync(cmdBuf));
 
 				cap->m_samples.MarkModifiedFromGpu();
 			}
@@ -138,7 +140,8 @@ void ThresholdFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<Q
 				din->PrepareForCpuAccess();
 				cap->PrepareForCpuAccess();
 
-				#pragma omp parallel for
+				int nthreads = ParallelTuning::GetThreadCount(ParallelTuning::KERNEL_THRESHOLD, len);
+				#pragma omp parallel for if(nthreads > 1) num_threads(nthreads)
 				for(size_t i=0; i<len; i++)
 					cap->m_samples[i] = sdin->m_samples[i] > midpoint;
 
@@ -193,7 +196,7 @@ void ThresholdFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<Q
 					compute_block_count / 32768 + 1);
 
 				cmdBuf.end();
-				queue->SubmitAndBlock(cmdBuf);
+				cap->m_samples.SetGpuCompletion(queue->SubmitAsync(cmdBuf));
 
 				cap->m_samples.MarkModifiedFromGpu();
 			}
@@ -202,7 +205,8 @@ void ThresholdFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<Q
 				din->PrepareForCpuAccess();
 				cap->PrepareForCpuAccess();
 
-				#pragma omp parallel for
+				int nthreads = ParallelTuning::GetThreadCount(ParallelTuning::KERNEL_THRESHOLD, len);
+				#pragma omp parallel for if(nthreads > 1) num_threads(nthreads)
 				for(size_t i=0; i<len; i++)
 					cap->m_samples[i] = udin->m_samples[i] > midpoint;
 
@@ -232,3 +236,49 @@ void ThresholdFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<Q
 		}
 	}
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shader fusion
+
+shared_ptr<FusibleShader> ThresholdFilter::GetFusibleShader(vector<size_t>& inputs)
+{
+	//Hysteresis is stateful so can't be done one sample at a time.
+	//(Without 8-bit storage support the chain is evaluated on the CPU)
+	if(m_hysteresis.GetFloatVal() != 0)
+		return nullptr;
+
+	if(!m_fusibleShader)
+	{
+		m_fusibleShader = make_shared<FusibleShader>(
+			"Threshold",
+			"float __kernel__(float din)\n"
+			"{\n"
+			"\tif(din > __push__threshold)\n"
+			"\t\treturn 1.0;\n"
+			"\telse\n"
+			"\t\treturn 0.0;\n"
+			"}\n");
+		m_fusibleShader->m_inputs.push_back(ShaderInputInfo("float", "din"));
+		m_fusibleShader->m_pushConstants.push_back(PushConstantInfo("float", "threshold"));
+		m_fusibleShader->m_outputType = "uint8_t";
+		m_fusibleShader->m_cpuOps.push_back(
+			FusibleCpuOp(FusibleCpuOp::OP_THRESHOLD, 0, FusibleCpuOp::PushConstant(0)));
+	}
+
+	inputs = { 0 };
+	return m_fusibleShader;
+}
+
+void ThresholdFilter::PrepareFusedRefresh(vector<uint32_t>& pushConstants)
+{
+	ClearMessages();
+
+	auto yunit = GetInput(0).GetYAxisUnits();
+	m_threshold.SetUnit(yunit);
+	m_hysteresis.SetUnit(yunit);
+
+	float threshold = m_threshold.GetFloatVal();
+	uint32_t word;
+	memcpy(&word, &threshold, sizeof(word));
+	pushConstants.push_back(word);
+}
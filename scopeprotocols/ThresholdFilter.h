@@ -48,6 +48,9 @@ public:
 
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
+	virtual std::shared_ptr<FusibleShader> GetFusibleShader(std::vector<size_t>& inputs) override;
+	virtual void PrepareFusedRefresh(std::vector<uint32_t>& pushConstants) override;
+
 	static std::string GetProtocolName();
 
 	PROTOCOL_DECODER_INITPROC(ThresholdFilter)
@@ -57,6 +60,9 @@ protected:
 	FilterParameter& m_hysteresis;
 
 	std::unique_ptr<ComputePipeline> m_computePipeline;
+
+	///@brief Elementwise kernel for shader fusion
+	static std::shared_ptr<FusibleShader> m_fusibleShader;
 };
 
 #endif
@@ -103,7 +103,9 @@ void TimeOutsideLevelMeasurement::Refresh(
 
 	if (uadin)
 	{
-		#pragma omp parallel
+		//High and low scans are independent serial passes, only worth two threads on long waveforms
+		int nthreads = ParallelTuning::GetThreadCount(ParallelTuning::KERNEL_REDUCTION, length);
+		#pragma omp parallel if(nthreads > 1) num_threads(2)
 		#pragma omp single nowait
 		{
 			if (processhigh == true)
@@ -173,7 +175,8 @@ void TimeOutsideLevelMeasurement::Refresh(
 	}
 	else if (sadin)
 	{
-		#pragma omp parallel for
+		int nthreads = ParallelTuning::GetThreadCount(ParallelTuning::KERNEL_REDUCTION, length);
+		#pragma omp parallel for if(nthreads > 1) num_threads(nthreads) reduction(+:hightime, lowtime)
 		for(size_t i = 0; i < length; i++)
 		{
 			//Simply sum durations of all samples with value greater than the high threshold
@@ -109,39 +109,177 @@ void UARTDecoder::Refresh(
 	cap->SetParent(this);
 	cap->PrepareForCpuAccess();
 
-	//Time-domain processing to reflect potentially variable sampling rate for RLE captures
-	int64_t next_value = 0;
-	size_t isample = 0;
+	//Split the capture at idle periods and decode the pieces in parallel.
+	//A byte that started before an idle run has read its stop bit within 9.5 bit periods, so any run longer than
+	//that is a point where the decoder is waiting for the next start bit.
+	size_t len = din->size();
+	auto segments = SegmentedDecode::FindIdleSegments(sdin, udin, true, 11 * scaledbitper, 0);
+	vector<DecodeState> entries(segments.size());
+	for(size_t i=0; i<segments.size(); i++)
+		entries[i].m_next = FindStartBit(sdin, udin, segments[i].m_start, len);
+
+	SegmentSymbols<char> bytes;
+	SegmentedDecode::Run(entries, bytes,
+		[&](size_t i, DecodeState& state, SegmentSymbols<char>& out)
+		{ DecodeSegment(sdin, udin, segments[i].m_end, scaledbitper, state, out); });
+
+	//Group bytes into packets
 	int64_t tlast = 0;
 	Packet* pack = NULL;
-	size_t len = din->size();
-	while(isample < len)
+	for(size_t i=0; i<bytes.m_samples.size(); i++)
 	{
-		//Wait for signal to go high (idle state)
-		while( (isample < len) && !GetValue(sdin, udin, isample))
-			isample ++;
-		if(isample >= len)
-			break;
+		int64_t tstart = bytes.m_offsets[i];
+		int64_t tend = tstart + bytes.m_durations[i];
+		unsigned char dval = bytes.m_samples[i];
 
-		//Wait for a falling edge (start bit)
-		while( (isample < len) && GetValue(sdin, udin, isample))
-			isample ++;
-		if(isample >= len)
-			break;
+		//If the last packet was more than 3 byte times ago, start a new one
+		if(pack != NULL)
+		{
+			int64_t delta = tstart - tlast;
+			if(delta > 30 * scaledbitper)
+			{
+				pack->m_len = (tend * din->m_timescale) - pack->m_offset;
+				FinishPacket(pack);
+				pack = NULL;
+			}
+		}
+
+		//If we don't have a packet yet, start one
+		if(pack == NULL)
+		{
+			pack = new Packet;
+			pack->m_offset = tstart * din->m_timescale + din->m_triggerPhase;
+		}
+
+		//Append to the existing packet
+		pack->m_data.push_back(dval);
+		tlast = tstart;
+	}
+
+	//If we have a packet in progress, add it
+	if(pack)
+	{
+		pack->m_len = ::GetOffsetScaled(sdin, udin, len-1) - pack->m_offset;
+		FinishPacket(pack);
+	}
+
+	bytes.Commit(cap, m_packets);
+}
+
+/**
+	@brief Finds the falling edge of the next start bit
+
+	@param sdin		Input waveform, if sparse
+	@param udin		Input waveform, if uniform
+	@param i		Index to start searching from
+	@param len		Length of the input
+
+	@return Index of the first low sample after the line has been idle, or len if there is none
+ */
+size_t UARTDecoder::FindStartBit(SparseDigitalWaveform* sdin, UniformDigitalWaveform* udin, size_t i, size_t len)
+{
+	//Wait for signal to go high (idle state), then for a falling edge
+	i = SegmentedDecode::FindNextValue(sdin, udin, i, len, true);
+	return SegmentedDecode::FindNextValue(sdin, udin, i, len, false);
+}
+
+/**
+	@brief Finds the first sample at or after i which ends at or after a given time
 
+	Gives the same result as stepping forward one sample at a time, without touching the samples in between. For
+	uniform inputs the index is computed directly, for sparse ones it's found with a binary search, since the samples
+	of a sparse digital waveform are already a list of transitions.
+
+	@param sdin		Input waveform, if sparse
+	@param udin		Input waveform, if uniform
+	@param i		Index to start searching from
+	@param len		Length of the input
+	@param t		Time to search for, in input timebase units
+
+	@return Index of the sample, or len if there is none
+ */
+size_t UARTDecoder::FindSampleEndingAfter(
+	SparseDigitalWaveform* sdin,
+	UniformDigitalWaveform* udin,
+	size_t i,
+	size_t len,
+	int64_t t)
+{
+	//Uniform sample j ends at j+1
+	if(udin)
+	{
+		int64_t target = t - 1;
+		if(target <= static_cast<int64_t>(i))
+			return i;
+		return min(len, static_cast<size_t>(target));
+	}
+
+	auto offsets = sdin->m_offsets.GetCpuPointer();
+	auto durations = sdin->m_durations.GetCpuPointer();
+	if( (i >= len) || (offsets[i] + durations[i] >= t) )
+		return i;
+
+	//The next bit is usually only a sample or two away, so gallop forward to bracket it before bisecting.
+	//Sample lo always ends before t, sample hi is either past the end or ends at or after t.
+	size_t lo = i;
+	size_t step = 1;
+	size_t hi = i + 1;
+	while( (hi < len) && (offsets[hi] + durations[hi] < t) )
+	{
+		lo = hi;
+		step *= 2;
+		hi = lo + step;
+	}
+	hi = min(hi, len);
+
+	while(hi - lo > 1)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+		if(offsets[mid] + durations[mid] < t)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return hi;
+}
+
+/**
+	@brief Decodes all bytes whose start bit begins before the end of a segment
+
+	The last byte may read samples past the end of the segment.
+
+	@param sdin			Input waveform, if sparse
+	@param udin			Input waveform, if uniform
+	@param end			Index one past the last sample of the segment
+	@param scaledbitper	Bit period, in input timebase units
+	@param state		Position of the first start bit on entry, position of the next one on exit
+	@param out			Decoded bytes
+ */
+void UARTDecoder::DecodeSegment(
+	SparseDigitalWaveform* sdin,
+	UniformDigitalWaveform* udin,
+	size_t end,
+	int64_t scaledbitper,
+	DecodeState& state,
+	SegmentSymbols<char>& out)
+{
+	//Time-domain processing to reflect potentially variable sampling rate for RLE captures
+	size_t len = sdin ? sdin->size() : udin->size();
+	size_t isample = state.m_next;
+	while(isample < end)
+	{
 		//Time of the start bit
 		int64_t tstart = ::GetOffset(sdin, udin, isample);
 
 		//The next data bit should be measured 1.5 bit periods after the falling edge
-		next_value = tstart + scaledbitper + scaledbitper/2;
+		int64_t next_value = tstart + scaledbitper + scaledbitper/2;
 
 		//Read eight data bits
 		unsigned char dval = 0;
 		for(int ibit=0; ibit<8; ibit++)
 		{
 			//Find the sample of interest
-			while( (isample < len) && ((::GetOffset(sdin, udin, isample) + GetDuration(sdin, udin, isample)) < next_value))
-				isample ++;
+			isample = FindSampleEndingAfter(sdin, udin, isample, len, next_value);
 			if(isample >= len)
 				break;
 
@@ -157,47 +295,20 @@ void UARTDecoder::Refresh(
 			break;
 
 		//All good, read the stop bit
-		while( (isample < len) && ((::GetOffset(sdin, udin, isample) + GetDuration(sdin, udin, isample)) < next_value))
-			isample ++;
+		isample = FindSampleEndingAfter(sdin, udin, isample, len, next_value);
 		if(isample >= len)
 			break;
 
 		//Save the sample
 		int64_t tend = next_value + (scaledbitper/2);
-		cap->m_offsets.push_back(tstart);
-		cap->m_durations.push_back(tend-tstart);
-		cap->m_samples.push_back(dval);
-
-		//If the last packet was more than 3 byte times ago, start a new one
-		if(pack != NULL)
-		{
-			int64_t delta = tstart - tlast;
-			if(delta > 30 * scaledbitper)
-			{
-				pack->m_len = (tend * din->m_timescale) - pack->m_offset;
-				FinishPacket(pack);
-				pack = NULL;
-			}
-		}
+		out.m_offsets.push_back(tstart);
+		out.m_durations.push_back(tend-tstart);
+		out.m_samples.push_back(dval);
 
-		//If we don't have a packet yet, start one
-		if(pack == NULL)
-		{
-			pack = new Packet;
-			pack->m_offset = tstart * din->m_timescale + din->m_triggerPhase;
-		}
-
-		//Append to the existing packet
-		pack->m_data.push_back(dval);
-		tlast = tstart;
+		isample = FindStartBit(sdin, udin, isample, len);
 	}
 
-	//If we have a packet in progress, add it
-	if(pack)
-	{
-		pack->m_len = ::GetOffsetScaled(sdin, udin, len-1) - pack->m_offset;
-		FinishPacket(pack);
-	}
+	state.m_next = isample;
 }
 
 void UARTDecoder::FinishPacket(Packet* pack)
@@ -221,9 +332,9 @@ void UARTDecoder::FinishPacket(Packet* pack)
 	m_packets.push_back(pack);
 }
 
-string ByteWaveform::GetColor(size_t /*i*/)
+vector<string> ByteWaveform::GetColorPalette()
 {
-	return m_parent->m_displaycolor;
+	return { m_parent->m_displaycolor };
 }
 
 string ByteWaveform::GetText(size_t i)
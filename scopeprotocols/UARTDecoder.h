@@ -36,7 +36,7 @@
 #ifndef UARTDecoder_h
 #define UARTDecoder_h
 
-#include "../scopehal/PacketDecoder.h"
+#include "../scopehal/SegmentedDecode.h"
 
 class ByteWaveform : public SparseWaveform<char>
 {
@@ -46,7 +46,7 @@ public:
 	{}
 
 	virtual std::string GetText(size_t) override;
-	virtual std::string GetColor(size_t) override;
+	virtual std::vector<std::string> GetColorPalette() override;
 
 	void SetParent(Filter* parent)
 	{ m_parent = parent; }
@@ -70,8 +70,40 @@ public:
 	PROTOCOL_DECODER_INITPROC(UARTDecoder)
 
 protected:
+
+	///@brief Position of the decoder between bytes, for decoding segments in parallel
+	class DecodeState
+	{
+	public:
+		///@brief Index of the falling edge of the next start bit, or the end of the capture if there isn't one
+		size_t m_next;
+
+		bool Matches(const DecodeState& entry) const
+		{ return m_next == entry.m_next; }
+
+		void Discard()
+		{}
+	};
+
 	void FinishPacket(Packet* pack);
 
+	static size_t FindStartBit(SparseDigitalWaveform* sdin, UniformDigitalWaveform* udin, size_t i, size_t len);
+
+	static size_t FindSampleEndingAfter(
+		SparseDigitalWaveform* sdin,
+		UniformDigitalWaveform* udin,
+		size_t i,
+		size_t len,
+		int64_t t);
+
+	static void DecodeSegment(
+		SparseDigitalWaveform* sdin,
+		UniformDigitalWaveform* udin,
+		size_t end,
+		int64_t scaledbitper,
+		DecodeState& state,
+		SegmentSymbols<char>& out);
+
 	FilterParameter& m_baud;
 };
 
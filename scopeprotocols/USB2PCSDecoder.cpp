@@ -495,25 +495,27 @@ void USB2PCSDecoder::RefreshIterationData(
 	}
 }
 
-std::string USB2PCSWaveform::GetColor(size_t i)
+vector<string> USB2PCSWaveform::GetColorPalette()
 {
-	auto sample = m_samples[i];
-	switch(sample.m_type)
+	//must be same order as SymbolType in header
+	return
 	{
-		case USB2PCSSymbol::TYPE_SYNC:
-			return StandardColors::colors[StandardColors::COLOR_PREAMBLE];
-		case USB2PCSSymbol::TYPE_EOP:
-			return StandardColors::colors[StandardColors::COLOR_PREAMBLE];
-		case USB2PCSSymbol::TYPE_RESET:
-			return StandardColors::colors[StandardColors::COLOR_CONTROL];
-		case USB2PCSSymbol::TYPE_DATA:
-			return StandardColors::colors[StandardColors::COLOR_DATA];
+		StandardColors::colors[StandardColors::COLOR_PREAMBLE],		//TYPE_SYNC
+		StandardColors::colors[StandardColors::COLOR_PREAMBLE],		//TYPE_EOP
+		StandardColors::colors[StandardColors::COLOR_CONTROL],		//TYPE_RESET
+		StandardColors::colors[StandardColors::COLOR_DATA],			//TYPE_DATA
 
 		//invalid state, should never happen
-		case USB2PCSSymbol::TYPE_ERROR:
-		default:
-			return StandardColors::colors[StandardColors::COLOR_ERROR];
-	}
+		StandardColors::colors[StandardColors::COLOR_ERROR]			//TYPE_ERROR
+	};
+}
+
+uint8_t USB2PCSWaveform::GetColorIndex(size_t i)
+{
+	auto type = m_samples[i].m_type;
+	if( (type > USB2PCSSymbol::TYPE_ERROR) || (type < 0) )
+		return USB2PCSSymbol::TYPE_ERROR;
+	return type;
 }
 
 string USB2PCSWaveform::GetText(size_t i)
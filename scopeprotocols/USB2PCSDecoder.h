@@ -75,7 +75,8 @@ class USB2PCSWaveform : public SparseWaveform<USB2PCSSymbol>
 public:
 	USB2PCSWaveform () : SparseWaveform<USB2PCSSymbol>() {};
 	virtual std::string GetText(size_t) override;
-	virtual std::string GetColor(size_t) override;
+	virtual std::vector<std::string> GetColorPalette() override;
+	virtual uint8_t GetColorIndex(size_t i) override;
 };
 
 class USB2PCSDecoder : public Filter
@@ -30,6 +30,9 @@
 #include "../scopehal/scopehal.h"
 #include "USB2PMADecoder.h"
 #include <algorithm>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
@@ -118,94 +121,272 @@ void USB2PMADecoder::Refresh(
 	//Figure out the line state for each input (no clock recovery yet)
 	auto cap = SetupEmptyWaveform<USB2PMAWaveform>(din_p, 0);
 	cap->PrepareForCpuAccess();
-	for(size_t i=0; i<len; i++)
+	if(len == 0)
 	{
-		auto vp = GetValue(sdin_p, udin_p, i);
-		auto vn = GetValue(sdin_n, udin_n, i);
-		bool bp = (vp > threshold_se);
-		bool bn = (vn > threshold_se);
-		float vdiff = vp - vn;
-
-		USB2PMASymbol::SegmentType type = USB2PMASymbol::TYPE_SE1;
-		if(fabs(vdiff) > threshold_diff)
-		{
-			if( (speed == SPEED_FULL) || (speed == SPEED_HIGH) )
-			{
-				if(vdiff > 0)
-					type = USB2PMASymbol::TYPE_J;
-				else
-					type = USB2PMASymbol::TYPE_K;
-			}
-			else
-			{
-				if(vdiff > 0)
-					type = USB2PMASymbol::TYPE_K;
-				else
-					type = USB2PMASymbol::TYPE_J;
-			}
-		}
-		else if(bp && bn)
-			type = USB2PMASymbol::TYPE_SE1;
+		cap->MarkModifiedFromCpu();
+		return;
+	}
+
+	//First pass: classify every sample into a byte-per-sample symbol array
+	const float* vp = sdin_p ? sdin_p->m_samples.GetCpuPointer() : udin_p->m_samples.GetCpuPointer();
+	const float* vn = sdin_n ? sdin_n->m_samples.GetCpuPointer() : udin_n->m_samples.GetCpuPointer();
+	float fdiff = GetFloatThreshold(threshold_diff);
+	float fse = GetFloatThreshold(threshold_se);
+	bool low = (speed == SPEED_LOW);
+	m_symbols.resize(len);
+	uint8_t* sym = m_symbols.data();
+
+	auto split = ParallelTuning::GetSplit(ParallelTuning::KERNEL_THRESHOLD, len, 32, 2);
+	size_t lastblock = split.m_numBlocks - 1;
+	size_t blocksize = split.m_blockSize;
+
+	#pragma omp parallel for if(split.m_threads > 1) num_threads(split.m_threads)
+	for(size_t i=0; i<split.m_numBlocks; i++)
+	{
+		//Last block gets any extra that didn't divide evenly
+		size_t nsamp = blocksize;
+		if(i == lastblock)
+			nsamp = len - i*blocksize;
+
+		size_t off = i*blocksize;
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			ClassifyAVX2(sym + off, vp + off, vn + off, nsamp, fdiff, fse, low);
 		else
-			type = USB2PMASymbol::TYPE_SE0;
+		#endif
+			Classify(sym + off, vp + off, vn + off, nsamp, fdiff, fse, low);
+	}
+
+	//Count runs of identical symbols so the output can be sized once.
+	//Glitch suppression only ever merges runs, so this is an upper bound on the output size.
+	auto nextChange = &FindNextChange;
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		nextChange = &FindNextChangeAVX2;
+	#endif
+	size_t nruns = 0;
+	for(size_t i=0; i<len; i = nextChange(sym, i, len))
+		nruns ++;
+	cap->Resize(nruns);
 
-		//First sample goes as-is
-		if(cap->m_samples.empty())
+	//Second pass: merge runs, ignoring SE0/SE1 states during transitions
+	int64_t* offsets = cap->m_offsets.GetCpuPointer();
+	int64_t* durations = cap->m_durations.GetCpuPointer();
+	USB2PMASymbol* samples = cap->m_samples.GetCpuPointer();
+	size_t nout = 0;
+	for(size_t i=0; i<len; )
+	{
+		size_t end = nextChange(sym, i, len);
+		auto type = static_cast<USB2PMASymbol::SegmentType>(sym[i]);
+
+		int64_t duration = end - i;
+		if(sdin_p)
 		{
-			cap->m_offsets.push_back(::GetOffset(sdin_p, udin_p, i));
-			cap->m_durations.push_back(GetDuration(sdin_p, udin_p, i));
-			cap->m_samples.push_back(type);
-			continue;
+			duration = 0;
+			for(size_t k=i; k<end; k++)
+				duration += sdin_p->m_durations[k];
 		}
 
-		//Type match? Extend the existing sample
-		size_t iold = cap->size()-1;
-		auto oldtype = cap->m_samples[iold];
-		if(oldtype == type)
+		//First run goes as-is
+		if(nout == 0)
 		{
-			cap->m_durations[iold] += GetDuration(sdin_p, udin_p, i);
+			offsets[0] = ::GetOffset(sdin_p, udin_p, i);
+			durations[0] = duration;
+			samples[0] = type;
+			nout = 1;
+			i = end;
 			continue;
 		}
 
 		//Ignore SE0/SE1 states during transitions.
-		int64_t last_fs = cap->m_durations[iold] * din_p->m_timescale;
+		//Adjacent runs always differ (even after merging), so there is never a type match to extend.
+		size_t iold = nout-1;
+		auto oldtype = samples[iold].m_type;
+		int64_t last_fs = durations[iold] * din_p->m_timescale;
 		if(
 			( (oldtype == USB2PMASymbol::TYPE_SE0) || (oldtype == USB2PMASymbol::TYPE_SE1) ) &&
 			(last_fs < transition_time))
 		{
-			cap->m_samples[iold].m_type = type;
-			cap->m_durations[iold] += GetDuration(sdin_p, udin_p, i);
-			continue;
+			samples[iold].m_type = type;
+			durations[iold] += duration;
 		}
 
 		//Not a match. Add a new sample.
-		cap->m_offsets.push_back(::GetOffset(sdin_p, udin_p, i));
-		cap->m_durations.push_back(GetDuration(sdin_p, udin_p, i));
-		cap->m_samples.push_back(type);
+		else
+		{
+			offsets[nout] = ::GetOffset(sdin_p, udin_p, i);
+			durations[nout] = duration;
+			samples[nout] = type;
+			nout ++;
+		}
+
+		i = end;
 	}
+	cap->Resize(nout);
 
 	cap->MarkModifiedFromCpu();
 }
 
-string USB2PMAWaveform::GetColor(size_t i)
+/**
+	@brief Returns the largest float not greater than a double precision threshold
+
+	For any float x, (x > threshold) is then the same as (x > GetFloatThreshold(threshold)), so the vectorized
+	classifier can compare in single precision and still match the scalar double precision comparisons exactly.
+ */
+float USB2PMADecoder::GetFloatThreshold(double threshold)
 {
-	auto sample = m_samples[i];
-	switch(sample.m_type)
+	float f = threshold;
+	if(f > threshold)
+		f = nextafterf(f, -INFINITY);
+	return f;
+}
+
+/**
+	@brief Classifies a block of D+/D- sample pairs into line states, one USB2PMASymbol::SegmentType per byte
+
+	@param sym				Output symbols
+	@param vp				D+ samples
+	@param vn				D- samples
+	@param count			Number of samples
+	@param thresholdDiff	Differential threshold for J/K, from GetFloatThreshold()
+	@param thresholdSE		Single ended threshold for SE1, from GetFloatThreshold()
+	@param low				True for low speed (inverted J/K polarity)
+ */
+void USB2PMADecoder::Classify(
+	uint8_t* sym, const float* vp, const float* vn, size_t count, float thresholdDiff, float thresholdSE, bool low)
+{
+	for(size_t i=0; i<count; i++)
 	{
-		case USB2PMASymbol::TYPE_J:
-		case USB2PMASymbol::TYPE_K:
-			return StandardColors::colors[StandardColors::COLOR_DATA];
+		float vdiff = vp[i] - vn[i];
 
-		case USB2PMASymbol::TYPE_SE0:
-			return StandardColors::colors[StandardColors::COLOR_PREAMBLE];
+		USB2PMASymbol::SegmentType type;
+		if(fabs(vdiff) > thresholdDiff)
+		{
+			if( (vdiff > 0) != low )
+				type = USB2PMASymbol::TYPE_J;
+			else
+				type = USB2PMASymbol::TYPE_K;
+		}
+		else if( (vp[i] > thresholdSE) && (vn[i] > thresholdSE) )
+			type = USB2PMASymbol::TYPE_SE1;
+		else
+			type = USB2PMASymbol::TYPE_SE0;
 
-		//invalid state, should never happen
-		case USB2PMASymbol::TYPE_SE1:
-		default:
-			return StandardColors::colors[StandardColors::COLOR_ERROR];
+		sym[i] = type;
 	}
 }
 
+#ifdef __x86_64__
+/**
+	@brief AVX2 optimized version of Classify()
+ */
+__attribute__((target("avx2")))
+void USB2PMADecoder::ClassifyAVX2(
+	uint8_t* sym, const float* vp, const float* vn, size_t count, float thresholdDiff, float thresholdSE, bool low)
+{
+	__m256 tdiff = _mm256_set1_ps(thresholdDiff);
+	__m256 tse = _mm256_set1_ps(thresholdSE);
+	__m256 zero = _mm256_setzero_ps();
+	__m256 absmask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	__m256i one = _mm256_set1_epi32(1);
+	__m256i two = _mm256_set1_epi32(2);
+	__m256i polarity = low ? _mm256_set1_epi32(-1) : _mm256_setzero_si256();
+	__m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	size_t end = count - (count % 32);
+	for(size_t i=0; i<end; i+=32)
+	{
+		__m256i types[4];
+		for(size_t j=0; j<4; j++)
+		{
+			__m256 p = _mm256_loadu_ps(vp + i + j*8);
+			__m256 n = _mm256_loadu_ps(vn + i + j*8);
+			__m256 vdiff = _mm256_sub_ps(p, n);
+
+			__m256i big = _mm256_castps_si256(_mm256_cmp_ps(_mm256_and_ps(vdiff, absmask), tdiff, _CMP_GT_OQ));
+			__m256i pos = _mm256_castps_si256(_mm256_cmp_ps(vdiff, zero, _CMP_GT_OQ));
+			__m256i se1 = _mm256_castps_si256(_mm256_and_ps(
+				_mm256_cmp_ps(p, tse, _CMP_GT_OQ),
+				_mm256_cmp_ps(n, tse, _CMP_GT_OQ)));
+
+			//J = 0 and K = 1, SE0 = 2 and SE1 = 3
+			__m256i jk = _mm256_andnot_si256(_mm256_xor_si256(pos, polarity), one);
+			__m256i se = _mm256_or_si256(two, _mm256_and_si256(se1, one));
+			types[j] = _mm256_blendv_epi8(se, jk, big);
+		}
+
+		//Narrow to bytes. Packs work within 128-bit halves, so put the dwords back in order afterwards.
+		__m256i words = _mm256_packs_epi32(types[0], types[1]);
+		__m256i words2 = _mm256_packs_epi32(types[2], types[3]);
+		__m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packs_epi16(words, words2), order);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(sym + i), bytes);
+	}
+
+	Classify(sym + end, vp + end, vn + end, count - end, thresholdDiff, thresholdSE, low);
+}
+#endif /* __x86_64__ */
+
+/**
+	@brief Returns the index of the first symbol after i which differs from sym[i], or len if there is none
+ */
+size_t USB2PMADecoder::FindNextChange(const uint8_t* sym, size_t i, size_t len)
+{
+	uint8_t value = sym[i];
+	for(i++; i<len; i++)
+	{
+		if(sym[i] != value)
+			return i;
+	}
+	return len;
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 optimized version of FindNextChange()
+ */
+__attribute__((target("avx2")))
+size_t USB2PMADecoder::FindNextChangeAVX2(const uint8_t* sym, size_t i, size_t len)
+{
+	uint8_t value = sym[i];
+	__m256i ref = _mm256_set1_epi8(value);
+	for(i++; i+32 <= len; i+=32)
+	{
+		__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sym + i));
+		uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, ref)));
+		if(mask)
+			return i + __builtin_ctz(mask);
+	}
+	for(; i<len; i++)
+	{
+		if(sym[i] != value)
+			return i;
+	}
+	return len;
+}
+#endif /* __x86_64__ */
+
+vector<string> USB2PMAWaveform::GetColorPalette()
+{
+	//must be same order as SegmentType in header
+	return
+	{
+		StandardColors::colors[StandardColors::COLOR_DATA],			//TYPE_J
+		StandardColors::colors[StandardColors::COLOR_DATA],			//TYPE_K
+		StandardColors::colors[StandardColors::COLOR_PREAMBLE],		//TYPE_SE0
+
+		//invalid state, should never happen
+		StandardColors::colors[StandardColors::COLOR_ERROR]			//TYPE_SE1
+	};
+}
+
+uint8_t USB2PMAWaveform::GetColorIndex(size_t i)
+{
+	auto type = m_samples[i].m_type;
+	if( (type > USB2PMASymbol::TYPE_SE1) || (type < 0) )
+		return USB2PMASymbol::TYPE_SE1;
+	return type;
+}
+
 string USB2PMAWaveform::GetText(size_t i)
 {
 	auto sample = m_samples[i];
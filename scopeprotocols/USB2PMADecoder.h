@@ -68,7 +68,8 @@ class USB2PMAWaveform : public SparseWaveform<USB2PMASymbol>
 public:
 	USB2PMAWaveform () : SparseWaveform<USB2PMASymbol>() {};
 	virtual std::string GetText(size_t) override;
-	virtual std::string GetColor(size_t) override;
+	virtual std::vector<std::string> GetColorPalette() override;
+	virtual uint8_t GetColorIndex(size_t i) override;
 };
 
 class USB2PMADecoder : public Filter
@@ -94,6 +95,23 @@ public:
 
 protected:
 	FilterParameter& m_speed;
+
+	///@brief Line state of each input sample, reused across refreshes
+	std::vector<uint8_t> m_symbols;
+
+	static float GetFloatThreshold(double threshold);
+
+	static void Classify(
+		uint8_t* sym, const float* vp, const float* vn, size_t count, float thresholdDiff, float thresholdSE, bool low);
+#ifdef __x86_64__
+	static void ClassifyAVX2(
+		uint8_t* sym, const float* vp, const float* vn, size_t count, float thresholdDiff, float thresholdSE, bool low);
+#endif
+
+	static size_t FindNextChange(const uint8_t* sym, size_t i, size_t len);
+#ifdef __x86_64__
+	static size_t FindNextChangeAVX2(const uint8_t* sym, size_t i, size_t len);
+#endif
 };
 
 #endif
@@ -33,6 +33,29 @@
 
 using namespace std;
 
+/**
+	@brief Interned names and values of the packet headers set by the USB 2.0 packet decoder
+ */
+struct USB2HeaderNames
+{
+	const string* type = Packet::Intern("Type");
+	const string* device = Packet::Intern("Device");
+	const string* endpoint = Packet::Intern("Endpoint");
+	const string* length = Packet::Intern("Length");
+
+	const string* sof = Packet::Intern("SOF");
+	const string* setup = Packet::Intern("SETUP");
+	const string* in = Packet::Intern("IN");
+	const string* out = Packet::Intern("OUT");
+	const string* none = Packet::Intern("--");
+};
+
+static const USB2HeaderNames& GetHeaderNames()
+{
+	static const USB2HeaderNames names;
+	return names;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -451,18 +474,19 @@ void USB2PacketDecoder::DecodeSof(USB2PacketWaveform* cap, size_t istart, size_t
 		return;
 
 	//Make the packet
+	auto& names = GetHeaderNames();
 	Packet* pack = new Packet;
 	pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
-	pack->m_headers["Type"] = "SOF";
+	pack->SetHeader(names.type, names.sof);
 	char tmp[128];
 	snprintf(tmp, sizeof(tmp), "Sequence = %u", snframe.m_data);
 	pack->m_headers["Details"] = tmp;
 	pack->m_len = ((cap->m_offsets[icrc] + cap->m_durations[icrc]) * cap->m_timescale) - pack->m_offset;
 	m_packets.push_back(pack);
 
-	pack->m_headers["Device"] = "--";
-	pack->m_headers["Endpoint"] = "--";
-	pack->m_headers["Length"] = "2";
+	pack->SetHeader(names.device, names.none);
+	pack->SetHeader(names.endpoint, names.none);
+	pack->SetHeader(names.length, 2);
 }
 
 void USB2PacketDecoder::DecodeSetup(USB2PacketWaveform* cap, size_t istart, size_t& i)
@@ -552,16 +576,15 @@ void USB2PacketDecoder::DecodeSetup(USB2PacketWaveform* cap, size_t istart, size
 	}
 
 	//Make the packet
+	auto& names = GetHeaderNames();
 	Packet* pack = new Packet;
 	pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
-	pack->m_headers["Type"] = "SETUP";
+	pack->SetHeader(names.type, names.setup);
 	pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+	pack->SetHeader(names.device, saddr.m_data);
+	pack->SetHeader(names.endpoint, sendp.m_data);
+	pack->SetHeader(names.length, 8);	//constant
 	char tmp[256];
-	snprintf(tmp, sizeof(tmp), "%d", saddr.m_data);
-	pack->m_headers["Device"] = tmp;
-	snprintf(tmp, sizeof(tmp), "%d", sendp.m_data);
-	pack->m_headers["Endpoint"] = tmp;
-	pack->m_headers["Length"] = "8";	//constant
 
 	//Decode setup details
 	uint8_t bmRequestType = data[0];
@@ -662,7 +685,7 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		return;
 	}
 
-	char tmp[256];
+	auto& names = GetHeaderNames();
 
 	//Look for the DATA packet after the IN/OUT
 	auto sdatpid = cap->m_samples[i];
@@ -687,18 +710,16 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
 		if( (cap->m_samples[istart].m_data & 0xf) == USB2PacketSymbol::PID_IN)
 		{
-			pack->m_headers["Type"] = "IN";
+			pack->SetHeader(names.type, names.in);
 			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
 		}
 		else
 		{
-			pack->m_headers["Type"] = "OUT";
+			pack->SetHeader(names.type, names.out);
 			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
 		}
-		snprintf(tmp, sizeof(tmp), "%d", saddr.m_data);
-		pack->m_headers["Device"] = tmp;
-		snprintf(tmp, sizeof(tmp), "%d", sendp.m_data);
-		pack->m_headers["Endpoint"] = tmp;
+		pack->SetHeader(names.device, saddr.m_data);
+		pack->SetHeader(names.endpoint, sendp.m_data);
 		pack->m_headers["Details"] = "NAK";
 		m_packets.push_back(pack);
 
@@ -727,18 +748,16 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 	pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
 	if( (cap->m_samples[istart].m_data & 0xf) == USB2PacketSymbol::PID_IN)
 	{
-		pack->m_headers["Type"] = "IN";
+		pack->SetHeader(names.type, names.in);
 		pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
 	}
 	else
 	{
-		pack->m_headers["Type"] = "OUT";
+		pack->SetHeader(names.type, names.out);
 		pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
 	}
-	snprintf(tmp, sizeof(tmp), "%d", saddr.m_data);
-	pack->m_headers["Device"] = tmp;
-	snprintf(tmp, sizeof(tmp), "%d", sendp.m_data);
-	pack->m_headers["Endpoint"] = tmp;
+	pack->SetHeader(names.device, saddr.m_data);
+	pack->SetHeader(names.endpoint, sendp.m_data);
 
 	//Read the data
 	while(i < cap->m_samples.size())
@@ -796,49 +815,46 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 	//Format the data
 	pack->m_headers["Details"] = ack;
 
-	snprintf(tmp, sizeof(tmp), "%zu", pack->m_data.size());
-	pack->m_headers["Length"] = tmp;
+	pack->SetHeader(names.length, pack->m_data.size());
 
 	m_packets.push_back(pack);
 }
 
-std::string USB2PacketWaveform::GetColor(size_t i)
+vector<string> USB2PacketWaveform::GetColorPalette()
 {
-	auto sample = m_samples[i];
-	switch(sample.m_type)
-	{
-		case USB2PacketSymbol::TYPE_PID:
-			if( (sample.m_data == USB2PacketSymbol::PID_RESERVED) ||
-				(sample.m_data == USB2PacketSymbol::PID_STALL) )
-				return StandardColors::colors[StandardColors::COLOR_ERROR];
-			else
-				return StandardColors::colors[StandardColors::COLOR_PREAMBLE];
-
-		case USB2PacketSymbol::TYPE_ADDR:
-			return StandardColors::colors[StandardColors::COLOR_ADDRESS];
-
-		case USB2PacketSymbol::TYPE_ENDP:
-			return StandardColors::colors[StandardColors::COLOR_ADDRESS];
-
-		case USB2PacketSymbol::TYPE_NFRAME:
-			return StandardColors::colors[StandardColors::COLOR_DATA];
-
-		case USB2PacketSymbol::TYPE_CRC5_GOOD:
-		case USB2PacketSymbol::TYPE_CRC16_GOOD:
-			return StandardColors::colors[StandardColors::COLOR_CHECKSUM_OK];
+	//must be same order as SymbolType in header
+	return
+	{
+		StandardColors::colors[StandardColors::COLOR_PREAMBLE],		//TYPE_PID
+		StandardColors::colors[StandardColors::COLOR_ADDRESS],		//TYPE_ADDR
+		StandardColors::colors[StandardColors::COLOR_ADDRESS],		//TYPE_ENDP
+		StandardColors::colors[StandardColors::COLOR_CHECKSUM_OK],	//TYPE_CRC5_GOOD
+		StandardColors::colors[StandardColors::COLOR_CHECKSUM_BAD],	//TYPE_CRC5_BAD
+		StandardColors::colors[StandardColors::COLOR_CHECKSUM_OK],	//TYPE_CRC16_GOOD
+		StandardColors::colors[StandardColors::COLOR_CHECKSUM_BAD],	//TYPE_CRC16_BAD
+		StandardColors::colors[StandardColors::COLOR_DATA],			//TYPE_NFRAME
+		StandardColors::colors[StandardColors::COLOR_DATA],			//TYPE_DATA
 
-		case USB2PacketSymbol::TYPE_CRC5_BAD:
-		case USB2PacketSymbol::TYPE_CRC16_BAD:
-			return StandardColors::colors[StandardColors::COLOR_CHECKSUM_BAD];
+		//invalid state, should never happen
+		StandardColors::colors[StandardColors::COLOR_ERROR]			//TYPE_ERROR
+	};
+}
 
-		case USB2PacketSymbol::TYPE_DATA:
-			return StandardColors::colors[StandardColors::COLOR_DATA];
+uint8_t USB2PacketWaveform::GetColorIndex(size_t i)
+{
+	auto& sample = m_samples[i];
+	auto type = sample.m_type;
+	if( (type > USB2PacketSymbol::TYPE_ERROR) || (type < 0) )
+		return USB2PacketSymbol::TYPE_ERROR;
 
-		//invalid state, should never happen
-		case USB2PacketSymbol::TYPE_ERROR:
-		default:
-			return StandardColors::colors[StandardColors::COLOR_ERROR];
+	//Reserved and stall PIDs are shown as errors
+	if( (type == USB2PacketSymbol::TYPE_PID) &&
+		( (sample.m_data == USB2PacketSymbol::PID_RESERVED) || (sample.m_data == USB2PacketSymbol::PID_STALL) ) )
+	{
+		return USB2PacketSymbol::TYPE_ERROR;
 	}
+
+	return type;
 }
 
 string USB2PacketWaveform::GetText(size_t i)
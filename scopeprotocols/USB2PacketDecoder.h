@@ -100,7 +100,8 @@ class USB2PacketWaveform : public SparseWaveform<USB2PacketSymbol>
 public:
 	USB2PacketWaveform () : SparseWaveform<USB2PacketSymbol>() {};
 	virtual std::string GetText(size_t) override;
-	virtual std::string GetColor(size_t) override;
+	virtual std::vector<std::string> GetColorPalette() override;
+	virtual uint8_t GetColorIndex(size_t i) override;
 };
 
 class USB2PacketDecoder : public PacketDecoder
@@ -181,7 +181,7 @@ void VICPDecoder::Refresh(
 						//Don't care about RX.
 						if(nextIsTx)
 						{
-							if( (sym.m_data[0] != 0x07) || (sym.m_data[1] != 0x45) )
+							if( (p->GetByte(sym.m_data, 0) != 0x07) || (p->GetByte(sym.m_data, 1) != 0x45) )
 							{
 								err = true;
 								break;
@@ -210,7 +210,7 @@ void VICPDecoder::Refresh(
 					//Don't care about TX.
 					if(!nextIsTx)
 					{
-						if( (sym.m_data[0] != 0x07) || (sym.m_data[1] != 0x45) )
+						if( (p->GetByte(sym.m_data, 0) != 0x07) || (p->GetByte(sym.m_data, 1) != 0x45) )
 						{
 							err = true;
 							break;
@@ -237,7 +237,7 @@ void VICPDecoder::Refresh(
 						//It's a data byte! Specifically, our opcode field.
 						cap->m_offsets.push_back(start);
 						cap->m_durations.push_back(dur);
-						cap->m_samples.push_back(VICPSymbol(VICPSymbol::TYPE_OPCODE, sym.m_data[0]));
+						cap->m_samples.push_back(VICPSymbol(VICPSymbol::TYPE_OPCODE, p->GetByte(sym.m_data, 0)));
 
 						//Create a new packet
 						pack = new Packet;
@@ -277,7 +277,7 @@ void VICPDecoder::Refresh(
 					{
 						cap->m_offsets.push_back(start);
 						cap->m_durations.push_back(dur);
-						cap->m_samples.push_back(VICPSymbol(VICPSymbol::TYPE_VERSION, sym.m_data[0]));
+						cap->m_samples.push_back(VICPSymbol(VICPSymbol::TYPE_VERSION, p->GetByte(sym.m_data, 0)));
 
 						state = 4;
 						i++;
@@ -295,10 +295,10 @@ void VICPDecoder::Refresh(
 					{
 						cap->m_offsets.push_back(start);
 						cap->m_durations.push_back(dur);
-						cap->m_samples.push_back(VICPSymbol(VICPSymbol::TYPE_SEQ, sym.m_data[0]));
+						cap->m_samples.push_back(VICPSymbol(VICPSymbol::TYPE_SEQ, p->GetByte(sym.m_data, 0)));
 
 						//Save the sequence number header
-						pack->m_headers["Sequence"] = to_string(sym.m_data[0]);
+						pack->m_headers["Sequence"] = to_string(p->GetByte(sym.m_data, 0));
 
 						state = 5;
 						i++;
@@ -316,7 +316,7 @@ void VICPDecoder::Refresh(
 					{
 						cap->m_offsets.push_back(start);
 						cap->m_durations.push_back(dur);
-						cap->m_samples.push_back(VICPSymbol(VICPSymbol::TYPE_RESERVED, sym.m_data[0]));
+						cap->m_samples.push_back(VICPSymbol(VICPSymbol::TYPE_RESERVED, p->GetByte(sym.m_data, 0)));
 
 						state = 6;
 						i++;
@@ -334,7 +334,7 @@ void VICPDecoder::Refresh(
 					{
 						cap->m_offsets.push_back(start);
 						cap->m_durations.push_back(dur);
-						cap->m_samples.push_back(VICPSymbol(VICPSymbol::TYPE_LENGTH, sym.m_data[0]));
+						cap->m_samples.push_back(VICPSymbol(VICPSymbol::TYPE_LENGTH, p->GetByte(sym.m_data, 0)));
 
 						state = 7;
 						i++;
@@ -355,7 +355,7 @@ void VICPDecoder::Refresh(
 					{
 						size_t clen = cap->m_offsets.size();
 						cap->m_durations[clen-1] = (start+dur) - cap->m_offsets[clen-1];
-						cap->m_samples[clen-1].m_data = (cap->m_samples[clen-1].m_data << 8) | sym.m_data[0];
+						cap->m_samples[clen-1].m_data = (cap->m_samples[clen-1].m_data << 8) | p->GetByte(sym.m_data, 0);
 
 						payloadBytesLeft = cap->m_samples[clen-1].m_data;
 						pack->m_headers["Length"] = to_string(payloadBytesLeft);
@@ -375,7 +375,7 @@ void VICPDecoder::Refresh(
 					else
 					{
 						string tmp;
-						tmp += (char)sym.m_data[0];
+						tmp += (char)p->GetByte(sym.m_data, 0);
 
 						cap->m_offsets.push_back(start);
 						cap->m_durations.push_back(dur);
@@ -416,7 +416,7 @@ void VICPDecoder::Refresh(
 
 						else
 						{
-							char ch = sym.m_data[0];
+							char ch = p->GetByte(sym.m_data, 0);
 							if(ch == '\r')
 								cap->m_samples[clen-1].m_str += "\\r";
 							else if(ch == '\n')
@@ -46,6 +46,11 @@ layout(std430, binding=2) restrict readonly buffer buf_lfsrTable
 	uint lfsrTable[];
 };
 
+layout(std430, binding=3) restrict buffer buf_errorCount
+{
+	uint errorCount[];
+};
+
 layout(std430, push_constant) uniform constants
 {
 	uint count;
@@ -111,6 +116,7 @@ void main()
 		endpos = count;
 
 	//PRBS verification
+	uint errors = 0;
 	for(uint i=startpos; i<endpos; i++)
 	{
 		uint next = ( (state >> 22) ^ (state >> 17) ) & 1;
@@ -120,7 +126,13 @@ void main()
 		if( (next == uint(din[i])) || (i < 23) )
 			dout[i] = uint8_t(0);
 		else
+		{
 			dout[i] = uint8_t(1);
+			errors ++;
+		}
 	}
 
+	//Only one atomic per thread, and none at all for the usual error-free case
+	if(errors != 0)
+		atomicAdd(errorCount[0], errors);
 }
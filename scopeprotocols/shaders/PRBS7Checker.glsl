@@ -41,6 +41,11 @@ layout(std430, binding=1) restrict writeonly buffer buf_dout
 	uint8_t dout[];
 };
 
+layout(std430, binding=2) restrict buffer buf_errorCount
+{
+	uint errorCount[];
+};
+
 layout(std430, push_constant) uniform constants
 {
 	uint count;
@@ -73,12 +78,17 @@ void main()
 	}
 
 	//Verify the LFSR state bits (this will always return correct for the first block since it was the seed)
+	uint errors = 0;
 	for(uint i=0; i<PRBS_BITS; i++)
 	{
 		if(uint(din[i]) == uint(din[startpos + i]))
 			dout[startpos+i] = uint8_t(0);
 		else
+		{
 			dout[startpos+i] = uint8_t(1);
+			if(startpos + i < endpos)
+				errors ++;
+		}
 	}
 	startpos += PRBS_BITS;
 
@@ -92,6 +102,13 @@ void main()
 		if( (next == uint(din[i])) || (i < 7) )
 			dout[i] = uint8_t(0);
 		else
+		{
 			dout[i] = uint8_t(1);
+			errors ++;
+		}
 	}
+
+	//Only one atomic per thread, and none at all for the usual error-free case
+	if(errors != 0)
+		atomicAdd(errorCount[0], errors);
 }